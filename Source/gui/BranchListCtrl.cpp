@@ -249,7 +249,7 @@ void CBranchListCtrl::OnViewUpdate()
 	m_Active = GetSelectedItemText();
 	SetCaption();
 	CCmd_Branches *pCmd= new CCmd_Branches;
-	pCmd->Init( m_hWnd, RUN_ASYNC);
+	InitUpdateCmd(pCmd);
 	if( pCmd->Run( ) )
 	{
 		MainFrame()->UpdateStatus( LoadStringResource(IDS_REQUESTING_BRANCH_LISTING) );
@@ -522,7 +522,7 @@ void CClientListCtrl::OnViewUpdate()
 	m_Active = GetSelectedItemText();
 	SetCaption();
 	CCmd_Clients *pCmd= new CCmd_Clients;
-	pCmd->Init( m_hWnd, RUN_ASYNC);
+	InitUpdateCmd(pCmd);
 	if( pCmd->Run( ) )
 	{
 		MainFrame()->UpdateStatus(LoadStringResource(IDS_REQUESTING_CLIENT_LISTING));
@@ -292,6 +292,7 @@ CDeltaTreeCtrl::CDeltaTreeCtrl()
 	m_PositionTo = _T("");
 	m_caption = LoadStringResource(IDS_PENDING_PERFORCE_CHANGELISTS);
 	m_RedoExpansion = FALSE;
+	m_Incremental = FALSE;
 	if (GET_P4REGPTR()->ExpandChgLists())
 	{
 		m_PrevExpansion = GET_P4REGPTR()->GetPendChgExpansion();
@@ -453,7 +454,12 @@ void CDeltaTreeCtrl::Clear()
 
 LRESULT CDeltaTreeCtrl::OnInitTree(WPARAM wParam, LPARAM lParam)
 {
-	InitList();
+	// If the tree still shows this port, client and user, keep my changelists
+	// and let the refresh update just the nodes that changed
+	if( m_MyRoot && m_TreeKey == GetTreeKey() )
+		StartIncrementalRefresh();
+	else
+		InitList();
 	return 0;
 }
 
@@ -513,6 +519,21 @@ void CDeltaTreeCtrl::InitList()
 	if (!m_DragToChangeNum)
 		m_DragToChange=m_MyDefault;
 
+	InsertOthersRoot();
+    SetRedraw(TRUE);
+
+	// Select nothing, so there is no focus rect
+	SelectItem(NULL);	
+
+	// Clear flag for expanding others pending changelist root
+	m_ExpandingOthersRoot= FALSE;
+
+	AbandonIncrementalRefresh();
+	m_TreeKey= GetTreeKey();
+}
+
+void CDeltaTreeCtrl::InsertOthersRoot()
+{
 	if ( GET_P4REGPTR()->GetEnablePendingChgsOtherClients( ) )
 	{
 		CString txt;
@@ -544,13 +565,183 @@ void CDeltaTreeCtrl::InitList()
 		else
 			m_OthersRoot=Insert(txt, CP4ViewImageList::VI_THEIRPENDING, EXPAND_FOLDER, TVI_ROOT, TRUE);
 	}
+}
+
+CString CDeltaTreeCtrl::GetTreeKey()
+{
+	CString key= GET_P4REGPTR()->GetP4Port();
+	key+= _T('\n');
+	key+= GET_P4REGPTR()->GetP4Client();
+	key+= _T('\n');
+	key+= GET_P4REGPTR()->GetP4User();
+	return key;
+}
+
+// Start a refresh that keeps my changelists in the tree.  Other clients'
+// changes are only fetched while that root is open, so it is still rebuilt.
+// The changes and opened files that come back are matched to the existing
+// nodes, and anything not found again is removed at the end.
+void CDeltaTreeCtrl::StartIncrementalRefresh()
+{
+	UpdateTreeState(TRUE);	// saves the current expansion
+	UnselectAll();
+
+    SetRedraw(FALSE);
+	if (m_OthersRoot)
+	{
+		DeleteLParams(m_OthersRoot);
+		CMultiSelTreeCtrl::DeleteItem(m_OthersRoot);
+		m_OthersRoot = NULL;
+	}
+	InsertOthersRoot();
     SetRedraw(TRUE);
 
-	// Select nothing, so there is no focus rect
-	SelectItem(NULL);	
+	if (!m_DragToChangeNum)
+		m_DragToChange=m_MyDefault;
 
-	// Clear flag for expanding others pending changelist root
+	SelectItem(NULL);	
 	m_ExpandingOthersRoot= FALSE;
+
+	m_SeenChanges.RemoveAll();
+	m_OldFiles.RemoveAll();
+	m_Incremental= TRUE;
+}
+
+// Find one of my numbered changes that is already in the tree,
+// bringing its text up to date
+HTREEITEM CDeltaTreeCtrl::RefreshChange(long changeNum, LPCTSTR text)
+{
+	if( changeNum <= 0 )
+		return NULL;
+
+	HTREEITEM item= FindChange(changeNum);
+	if( item == NULL || GetParentItem(item) != m_MyRoot )
+		return NULL;
+
+	if( GetItemText(item) != text )
+		SetItemText(item, text);
+	return item;
+}
+
+CString CDeltaTreeCtrl::GetFileKey(HTREEITEM changeItem, LPCTSTR depotPath)
+{
+	CString key;
+	key.Format(_T("%p "), changeItem);
+	return key + depotPath;
+}
+
+// Index the files now under my changes, so the opened files
+// that come back can be matched to them
+void CDeltaTreeCtrl::CollectOldFiles()
+{
+	m_OldFiles.RemoveAll();
+
+	HTREEITEM change= GetChildItem(m_MyRoot);
+	while(change != NULL)
+	{
+		HTREEITEM file= GetChildItem(change);
+		while(file != NULL)
+		{
+			CP4FileStats *stats= GetLParamTyped<CP4FileStats>(file);
+			if( stats )
+				m_OldFiles.SetAt(GetFileKey(change, stats->GetFullDepotPath()), file);
+			file= GetNextSiblingItem(file);
+		}
+		change= GetNextSiblingItem(change);
+	}
+}
+
+// Reuse the node of a file that was already open in this change, updating
+// its text and image only if they differ.  The new stats replace the old.
+HTREEITEM CDeltaTreeCtrl::RefreshFile(CP4FileStats *stats, HTREEITEM changeItem)
+{
+	void *ptr;
+	CString key= GetFileKey(changeItem, stats->GetFullDepotPath());
+	if( !m_OldFiles.Lookup(key, ptr) )
+		return NULL;
+	m_OldFiles.RemoveKey(key);
+
+	HTREEITEM item= (HTREEITEM) ptr;
+	CString text= stats->GetFormattedChangeFile(GET_P4REGPTR()->ShowFileType(), GET_P4REGPTR()->ShowOpenAction());
+	if( GetItemText(item) != text )
+		SetItemText(item, text);
+
+	int image= TheApp()->GetFileImageIndex(stats, TRUE);
+	int oldImage, oldSelImage;
+	GetItemImage(item, oldImage, oldSelImage);
+	if( oldImage != image )
+		SetItemImage(item, image, image);
+
+	delete GetLParamObject(item);
+	SetLParam(item, (LPARAM) stats);
+	return item;
+}
+
+// Remove the files and changes that the refresh did not find again,
+// and drop the fixes of the changes that were kept, fetching them again
+// as a rebuilt tree would
+void CDeltaTreeCtrl::FinishIncrementalRefresh()
+{
+	if( !m_Incremental )
+		return;
+
+	CString key;
+	void *ptr;
+	POSITION pos= m_OldFiles.GetStartPosition();
+	while(pos != NULL)
+	{
+		m_OldFiles.GetNextAssoc(pos, key, ptr);
+		DeleteItem((HTREEITEM) ptr);
+	}
+
+	HTREEITEM item= GetChildItem(m_MyRoot);
+	while(item != NULL)
+	{
+		HTREEITEM next= GetNextSiblingItem(item);
+		if( item != m_MyDefault && !m_SeenChanges.Lookup(item, ptr) )
+		{
+			if( m_DragToChange == item )
+				m_DragToChange= m_MyDefault;
+			DeleteItem(item);
+		}
+		else if( GetChangeNumber(item) > 0 )
+		{
+			HTREEITEM child= GetChildItem(item);
+			while(child != NULL)
+			{
+				HTREEITEM nextChild= GetNextSiblingItem(child);
+				if( !IsAFile(child) )
+					DeleteItem(child);
+				child= nextChild;
+			}
+			SetLParam(item, NULL);
+			SetChildCount(item, 1);
+		}
+		item= next;
+	}
+
+	SetLParam(m_MyRoot, EXPAND_FOLDER);
+	if( m_MyRootExpanded )
+	{
+		// Fetches the fixes for empty changes, then for the open ones with files
+		ExpandTree(m_MyRoot);
+		item= GetChildItem(m_MyRoot);
+		while(item != NULL)
+		{
+			if( GetChildItem(item) != NULL && (GetItemState(item) & TVIS_EXPANDED) )
+				ExpandTree(item);
+			item= GetNextSiblingItem(item);
+		}
+	}
+
+	AbandonIncrementalRefresh();
+}
+
+void CDeltaTreeCtrl::AbandonIncrementalRefresh()
+{
+	m_SeenChanges.RemoveAll();
+	m_OldFiles.RemoveAll();
+	m_Incremental= FALSE;
 }
 
 
@@ -975,7 +1166,10 @@ LRESULT CDeltaTreeCtrl::OnP4AutoResolve(WPARAM wParam, LPARAM lParam)
 			}
 		}
 		else
+		{
 			pCmd->ReleaseServerLock();
+			MainFrame()->StartResolvePreview(pCmd->DetachLocalPreview());
+		}
 	}
 	else
 		pCmd->ReleaseServerLock();
@@ -2002,6 +2196,11 @@ LRESULT CDeltaTreeCtrl::OnP4Ostat(WPARAM wParam, LPARAM lParam)
 			for( int i=0; i < array->GetSize(); i++)
 			   delete (CP4FileStats *) array->GetAt(i);
 		}
+		if( !m_ExpandingOthersRoot )
+		{
+			AbandonIncrementalRefresh();
+			MainFrame()->StartupLoadFailed();
+		}
         pCmd->ReleaseServerLock();
 		delete pCmd;
 
@@ -2017,6 +2216,11 @@ LRESULT CDeltaTreeCtrl::OnP4Ostat(WPARAM wParam, LPARAM lParam)
 	HTREEITEM changeItem=NULL;
 	int lastChangeNum= -1;
 	CString lastOtherUser;
+
+	// Match the files to those already in my changes, unless rebuilding
+	BOOL incremental= m_Incremental && !m_ExpandingOthersRoot;
+	if( incremental )
+		CollectOldFiles();
 		
 	if(array->GetSize() > 0)
 	{
@@ -2057,6 +2261,9 @@ LRESULT CDeltaTreeCtrl::OnP4Ostat(WPARAM wParam, LPARAM lParam)
                 else
 				    changeItem=InsertChange(stats, TRUE);
 
+				if( incremental && changeItem != NULL )
+					m_SeenChanges.SetAt(changeItem, changeItem);
+
 				lastChangeNum = stats->GetOpenChangeNum();
 				lastOtherUser = !lastChangeNum && stats->IsMyOpen() 
 							  ? _T("") : stats->GetOtherUsers();
@@ -2065,8 +2272,9 @@ LRESULT CDeltaTreeCtrl::OnP4Ostat(WPARAM wParam, LPARAM lParam)
 			if(changeItem!=NULL)
 			{
 				// Insert the file under the change
-				Insert(stats->GetFormattedChangeFile(GET_P4REGPTR()->ShowFileType(), GET_P4REGPTR()->ShowOpenAction()),
-							TheApp()->GetFileImageIndex(stats, TRUE), (LPARAM) stats, changeItem, FALSE);
+				if( !incremental || !RefreshFile(stats, changeItem) )
+					Insert(stats->GetFormattedChangeFile(GET_P4REGPTR()->ShowFileType(), GET_P4REGPTR()->ShowOpenAction()),
+								TheApp()->GetFileImageIndex(stats, TRUE), (LPARAM) stats, changeItem, FALSE);
 			}
 			else
 				ASSERT(0);
@@ -2080,6 +2288,8 @@ LRESULT CDeltaTreeCtrl::OnP4Ostat(WPARAM wParam, LPARAM lParam)
 
 			if ( !PumpMessages( ) || MainFrame()->IsQuitting() )
 			{
+				if( incremental )
+					AbandonIncrementalRefresh();
                 pCmd->ReleaseServerLock();
 				delete pCmd;
                 SetRedraw(TRUE);
@@ -2125,6 +2335,8 @@ LRESULT CDeltaTreeCtrl::OnP4Ostat(WPARAM wParam, LPARAM lParam)
     
 	// Expand the tree again
     SetRedraw(FALSE);
+	if( incremental )
+		FinishIncrementalRefresh();
 	SortTree();
 	if( !m_ExpandingOthersRoot )
 	{
@@ -3118,7 +3330,12 @@ LRESULT CDeltaTreeCtrl::OnP4Change(WPARAM wParam, LPARAM lParam)
 				HTREEITEM item;
 				if(change->IsMyChange())
 				{
-					item=Insert(change->GetFormattedChange(GET_P4REGPTR()->ShowChangeDesc(), GET_P4REGPTR()->SortChgsByUser()), 0, NULL, m_MyRoot, TRUE);
+					CString txt= change->GetFormattedChange(GET_P4REGPTR()->ShowChangeDesc(), GET_P4REGPTR()->SortChgsByUser());
+					item= m_Incremental ? RefreshChange(change->GetChangeNumber(), txt) : NULL;
+					if( !item )
+						item=Insert(txt, 0, NULL, m_MyRoot, TRUE);
+					if( m_Incremental )
+						m_SeenChanges.SetAt(item, item);
 				}
 				else if (m_OthersRoot)
 				{
@@ -3146,8 +3363,10 @@ LRESULT CDeltaTreeCtrl::OnP4Change(WPARAM wParam, LPARAM lParam)
 
 		if(pCmd->GetError() || MainFrame()->IsQuitting())
 		{
+			AbandonIncrementalRefresh();
            	MainFrame()->ClearStatus();
 			MainFrame()->SetLastUpdateTime(UPDATE_FAILED);
+			MainFrame()->StartupLoadFailed();
 			pCmd->ReleaseServerLock();
 		}
 		else
@@ -3167,9 +3386,11 @@ LRESULT CDeltaTreeCtrl::OnP4Change(WPARAM wParam, LPARAM lParam)
 			else
 			{
 				delete pCmdOstat;
+				AbandonIncrementalRefresh();
                	MainFrame()->ClearStatus();
 				pCmd->ReleaseServerLock();
 				MainFrame()->SetLastUpdateTime(UPDATE_FAILED);
+				MainFrame()->StartupLoadFailed();
 			}
 		}
 		delete pCmd;
@@ -71,6 +71,13 @@ protected:
 	// Collect previous execution tree state expansion here
 	BOOL m_RedoExpansion;
 	CString m_PrevExpansion;
+
+	// A refresh for the same port, client and user is applied to the nodes
+	// already in the tree instead of rebuilding my changelists
+	BOOL m_Incremental;
+	CString m_TreeKey;
+	CMapPtrToPtr m_SeenChanges;		// my changes found again by this refresh
+	CMapStringToPtr m_OldFiles;		// change item + depot path -> file not yet found again
     
 	//////////////////////
 	// OLE drag drop support
@@ -301,6 +308,15 @@ protected:
 	void UpdateTreeState(BOOL saveTreeState);
 	
 	void InitList();
+	void InsertOthersRoot();
+	CString GetTreeKey();
+	void StartIncrementalRefresh();
+	HTREEITEM RefreshChange(long changeNum, LPCTSTR text);
+	CString GetFileKey(HTREEITEM changeItem, LPCTSTR depotPath);
+	void CollectOldFiles();
+	HTREEITEM RefreshFile(CP4FileStats *stats, HTREEITEM changeItem);
+	void FinishIncrementalRefresh();
+	void AbandonIncrementalRefresh();
 	void DeleteLParams(HTREEITEM root);
 	void DeleteItem(HTREEITEM item);
 
@@ -2245,6 +2245,7 @@ BOOL CDepotTreeCtrl::OnP4RevertFile(CCmd_ListOpStat *pCmd)
 void CDepotTreeCtrl::StartChangeWndUpdate(int key)
 {
 	XTRACE(_T("StartChangeWndUpdate()\n"));
+	MainFrame()->StartupPhaseDone(STARTUP_DEPOTTREE);
 
 	if( !m_ClearedChangeWnd )
 		::SendMessage(m_changeWnd, WM_INITTREE, 0, 0);
@@ -2263,6 +2264,7 @@ void CDepotTreeCtrl::StartChangeWndUpdate(int key)
 	{
 		RELEASE_SERVER_LOCK(key);
 		MainFrame()->SetLastUpdateTime(UPDATE_FAILED);
+		MainFrame()->StartupLoadFailed();
 		MainFrame()->ClearStatus();
 		delete pCmd;
 	}
@@ -2270,6 +2272,22 @@ void CDepotTreeCtrl::StartChangeWndUpdate(int key)
 
 
 
+/*
+	_________________________________________________________________
+
+	Refresh just the changes window, leaving the depot tree alone.
+	For when the auto-poll finds a new pending change or different
+	opened files, but nothing new has been submitted
+	_________________________________________________________________
+*/
+
+void CDepotTreeCtrl::UpdateChangeWnd(int key)
+{
+	m_ClearedChangeWnd= FALSE;
+	StartChangeWndUpdate(key);
+}
+
+
 /*
 	_________________________________________________________________
 
@@ -2449,6 +2467,7 @@ LRESULT CDepotTreeCtrl::OnP4DirStat(WPARAM wParam, LPARAM lParam)
 		{
 			pCmd->ReleaseServerLock();
 			MainFrame()->SetLastUpdateTime(UPDATE_FAILED);
+			MainFrame()->StartupLoadFailed();
 			MainFrame()->ClearStatus();
 			delete pCmd;
 			return 0;
@@ -2753,6 +2772,7 @@ LRESULT CDepotTreeCtrl::OnP4FStat(WPARAM wParam, LPARAM lParam)
 		{
 			pCmd->ReleaseServerLock();
 			MainFrame()->SetLastUpdateTime(UPDATE_FAILED);
+			MainFrame()->StartupLoadFailed();
 			MainFrame()->ClearStatus();
 			delete pCmd;
 			return 0;
@@ -3280,6 +3300,7 @@ void CDepotTreeCtrl::OnViewUpdate( BOOL redrill, int key /*=0*/ )
 		if( key )
 			RELEASE_SERVER_LOCK( key );        
 		delete pCmd;
+		MainFrame()->StartupLoadFailed();
 		MainFrame()->ClearStatus();
 	}
 }
@@ -3332,10 +3353,12 @@ LRESULT CDepotTreeCtrl::OnP4Depots ( WPARAM wParam, LPARAM lParam )
 		if (!LoadStringResource(IDS_UNABLE_TO_GET_CLIENT_DESCRIPTION).Compare(pCmd->GetErrorText()))
 			bRmvMRUPcu = TRUE;	// remove the PCU because it has total failure
 
+		MainFrame()->StartupLoadFailed();
 		goto depotend;
 	}
 	else
 	{
+		MainFrame()->StartupPhaseDone(STARTUP_DEPOTS);
 		if (GET_P4REGPTR( )->ShowEntireDepot( ) > SDF_DEPOT)
 		{
 #ifdef	_DEBUG
@@ -3348,6 +3371,7 @@ LRESULT CDepotTreeCtrl::OnP4Depots ( WPARAM wParam, LPARAM lParam )
 					RELEASE_SERVER_LOCK( key );        
 				::PostMessage(MainFrame()->m_hWnd, WM_COMMAND, ID_VIEW_CLIENTVIEW, 0);
 				AddToStatus( LoadStringResource(IDS_NOLOCALFORNULLROOT), SV_WARNING );
+				MainFrame()->StartupLoadFailed();
 				goto depotend;
 			}
 		}
@@ -3812,7 +3836,8 @@ LRESULT CDepotTreeCtrl::OnP4Diff2(WPARAM wParam, LPARAM lParam)
 {
 	CCmd_Diff2 *pCmd= (CCmd_Diff2 *) wParam;
 	CString msg= pCmd->GetInfoText();
-	if( ! msg.IsEmpty() )
+	CP4FolderCompare *pCompare= pCmd->DetachFolderCompare();
+	if( ! msg.IsEmpty() || pCompare )
 	{
 		if (pCmd->IsOutput2Dlg())
 		{
@@ -3820,6 +3845,7 @@ LRESULT CDepotTreeCtrl::OnP4Diff2(WPARAM wParam, LPARAM lParam)
 			m_Diff2dlg = new CDiff2Output(this);
 			m_Diff2dlg->SetKey(key = pCmd->HaveServerLock()? pCmd->GetServerKey() : 0);
 			m_Diff2dlg->SetMsg( msg );
+			m_Diff2dlg->SetFolderCompare( pCompare );
 			CStringArray names;
 			names.Add(pCmd->GetFileName(0));
 			names.Add(pCmd->GetFileName(1));
@@ -5164,6 +5190,11 @@ void CDepotTreeCtrl::FileGet(BOOL whatIf, BOOL force, BOOL removeFiles, LPCTSTR
 
 	m_StringList.RemoveAll();
 
+	// A preview to head can be answered from the stats we already have for
+	// any files fetched recently enough
+	CP4SyncPreview preview;
+	BOOL usePreview = whatIf && !force && !removeFiles && (!qualifier || !*qualifier);
+
 	HTREEITEM cItem;
 	CString itemStr;
 
@@ -5190,6 +5221,8 @@ void CDepotTreeCtrl::FileGet(BOOL whatIf, BOOL force, BOOL removeFiles, LPCTSTR
 			else
 			{
 				CP4FileStats *stats= m_FSColl.GetStats((long)GetLParam(cItem));
+				if (usePreview && preview.Preview(stats))
+					continue;
 				BOOL b =  TheApp()->m_HasPlusMapping;
 				CString dPath = stats->GetFullDepotPath();
 				if (!b && dPath.Find(_T('%')) != -1)
@@ -5207,6 +5240,15 @@ void CDepotTreeCtrl::FileGet(BOOL whatIf, BOOL force, BOOL removeFiles, LPCTSTR
 	
 	CCmd_Get *pCmd= new CCmd_Get;
 	pCmd->Init( m_hWnd, RUN_ASYNC);
+	if (preview.GetCount())
+	{
+		pCmd->SetCachedPreview(&preview);
+		if (m_StringList.IsEmpty())
+		{
+			pCmd->PostCachedPreview();
+			return;
+		}
+	}
 	if( pCmd->Run( &m_StringList, whatIf, force ) )
 		MainFrame()->UpdateStatus( LoadStringResource(IDS_FILE_SYNC) );
 	else
@@ -311,6 +311,7 @@ public:
 	//		called by mainframe to initiate updates of depot view
 	//
 	void OnViewUpdate( BOOL redrill, int key=0 );
+	void UpdateChangeWnd( int key );
 		
 	//		Expand an entire path. TRUE=new path in path; FALSE continue expanding old path
 	//
@@ -43,6 +43,7 @@ CDiff2Output::CDiff2Output(CWnd* pParent)
 	//{{AFX_DATA_INIT(CDiff2Output)
 	//}}AFX_DATA_INIT
 	m_pParent = pParent;
+	m_pCompare = NULL;
 	if (m_pParent)
 		MainFrame()->SetModelessWnd(this);
 	m_InitRect.SetRect(0,0,100,100);
@@ -56,6 +57,7 @@ CDiff2Output::~CDiff2Output()
 	CMainFrame * mainWnd = MainFrame();
 	if (mainWnd)
 		mainWnd->SetGotUserInput( );
+	delete m_pCompare;
 }
 
 void CDiff2Output::DoDataExchange(CDataExchange* pDX)
@@ -74,6 +76,7 @@ BEGIN_MESSAGE_MAP(CDiff2Output, CDialog)
 	ON_WM_GETMINMAXINFO()
 	ON_NOTIFY(NM_DBLCLK, IDC_LIST, OnDblclickP4list)
 	ON_NOTIFY(LVN_ITEMCHANGED, IDC_LIST, OnItemchangedP4List)
+	ON_NOTIFY(LVN_GETDISPINFO, IDC_LIST, OnGetdispinfoP4List)
 	ON_BN_CLICKED(ID_DIFF2, OnDiff2)
 	ON_WM_CLOSE()
 	ON_WM_DESTROY()
@@ -251,17 +254,11 @@ BOOL CDiff2Output::OnInitDialog()
 
 void CDiff2Output::AddTheListData(int lgthHdr1, int lgthHdr2)
 {
-	// Add the data
+	// Parse diff2's output into the rows; a local folder compare
+	// already has its rows
 	int i;
-	LV_ITEM lvItem;
-	LPARAM  lParam;
-	int iActualItem = -1;
-
-	int maxwcol2 = m_ListCtrl.GetStringWidth(m_ColNames->GetAt(1)) + 20;
-
-	int iItem = 0;
 	CString msg = m_Msg;
-	while ((i = msg.Find(_T('\n'))) != -1)
+	while (!m_pCompare && (i = msg.Find(_T('\n'))) != -1)
 	{
 		CString line = msg.Left(i);
 		line.TrimLeft(_T(" =\t\r\n"));
@@ -291,7 +288,7 @@ void CDiff2Output::AddTheListData(int lgthHdr1, int lgthHdr2)
 		}
 		col2txt.TrimRight(_T(" =\t\r\n"));
 
-		lParam = 1;							// 1 -> can diff 2 files
+		BYTE canDiff = 1;					// 1 -> can diff 2 files
 		if (col1txt.GetAt(0) == _T('/'))
 		{
 			if (col1txt.Find(m_Hdr1) == 0)
@@ -300,7 +297,7 @@ void CDiff2Output::AddTheListData(int lgthHdr1, int lgthHdr2)
 		else
 		{
 			col1txt = _T("   ") + col1txt;
-			lParam = 0;						// 0 -> cannot diff 2 files
+			canDiff = 0;					// 0 -> cannot diff 2 files
 		}
 		if (col2txt.GetAt(0) == _T('/'))
 		{
@@ -310,30 +307,23 @@ void CDiff2Output::AddTheListData(int lgthHdr1, int lgthHdr2)
 		else
 		{
 			col2txt = _T("   ") + col2txt;
-			lParam = 0;						// 0 -> cannot diff 2 files
+			canDiff = 0;					// 0 -> cannot diff 2 files
 		}
 
-		maxwcol2 = max(maxwcol2, m_ListCtrl.GetStringWidth(col2txt)+20);
-
-		for(int subItem=0; subItem < 2; subItem++)
-		{
-			lvItem.mask=LVIF_TEXT | 
-					((subItem==0) ? LVIF_IMAGE : 0) |
-					((subItem==0) ? LVIF_PARAM : 0);
-			lvItem.iItem = (subItem==0) ? iItem : iActualItem;
-            ASSERT(lvItem.iItem != -1);
-			lvItem.iSubItem = subItem;
-			lvItem.lParam = lParam;
-			lvItem.pszText = const_cast<LPTSTR>( subItem==0 ? (LPCTSTR)col1txt : (LPCTSTR)col2txt);
-
-			if(subItem==0)
-				iActualItem=m_ListCtrl.InsertItem(&lvItem);
-			else
-				m_ListCtrl.SetItem(&lvItem);
-		}
-		iItem++;
+		m_Col1.Add(col1txt);
+		m_Col2.Add(col2txt);
+		m_CanDiff.Add(canDiff);
 	}
 
+	// The list is virtual: it asks for the text of just the rows it shows
+	int nRows = GetRowCount();
+	m_ListCtrl.SetItemCountEx(nRows, LVSICF_NOINVALIDATEALL);
+
+	// Size the second column to fit the first screenfuls of rows
+	int maxwcol2 = m_ListCtrl.GetStringWidth(m_ColNames->GetAt(1)) + 20;
+	for (i = 0; i < min(nRows, 1000); i++)
+		maxwcol2 = max(maxwcol2, m_ListCtrl.GetStringWidth(GetColumnText(i, 1))+20);
+
 	int w = GetSystemMetrics(SM_CXVSCROLL);
 	CRect rect;
 	m_ListCtrl.GetWindowRect(&rect);
@@ -345,6 +335,41 @@ void CDiff2Output::AddTheListData(int lgthHdr1, int lgthHdr2)
 	m_ListCtrl.SetFocus();
 }
 
+int CDiff2Output::GetRowCount()
+{
+	return m_pCompare ? m_pCompare->GetRowCount() : (int) m_Col1.GetSize();
+}
+
+CString CDiff2Output::GetColumnText(int row, int col)
+{
+	if (!m_pCompare)
+		return col ? m_Col2[row] : m_Col1[row];
+
+	CString txt = m_pCompare->GetFileText(col, row);
+	return txt.GetAt(0) == _T('<') ? _T("   ") + txt : txt;
+}
+
+BOOL CDiff2Output::CanDiff(int row)
+{
+	if (row < 0 || row >= GetRowCount())
+		return FALSE;
+	return m_pCompare ? m_pCompare->GetRow(row).m_Status == FOLDER_DIFFERENT : m_CanDiff[row];
+}
+
+void CDiff2Output::OnGetdispinfoP4List(NMHDR* pNMHDR, LRESULT* pResult) 
+{
+	LV_DISPINFO *pDispInfo = (LV_DISPINFO*)pNMHDR;
+	LV_ITEM *pItem = &pDispInfo->item;
+	*pResult = 0;
+
+	if (pItem->iItem < 0 || pItem->iItem >= GetRowCount())
+		return;
+	if (pItem->mask & LVIF_TEXT)
+		lstrcpyn(pItem->pszText, GetColumnText(pItem->iItem, pItem->iSubItem), pItem->cchTextMax);
+	if (pItem->mask & LVIF_PARAM)
+		pItem->lParam = CanDiff(pItem->iItem);
+}
+
 void CDiff2Output::OnOK() 
 {
 	OnCancel();
@@ -552,7 +577,7 @@ void CDiff2Output::OnItemchangedP4List(NMHDR* pNMHDR, LRESULT* pResult)
 	int index = m_ListCtrl.GetNextSelectedItem(pos);
 	CWnd *ctl = GetDlgItem(ID_DIFF2);
 	ctl->UpdateWindow();
-	BOOL enable = m_ListCtrl.GetItemData(index) != 0;
+	BOOL enable = CanDiff(index);
 	if(enable != ctl->IsWindowEnabled())
 		ctl->EnableWindow(enable);	// 0 -> cannot diff; 1 -> can diff
 }
@@ -570,7 +595,7 @@ void CDiff2Output::OnDiff2()
 	if (!pos)
 		return;
 	int index = m_ListCtrl.GetNextSelectedItem(pos);
-	if (!m_ListCtrl.GetItemData(index))	// 0 -> cannot diff; 1 -> can diff
+	if (!CanDiff(index))	// 0 -> cannot diff; 1 -> can diff
 	{
 		MessageBeep(0);
 		return;
@@ -643,14 +668,12 @@ void CDiff2Output::OnContextMenu(CWnd* pWnd, CPoint point)
 	// make a new selection new if reqd
 	if(m_ListCtrl.GetItemState(index,LVIS_SELECTED) != LVIS_SELECTED)
 	{
-		for(int i=m_ListCtrl.GetItemCount(); i>=0; i-- )
-			m_ListCtrl.SetItemState(i, 0, LVIS_SELECTED);
-		
+		m_ListCtrl.SetItemState(-1, 0, LVIS_SELECTED);
 		m_ListCtrl.SetItemState(index, LVIS_SELECTED, LVIS_SELECTED);
 	}
 
 	LPARAM b;
-	if ((b = m_ListCtrl.GetItemData(index)) > 0)	// 0 -> cannot diff; 1 -> can diff
+	if ((b = CanDiff(index)) > 0)	// 0 -> cannot diff; 1 -> can diff
 	{
 		popMenu.AppendMenu(MF_ENABLED | MF_STRING, ID_DIFF2, LoadStringResource(IDS_DIFFTHE2FILES));
 		popMenu.AppendMenu(MF_SEPARATOR);
@@ -1095,7 +1118,7 @@ void CDiff2Output::OnSinglePaneView()
 	CSpecDescDlg *dlg = new CSpecDescDlg(m_pParent);
 	dlg->SetIsModeless(TRUE);
 	dlg->SetKey(m_Key);
-	dlg->SetDescription( m_Msg );
+	dlg->SetDescription( m_pCompare ? m_pCompare->GetText() : m_Msg );
 	dlg->SetItemName( m_OrigHdr1 + _T("... <> ") + m_OrigHdr2 + _T("...") );
 	dlg->SetCaption( m_caption );
 	dlg->SetViewType(P4DESCRIBE);
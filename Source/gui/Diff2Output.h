@@ -5,6 +5,7 @@
 #define __DIFF2OUTPUT_DIALOG_HDR
 
 #include "WinPos.h"
+#include "P4FolderCompare.h"
 
 /////////////////////////////////////////////////////////////////////////////
 // CDiff2Output dialog
@@ -27,6 +28,7 @@ public:
 	void SetCaption(CString caption) { m_caption = caption; }
 	void SetMsg(CString msg) { m_Msg = msg; }
 	void SetKey(int key) { m_Key = key; }
+	void SetFolderCompare(CP4FolderCompare *pCompare) { m_pCompare = pCompare; }
 
 protected:
 	CWnd* m_pParent;
@@ -37,6 +39,13 @@ protected:
 	int m_Key;
 	int m_SubItem;
 
+	// The rows of the (virtual) list: either from a local folder compare,
+	// or parsed from diff2's output
+	CP4FolderCompare *m_pCompare;
+	CStringArray m_Col1;
+	CStringArray m_Col2;
+	CByteArray m_CanDiff;
+
 	CString m_ItemStr;
 	CStringList m_StringList;
 	CString m_Viewer;
@@ -66,6 +75,9 @@ protected:
 	void RestoreSavedWidths(int *width, int numcols);
 	void SaveColumnWidths();
 	void AddTheListData(int lgthHdr1, int lgthHdr2);
+	int  GetRowCount();
+	CString GetColumnText(int row, int col);
+	BOOL CanDiff(int row);
 	CString ParseFileInfo(CString *itemStr, int *rev=NULL, CString *filetype=NULL);
 	BOOL PumpMessages( );
 
@@ -80,6 +92,7 @@ protected:
 	afx_msg void OnSysCommand(UINT nID, LPARAM lParam);
 	afx_msg void OnDblclickP4list(NMHDR* pNMHDR, LRESULT* pResult);
 	afx_msg void OnItemchangedP4List(NMHDR* pNMHDR, LRESULT* pResult);
+	afx_msg void OnGetdispinfoP4List(NMHDR* pNMHDR, LRESULT* pResult);
 //	afx_msg void OnHelp();
 //	afx_msg BOOL OnHelpInfo(HELPINFO* pHelpInfo);
 	afx_msg void OnContextMenu(CWnd* pWnd, CPoint point);
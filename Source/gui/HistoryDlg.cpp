@@ -66,6 +66,7 @@ CHistoryDlg::CHistoryDlg(CWnd* pParent /*=NULL*/)
 	m_More = FALSE;
 	m_pFRDlg = NULL;
 	m_FindWhatFlags = FR_DOWN | FR_HIDEWHOLEWORD;
+	m_pPrefetcher = new CP4Prefetcher;
 }
 
 CHistoryDlg::~CHistoryDlg()
@@ -612,24 +613,7 @@ CString CHistoryDlg::WriteTempHistFile()
 		if (m_InitialName == rev->m_FName)
 		{
 			b = TRUE;
-			CString chgType = rev->m_ChangeType;
-			CString integs = _T("");
-			if ((i = chgType.Find(_T(": "))) != -1)
-			{
-				integs = chgType.Mid(i + 2);
-				chgType = chgType.Left(i);
-			}
-			str.Format(_T("... #%d change %d %s on %s by %s %s"), 
-				rev->m_RevisionNum, rev->m_ChangeNum, chgType, 
-				rev->m_Date, rev->m_User, rev->m_ChangeDescription);
-			str.Replace(_T("\n"), _T("\n        "));
-			if (integs.GetLength() > 0)
-			{
-				integs.Replace(_T("; "), _T("\n... ... "));
-				str += _T("\n\n... ... ") + integs;
-			}
-			str += _T("\n\n");
-			str.Remove(_T('\r'));
+			str = rev->GetFilelogText();
 			sptr.Set(const_cast<char*>((const char*)CharFromCString(str)));
 			pOutputFile->Write( &sptr, &e );
 			if(e.Test())
@@ -1411,6 +1395,8 @@ BOOL CHistoryDlg::OnInitDialog()
 	CString txt;
 	BOOL bMultiFileNames = FALSE;
 	int	fnbr= 0;
+	m_ListCtl.SetRedraw(FALSE);		// thousands of rows go in faster unpainted
+	m_ListCtl.SetItemCount((int)m_pHistory->GetRevisionCount());
 	for(int iItem=0; iItem < m_pHistory->GetRevisionCount(); iItem++)
 	{
 		if(iItem==0)
@@ -1497,6 +1483,7 @@ BOOL CHistoryDlg::OnInitDialog()
 	
 	// Sort the list
 	m_ListCtl.Sort( m_LastSortColumn = bMultiFileNames ? 1 : 0, m_SortAscending );
+	m_ListCtl.SetRedraw(TRUE);
 	
 	// Make sure desired item is selected
 	int iPos = 0;
@@ -1676,6 +1663,8 @@ void CHistoryDlg::OnItemchangedRevlist(NMHDR* pNMHDR, LRESULT* pResult)
 		GetDlgItem(IDC_ACTIONLABEL)->SetWindowText(txt);
 		txt.FormatMessage(IDS_SUMMARYLABEL, ((CRevision *) pNMListView->lParam)->m_ChangeNum);
 		GetDlgItem(IDC_SUMMARYLABEL)->SetWindowText(txt);
+
+		PrefetchNeighbors((CRevision *) pNMListView->lParam);
 	}
 
 	EnableButtons();
@@ -1684,6 +1673,60 @@ void CHistoryDlg::OnItemchangedRevlist(NMHDR* pNMHDR, LRESULT* pResult)
 }
 
 
+// The next thing the user does is nearly always to browse this revision or
+// diff it against the one before or after, so get all three into the
+// revision cache in the background while they decide.  The list may be
+// sorted any which way and hold other files' revisions too, so the
+// neighbors are found by revision number.
+void CHistoryDlg::PrefetchNeighbors(CRevision *sel)
+{
+	if (!m_pPrefetcher || !m_pPrefetcher->IsEnabled() || !sel)
+		return;
+
+	CRevision *prev = NULL;
+	CRevision *next = NULL;
+	for (int i = 0; i < m_ListCtl.GetItemCount(); i++)
+	{
+		CRevision *rev = (CRevision *) m_ListCtl.GetItemData(i);
+		if (!rev || rev->m_FName != sel->m_FName)
+			continue;
+		if (rev->m_RevisionNum < sel->m_RevisionNum
+		 && (!prev || rev->m_RevisionNum > prev->m_RevisionNum))
+			prev = rev;
+		else if (rev->m_RevisionNum > sel->m_RevisionNum
+		 && (!next || rev->m_RevisionNum < next->m_RevisionNum))
+			next = rev;
+	}
+
+	m_pPrefetcher->ClearQueue();
+	PrefetchRev(sel);
+	PrefetchRev(next);
+	PrefetchRev(prev);
+	m_pPrefetcher->Start();
+}
+
+void CHistoryDlg::PrefetchRev(CRevision *rev)
+{
+	// deleted revisions (including move/delete) have nothing to print
+	if (!rev || rev->m_ChangeType.Find(_T("delete")) != -1
+			 || rev->m_ChangeType.Find(_T("purge")) == 0)
+		return;
+
+	// Use the type the revision was submitted as, just as OnDiff2() does
+	CString ftype;
+	int j;
+	if ((j = rev->m_ChangeDescription.Find(_T(')'))) != -1)
+		ftype = rev->m_ChangeDescription.Left(j+1);
+	if ((ftype.GetLength() > 1) && (ftype.GetAt(0) == _T('(')) && (ftype.Find(_T(' ')) == -1))
+	{
+		ftype.TrimLeft(_T('('));
+		ftype.TrimRight(_T(')'));
+	}
+	else ftype = m_FileType;
+
+	m_pPrefetcher->Add(rev->m_FName, rev->m_RevisionNum, ftype);
+}
+
 void CHistoryDlg::EnableButtons()
 {
 	if(m_Busy)
@@ -2372,6 +2415,11 @@ void CHistoryDlg::OnPerforceOptions()
 // to MainFrame which will delete the 'this' object
 void CHistoryDlg::OnDestroy()
 {
+	if (m_pPrefetcher)
+	{
+		m_pPrefetcher->Release();
+		m_pPrefetcher = NULL;
+	}
 	if (m_pParent)
 		::PostMessage(MainFrame()->m_hWnd, WM_P4DLGDESTROY, 0, (LPARAM)this);
 }
@@ -13,6 +13,7 @@
 #include "sortlistheader.h"
 #include "WinPos.h"
 #include "cmd_history.h"
+#include "P4Prefetcher.h"
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -124,6 +125,8 @@ protected:
 	CString m_FindWhatStr;
 	int m_FindWhatFlags;
 
+	CP4Prefetcher *m_pPrefetcher;
+
 // Overrides
 	// ClassWizard generated virtual function overrides
 	//{{AFX_VIRTUAL(CHistoryDlg)
@@ -215,6 +218,8 @@ protected:
 	void SaveColumnWidths();
 	void RestoreSavedWidths(int *width, int numcols);
 	void SizeBottonOfHistory(int x, int y);
+	void PrefetchNeighbors(CRevision *sel);
+	void PrefetchRev(CRevision *rev);
 	CString WriteTempHistFile();
 
 	DECLARE_MESSAGE_MAP()
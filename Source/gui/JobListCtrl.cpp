@@ -33,6 +33,16 @@ static char THIS_FILE[] = __FILE__;
 
 #define IMG_INDEX(x) (x-IDB_PERFORCE)
 
+#define JOBSTOREMAXAGE	1200000		// ms before the job store is loaded afresh,
+									// which is when deleted jobs drop out of it
+
+// The -m that CCmd_Jobs will use, or 0 for all jobs
+static int GetJobLimit()
+{
+	return (!GET_P4REGPTR()->GetFetchAllJobs() && GET_P4REGPTR()->GetFetchJobCount() > 0)
+			? GET_P4REGPTR()->GetFetchJobCount() : 0;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // CJobListCtrl
 
@@ -99,6 +109,7 @@ CJobListCtrl::CJobListCtrl()
 	m_PostListToChangeWnd= 0;
 	m_Need2DoNew = FALSE;
 	m_NewJob = FALSE;
+	m_StoreFetch = STORE_NONE;
     m_ColCodes.RemoveAll();
     m_captionplain = LoadStringResource(IDS_PERFORCE_JOBS);
 
@@ -146,6 +157,7 @@ LRESULT CJobListCtrl::OnClear( WPARAM wParam, LPARAM lParam )
 {
 	m_sFilter.Empty( );
 	PersistentJobFilter( KEY_READ );
+	m_JobStore.Clear();
 	Clear();
 	return 0;
 }
@@ -499,6 +511,40 @@ LRESULT CJobListCtrl::OnP4JobList(WPARAM wParam, LPARAM lParam)
 
 	CCmd_Jobs *pCmd= (CCmd_Jobs *) wParam;
 
+	if(m_StoreFetch != STORE_NONE)
+	{
+		BOOL refresh = m_StoreFetch == STORE_REFRESH;
+		m_StoreFetch = STORE_NONE;
+		if(!pCmd->GetError())
+		{
+			// If the server stopped at the -m limit, the store doesn't
+			// have every job
+			jobs= pCmd->GetList();
+			int limit = GetJobLimit();
+			BOOL full = limit && jobs->GetCount() >= limit;
+			if (refresh)
+				m_JobStore.Merge(jobs);
+			else
+				m_JobStore.Load(jobs, !full);
+			delete pCmd;
+
+			if (refresh && full)
+			{
+				// Too many jobs changed to catch up with, so start again
+				m_JobStore.Clear();
+				GetJobs();
+			}
+			else if (FillFromStore())
+				FinishJobList(TRUE);
+			else
+				GetJobs(FALSE);
+			return 0;
+		}
+		delete pCmd;
+		FinishJobList(FALSE);
+		return 0;
+	}
+
 	if(!pCmd->GetError())
 	{
 		SET_BUSYCURSOR();
@@ -527,15 +573,30 @@ LRESULT CJobListCtrl::OnP4JobList(WPARAM wParam, LPARAM lParam)
 		}
         SetRedraw(TRUE);
 
+		////jobs->RemoveAll();
+
+		FinishJobList(TRUE);
+		::SetCursor(::LoadCursor(NULL, IDC_ARROW));
+	}
+	else
+		FinishJobList(FALSE);
+	
+    delete pCmd;
+	return 0;
+}
+
+// Everything that follows filling the list, from the server or the store
+void CJobListCtrl::FinishJobList( BOOL bOK )
+{
+	if(bOK)
+	{
 		CString msg;
-		msg.FormatMessage(IDS_NUMBER_OF_JOBS_n, index );
+		msg.FormatMessage(IDS_NUMBER_OF_JOBS_n, GetItemCount() );
 		AddToStatus( msg, SV_COMPLETION );
 
-		////jobs->RemoveAll();
-
 		ReSort();
 	
-		if(jobs->GetCount() > 0)
+		if(GetItemCount() > 0)
 		{
 			int i = FindInList(m_Active);
 			if (i < 0)	i=0;
@@ -546,7 +607,6 @@ LRESULT CJobListCtrl::OnP4JobList(WPARAM wParam, LPARAM lParam)
 		CP4ListCtrl::SetUpdateDone();
 		if (m_Need2DoNew)
 			OnJobNew();
-		::SetCursor(::LoadCursor(NULL, IDC_ARROW));
 	}
 	else
 	{
@@ -561,14 +621,11 @@ LRESULT CJobListCtrl::OnP4JobList(WPARAM wParam, LPARAM lParam)
 		m_PostListToChangeWnd= 0;
     }
 	
-    delete pCmd;
 	MainFrame()->ClearStatus();
 
 	// Notify the mainframe that we have finished getting the jobs,
 	// hence the entire set of async command have finished.
 	MainFrame()->ExpandDepotIfNeedBe();
-
-	return 0;
 }
 
 /*
@@ -636,8 +693,15 @@ void CJobListCtrl::GetJobSpec( )
 }
 
 
-void CJobListCtrl::GetJobs( )
+void CJobListCtrl::GetJobs( BOOL bUseStore/*=TRUE*/ )
 {
+	// Once the store is known not to hold every job, a filter must go
+	// to the server
+	if( bUseStore && UseJobStore( )
+	 && (m_sFilter.IsEmpty() || !m_JobStore.IsLoaded() || m_JobStore.IsComplete())
+	 && GetStoreJobs( ) )
+		return;
+
 	CCmd_Jobs *pCmd = new CCmd_Jobs;
 	pCmd->Init( m_hWnd, RUN_ASYNC);
 	
@@ -691,6 +755,111 @@ void CJobListCtrl::GetJobs( )
 }
 
 
+// The store is only used for expression filters: a file filter needs the
+// server, and only tagged output carries every field
+BOOL CJobListCtrl::UseJobStore( )
+{
+	return GET_P4REGPTR()->GetLocalJobQuery() && GET_SERVERLEVEL() >= 8
+		&& m_FilterView.IsEmpty() && !m_Spec.IsEmpty();
+}
+
+// Fetches every field of every job into the store, or, if the store is
+// recent enough, just the jobs modified since it was last brought up to date
+BOOL CJobListCtrl::GetStoreJobs( )
+{
+	m_JobStore.SetSpec( m_Spec );
+	if( !m_JobStore.GetFieldNames().GetSize() )
+		return FALSE;
+
+	BOOL refresh = m_JobStore.CanRefresh() && m_JobStore.GetAge() < JOBSTOREMAXAGE;
+	CString filter;
+	if( refresh )
+		filter = m_JobStore.GetNewerFilter();
+
+	CCmd_Jobs *pCmd = new CCmd_Jobs;
+	pCmd->Init( m_hWnd, RUN_ASYNC);
+	pCmd->SetFilter( refresh );
+	pCmd->GetFieldNames().Copy(m_JobStore.GetFieldNames());
+	pCmd->GetFieldCodes().Copy(m_JobStore.GetFieldCodes());
+	if( pCmd->Run( refresh ? LPCTSTR(filter) : NULL, FALSE ) )
+	{
+		m_StoreFetch = refresh ? STORE_REFRESH : STORE_LOAD;
+		CP4ListCtrl::OnViewUpdate();
+		MainFrame()->UpdateStatus( LoadStringResource(IDS_REQUESTING_JOBS_LISTING) );
+	}
+	else
+		delete pCmd;
+	return TRUE;
+}
+
+static int compareJobNamesDown(const void *arg1, const void *arg2)
+{
+	return _tcscmp(*(LPCTSTR *) arg2, *(LPCTSTR *) arg1);
+}
+
+// Fills the list with the jobs in the store that match the filter.  Returns
+// FALSE if the store can't answer it, and the server must be asked.
+BOOL CJobListCtrl::FillFromStore( )
+{
+	if( !m_JobStore.IsLoaded() || (!m_JobStore.CanAnswer() && !m_sFilter.IsEmpty()) )
+		return FALSE;
+
+	CDWordArray found;
+	if( !m_JobStore.Query( m_sFilter, found ) )
+		return FALSE;
+
+	// Show no more than the server would have sent for 'jobs -m -r':
+	// the highest named jobs
+	int limit = GetJobLimit();
+	INT_PTR count = found.GetSize();
+	LPCTSTR *names = NULL;
+	if( limit && count > limit )
+	{
+		names = new LPCTSTR[count];
+		CMapStringToPtr jobOf;
+		for( INT_PTR i = 0; i < count; i++ )
+		{
+			names[i] = m_JobStore.GetJobName( (int) found[i] );
+			jobOf.SetAt( names[i], (void *)(INT_PTR) found[i] );
+		}
+		qsort( names, count, sizeof(LPCTSTR), compareJobNamesDown );
+		count = limit;
+		for( INT_PTR i = 0; i < count; i++ )
+		{
+			void *p;
+			jobOf.Lookup( names[i], p );
+			found[i] = (DWORD)(INT_PTR) p;
+		}
+		delete [] names;
+	}
+
+	Clear();
+	SetRedraw(FALSE);
+	for( int i = 0; i < count; i++ )
+	{
+		CP4Job *job = m_JobStore.MakeJob( (int) found[i] );
+		job->ConvertToColumns( m_ColCodes, m_ColNames, m_FieldNames );
+		InsertJob( job, i );
+	}
+	SetRedraw(TRUE);
+	return TRUE;
+}
+
+// A new filter is answered from the store when it can be; if not, the
+// list is fetched again
+void CJobListCtrl::ApplyFilter( )
+{
+	m_Active = GetSelectedItemText();
+	if( UseJobStore( ) && m_JobStore.CanAnswer( ) && FillFromStore( ) )
+	{
+		SetCaption( );
+		FinishJobList( TRUE );
+	}
+	else
+		OnViewUpdate( );
+}
+
+
 /*
 	_________________________________________________________________
 */
@@ -892,6 +1061,8 @@ LRESULT CJobListCtrl::OnP4EndSpecEdit( WPARAM wParam, LPARAM lParam )
 				m_pNewSpec->SetJobStatus(JOB_OPEN);
 		}
 
+		// The store learns the new values, and date, on its next refresh
+		m_JobStore.SetStale();
 		m_pNewSpec->ConvertToColumns(m_ColCodes, m_ColNames, m_FieldNames);
 		if(m_NewJob & (FindInList(pCmd->GetNewJobName()) == -1) )
 		{
@@ -999,7 +1170,7 @@ void CJobListCtrl::OnJobSetFilter()
 	{
 		m_sFilter = dlg.GetFilterString ( );
 		PersistentJobFilter( KEY_WRITE );
-		OnViewUpdate( );	
+		ApplyFilter( );	
 	}
 }
 
@@ -1014,7 +1185,7 @@ void CJobListCtrl::OnJobRemovefilter()
 {
 	m_sFilter.Empty ( );
 	PersistentJobFilter( KEY_WRITE );
-	OnViewUpdate( );
+	ApplyFilter( );
 }
 
 
@@ -1056,6 +1227,14 @@ void CJobListCtrl::PersistentJobFilter( REGSAM accessmask )
 	}
 }
 
+LRESULT CJobListCtrl::OnP4Delete( WPARAM wParam, LPARAM lParam )
+{
+	CCmd_Delete *pCmd = ( CCmd_Delete * )wParam;
+	if(!pCmd->GetError())
+		m_JobStore.Remove( m_Active );
+	return CP4ListCtrl::OnP4Delete( wParam, lParam );
+}
+
 void CJobListCtrl::OnUpdateJobConfigure(CCmdUI* pCmdUI) 
 {
 	pCmdUI->Enable(MainFrame()->SetMenuIcon(pCmdUI, !SERVER_BUSY()));
@@ -11,6 +11,7 @@
 
 #include "P4ListCtrl.h"
 #include "P4Job.h"
+#include "P4JobStore.h"
 
 // Note: this value must be <= MAX_P4OBJECTS_COLUMNS in P4ListCtrl.h
 #define	MAX_JOBS_COLUMNS	16
@@ -44,6 +45,11 @@ protected:
 	CStringList m_StrList;		// Temp string list
 	BOOL m_Need2CallOnJobConfigure;	// Need to call OnJobConfigure() after getting spec
 
+	// Every job is kept locally so filters and column changes can be
+	// answered without the server; see P4JobStore.h
+	CP4JobStore m_JobStore;
+	enum { STORE_NONE, STORE_LOAD, STORE_REFRESH } m_StoreFetch;	// fetch in progress
+
 	// Internal clipboard formats
 	CLIPFORMAT m_CF_JOB;
 	CLIPFORMAT m_CF_DEPOT;
@@ -66,8 +72,13 @@ private:
 	int GetFieldNbr( CString str, const CString &spec );
 	LRESULT OnP4JobSpecColumnNames( WPARAM wParam, LPARAM lParam );
 	BOOL m_bAlreadyGotColumns;
-	void GetJobs( );
+	void GetJobs( BOOL bUseStore = TRUE );
 	void GetJobSpec( );
+	BOOL UseJobStore( );
+	BOOL GetStoreJobs( );
+	BOOL FillFromStore( );
+	void FinishJobList( BOOL bOK );
+	void ApplyFilter( );
 
 
 protected:
@@ -132,6 +143,7 @@ protected:
 	afx_msg void OnPerforceOptions();
 	LRESULT OnP4JobSpec(WPARAM wParam, LPARAM lParam);
 	LRESULT OnP4EndSpecEdit(WPARAM wParam, LPARAM lParam);
+	LRESULT OnP4Delete(WPARAM wParam, LPARAM lParam);
 	LRESULT OnP4JobList(WPARAM wParam, LPARAM lParam);
     LRESULT OnQueryJobs( WPARAM wParam, LPARAM lParam );
     LRESULT OnQueryJobSpec( WPARAM wParam, LPARAM lParam );
@@ -504,7 +504,7 @@ void CLabelListCtrl::OnViewUpdate()
 {
 	m_Active = GetSelectedItemText();
 	CCmd_Labels *pCmd= new CCmd_Labels;
-	pCmd->Init( m_hWnd, RUN_ASYNC);
+	InitUpdateCmd(pCmd);
 
 	if (GET_SERVERLEVEL() >= 11)
 	{
@@ -22,6 +22,7 @@
 #include "cmd_info.h"
 #include "cmd_listopstat.h"
 #include "Cmd_Logout.h"
+#include "Cmd_ChangeCheck.h"
 #include "Cmd_Opened.h"
 #include "cmd_refresh.h"
 #include "cmd_where.h"
@@ -39,6 +40,8 @@
 #include "ImageList.h"
 #include "OptionsTreeDlg.h"
 #include "SpecDescDlg.h"
+#include "P4ResolvePreview.h"
+#include "P4StreamDiff.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -56,6 +59,23 @@ UINT wmRplycmd;
 //#define MAKEID(x) (m_wndHRSplitter.IdFromRowCol(0,0)+16*x +1)
 #define MAKEID(x) (m_wndVSplitter.IdFromRowCol(0,1)+16*x +1)
 
+// Auto-polls in a row that find nothing changed before refreshing anyway,
+// to pick up what the change check can't see, like other users' opens
+#define CHANGECHECK_MAXSKIPS	10
+
+// The opened files are only compared on every this many change checks,
+// since listing them costs far more than the other queries
+#define CHANGECHECK_OPENEDEVERY	5
+
+// A change check slower than this, and several times slower than the
+// fastest one seen, means the server is busy
+#define CHANGECHECK_BUSYMS		2000
+#define CHANGECHECK_BUSYRATIO	3
+
+// How far the poll interval may be moved at random, in tenths of a
+// percent, so clients started together don't keep polling together
+#define AUTOPOLL_JITTER			100
+
 /////////////////////////////////////////////////////////////////////////////
 // CTBDropTarget
 
@@ -275,8 +295,13 @@ BEGIN_MESSAGE_MAP(CMainFrame, CFrameWnd)
 	ON_MESSAGE(WM_STATUSCLEAR, OnStatusClear )
 	ON_MESSAGE(WM_CLIENTERROR, OnClientError )
 	ON_MESSAGE(WM_P4LISTOPSTAT, OnP4ListOp )
+	ON_MESSAGE(WM_P4CHANGECHECK, OnP4ChangeCheck )
 	ON_MESSAGE(WM_P4FILEINFORMATION, OnP4FileInformation )
 	ON_MESSAGE(WM_P4DIFF, OnP4Diff )
+	ON_MESSAGE(WM_SHOWQUICKDIFF, OnShowQuickDiff )
+	ON_MESSAGE(WM_P4ENDDESCRIBE, OnP4EndQuickDiff )
+	ON_MESSAGE(WM_DIFFPROGRESS, OnDiffProgress )
+	ON_MESSAGE(WM_SYNCPROGRESS, OnSyncProgress )
 	ON_MESSAGE(WM_NEWCLIENT, OnNewClient )
 	ON_MESSAGE(WM_NEWUSER, OnNewUser )
 	ON_MESSAGE(WM_USERPSWDDLG, OnUserPasswordDlg )
@@ -312,6 +337,14 @@ CMainFrame::CMainFrame()
 	m_FullRefreshRequired= TRUE;
 	m_pStatusView= NULL;
 	m_DoNotAutoPollCtr=0;
+	m_pChangeState= NULL;
+	m_ChangeCheckSkips= m_OpenedCheckSkips= 0;
+	m_pResolvePreview= NULL;
+	m_IdlePolls= m_PollShift= 0;
+	m_ServerBusy= FALSE;
+	m_CheckStart= m_CheckLatency= m_CheckFastest= 0;
+	srand(GetTickCount() ^ GetCurrentProcessId());
+	m_PollJitter= rand() % (2*AUTOPOLL_JITTER+1) - AUTOPOLL_JITTER;
 	m_Timer=0;
 	m_LastUpdateTime=0;
     m_LastUpdateResult=UPDATE_SUCCESS;
@@ -321,6 +354,8 @@ CMainFrame::CMainFrame()
 	m_InPopUpMenu = FALSE;
 	m_GetCliRootAndContinue = 0;
 	m_Need2ExpandDepot = m_Need2Poll4Jobs = 0;
+	m_DepotExpandDeferred = FALSE;
+	m_pStartupRetry = NULL;
 	m_P4QTree = m_P4TLV = 0;
 	m_StatusBarWarnLevel = SV_MSG;
 	m_CF_FILENAME = RegisterClipboardFormat(_T("FileName"));
@@ -349,6 +384,8 @@ CMainFrame::CMainFrame()
 CMainFrame::~CMainFrame()
 {
 	delete m_pDropTgt;
+	delete m_pChangeState;
+	delete m_pResolvePreview;
 	if (m_USER32dll)
 		FreeLibrary(m_USER32dll);
 }
@@ -733,7 +770,7 @@ int CMainFrame::OnCreate(LPCREATESTRUCT lpCreateStruct)
 	else	// normal operation
 	{
 		//	Run the initial update of depot and changelist panes
-		UpdateDepotandChangeViews(NO_REDRILL);
+		StartupLoad(NO_REDRILL);
 		m_Need2ExpandDepot = GET_P4REGPTR()->GetExpandFlag();
 	}
 	return 0;
@@ -953,6 +990,59 @@ LRESULT CMainFrame::OnP4Diff(WPARAM wParam, LPARAM lParam)
 	return 0;
 }
 
+// Posted by CP4DiffEngine::QuickDiff() with the caption, the diff text and
+// the item name of the window to show
+LRESULT CMainFrame::OnShowQuickDiff(WPARAM wParam, LPARAM lParam)
+{
+	CStringArray *pArgs = (CStringArray *) lParam;
+
+	CSpecDescDlg *dlg = new CSpecDescDlg(this);
+	dlg->SetIsModeless(TRUE);
+	dlg->SetKey(0);
+	dlg->SetDescription(pArgs->GetAt(1), FALSE);
+	dlg->SetItemName(pArgs->GetAt(2));
+	dlg->SetCaption(pArgs->GetAt(0));
+	dlg->SetViewType(P4DESCRIBE);
+	if (!dlg->Create(IDD_SPECDESC, this))	// display the description dialog box
+	{
+		dlg->DestroyWindow();	// some error! clean up
+		delete dlg;
+	}
+	delete pArgs;
+	return 0;
+}
+
+LRESULT CMainFrame::OnP4EndQuickDiff(WPARAM wParam, LPARAM lParam)
+{
+	CSpecDescDlg *dlg = (CSpecDescDlg *)lParam;
+	dlg->DestroyWindow();
+	return TRUE;
+}
+
+// Posted by CP4StreamDiff as it works through a pair of large files
+LRESULT CMainFrame::OnDiffProgress(WPARAM wParam, LPARAM lParam)
+{
+	int percent = (int) wParam;
+	if (percent < 0)
+		ClearStatus();
+	else
+	{
+		CString txt;
+		txt.FormatMessage(IDS_COMPARING_FILES_n, percent);
+		UpdateStatus(txt);
+	}
+	return 0;
+}
+
+// Posted by CP4SyncProgress; an empty string clears the status bar
+LRESULT CMainFrame::OnSyncProgress(WPARAM wParam, LPARAM lParam)
+{
+	CString *pTxt = (CString *) lParam;
+	UpdateStatus(*pTxt);
+	delete pTxt;
+	return 0;
+}
+
 /*
 	_________________________________________________________________
 
@@ -1216,8 +1306,11 @@ void CMainFrame::SetStatusBarLevel(StatusView level)
 // Status window updates:
 // Use AddToStatusLog to append a line to the status view
 // Use ClearStatusLog to clear the status view
-// Post WM_STATUSADD to run OnStatusAdd to append from outside main thread
-//                  WM_ADDTOSTATUS will delete wParam, a (char *)      
+// From any other thread, use TheApp()->StatusAdd, which queues the line in
+//                  CP4StatusLog for the status view to pick up on its timer
+// WM_STATUSADD and WM_STATUSADDARRAY are still handled for anything that
+//                  posts them: OnStatusAdd deletes wParam, a (TCHAR *),
+//                  and OnStatusAddArray deletes wParam, a CStringArray *
 // Post WM_STATUSCLEAR to run OnStatusClear to run ClearStatusLog 
 
 void CMainFrame::AddToStatusLog( LPCTSTR txt, StatusView level, bool showDialog)
@@ -1287,6 +1380,8 @@ void CMainFrame::OnDestroy()
 {
 	// Release resources used by the critical section object.
     DeleteCriticalSection(&CriticalSection);
+	GET_CHANGEINDEX()->Flush();
+	GET_REVCACHE()->Flush();
 	UpdateStatus(_T(" "));
 	CFrameWnd::OnDestroy();
 }
@@ -1747,7 +1842,7 @@ void CMainFrame::OnPerforceOptions( BOOL m_ShowOptionsDlg,
 			m_pUserView->GetListCtrl().Clear();
 			m_pLabelView->GetListCtrl().Clear();
 			m_pJobView->GetListCtrl().Clear();
-	        UpdateDepotandChangeViews( NO_REDRILL );
+	        StartupLoad( NO_REDRILL );
 		}
 		else
 			UpdateDepotandChangeViews( REDRILL );
@@ -1842,6 +1937,10 @@ void CMainFrame::OnClose()
 		// If user wants to re-expand pending changelist on reconnect, then save current expansion
 		m_pDeltaView->GetTreeCtrl().SaveExpansion();
 	}
+	m_Startup.Cancel();
+	if (m_pResolvePreview)
+		m_pResolvePreview->Cancel();
+
 	// Kill update timer if reqd
 	if(m_Timer != 0)
 		KillTimer(UPDATE_TIMER);
@@ -1949,6 +2048,89 @@ void CMainFrame::UpdateDepotandChangeViews(BOOL redrill, int key /*=0*/)
     m_pDepotView->GetTreeCtrl().OnViewUpdate( redrill, key );
 }
 
+/*
+	_________________________________________________________________
+
+	Fill the panes at startup or after a connection change.  The depot
+	and changes panes are loaded through the server lock, one step after
+	another.  The right pane, if it is showing a list, needs none of
+	that, so it is fetched at the same time on its own connection.  Jobs
+	and submitted changes take several steps through the lock, so they
+	wait their turn as before, and panes that aren't showing are left
+	until they are.
+	_________________________________________________________________
+*/
+
+void CMainFrame::StartupLoad(BOOL redrill)
+{
+	m_Startup.Begin();
+	m_DepotExpandDeferred = FALSE;
+	m_pStartupRetry = NULL;
+	UpdateDepotandChangeViews(redrill);
+
+	int tab= m_currentTab;
+	switch(TheApp()->m_InitialView)
+	{
+	case _T('L'):
+		tab= 1;
+		break;
+	case _T('B'):
+		tab= 2;
+		break;
+	case _T('U'):
+		tab= 3;
+		break;
+	case _T('C'):
+		tab= 4;
+		break;
+	}
+
+	CP4ListCtrl *list;
+	LPCTSTR name;
+	switch(tab)
+	{
+	case 1:
+		list= &m_pLabelView->GetListCtrl();
+		name= _T("labels");
+		break;
+	case 2:
+		list= &m_pBranchView->GetListCtrl();
+		name= _T("branches");
+		break;
+	case 3:
+		list= &m_pUserView->GetListCtrl();
+		name= _T("users");
+		break;
+	case 4:
+		list= &m_pClientView->GetListCtrl();
+		name= _T("clients");
+		break;
+	default:
+		return;
+	}
+
+	if(!GET_P4REGPTR()->GetParallelStartup() || !list->IsClear() 
+			|| !m_Startup.StartAlongside(name))
+		return;
+
+	list->SetStartupLoad(m_Startup.GetCancelFlag());
+	list->SendMessage(WM_COMMAND, ID_VIEW_UPDATE_RIGHT, 0);
+	if(!list->IsUpdating())
+	{
+		list->SetStartupLoad(NULL);
+		m_Startup.Skip(STARTUP_RIGHTPANE);
+		return;
+	}
+
+	if(tab != m_currentTab)
+		SetRightSplitter(tab);
+
+	// The initial view is showing, so FinishedGettingChgs() mustn't switch
+	// to it again; it does the depot expansion the right pane couldn't do
+	// if the pane finished first
+	TheApp()->m_InitialView= _T('\0');
+}
+
 void CMainFrame::ExpandDepotString(const CString &path, BOOL newPath)
 {
     m_pDepotView->GetTreeCtrl().ExpandDepotString( path, newPath );
@@ -2509,10 +2691,12 @@ void CMainFrame::OnTimer(UINT_PTR nIDEvent)
 	if(!m_GotInput && !GET_P4REGPTR()->GetAutoPollIconic())
 		return;
 
-	if((m_LastUpdateTime > time) || ((time-m_LastUpdateTime)/60000 >= GET_P4REGPTR()->GetAutoPollTime()))
+	if((m_LastUpdateTime > time) || (time-m_LastUpdateTime >= GetPollDelay()))
 	{
 		XTRACE(_T("OnTimer - starting update\n"));
 
+		SchedulePoll();
+
 		// Clear our flag which indicates whether we got any mousedowns or keystrokes
 		m_GotInput = FALSE;
 
@@ -2544,6 +2728,29 @@ void CMainFrame::OnTimer(UINT_PTR nIDEvent)
             // ask for incremental update 
 			int lock = 0;
 			GET_SERVER_LOCK( lock );
+			if( m_FullRefreshRequired )
+			{
+				delete m_pChangeState;
+				m_pChangeState= NULL;
+				m_IdlePolls= 0;
+				m_ServerBusy= FALSE;
+				m_CheckLatency= m_CheckFastest= 0;
+			}
+			else if( GET_P4REGPTR()->GetChangeCheck() )
+			{
+				// Find out what changed first, and let OnP4ChangeCheck
+				// refresh only the panes that need it
+				BOOL checkOpened= !m_pChangeState 
+							   || ++m_OpenedCheckSkips >= CHANGECHECK_OPENEDEVERY;
+				if( checkOpened )
+					m_OpenedCheckSkips= 0;
+				CCmd_ChangeCheck *pCmd= new CCmd_ChangeCheck;
+				pCmd->Init( m_hWnd, RUN_ASYNC, HOLD_LOCK, lock );
+				m_CheckStart= GetTickCount();
+				if( pCmd->Run( checkOpened ) )
+					return;
+				delete pCmd;
+			}
             UpdateDepotandChangeViews(!m_FullRefreshRequired, lock);
 		}
         else
@@ -2552,6 +2759,129 @@ void CMainFrame::OnTimer(UINT_PTR nIDEvent)
 	}
 }
 
+/*
+	_________________________________________________________________
+
+	The auto-poll change check is back.  Compare it with the last one:
+		- no last check, or the client spec was updated: full refresh
+		- a new submitted change: depot and changes panes
+		- a new pending change or different opened files: changes pane
+		- nothing: no refresh, unless CHANGECHECK_MAXSKIPS polls in a
+		  row have found nothing
+	_________________________________________________________________
+*/
+
+LRESULT CMainFrame::OnP4ChangeCheck(WPARAM wParam, LPARAM lParam)
+{
+	CCmd_ChangeCheck *pCmd= (CCmd_ChangeCheck *) wParam;
+	int key= pCmd->GetServerKey();
+
+	if( m_Quitting )
+	{
+		pCmd->ReleaseServerLock();
+		delete pCmd;
+		return 0;
+	}
+
+	if( pCmd->GetError() )
+	{
+		// Can't tell what changed, so refresh the way we always did
+		delete m_pChangeState;
+		m_pChangeState= NULL;
+		UpdateDepotandChangeViews(!m_FullRefreshRequired, key);
+		delete pCmd;
+		return 0;
+	}
+
+	// How long the check took says how busy the server is
+	DWORD latency= GetTickCount() - m_CheckStart;
+	m_CheckLatency= m_CheckLatency ? (3*m_CheckLatency + latency) / 4 : latency;
+	if( !m_CheckFastest || latency < m_CheckFastest )
+		m_CheckFastest= latency;
+	m_ServerBusy= m_CheckLatency > CHANGECHECK_BUSYMS 
+			   && m_CheckLatency > CHANGECHECK_BUSYRATIO * m_CheckFastest;
+
+	CHANGESTATE state= pCmd->GetState();
+	CHANGESTATE *last= m_pChangeState;
+	if( last )
+	{
+		// What this check skipped is taken to be as it was
+		if( !state.m_OpenedChecked )
+		{
+			state.m_OpenedCount= last->m_OpenedCount;
+			state.m_OpenedDigest= last->m_OpenedDigest;
+		}
+		if( !state.m_ClientChecked )
+			state.m_ClientUpdate= last->m_ClientUpdate;
+	}
+	int idlePolls= m_IdlePolls;
+	m_IdlePolls= 0;
+
+	if( !last || last->m_ClientUpdate != state.m_ClientUpdate 
+			  || state.m_MaxSubmitted < last->m_MaxSubmitted )
+	{
+		XTRACE(_T("OnP4ChangeCheck - full refresh\n"));
+		m_ChangeCheckSkips= 0;
+		// A new client view can't be redrilled
+		UpdateDepotandChangeViews(!m_FullRefreshRequired && (!last
+			|| last->m_ClientUpdate == state.m_ClientUpdate), key);
+	}
+	else if( state.m_MaxSubmitted != last->m_MaxSubmitted 
+		  || ++m_ChangeCheckSkips >= CHANGECHECK_MAXSKIPS )
+	{
+		XTRACE(_T("OnP4ChangeCheck - depot and changes\n"));
+		if( state.m_MaxSubmitted == last->m_MaxSubmitted )
+			m_IdlePolls= idlePolls + 1;		// only a safety refresh
+		m_ChangeCheckSkips= 0;
+		UpdateDepotandChangeViews(REDRILL, key);
+	}
+	else if( state.m_MaxChange != last->m_MaxChange
+		  || state.m_OpenedCount != last->m_OpenedCount
+		  || state.m_OpenedDigest != last->m_OpenedDigest )
+	{
+		XTRACE(_T("OnP4ChangeCheck - changes\n"));
+		m_ChangeCheckSkips= 0;
+		m_pDepotView->GetTreeCtrl().UpdateChangeWnd(key);
+	}
+	else
+	{
+		XTRACE(_T("OnP4ChangeCheck - nothing changed\n"));
+		m_IdlePolls= idlePolls + 1;
+		pCmd->ReleaseServerLock();
+		SetLastUpdateTime(UPDATE_SUCCESS);
+		ClearStatus();
+	}
+
+	if( !m_pChangeState )
+		m_pChangeState= new CHANGESTATE;
+	*m_pChangeState= state;
+	SchedulePoll();
+
+	delete pCmd;
+	return 0;
+}
+
+// Works out when the next auto-poll is due, from how many polls in a row
+// have found nothing new and whether the server seems busy, and picks a
+// new random offset for it
+void CMainFrame::SchedulePoll()
+{
+	int shift= m_IdlePolls + (m_ServerBusy ? 1 : 0);
+	int maxShift= 0;
+	while( (2 << maxShift) <= GET_P4REGPTR()->GetAutoPollBackoff() )
+		maxShift++;
+	m_PollShift= min(shift, maxShift);
+	m_PollJitter= rand() % (2*AUTOPOLL_JITTER+1) - AUTOPOLL_JITTER;
+}
+
+long CMainFrame::GetPollDelay()
+{
+	long period= GET_P4REGPTR()->GetAutoPollTime() * 60000;
+	for( int i= 0; i < m_PollShift && period < 86400000L; i++ )
+		period *= 2;
+	return period + period / 1000 * m_PollJitter;
+}
+
 BOOL CMainFrame::UpdateRightView()
 {
 	BOOL updating=FALSE;
@@ -3447,8 +3777,19 @@ void CMainFrame::OnEditPaste()
 //
 void CMainFrame::FinishedGettingChgs(BOOL bNeed2RefreshOldChgs)
 {
+	m_Startup.Done(STARTUP_CHANGES);
 	while (SERVER_BUSY())
 		Sleep(100);
+
+	// Fetch again a right pane that failed alongside the loads
+	if (m_pStartupRetry)
+	{
+		CP4ListCtrl *list = m_pStartupRetry;
+		m_pStartupRetry = NULL;
+		if (list->IsClear() && list->IsWindowVisible())
+			list->PostMessage(WM_COMMAND, ID_VIEW_UPDATE_RIGHT, 0);
+	}
+
 	if (!TheApp()->m_SubmitPath.IsEmpty())
 	{
 		int n;
@@ -3572,8 +3913,37 @@ void CMainFrame::FinishedGettingChgs(BOOL bNeed2RefreshOldChgs)
 	else ExpandDepotIfNeedBe();
 }
 
+// A startup load through the server lock failed, so FinishedGettingChgs()
+// won't be called; do the depot expansion a right pane left for it
+void CMainFrame::StartupLoadFailed()
+{
+	m_Startup.Fail();
+	if (m_DepotExpandDeferred)
+		ExpandDepotIfNeedBe();
+}
+
+// A right pane fetched alongside can't prompt for a password, so if it
+// failed it is fetched again the usual way, once the lock is free
+void CMainFrame::StartupPaneFailed(CP4ListCtrl *list)
+{
+	if (m_Startup.IsPending(STARTUP_CHANGES))
+		m_pStartupRetry = list;
+	else if (list->IsWindowVisible())
+		list->PostMessage(WM_COMMAND, ID_VIEW_UPDATE_RIGHT, 0);
+}
+
 void CMainFrame::ExpandDepotIfNeedBe()
 {
+	// A right pane fetched alongside the startup loads can finish first;
+	// the expansion has to wait for the depot tree and changes, and
+	// FinishedGettingChgs() does it then
+	if (m_Startup.IsPending(STARTUP_CHANGES))
+	{
+		m_DepotExpandDeferred = TRUE;
+		return;
+	}
+	m_DepotExpandDeferred = FALSE;
+
 	if (m_Need2ExpandDepot || !TheApp()->m_ExpandPath.IsEmpty())
 	{
 		m_Need2ExpandDepot = 0;
@@ -6639,7 +7009,7 @@ void CMainFrame::WaitAWhileToPoll()
 		return;
 
 	long time=GetTickCount();
-	long period=GET_P4REGPTR()->GetAutoPollTime() * 60000;
+	long period=GetPollDelay();
 
 	m_LastUpdateTime= max(m_LastUpdateTime, time + 20000 - period);
 }
@@ -7004,7 +7374,8 @@ void CMainFrame::OnViewUpdate()
 
 void CMainFrame::OnUpdateCancelCommand(CCmdUI* pCmdUI)
 {
-	pCmdUI->Enable(SetMenuIcon(pCmdUI, SERVER_BUSY()));
+	pCmdUI->Enable(SetMenuIcon(pCmdUI, SERVER_BUSY() || IsResolvePreviewRunning()
+									|| CP4StreamDiff::IsRunning()));
 }
 
 void CMainFrame::OnCancelButton()
@@ -7012,12 +7383,53 @@ void CMainFrame::OnCancelButton()
 	if (SERVER_BUSY() && IDYES == AfxMessageBox(IDS_CANCEL_AREYOUSURE, 
 									MB_YESNO|MB_ICONQUESTION|MB_DEFBUTTON2))
 		OnCancelCommand();
+	else if (!SERVER_BUSY() && (IsResolvePreviewRunning() || CP4StreamDiff::IsRunning()))
+		OnCancelCommand();
 }
 
 void CMainFrame::OnCancelCommand()
 {
 	if (SERVER_BUSY())
 		global_cancel = 1;
+
+	// Large file diffs run after their command has let go of the server
+	if (CP4StreamDiff::IsRunning())
+		CP4StreamDiff::Cancel();
+
+	// The merge preview's prints don't look at global_cancel
+	if (IsResolvePreviewRunning())
+	{
+		m_pResolvePreview->Cancel();
+		AddToStatusLog(LoadStringResource(IDS_MERGE_PREVIEW_CANCELED), SV_WARNING);
+	}
+}
+
+/*
+	_________________________________________________________________
+
+	Run the local merge preview gathered by a "resolve -n" in the
+	background, now that the command has let go of the server.  A
+	preview still running from an earlier resolve is abandoned.
+	_________________________________________________________________
+*/
+
+void CMainFrame::StartResolvePreview(CP4ResolvePreview *preview)
+{
+	if (!preview)
+		return;
+
+	delete m_pResolvePreview;
+	m_pResolvePreview= preview;
+	if (IsQuitting() || !m_pResolvePreview->Start())
+	{
+		delete m_pResolvePreview;
+		m_pResolvePreview= NULL;
+	}
+}
+
+BOOL CMainFrame::IsResolvePreviewRunning()
+{
+	return m_pResolvePreview && m_pResolvePreview->IsRunning();
 }
 
 BOOL CMainFrame::SetMenuIcon(CCmdUI* pCmdUI, BOOL bEnable)
@@ -19,7 +19,9 @@
 #include "FlatSplitter.h"
 #include "ZimbabweSplitter.h"
 #include "P4Menu.h"
+#include "P4StartupLoader.h"
 
+#define	STATUS_TIMER 96
 #define	MISC_TIMER	 97
 #define SORT_TIMER	 98
 #define UPDATE_TIMER 99
@@ -179,6 +181,18 @@ enum _ham
 // Message to Post that when received forces the focus to lParam window
 #define	WM_FORCEFOCUS		(WM_USER+467)
 
+// Message to show the result of an in-process diff - lParam is a CStringArray ptr
+#define	WM_SHOWQUICKDIFF	(WM_USER+468)
+
+// Message with the progress of a streamed diff - wParam is percent done, or -1 when finished
+#define	WM_DIFFPROGRESS		(WM_USER+469)
+
+// Message with the progress of a sync - lParam is a CString ptr with the text for the status bar
+#define	WM_SYNCPROGRESS		(WM_USER+470)
+
+// Message to a describe window that its hot spot thread has found more hot spots
+#define	WM_HOTSPOTSFOUND	(WM_USER+471)
+
 // Message from help app
 #define	WM_HELPERAPP		(WM_USER+0x1C00)
 
@@ -221,6 +235,8 @@ public:
 
 class CDeltaView;
 class CDepotView;
+struct CHANGESTATE;
+class CP4ResolvePreview;
 
 class CMainFrame : public CFrameWnd
 {
@@ -301,6 +317,35 @@ protected:
 	BOOL m_ClientError;
 	int  m_DoNotAutoPollCtr;
 
+	// What the last auto-poll change check found, NULL if there
+	// has been none since the last full refresh
+	CHANGESTATE *m_pChangeState;
+	int  m_ChangeCheckSkips;
+	int  m_OpenedCheckSkips;	// checks since the opened files were compared
+
+	// The panes' loads at startup and after a connection change
+	CP4StartupLoader m_Startup;
+	BOOL m_DepotExpandDeferred;		// left for FinishedGettingChgs() to do
+	CP4ListCtrl *m_pStartupRetry;	// right pane whose fetch alongside failed
+	void StartupLoad(BOOL redrill);
+
+	// The local merge preview of the last "resolve -n", if any
+	CP4ResolvePreview *m_pResolvePreview;
+	BOOL IsResolvePreviewRunning();
+
+	// Auto-poll backoff: the poll interval is doubled for each poll in
+	// a row that finds nothing new, and once more while the server is
+	// slow to answer, then moved up or down a little at random
+	int  m_IdlePolls;
+	int  m_PollShift;
+	int  m_PollJitter;		// tenths of a percent
+	BOOL m_ServerBusy;
+	DWORD m_CheckStart;
+	DWORD m_CheckLatency;	// smoothed time a change check takes
+	DWORD m_CheckFastest;
+	void SchedulePoll();
+	long GetPollDelay();
+
 	// Update on uncover timers
 	DWORD m_DeltaUpdateTime;
 	DWORD m_LabelUpdateTime;
@@ -348,7 +393,11 @@ public:
 	void ViewJobs( );
 	void UpdateCaption(BOOL updatePCU = TRUE);
 	void SetLastUpdateTime(BOOL updateResult);
-	void SetGotUserInput( ) { m_GotInput = TRUE; }
+	void StartupPhaseDone(int phase) { m_Startup.Done(phase); }
+	void StartupLoadFailed();
+	void StartupPaneFailed(CP4ListCtrl *list);
+	void StartResolvePreview(CP4ResolvePreview *preview);
+	void SetGotUserInput( ) { m_GotInput = TRUE; if (m_IdlePolls) { m_IdlePolls = 0; SchedulePoll(); } }
 	void ClearLastUpdateTime(); 
 	void OnCmdPromptPublic();
 	int  HaveTLV() { return m_P4TLV; }
@@ -658,8 +707,13 @@ protected:
 	LRESULT OnExternalRplycmd(WPARAM wParam, LPARAM lParam);
 	LRESULT OnClientError(WPARAM wParam, LPARAM lParam);
 	LRESULT OnP4ListOp(WPARAM wParam, LPARAM lParam);
+	LRESULT OnP4ChangeCheck(WPARAM wParam, LPARAM lParam);
 	LRESULT OnP4FileInformation(WPARAM wParam, LPARAM lParam);
 	LRESULT OnP4Diff(WPARAM wParam, LPARAM lParam);
+	LRESULT OnShowQuickDiff(WPARAM wParam, LPARAM lParam);
+	LRESULT OnP4EndQuickDiff(WPARAM wParam, LPARAM lParam);
+	LRESULT OnDiffProgress(WPARAM wParam, LPARAM lParam);
+	LRESULT OnSyncProgress(WPARAM wParam, LPARAM lParam);
 	LRESULT OnNewClient(WPARAM wParam, LPARAM lParam);
 	LRESULT OnNewUser(WPARAM wParam, LPARAM lParam);
 	LRESULT OnUserPasswordDlg( WPARAM wParam, LPARAM lParam );
@@ -16,6 +16,7 @@ COldChgFilterDlg::COldChgFilterDlg(CWnd* pParent /*=NULL*/)
 	, m_WinPos(false)
 {
 	m_includeIntegrations = m_UseClientSyntax = m_bPending = FALSE;
+	m_useDescription = FALSE;
 	m_InitRect = m_LastRect = CRect(0,0,0,0);
 	m_WinPos.SetWindow( this, _T("OldChgFilterDlg") );
 	m_filter = _T("");
@@ -48,6 +49,10 @@ void COldChgFilterDlg::DoDataExchange(CDataExchange* pDX)
 	DDX_Text(pDX, IDC_USER, m_user);
 	DDV_MaxChars(pDX, m_user, 1024);
 
+	DDX_Check(pDX, IDC_USE_DESCRIPTION, m_useDescription);
+	DDX_Text(pDX, IDC_DESCRIPTION, m_description);
+	DDV_MaxChars(pDX, m_description, 1024);
+
 	DDX_Check(pDX, IDC_INCLUDE_INTEGS, m_includeIntegrations);
 	DDX_Check(pDX, IDC_USE_CLIENT_SYNTAX, m_UseClientSyntax);
 
@@ -63,6 +68,7 @@ BEGIN_MESSAGE_MAP(COldChgFilterDlg, CDialog)
 	ON_BN_CLICKED(IDC_BROWSE_CLIENTS, OnBrowseClients)
 	ON_BN_CLICKED(IDC_USE_USER, OnUser)
 	ON_BN_CLICKED(IDC_BROWSE_USERS, OnBrowseUsers)
+	ON_BN_CLICKED(IDC_USE_DESCRIPTION, OnDescription)
 	ON_BN_CLICKED(IDC_FILE_ANY, OnFile)
 	ON_BN_CLICKED(IDC_FILE_FILESPEC, OnFile)
 	ON_BN_CLICKED(IDC_FILE_SELECTED, OnFile)
@@ -82,6 +88,13 @@ BOOL COldChgFilterDlg::OnInitDialog()
 	if (m_bPending || !GET_P4REGPTR()->GetEnableSubChgIntegFilter( ))
 		GetDlgItem(IDC_INCLUDE_INTEGS)->ShowWindow(SW_HIDE);
 
+	// Descriptions are searched in the local index of submitted changes
+	if (m_bPending || !GET_CHANGEINDEX()->IsEnabled())
+	{
+		m_useDescription = FALSE;
+		GetDlgItem(IDC_USE_DESCRIPTION)->EnableWindow( FALSE );
+	}
+
 	if (m_bPending)
 	{
 		GetDlgItem(IDC_SETREVRANGE)->ShowWindow(SW_HIDE);
@@ -102,6 +115,7 @@ BOOL COldChgFilterDlg::OnInitDialog()
 	LoadFilterComboBox();
 	OnClient();
 	OnUser();
+	OnDescription();
 	OnFile();
 	
 	if (m_selectedFiles.IsEmpty())
@@ -197,6 +211,14 @@ LRESULT COldChgFilterDlg::OnBrowseUsersCallBack(WPARAM wParam, LPARAM lParam)
 	return 0;
 }
 
+void COldChgFilterDlg::OnDescription()
+{
+	UpdateData(TRUE);
+	GetDlgItem(IDC_DESCRIPTION)->EnableWindow(m_useDescription);
+	if (m_useDescription)
+		GotoDlgCtrl(GetDlgItem(IDC_DESCRIPTION));
+}
+
 void COldChgFilterDlg::OnFile()
 {
 	int fileChoice = GetCheckedRadioButton(IDC_FILE_ANY, IDC_FILE_LASTSELECTED);
@@ -328,6 +350,10 @@ void COldChgFilterDlg::OnSize(UINT nType, int cx, int cy)
 	// Widen the 2 file combo/edit boxes by the change in width
 	pWnd = GetDlgItem(IDC_FILESPEC);
 	pWnd->GetWindowRect(&rect);
+	pWnd->SetWindowPos(NULL, 0, 0, rect.right - rect.left + dx, 
+								   rect.bottom - rect.top, SWP_NOMOVE | SWP_NOZORDER);
+	pWnd = GetDlgItem(IDC_DESCRIPTION);
+	pWnd->GetWindowRect(&rect);
 	pWnd->SetWindowPos(NULL, 0, 0, rect.right - rect.left + dx, 
 								   rect.bottom - rect.top, SWP_NOMOVE | SWP_NOZORDER);
 	pWnd = GetDlgItem(IDC_SELECTED);
@@ -23,6 +23,9 @@ public:
 	BOOL m_useUser;
 	CString m_user;
 
+	BOOL m_useDescription;
+	CString m_description;
+
 	BOOL m_includeIntegrations;
 
 	CComboBox m_fileCombo;
@@ -64,6 +67,7 @@ protected:
 	afx_msg void OnBrowseClients();
 	afx_msg void OnUser();
 	afx_msg void OnBrowseUsers();
+	afx_msg void OnDescription();
 	afx_msg void OnFile();
 	afx_msg void OnSetRevRange();
 	afx_msg void OnHelp();
@@ -86,6 +86,9 @@ BEGIN_MESSAGE_MAP(COldChgListCtrl, CP4ListCtrl)
 	ON_COMMAND(ID_POSITIONDEPOT, OnPositionDepot)
 	ON_UPDATE_COMMAND_UI(ID_CHANGE_REMOVEFIX, OnUpdateRemovefix)
 	ON_COMMAND(ID_CHANGE_REMOVEFIX, OnRemovefix)
+	ON_WM_VSCROLL()
+	ON_WM_MOUSEWHEEL()
+	ON_WM_KEYUP()
 	ON_MESSAGE(WM_P4FIXES, OnP4Fixes )
 	ON_MESSAGE(WM_P4FIX, OnP4Fix )
 	ON_MESSAGE(WM_ONDODELETEFIXES, OnDoDeleteFixes )
@@ -110,14 +113,19 @@ COldChgListCtrl::COldChgListCtrl()
 {
     m_viewType = P4CHANGE_SPEC;
 	m_MaxChange=0;
+	m_MinChange=0;
 	m_ItemCount=0;
 	m_LastUpdateTime=0;
+	m_Fetch=FETCH_LATEST;
+	m_FetchLimit=m_FetchedRows=0;
+	m_AllFetched=FALSE;
 	m_SortAscending=FALSE;
 	m_FilterInteg = m_FilterSpecial = m_ForceFocusHere = FALSE;
 	m_FilteredByUser = GET_P4REGPTR()->GetFilteredByUser();
 	m_UserFilter = GET_P4REGPTR()->GetUserFilter();
 	m_FilteredByClient = GET_P4REGPTR()->GetFilteredByClient();
 	m_ClientFilter = GET_P4REGPTR()->GetClientFilter();
+	m_FilteredByDesc = FALSE;
 	m_LastSortCol=0;
 	m_LastDescNbr=_T("");
 	m_captionplain = LoadStringResource(IDS_SUBMITTED_PERFORCE_CHANGELISTS);
@@ -181,6 +189,8 @@ void COldChgListCtrl::Clear()
     SetRedraw(TRUE);
 	m_ItemCount=0;
 	m_MaxChange=0;
+	m_MinChange=0;
+	m_AllFetched=FALSE;
 	m_LastUpdateTime=0;
 	CP4ListCtrl::Clear();
 }
@@ -192,6 +202,7 @@ void COldChgListCtrl::ClearFilter()
 	GET_P4REGPTR()->SetFilteredByUser(FALSE);
 	GET_P4REGPTR()->SetFilteredByClient(FALSE);
 	m_FilterInteg = m_FilterSpecial = m_FilteredByUser = m_FilteredByClient = FALSE;
+	m_FilteredByDesc = FALSE;
 	m_FilterView.RemoveAll(); 
 	SetCaption();
 	PersistentChgFilter( KEY_WRITE );
@@ -313,19 +324,40 @@ LRESULT COldChgListCtrl::OnP4Change(WPARAM wParam, LPARAM lParam)
 		CObList *list= (CObList *) wParam;
 		ASSERT_KINDOF(CObList, list);
 
+		// The changes are already in the index, so a description
+		// filter can be checked against it
+		CMap<long, long, BYTE, BYTE> matches;
+		if (m_FilteredByDesc)
+			GetDescMatches(matches);
+
 		POSITION pos= list->GetHeadPosition();
         SetRedraw(FALSE);
 		while(pos != NULL)
 		{
 			CP4Change *change= (CP4Change *) list->GetNext(pos);
 			ASSERT_KINDOF(CP4Change, change);
+			m_FetchedRows++;
 
-			if(change->GetChangeNumber() > m_MaxChange)
+			BYTE b;
+			if (m_FilteredByDesc && !matches.Lookup(change->GetChangeNumber(), b))
+			{
+				// Still counts towards the range we have, so paging goes on
+				// from here rather than fetching this page again
+				if(!m_NewMinChange || change->GetChangeNumber() < m_NewMinChange)
+					m_NewMinChange=change->GetChangeNumber();
+				if(change->GetChangeNumber() > m_NewMaxChange)
+					m_NewMaxChange=change->GetChangeNumber();
+				delete change;
+			}
+			else if(change->GetChangeNumber() > m_MaxChange
+			 || (m_Fetch == FETCH_OLDER && change->GetChangeNumber() < m_MinChange))
 			{
 				// Note: Do not delete change if inserted in list, because  
 				//       DeleteItem() will get rid of the change later.
 				if(change->GetChangeNumber() > m_NewMaxChange)
 					m_NewMaxChange=change->GetChangeNumber();
+				if(!m_NewMinChange || change->GetChangeNumber() < m_NewMinChange)
+					m_NewMinChange=change->GetChangeNumber();
 				InsertChange(change, m_ItemCount);
 				m_ItemCount++;
 			}
@@ -357,11 +389,27 @@ LRESULT COldChgListCtrl::OnP4Change(WPARAM wParam, LPARAM lParam)
         // Record the new max change
 		if (m_NewMaxChange > m_MaxChange)
 			m_MaxChange = m_NewMaxChange;
+		if (m_NewMinChange && (!m_MinChange || m_NewMinChange < m_MinChange))
+			m_MinChange = m_NewMinChange;
+
+		// A page that came back short means we have reached the first change.
+		// A refresh that came back full may have skipped some changes between
+		// the newest it got and the newest we had, so drop everything below
+		// what it got and let paging bring the older ones back.
+		if (!pCmd->GetError())
+		{
+			if (m_Fetch != FETCH_NEWER && (!m_FetchLimit || m_FetchedRows < m_FetchLimit))
+				m_AllFetched = TRUE;
+			else if (m_Fetch == FETCH_NEWER && m_FetchLimit && m_FetchedRows >= m_FetchLimit && m_NewMinChange)
+				DropOlderThan(m_NewMinChange);
+		}
+		BOOL paged = m_Fetch == FETCH_OLDER;
+		m_Fetch = FETCH_LATEST;
 
 		// Sort the view
 		ReSort();
 		
-		if( m_ItemCount > 0)
+		if( m_ItemCount > 0 && !paged)
 		{
 			int i = FindInList(m_Active);
 			if (i < 0)	i=0;
@@ -381,7 +429,8 @@ LRESULT COldChgListCtrl::OnP4Change(WPARAM wParam, LPARAM lParam)
 
 		// Notify the mainframe that we have finished getting the submitted changlists,
 		// hence the entire set of port connection async command have finished.
-		MainFrame()->FinishedGettingChgs(FALSE);
+		if (!paged)
+			MainFrame()->FinishedGettingChgs(FALSE);
 
 		// and we are done - must explicitly call this in case filter yielded 0 chglists
 		CP4ListCtrl::SetUpdateDone();
@@ -534,6 +583,11 @@ void COldChgListCtrl::OnViewUpdate()
 	if (!str.IsEmpty())
 		m_Active = str;
 
+	// A description search with nothing for the server to do is
+	// answered from the local index
+	if (FillFromIndex())
+		return;
+
 	// For a full refresh, proceed to GetChanges
 	if(m_MaxChange == 0)
     {
@@ -564,6 +618,12 @@ void COldChgListCtrl::OnViewUpdate()
 				MainFrame()->ClearStatus();
 			}
 		}
+		else if (CanFetchRange())
+		{
+			// Just the changes newer than the newest we have
+			GetChanges(GET_P4REGPTR()->GetFetchAllChanges() ? 0 : GET_P4REGPTR()->GetFetchChangeCount(),
+				0, FETCH_NEWER);
+		}
 		else
 		{
 			// Make a conservative estimate of changes submitted since last update
@@ -614,6 +674,11 @@ LRESULT COldChgListCtrl::OnP4MaxChange(WPARAM wParam, LPARAM lParam)
 	
 		GetChanges(numChanges, key);
 	}
+	else if (CanFetchRange())
+	{
+		GetChanges(GET_P4REGPTR()->GetFetchAllChanges() ? 0 : GET_P4REGPTR()->GetFetchChangeCount(),
+			key, FETCH_NEWER);
+	}
 	else
 	{
 		// Add 10 changes worth of "padding" in case a change is submitted between 
@@ -624,21 +689,33 @@ LRESULT COldChgListCtrl::OnP4MaxChange(WPARAM wParam, LPARAM lParam)
 	return 0;
 }
 
-void COldChgListCtrl::GetChanges(long numToFetch, int key/*=0*/)
+void COldChgListCtrl::GetChanges(long numToFetch, int key/*=0*/, EChgFetch fetch/*=FETCH_LATEST*/)
 {	
-	m_NewMaxChange=0;
+	m_NewMaxChange=m_NewMinChange=0;
+	m_Fetch=fetch;
+	m_FetchLimit=numToFetch;
+	m_FetchedRows=0;
 	CCmd_Changes *pCmd= new CCmd_Changes;
     if( key==0 )
 	    pCmd->Init( m_hWnd, RUN_ASYNC);
     else
         pCmd->Init( m_hWnd, RUN_ASYNC, LOSE_LOCK, key);
 
+	// Bound the changes to those we don't have yet
+	CString range;
+	if (fetch == FETCH_NEWER)
+		range.Format(_T("@%ld,#head"), m_MaxChange + 1);
+	else if (fetch == FETCH_OLDER)
+		range.Format(_T("@%ld"), m_MinChange - 1);
+
 	// Make a copy of the filter view, because CCmdChanges will
 	// destroy that copy
 	POSITION pos=m_FilterView.GetHeadPosition();
 	m_StrList.RemoveAll();
 	while(pos != NULL)
-		m_StrList.AddTail(m_FilterView.GetNext(pos));
+		m_StrList.AddTail(m_FilterView.GetNext(pos) + range);
+	if (m_StrList.IsEmpty() && !range.IsEmpty())
+		m_StrList.AddTail(_T("//...") + range);
 
 	if( pCmd->Run(SUBMITTED_CHANGES, 
 		(GET_SERVERLEVEL() >= 19 && GET_P4REGPTR()->GetUseShortSubmittedDesc()) ? 2 : 1, 
@@ -654,10 +731,138 @@ void COldChgListCtrl::GetChanges(long numToFetch, int key/*=0*/)
         if(pCmd->HaveServerLock())
             pCmd->ReleaseServerLock();
 		delete pCmd;
+		m_Fetch=FETCH_LATEST;
 		MainFrame()->ClearStatus();
 	}
 }
 
+// Fills the list from the local change index when only descriptions, users
+// and clients are being filtered on.  Returns FALSE if the server is needed.
+BOOL COldChgListCtrl::FillFromIndex()
+{
+	if (!m_FilteredByDesc || m_FilterView.GetCount() || m_FilterInteg
+	 || !GET_CHANGEINDEX()->IsEnabled())
+		return FALSE;
+
+	Clear();
+	CDWordArray changes;
+	GET_CHANGEINDEX()->Find(m_DescFilter,
+		m_FilteredByUser ? LPCTSTR(m_UserFilter) : NULL,
+		m_FilteredByClient ? LPCTSTR(m_ClientFilter) : NULL, changes);
+
+    SetRedraw(FALSE);
+	for (INT_PTR i = 0; i < changes.GetSize(); i++)
+	{
+		CP4Change *change = GET_CHANGEINDEX()->MakeChange((long) changes[i]);
+		if (!change)
+			continue;
+		if (!m_MaxChange)
+			m_MaxChange = change->GetChangeNumber();
+		m_MinChange = change->GetChangeNumber();
+		InsertChange(change, m_ItemCount);
+		m_ItemCount++;
+	}
+    SetRedraw(TRUE);
+	m_AllFetched = TRUE;
+	m_LastUpdateTime = GetTickCount();
+	ReSort();
+
+	if (m_ItemCount > 0)
+	{
+		int i = FindInList(m_Active);
+		if (i < 0)	i=0;
+		SetItemState( i, LVIS_SELECTED|LVIS_FOCUSED, LVIS_SELECTED|LVIS_FOCUSED );
+		EnsureVisible(i, FALSE);
+		CP4ListCtrl::SetUpdateDone();
+	}
+	else
+		m_UpdateState = LIST_CLEAR;
+
+	CString msg;
+	msg.FormatMessage(IDS_n_OF_n_INDEXED_CHANGES_MATCH_s, m_ItemCount,
+		GET_CHANGEINDEX()->GetCount(), (LPCTSTR) m_DescFilter);
+	AddToStatus(msg);
+	MainFrame()->ClearStatus();
+
+	if (m_PostViewUpdateMsg)
+	{
+		PostMessage(m_PostViewUpdateMsg, m_PostViewUpdateWParam, m_PostViewUpdateLParam);
+		m_PostViewUpdateMsg = 0;
+	}
+	return TRUE;
+}
+
+void COldChgListCtrl::GetDescMatches(CMap<long, long, BYTE, BYTE> &matches)
+{
+	CDWordArray changes;
+	GET_CHANGEINDEX()->Find(m_DescFilter, NULL, NULL, changes);
+	for (INT_PTR i = 0; i < changes.GetSize(); i++)
+		matches.SetAt((long) changes[i], 1);
+}
+
+// A change range can only be added to the filter if it doesn't already
+// have a revision or range of its own
+BOOL COldChgListCtrl::CanFetchRange()
+{
+	for (POSITION pos=m_FilterView.GetHeadPosition(); pos != NULL; )
+	{
+		if (m_FilterView.GetNext(pos).FindOneOf(_T("@#")) != -1)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+#define PAGEMARGIN	10		// rows from the bottom that bring in the next page
+
+// Fetches the next page of older changes once the user has scrolled to
+// near the bottom of what is loaded
+void COldChgListCtrl::FetchOlderIfNeeded()
+{
+	if (m_AllFetched || m_UpdateState != LIST_UPDATED || !m_ItemCount || m_MinChange <= 1
+	 || SERVER_BUSY() || GET_P4REGPTR()->GetFetchAllChanges() || !CanFetchRange())
+		return;
+	if (GetTopIndex() + GetCountPerPage() < GetItemCount() - PAGEMARGIN)
+		return;
+	GetChanges(GET_P4REGPTR()->GetFetchChangeCount(), 0, FETCH_OLDER);
+}
+
+void COldChgListCtrl::DropOlderThan(long changeNumber)
+{
+	for (int i = GetItemCount() - 1; i >= 0; i--)
+	{
+		CP4Change *change= (CP4Change *) GetItemData(i);
+		if (change && change->GetChangeNumber() < changeNumber)
+		{
+			DeleteItem(i);		// deletes the change too
+			m_ItemCount--;
+		}
+	}
+	m_MinChange = changeNumber;
+	m_AllFetched = FALSE;
+}
+
+void COldChgListCtrl::OnVScroll(UINT nSBCode, UINT nPos, CScrollBar* pScrollBar)
+{
+	CP4ListCtrl::OnVScroll(nSBCode, nPos, pScrollBar);
+	if (nSBCode != SB_THUMBTRACK)
+		FetchOlderIfNeeded();
+}
+
+BOOL COldChgListCtrl::OnMouseWheel(UINT nFlags, short zDelta, CPoint pt)
+{
+	BOOL b = CP4ListCtrl::OnMouseWheel(nFlags, zDelta, pt);
+	if (zDelta < 0)
+		FetchOlderIfNeeded();
+	return b;
+}
+
+void COldChgListCtrl::OnKeyUp(UINT nChar, UINT nRepCnt, UINT nFlags)
+{
+	CP4ListCtrl::OnKeyUp(nChar, nRepCnt, nFlags);
+	if (nChar == VK_NEXT || nChar == VK_END || nChar == VK_DOWN)
+		FetchOlderIfNeeded();
+}
+
 void COldChgListCtrl::OnContextMenu(CWnd* pWnd, CPoint point) 
 {
 	// make sure window is active
@@ -700,7 +905,7 @@ void COldChgListCtrl::OnContextMenu(CWnd* pWnd, CPoint point)
 	}
 
 	popMenu.AppendMenu(MF_ENABLED | MF_STRING, ID_FILTER_SETVIEW, LoadStringResource(IDS_FILTER_SETVIEW));
-	UINT flags = (m_FilterView.GetCount() || m_FilteredByClient || m_FilteredByUser) 
+	UINT flags = (m_FilterView.GetCount() || m_FilteredByClient || m_FilteredByUser || m_FilteredByDesc) 
 		? MF_ENABLED | MF_STRING : MF_DISABLED | MF_STRING;
 	popMenu.AppendMenu(flags, ID_FILTER_CLEARVIEW, LoadStringResource(IDS_CLEARFILTER));
 
@@ -1124,6 +1329,8 @@ void COldChgListCtrl::OnFilterSetview()
 	dlg.m_client = m_ClientFilter;
 	dlg.m_useUser = m_FilteredByUser;
 	dlg.m_user = m_UserFilter;
+	dlg.m_useDescription = m_FilteredByDesc;
+	dlg.m_description = m_DescFilter;
 	dlg.m_includeIntegrations = m_FilterInteg;
 
 	// get selected files from depot view and convert to string
@@ -1178,6 +1385,14 @@ void COldChgListCtrl::OnFilterSetview()
 		GET_P4REGPTR()->SetUserFilter(m_UserFilter);
 	}
 
+	m_FilteredByDesc = dlg.m_useDescription && !dlg.m_description.IsEmpty();
+	if(m_FilteredByDesc)
+	{
+		m_DescFilter = dlg.m_description;
+		m_DescFilter.TrimLeft();
+		m_DescFilter.TrimRight();
+	}
+
 	// get include integrations option
 	m_FilterInteg = dlg.m_includeIntegrations;
 
@@ -1280,7 +1495,7 @@ void COldChgListCtrl::OnUpdateFilterClearview(CCmdUI* pCmdUI)
 {
 	pCmdUI->SetText(LoadStringResource(IDS_FILTER_CLEARVIEW));
 	pCmdUI->Enable(MainFrame()->SetMenuIcon(pCmdUI, !SERVER_BUSY() && 
-		(m_FilterView.GetCount() || m_FilteredByClient || m_FilteredByUser)));
+		(m_FilterView.GetCount() || m_FilteredByClient || m_FilteredByUser || m_FilteredByDesc)));
 }
 
 void COldChgListCtrl::OnUpdateFilterSetview(CCmdUI* pCmdUI) 
@@ -1365,7 +1580,7 @@ void COldChgListCtrl::PersistentChgFilter( REGSAM accessmask )
 
 void COldChgListCtrl::SetCaption()
 {
-	if (m_FilterView.GetCount() > 0 || m_FilteredByUser || m_FilteredByClient)
+	if (m_FilterView.GetCount() > 0 || m_FilteredByUser || m_FilteredByClient || m_FilteredByDesc)
 	{
 		CString txt = _T("");
 		if (m_FilteredByClient)
@@ -1376,6 +1591,12 @@ void COldChgListCtrl::SetCaption()
 				txt += _T("; ");
 			txt += LoadStringResource(IDS_USER) + _T(' ') + m_UserFilter;
 		}
+		if (m_FilteredByDesc)
+		{
+			if (!txt.IsEmpty())
+				txt += _T("; ");
+			txt += _T('\'') + m_DescFilter + _T('\'');
+		}
 		if (m_FilterView.GetCount() > 0)
 		{
 			if (!txt.IsEmpty())
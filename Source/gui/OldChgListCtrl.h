@@ -15,6 +15,14 @@ class CDeleteFixes;
 #include "P4Change.h"
 #include "SyncChange.h"
 
+// What the changes command in progress is fetching
+enum EChgFetch
+{
+	FETCH_LATEST,		// the most recent changes, replacing the list
+	FETCH_NEWER,		// changes newer than the newest shown
+	FETCH_OLDER,		// the next page of changes older than the oldest shown
+};
+
 class COldChgListCtrl : public CP4ListCtrl
 {
 public:
@@ -27,7 +35,7 @@ public:
 	void EditTheSpec(CString *name, BOOL uFlag);
 	void ClearFilter();
 	void OnDeleteitem(NMHDR* pNMHDR, LRESULT* pResult);
-	void GetChanges(long numToFetch, int key=0);
+	void GetChanges(long numToFetch, int key=0, EChgFetch fetch=FETCH_LATEST);
 	void OnDescribeChg();
 	void FilterByUser(CString user);
 	void FilterByClient(CString client);
@@ -41,6 +49,14 @@ protected:
 	CString m_UserFilter;
 	CString m_ClientFilter;
 
+	// Description words are looked up in the local change index.  With no
+	// file filter the list is filled from the index alone; with one, the
+	// server's list is cut down to the changes the index matches.
+	BOOL m_FilteredByDesc;
+	CString m_DescFilter;
+	BOOL FillFromIndex();
+	void GetDescMatches(CMap<long, long, BYTE, BYTE> &matches);
+
 	CString m_JobSpec;
 	CString *m_pJobSpec;
 	CStringList m_JobList;
@@ -80,6 +96,18 @@ protected:
 	inline CP4winApp *TheApp() { return (CP4winApp *) AfxGetApp(); }
 	long m_ItemCount;
 	long m_MaxChange, m_NewMaxChange;
+	long m_MinChange, m_NewMinChange;
+
+	// The list is fetched a page at a time, using a change range so the
+	// server sends only what isn't shown yet: newer changes on a refresh,
+	// older ones as the user scrolls to the bottom
+	EChgFetch m_Fetch;
+	long m_FetchLimit;			// -m of the fetch in progress, 0 if none
+	long m_FetchedRows;
+	BOOL m_AllFetched;			// nothing older than m_MinChange is left
+	BOOL CanFetchRange();
+	void FetchOlderIfNeeded();
+	void DropOlderThan(long changeNumber);
 	long m_LastUpdateTime;
 	BOOL m_ForceFocusHere;
 	BOOL m_FilterSpecial;
@@ -135,6 +163,9 @@ protected:
 	afx_msg void OnPositionDepot();
 	afx_msg void OnUpdateRemovefix(CCmdUI* pCmdUI);
 	afx_msg void OnRemovefix();
+	afx_msg void OnVScroll(UINT nSBCode, UINT nPos, CScrollBar* pScrollBar);
+	afx_msg BOOL OnMouseWheel(UINT nFlags, short zDelta, CPoint pt);
+	afx_msg void OnKeyUp(UINT nChar, UINT nRepCnt, UINT nFlags);
 	LRESULT OnP4Fixes(WPARAM wParam, LPARAM lParam);
 	LRESULT OnP4Fix(WPARAM wParam, LPARAM lParam);
 	LRESULT OnDoDeleteFixes(WPARAM wParam, LPARAM lParam);
@@ -23,6 +23,7 @@ IMPLEMENT_DYNCREATE(CP4Change, CObject)
 CP4Change::CP4Change()
 {
 	m_Initialized=FALSE;
+	m_Shelved=FALSE;
 }
 
 CP4Change::~CP4Change()
@@ -100,7 +101,21 @@ BOOL CP4Change::Create(LPCTSTR changesRow)
     return TRUE;
 }
 
-static void TimestampToFormattedTime( long changeTime, CString *pFormatted )
+// A submitted change from what the local change index saved of it
+BOOL CP4Change::Create(long changeNumber, LPCTSTR date, LPCTSTR userAtClient, LPCTSTR description)
+{
+	m_ChangeNumber= changeNumber;
+	m_ChangeDate= date;
+	m_UserAtClient= userAtClient;
+	int at= m_UserAtClient.Find(_T('@'));
+	m_MyChange= at != -1 && Compare( m_UserAtClient.Mid( at+1 ), GET_P4REGPTR()->GetP4Client() ) == 0;
+	m_Pending= m_Shelved= FALSE;
+	m_Description= description;
+	m_Initialized=TRUE;
+	return TRUE;
+}
+
+void TimestampToFormattedTime( long changeTime, CString *pFormatted )
 {
 	// There's some weird negative number math going on in CP4FileStats::GetFormattedHeadTime()
 	ASSERT(changeTime >= 0);
@@ -30,6 +30,7 @@ protected:
 public:
 	BOOL Create(LPCTSTR changesRow);  // char * as returned by 'p4 changes'
 	BOOL Create(class StrDict *varlist);
+	BOOL Create(long changeNumber, LPCTSTR date, LPCTSTR userAtClient, LPCTSTR description);
 
 	inline BOOL IsPending() const {ASSERT(m_Initialized); return m_Pending;}
 	inline BOOL IsShelved() const {ASSERT(m_Initialized); return m_Shelved;}
@@ -48,4 +49,6 @@ public:
 
 };
 
+void TimestampToFormattedTime( long changeTime, CString *pFormatted );
+
 #endif //__P4CHANGE__
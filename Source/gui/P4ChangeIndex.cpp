@@ -0,0 +1,518 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4ChangeIndex.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4Change.h"
+#include "P4ChangeIndex.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+#define CHANGEINDEX_DIR		_T("P4WinIndex")
+#define CHANGEINDEX_CHUNK	65536	// characters written at a time
+
+
+CP4ChangeIndex::CP4ChangeIndex()
+{
+	m_Loaded = m_Dirty = FALSE;
+	m_WordsSorted = TRUE;
+}
+
+CP4ChangeIndex::~CP4ChangeIndex()
+{
+	Flush();
+	RemoveAll();
+}
+
+BOOL CP4ChangeIndex::IsEnabled()
+{
+	return GET_P4REGPTR()->GetChangeIndex();
+}
+
+// One file per server, named after the port
+CString CP4ChangeIndex::GetIndexFile(LPCTSTR port)
+{
+	CString name = port;
+	for (int i = 0; i < name.GetLength(); i++)
+	{
+		if (_tcschr(_T(":/\\*?\"<>|"), name[i]))
+			name.SetAt(i, _T('_'));
+	}
+	CString dir = GET_P4REGPTR()->GetTempDir();
+	dir.TrimRight(_T('\\'));
+	dir += _T('\\');
+	dir += CHANGEINDEX_DIR;
+	CreateDirectory(dir, NULL);
+	return dir + _T('\\') + name + _T(".idx");
+}
+
+// Words are runs of letters, digits and underscores, lower cased.  Anything
+// outside ASCII counts as a letter, so words in other scripts are kept whole.
+void CP4ChangeIndex::SplitWords(LPCTSTR text, CStringArray &words)
+{
+	LPCTSTR p = text;
+	while (*p)
+	{
+		while (*p && !((unsigned) *p > 127 || _istalnum(*p) || *p == _T('_')))
+			p++;
+		LPCTSTR beg = p;
+		while (*p && ((unsigned) *p > 127 || _istalnum(*p) || *p == _T('_')))
+			p++;
+		if (p > beg)
+		{
+			CString word(beg, (int)(p - beg));
+			word.MakeLower();
+			words.Add(word);
+		}
+	}
+}
+
+// May be called from any thread
+void CP4ChangeIndex::Add(CP4Change *change)
+{
+	if (!IsEnabled() || change->IsPending() || change->IsShelved() || !change->GetChangeNumber())
+		return;
+
+	m_Lock.Lock();
+	Load();
+	CIndexedChange *ic;
+	long number = change->GetChangeNumber();
+	if (!m_Changes.Lookup(number, ic))
+	{
+		ic = new CIndexedChange;
+		ic->m_Change = number;
+		m_Changes.SetAt(number, ic);
+	}
+	else if (ic->m_Desc.GetLength() >= lstrlen(change->GetDescription()))
+	{
+		m_Lock.Unlock();
+		return;
+	}
+	else
+		UnindexChange(ic);		// the shorter description's words go with it
+	ic->m_Date = change->GetChangeDate();
+	ic->m_User = change->GetUser();
+	ic->m_Desc = change->GetDescription();
+	IndexChange(ic);
+	m_Dirty = TRUE;
+	m_Lock.Unlock();
+}
+
+// The words a change is indexed under
+void CP4ChangeIndex::GetWords(CIndexedChange *ic, CStringArray &words)
+{
+	SplitWords(ic->m_Desc, words);
+	SplitWords(ic->m_User, words);
+
+	// and the user and client whole, as names can hold punctuation
+	CString user = ic->m_User;
+	int at = user.Find(_T('@'));
+	if (at > 0)
+	{
+		words.Add(user.Left(at));
+		words.Add(user.Mid(at + 1));
+	}
+	for (int i = 0; i < words.GetSize(); i++)
+		words[i].MakeLower();
+}
+
+// Must be called with m_Lock held
+void CP4ChangeIndex::IndexChange(CIndexedChange *ic)
+{
+	CStringArray words;
+	GetWords(ic, words);
+	for (int i = 0; i < words.GetSize(); i++)
+		AddWord(words[i], ic->m_Change);
+}
+
+// Must be called with m_Lock held
+void CP4ChangeIndex::UnindexChange(CIndexedChange *ic)
+{
+	CStringArray words;
+	GetWords(ic, words);
+	for (int i = 0; i < words.GetSize(); i++)
+		RemoveWord(words[i], ic->m_Change);
+}
+
+// Must be called with m_Lock held
+void CP4ChangeIndex::AddWord(LPCTSTR word, long changeNumber)
+{
+	void *p;
+	CDWordArray *list;
+	if (m_Words.Lookup(word, p))
+		list = (CDWordArray *) p;
+	else
+	{
+		list = new CDWordArray;
+		m_Words.SetAt(word, list);
+		m_WordsSorted = FALSE;
+	}
+	// A word used twice in one description is listed once
+	INT_PTR n = list->GetSize();
+	if (!n || list->GetAt(n - 1) != (DWORD) changeNumber)
+		list->Add((DWORD) changeNumber);
+}
+
+// Must be called with m_Lock held
+void CP4ChangeIndex::RemoveWord(LPCTSTR word, long changeNumber)
+{
+	void *p;
+	if (!m_Words.Lookup(word, p))
+		return;
+	CDWordArray *list = (CDWordArray *) p;
+	for (INT_PTR i = list->GetSize(); i--; )
+	{
+		if (list->GetAt(i) == (DWORD) changeNumber)
+			list->RemoveAt(i);
+	}
+	if (!list->GetSize())
+	{
+		delete list;
+		m_Words.RemoveKey(word);
+		m_WordsSorted = FALSE;
+	}
+}
+
+static int compareWords(const void *arg1, const void *arg2)
+{
+	return _tcscmp(*(const CString *) arg1, *(const CString *) arg2);
+}
+
+// Must be called with m_Lock held
+void CP4ChangeIndex::SortWords()
+{
+	if (m_WordsSorted)
+		return;
+	m_SortedWords.RemoveAll();
+	m_SortedWords.SetSize(0, m_Words.GetCount());
+	CString word;
+	void *p;
+	for (POSITION pos = m_Words.GetStartPosition(); pos != NULL; )
+	{
+		m_Words.GetNextAssoc(pos, word, p);
+		m_SortedWords.Add(word);
+	}
+	qsort(m_SortedWords.GetData(), m_SortedWords.GetSize(), sizeof(CString), compareWords);
+	m_WordsSorted = TRUE;
+}
+
+// Adds the changes using word to found.  A word ending in '*' matches any
+// word it is the start of.  Must be called with m_Lock held.
+void CP4ChangeIndex::FindWord(CString word, CMap<long, long, BYTE, BYTE> &found)
+{
+	BOOL prefix = word.Right(1) == _T("*");
+	word.TrimRight(_T('*'));
+	word.MakeLower();
+	if (word.IsEmpty())
+		return;
+
+	CStringArray words;
+	if (!prefix)
+		words.Add(word);
+	else
+	{
+		SortWords();
+		INT_PTR lo = 0, hi = m_SortedWords.GetSize();
+		while (lo < hi)
+		{
+			INT_PTR mid = (lo + hi) / 2;
+			if (_tcscmp(m_SortedWords[mid], word) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		for ( ; lo < m_SortedWords.GetSize()
+			  && _tcsncmp(m_SortedWords[lo], word, word.GetLength()) == 0; lo++)
+			words.Add(m_SortedWords[lo]);
+	}
+
+	for (int i = 0; i < words.GetSize(); i++)
+	{
+		void *p;
+		if (!m_Words.Lookup(words[i], p))
+			continue;
+		CDWordArray *list = (CDWordArray *) p;
+		for (INT_PTR j = 0; j < list->GetSize(); j++)
+			found.SetAt((long) list->GetAt(j), 1);
+	}
+}
+
+static int compareChangesDown(const void *arg1, const void *arg2)
+{
+	DWORD c1 = *(const DWORD *) arg1;
+	DWORD c2 = *(const DWORD *) arg2;
+	return c1 < c2 ? 1 : c1 > c2 ? -1 : 0;
+}
+
+// Finds the changes using every word of query, newest first, optionally
+// limited to a user and/or client.  Returns the number found.
+int CP4ChangeIndex::Find(LPCTSTR query, LPCTSTR user, LPCTSTR client, CDWordArray &changes)
+{
+	changes.RemoveAll();
+
+	// Split on white space only, so a trailing '*' stays with its word
+	CStringArray terms;
+	CString q = query;
+	int pos = 0;
+	CString term = q.Tokenize(_T(" \t"), pos);
+	while (!term.IsEmpty())
+	{
+		terms.Add(term);
+		term = q.Tokenize(_T(" \t"), pos);
+	}
+	if (!terms.GetSize())
+		return 0;
+
+	m_Lock.Lock();
+	Load();
+
+	CMap<long, long, BYTE, BYTE> result;
+	for (int i = 0; i < terms.GetSize(); i++)
+	{
+		CMap<long, long, BYTE, BYTE> found;
+		FindWord(terms[i], found);
+		if (i == 0)
+		{
+			long c;
+			BYTE b;
+			for (POSITION p = found.GetStartPosition(); p != NULL; )
+			{
+				found.GetNextAssoc(p, c, b);
+				result.SetAt(c, b);
+			}
+		}
+		else
+		{
+			long c;
+			BYTE b;
+			CDWordArray missing;
+			for (POSITION p = result.GetStartPosition(); p != NULL; )
+			{
+				result.GetNextAssoc(p, c, b);
+				if (!found.Lookup(c, b))
+					missing.Add((DWORD) c);
+			}
+			for (INT_PTR j = 0; j < missing.GetSize(); j++)
+				result.RemoveKey((long) missing[j]);
+		}
+		if (result.IsEmpty())
+			break;
+	}
+
+	long c;
+	BYTE b;
+	for (POSITION p = result.GetStartPosition(); p != NULL; )
+	{
+		result.GetNextAssoc(p, c, b);
+		CIndexedChange *ic;
+		if (!m_Changes.Lookup(c, ic))
+			continue;
+		int at = ic->m_User.Find(_T('@'));
+		if (user && *user && Compare(ic->m_User.Left(at), user) != 0)
+			continue;
+		if (client && *client && Compare(ic->m_User.Mid(at + 1), client) != 0)
+			continue;
+		changes.Add((DWORD) c);
+	}
+	m_Lock.Unlock();
+
+	qsort(changes.GetData(), changes.GetSize(), sizeof(DWORD), compareChangesDown);
+	return (int) changes.GetSize();
+}
+
+// Makes a change for the submitted pane from what the index holds.  The
+// caller owns the change.
+CP4Change *CP4ChangeIndex::MakeChange(long changeNumber)
+{
+	CP4Change *change = NULL;
+	m_Lock.Lock();
+	CIndexedChange *ic;
+	if (m_Changes.Lookup(changeNumber, ic))
+	{
+		change = new CP4Change;
+		change->Create(ic->m_Change, ic->m_Date, ic->m_User, ic->m_Desc);
+	}
+	m_Lock.Unlock();
+	return change;
+}
+
+void CP4ChangeIndex::Flush()
+{
+	m_Lock.Lock();
+	Save();
+	m_Lock.Unlock();
+}
+
+// Must be called with m_Lock held
+void CP4ChangeIndex::RemoveAll()
+{
+	long c;
+	CIndexedChange *ic;
+	for (POSITION pos = m_Changes.GetStartPosition(); pos != NULL; )
+	{
+		m_Changes.GetNextAssoc(pos, c, ic);
+		delete ic;
+	}
+	m_Changes.RemoveAll();
+
+	CString word;
+	void *p;
+	for (POSITION pos = m_Words.GetStartPosition(); pos != NULL; )
+	{
+		m_Words.GetNextAssoc(pos, word, p);
+		delete (CDWordArray *) p;
+	}
+	m_Words.RemoveAll();
+	m_SortedWords.RemoveAll();
+	m_WordsSorted = TRUE;
+}
+
+static CString Escape(const CString &str)
+{
+	CString out = str;
+	out.Replace(_T("\\"), _T("\\\\"));
+	out.Replace(_T("\t"), _T("\\t"));
+	out.Replace(_T("\r"), _T("\\r"));
+	out.Replace(_T("\n"), _T("\\n"));
+	return out;
+}
+
+static CString Unescape(const CString &str)
+{
+	if (str.Find(_T('\\')) == -1)
+		return str;
+	CString out;
+	int len = str.GetLength();
+	for (int i = 0; i < len; i++)
+	{
+		TCHAR c = str[i];
+		if (c == _T('\\') && i + 1 < len)
+		{
+			c = str[++i];
+			if (c == _T('t'))
+				c = _T('\t');
+			else if (c == _T('r'))
+				c = _T('\r');
+			else if (c == _T('n'))
+				c = _T('\n');
+		}
+		out += c;
+	}
+	return out;
+}
+
+// Loads the index for the current server, writing out the one for the
+// last server first.  Must be called with m_Lock held.
+void CP4ChangeIndex::Load()
+{
+	CString port = GET_P4REGPTR()->GetP4Port();
+	if (m_Loaded && port == m_Port)
+		return;
+
+	if (m_Loaded)
+	{
+		Save();
+		RemoveAll();
+	}
+	m_Port = port;
+	m_Loaded = TRUE;
+	m_Dirty = FALSE;
+
+	HANDLE hFile;
+	if ((hFile = CreateFile(GetIndexFile(m_Port), GENERIC_READ,
+				FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0)) == INVALID_HANDLE_VALUE)
+		return;
+
+	DWORD NumberOfBytesRead;
+	DWORD fsize = GetFileSize(hFile, NULL);
+	LPTSTR pBuf = new TCHAR[fsize/sizeof(TCHAR) + 1];
+	BOOL b = ReadFile(hFile, pBuf, fsize, &NumberOfBytesRead, NULL);
+	CloseHandle(hFile);
+	pBuf[b ? NumberOfBytesRead/sizeof(TCHAR) : 0] = _T('\0');
+
+	// Each line is: change, date, user@client, description
+	LPTSTR pStr = pBuf;
+#ifdef UNICODE
+	if (*pStr == 0xFEFF)
+		pStr++;
+#endif
+	while (*pStr)
+	{
+		LPTSTR end = _tcschr(pStr, _T('\n'));
+		if (end)
+			*end = _T('\0');
+		CString line = pStr;
+		pStr = end ? end + 1 : pStr + lstrlen(pStr);
+		line.TrimRight(_T("\r"));
+
+		CString fld[4];
+		int f, i, pos = 0;
+		for (f = 0; f < 4 && pos <= line.GetLength(); f++)
+		{
+			if ((i = line.Find(_T('\t'), pos)) == -1 || f == 3)
+				i = line.GetLength();
+			fld[f] = line.Mid(pos, i - pos);
+			pos = i + 1;
+		}
+		long number = _ttol(fld[0]);
+		if (f < 4 || number <= 0)
+			continue;
+
+		CIndexedChange *ic;
+		if (m_Changes.Lookup(number, ic))
+			continue;
+		ic = new CIndexedChange;
+		ic->m_Change = number;
+		ic->m_Date = fld[1];
+		ic->m_User = fld[2];
+		ic->m_Desc = Unescape(fld[3]);
+		m_Changes.SetAt(number, ic);
+		IndexChange(ic);
+	}
+	delete [] pBuf;
+}
+
+// Must be called with m_Lock held
+void CP4ChangeIndex::Save()
+{
+	if (!m_Loaded || !m_Dirty)
+		return;
+
+	HANDLE hFile;
+	if ((hFile = CreateFile(GetIndexFile(m_Port), GENERIC_READ | GENERIC_WRITE,
+				FILE_SHARE_READ, 0, CREATE_ALWAYS, 0, 0)) == INVALID_HANDLE_VALUE)
+		return;
+
+	CString buf;
+#ifdef UNICODE
+	buf += (TCHAR)0xFEFF;
+#endif
+	DWORD NumberOfBytesWritten;
+	long c;
+	CIndexedChange *ic;
+	for (POSITION pos = m_Changes.GetStartPosition(); pos != NULL; )
+	{
+		m_Changes.GetNextAssoc(pos, c, ic);
+		CString recd;
+		recd.Format(_T("%ld\t%s\t%s\t%s\r\n"), ic->m_Change, ic->m_Date, ic->m_User,
+			Escape(ic->m_Desc));
+		buf += recd;
+		if (buf.GetLength() >= CHANGEINDEX_CHUNK)
+		{
+			WriteFile(hFile, buf, buf.GetLength()*sizeof(TCHAR), &NumberOfBytesWritten, NULL);
+			buf.Empty();
+		}
+	}
+	if (!buf.IsEmpty())
+		WriteFile(hFile, buf, buf.GetLength()*sizeof(TCHAR), &NumberOfBytesWritten, NULL);
+	CloseHandle(hFile);
+	m_Dirty = FALSE;
+}
@@ -0,0 +1,73 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4ChangeIndex.h
+//
+// CP4ChangeIndex is a local full-text index of submitted changelists, so
+// the submitted pane can search descriptions, users and clients without
+// asking the server.  Every change that 'p4 changes' returns is added as it
+// arrives, keeping the longest description seen (so a later -l fetch
+// replaces a -L one).  Words are kept lower case in an inverted index that
+// maps each word to the changes using it; a sorted copy of the word list
+// serves prefix searches.  The index is kept per server port in the temp
+// directory and loaded the first time it is used.
+
+#ifndef __P4CHANGEINDEX__
+#define __P4CHANGEINDEX__
+
+#include <afxmt.h>
+
+class CP4Change;
+
+class CIndexedChange : public CObject
+{
+public:
+	long	m_Change;
+	CString m_Date;
+	CString m_User;			// user@client
+	CString m_Desc;
+};
+
+class CP4ChangeIndex
+{
+public:
+	CP4ChangeIndex();
+	~CP4ChangeIndex();
+
+protected:
+	CCriticalSection m_Lock;
+	CString m_Port;						// the server the index is loaded for
+	BOOL	m_Loaded;
+	BOOL	m_Dirty;
+	CMap<long, long, CIndexedChange *, CIndexedChange *> m_Changes;
+	CMapStringToPtr m_Words;			// word -> CDWordArray of change numbers
+	CStringArray m_SortedWords;			// for prefix searches, rebuilt as needed
+	BOOL	m_WordsSorted;
+
+public:
+	BOOL IsEnabled();
+	void Add(CP4Change *change);
+	int  Find(LPCTSTR query, LPCTSTR user, LPCTSTR client, CDWordArray &changes);
+	CP4Change *MakeChange(long changeNumber);
+	void Flush();
+	int  GetCount() { return (int) m_Changes.GetCount(); }
+
+	static void SplitWords(LPCTSTR text, CStringArray &words);
+
+protected:
+	CString GetIndexFile(LPCTSTR port);
+	void Load();
+	void Save();
+	void RemoveAll();
+	void GetWords(CIndexedChange *ic, CStringArray &words);
+	void IndexChange(CIndexedChange *ic);
+	void UnindexChange(CIndexedChange *ic);
+	void AddWord(LPCTSTR word, long changeNumber);
+	void RemoveWord(LPCTSTR word, long changeNumber);
+	void SortWords();
+	void FindWord(CString word, CMap<long, long, BYTE, BYTE> &found);
+};
+
+#endif //__P4CHANGEINDEX__
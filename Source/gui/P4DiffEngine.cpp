@@ -0,0 +1,903 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4DiffEngine.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "MainFrm.h"
+#include "P4DiffEngine.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+// Unique-line anchoring only pays off for the first few levels; below that
+// the ranges are small and Myers does just as well
+#define MAXANCHORDEPTH	8
+
+// Width of each file's column in side-by-side output
+#define SIDEBYSIDEWIDTH	60
+
+static inline BOOL IsWhite(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Walks a line the way the whitespace options see it: with -dw all white
+// space is skipped, with -db each run of it reads as a single blank and
+// trailing white space is ignored
+class CLineWalker
+{
+	const char *m_P;
+	const char *m_End;
+	int m_Flags;
+
+public:
+	CLineWalker(const char *p, int len, int flags)
+	{
+		m_P = p;
+		m_End = p + len;
+		m_Flags = flags;
+	}
+
+	int Next()
+	{
+		if (m_P < m_End && IsWhite(*m_P))
+		{
+			if (m_Flags & DIFF_IGNOREWS)
+			{
+				while (m_P < m_End && IsWhite(*m_P))
+					m_P++;
+			}
+			else if (m_Flags & DIFF_IGNOREWSCHANGES)
+			{
+				while (m_P < m_End && IsWhite(*m_P))
+					m_P++;
+				return m_P < m_End ? ' ' : -1;
+			}
+		}
+		return m_P < m_End ? (unsigned char) *m_P++ : -1;
+	}
+};
+
+
+CP4DiffEngine::CP4DiffEngine()
+{
+	for (int side = 0; side < 2; side++)
+	{
+		m_File[side].m_Buf = NULL;
+		m_File[side].m_Size = 0;
+		m_File[side].m_Class = NULL;
+		m_File[side].m_Changed = NULL;
+		m_Count[side] = m_Where[side] = NULL;
+	}
+	m_FDiag = m_BDiag = NULL;
+	m_Flags = 0;
+	m_NumClasses = 0;
+	m_TooExpensive = 4096;
+}
+
+CP4DiffEngine::~CP4DiffEngine()
+{
+	Reset(0);
+	Reset(1);
+	FreeWorkSpace();
+}
+
+void CP4DiffEngine::Reset(int side)
+{
+	DIFFFILE &f = m_File[side];
+	delete [] f.m_Buf;
+	delete [] f.m_Class;
+	delete [] f.m_Changed;
+	f.m_Buf = NULL;
+	f.m_Class = NULL;
+	f.m_Changed = NULL;
+	f.m_Size = 0;
+	f.m_Lines.RemoveAll();
+	m_Hunks.RemoveAll();
+}
+
+void CP4DiffEngine::FreeWorkSpace()
+{
+	delete [] m_FDiag;
+	delete [] m_BDiag;
+	m_FDiag = m_BDiag = NULL;
+	for (int side = 0; side < 2; side++)
+	{
+		delete [] m_Count[side];
+		delete [] m_Where[side];
+		m_Count[side] = m_Where[side] = NULL;
+	}
+}
+
+// diffFlags are the letters that follow -d: "b", "w" or "l"
+int CP4DiffEngine::FlagsFromString(const char *diffFlags)
+{
+	int flags = 0;
+	for (const char *p = diffFlags; p && *p; p++)
+	{
+		switch (*p)
+		{
+		case 'b': flags |= DIFF_IGNOREWSCHANGES; break;
+		case 'w': flags |= DIFF_IGNOREWS; break;
+		case 'l': flags |= DIFF_IGNORELE; break;
+		}
+	}
+	return flags;
+}
+
+// The whitespace option chosen for P4Diff on the Helper Apps page
+int CP4DiffEngine::FlagsFromOptions()
+{
+	switch (GET_P4REGPTR()->GetWhtSpFlag())
+	{
+	case 0: return DIFF_IGNORELE;
+	case 1: return DIFF_IGNOREWSCHANGES;
+	case 2: return DIFF_IGNOREWS;
+	default: return 0;
+	}
+}
+
+// Compares two text files in memory and shows the result in a modeless
+// describe window, unified or side by side as the QuickDiff setting says.
+// Returns FALSE if the files could not be compared this way (too large, or
+// unreadable), in which case the caller should start the diff application
+// as usual.  Commands should let go of the server lock before calling this.
+BOOL CP4DiffEngine::QuickDiff(LPCTSTR fileName1, LPCTSTR fileName2,
+							  LPCTSTR label1, LPCTSTR label2, int flags)
+{
+	__int64 maxBytes = (__int64)GET_P4REGPTR()->GetQuickDiffMaxSize() * 1024 * 1024;
+	CString errorText;
+	CP4DiffEngine diff;
+	diff.SetFlags(flags);
+	if (!diff.LoadFile(0, fileName1, maxBytes, errorText)
+	 || !diff.LoadFile(1, fileName2, maxBytes, errorText))
+	{
+		if ( GET_P4REGPTR()->ShowCommandTrace( ) )
+			TheApp()->StatusAdd(errorText);
+		return FALSE;
+	}
+
+	CString txt;
+	if (!diff.Compare())
+	{
+		txt.FormatMessage(IDS_NO_DIFFERENCES_s_s, label1, label2);
+		TheApp()->StatusAdd(txt);
+		return TRUE;
+	}
+
+	// MainFrame owns the array from here on
+	CStringArray *pArgs = new CStringArray;
+	txt.Format(_T("%s <> %s"), label1, label2);
+	pArgs->Add(txt);
+	pArgs->Add(GET_P4REGPTR()->GetQuickDiff() == QUICKDIFF_SIDEBYSIDE
+				? diff.GetSideBySideText(label1, label2) : diff.GetUnifiedText(label1, label2));
+	pArgs->Add(label2);
+	::PostMessage(MainFrame()->m_hWnd, WM_SHOWQUICKDIFF, 0, (LPARAM)pArgs);
+	return TRUE;
+}
+
+BOOL CP4DiffEngine::LoadFile(int side, LPCTSTR fileName, __int64 maxBytes, CString &errorText)
+{
+	Reset(side);
+
+	HANDLE hFile;
+	if ((hFile = CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+				0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0)) == INVALID_HANDLE_VALUE)
+	{
+		errorText.FormatMessage(IDS_UNABLE_TO_OPEN_s, fileName);
+		return FALSE;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart > maxBytes)
+	{
+		CloseHandle(hFile);
+		errorText.FormatMessage(IDS_s_TOO_LARGE_TO_COMPARE, fileName);
+		return FALSE;
+	}
+
+	DIFFFILE &f = m_File[side];
+	f.m_Size = size.QuadPart;
+	f.m_Buf = new char[(size_t) f.m_Size + 1];
+	DWORD NumberOfBytesRead = 0;
+	BOOL b = ReadFile(hFile, f.m_Buf, (DWORD) f.m_Size, &NumberOfBytesRead, NULL);
+	CloseHandle(hFile);
+	if (!b || NumberOfBytesRead != (DWORD) f.m_Size)
+	{
+		Reset(side);
+		errorText.FormatMessage(IDS_UNABLE_TO_READ_s, fileName);
+		return FALSE;
+	}
+	f.m_Buf[f.m_Size] = '\0';
+	SplitLines(side);
+	return TRUE;
+}
+
+void CP4DiffEngine::SetText(int side, const char *text, int length)
+{
+	Reset(side);
+
+	DIFFFILE &f = m_File[side];
+	f.m_Size = length;
+	f.m_Buf = new char[length + 1];
+	memcpy(f.m_Buf, text, length);
+	f.m_Buf[length] = '\0';
+	SplitLines(side);
+}
+
+void CP4DiffEngine::SplitLines(int side)
+{
+	DIFFFILE &f = m_File[side];
+	const char *p = f.m_Buf;
+	const char *end = f.m_Buf + f.m_Size;
+
+	// Guess at the line count so the array grows in big steps
+	f.m_Lines.SetSize(0, max(1024, (INT_PTR)(f.m_Size / 64)));
+	while (p < end)
+	{
+		const char *nl = (const char *) memchr(p, '\n', end - p);
+		const char *eol = nl ? nl : end;
+
+		DIFFLINE line;
+		line.m_Text = p;
+		line.m_Length = (int)(eol - p);
+		line.m_Hash = 0;
+		f.m_Lines.Add(line);
+		p = nl ? nl + 1 : end;
+	}
+}
+
+// Hashes a line as the whitespace options see it.  Without them, which is
+// the usual case, the line is taken a machine word at a time.
+DWORD CP4DiffEngine::HashLine(const char *p, int len)
+{
+	DWORD h = 2166136261U;
+
+	if (m_Flags & (DIFF_IGNOREWS | DIFF_IGNOREWSCHANGES))
+	{
+		CLineWalker walker(p, len, m_Flags);
+		int c;
+		while ((c = walker.Next()) != -1)
+			h = (h ^ (DWORD) c) * 16777619U;
+		return h;
+	}
+
+	const char *end = p + len;
+	for ( ; end - p >= (int) sizeof(DWORD); p += sizeof(DWORD))
+	{
+		DWORD w;
+		memcpy(&w, p, sizeof(DWORD));
+		h = (_rotl(h, 5) ^ w) * 0x9E3779B1U;
+	}
+	for ( ; p < end; p++)
+		h = (h ^ (unsigned char) *p) * 16777619U;
+	return h ^ (h >> 15);
+}
+
+BOOL CP4DiffEngine::LinesEqual(const DIFFLINE &a, const DIFFLINE &b)
+{
+	if (a.m_Hash != b.m_Hash)
+		return FALSE;
+
+	if (!(m_Flags & (DIFF_IGNOREWS | DIFF_IGNOREWSCHANGES)))
+		return a.m_Length == b.m_Length && !memcmp(a.m_Text, b.m_Text, a.m_Length);
+
+	CLineWalker wa(a.m_Text, a.m_Length, m_Flags);
+	CLineWalker wb(b.m_Text, b.m_Length, m_Flags);
+	int c;
+	do
+	{
+		if ((c = wa.Next()) != wb.Next())
+			return FALSE;
+	} while (c != -1);
+	return TRUE;
+}
+
+// Compares two lines, given without their newlines, as Compare() would
+BOOL CP4DiffEngine::LinesMatch(const char *a, int alen, const char *b, int blen)
+{
+	if (m_Flags)
+	{
+		if (alen && a[alen - 1] == '\r')
+			alen--;
+		if (blen && b[blen - 1] == '\r')
+			blen--;
+	}
+	if (!(m_Flags & (DIFF_IGNOREWS | DIFF_IGNOREWSCHANGES)))
+		return alen == blen && !memcmp(a, b, alen);
+
+	DIFFLINE la, lb;
+	la.m_Text = a;
+	la.m_Length = alen;
+	lb.m_Text = b;
+	lb.m_Length = blen;
+	la.m_Hash = lb.m_Hash = 0;
+	return LinesEqual(la, lb);
+}
+
+// Numbers the lines of both files so that lines that compare equal get the
+// same number, and the comparison proper only has to look at integers
+void CP4DiffEngine::Classify()
+{
+	int n[2];
+	int side;
+	for (side = 0; side < 2; side++)
+	{
+		DIFFFILE &f = m_File[side];
+		n[side] = (int) f.m_Lines.GetSize();
+		delete [] f.m_Class;
+		f.m_Class = new int[n[side] + 1];
+
+		for (int i = 0; i < n[side]; i++)
+		{
+			DIFFLINE &line = f.m_Lines[i];
+
+			// A carriage return is part of the line unless -dl (or -db or
+			// -dw, which treat it as white space) says otherwise
+			int len = line.m_Length;
+			if (m_Flags && len && line.m_Text[len - 1] == '\r')
+				len--;
+			line.m_Hash = HashLine(line.m_Text, len);
+		}
+	}
+
+	// Open hash table of class representatives
+	int tableSize = 1024;
+	while (tableSize < 2 * (n[0] + n[1]))
+		tableSize <<= 1;
+	int *table = new int[tableSize];			// class + 1, or 0 when empty
+	memset(table, 0, tableSize * sizeof(int));
+	CArray<DIFFLINE, DIFFLINE&> reps;
+	reps.SetSize(0, 4096);
+
+	m_NumClasses = 0;
+	for (side = 0; side < 2; side++)
+	{
+		DIFFFILE &f = m_File[side];
+		for (int i = 0; i < n[side]; i++)
+		{
+			DIFFLINE line = f.m_Lines[i];
+			if (m_Flags && line.m_Length && line.m_Text[line.m_Length - 1] == '\r')
+				line.m_Length--;
+
+			int slot = line.m_Hash & (tableSize - 1);
+			while (table[slot] && !LinesEqual(reps[table[slot] - 1], line))
+				slot = (slot + 1) & (tableSize - 1);
+			if (!table[slot])
+			{
+				reps.Add(line);
+				table[slot] = ++m_NumClasses;
+			}
+			f.m_Class[i] = table[slot] - 1;
+		}
+	}
+	delete [] table;
+}
+
+int CP4DiffEngine::Compare()
+{
+	m_Hunks.RemoveAll();
+	Classify();
+
+	int n = GetLineCount(0);
+	int m = GetLineCount(1);
+	for (int side = 0; side < 2; side++)
+	{
+		int lines = side ? m : n;
+		delete [] m_File[side].m_Changed;
+		m_File[side].m_Changed = new char[lines + 1];
+		memset(m_File[side].m_Changed, 0, lines + 1);
+
+		m_Count[side] = new int[m_NumClasses + 1];
+		m_Where[side] = new int[m_NumClasses + 1];
+		memset(m_Count[side], 0, (m_NumClasses + 1) * sizeof(int));
+	}
+
+	// Diagonals run from -(m+1) to n+1
+	m_FDiag = new int[n + m + 3];
+	m_BDiag = new int[n + m + 3];
+
+	// Give up on a minimal diff at around the square root of the total size
+	int diags = n + m + 3;
+	for (m_TooExpensive = 1; diags; diags >>= 2)
+		m_TooExpensive <<= 1;
+	m_TooExpensive = max(4096, m_TooExpensive);
+
+	DiffRange(0, n, 0, m, 0);
+	FreeWorkSpace();
+
+	BuildHunks();
+	return GetHunkCount();
+}
+
+void CP4DiffEngine::DiffRange(int xoff, int xlim, int yoff, int ylim, int depth)
+{
+	const int *xv = m_File[0].m_Class;
+	const int *yv = m_File[1].m_Class;
+
+	while (xoff < xlim && yoff < ylim && xv[xoff] == yv[yoff])
+		xoff++, yoff++;
+	while (xoff < xlim && yoff < ylim && xv[xlim - 1] == yv[ylim - 1])
+		xlim--, ylim--;
+
+	CArray<POINT, POINT&> anchors;
+	if (xoff == xlim || yoff == ylim || depth >= MAXANCHORDEPTH
+	 || !FindAnchors(xoff, xlim, yoff, ylim, anchors))
+	{
+		CompareSeq(xoff, xlim, yoff, ylim, FALSE);
+		return;
+	}
+
+	for (INT_PTR i = 0; i < anchors.GetSize(); i++)
+	{
+		DiffRange(xoff, anchors[i].x, yoff, anchors[i].y, depth + 1);
+		xoff = anchors[i].x + 1;
+		yoff = anchors[i].y + 1;
+	}
+	DiffRange(xoff, xlim, yoff, ylim, depth + 1);
+}
+
+// Finds the lines that occur exactly once in each range, and of those the
+// longest run that appears in the same order in both
+BOOL CP4DiffEngine::FindAnchors(int xoff, int xlim, int yoff, int ylim, CArray<POINT, POINT&> &anchors)
+{
+	const int *xv = m_File[0].m_Class;
+	const int *yv = m_File[1].m_Class;
+	int i;
+
+	for (i = xoff; i < xlim; i++)
+	{
+		m_Count[0][xv[i]]++;
+		m_Where[0][xv[i]] = i;
+	}
+	for (i = yoff; i < ylim; i++)
+	{
+		m_Count[1][yv[i]]++;
+		m_Where[1][yv[i]] = i;
+	}
+
+	CArray<POINT, POINT&> cand;
+	for (i = xoff; i < xlim; i++)
+	{
+		int c = xv[i];
+		if (m_Count[0][c] == 1 && m_Count[1][c] == 1)
+		{
+			POINT pt;
+			pt.x = i;
+			pt.y = m_Where[1][c];
+			cand.Add(pt);
+		}
+	}
+
+	for (i = xoff; i < xlim; i++)
+		m_Count[0][xv[i]] = 0;
+	for (i = yoff; i < ylim; i++)
+		m_Count[1][yv[i]] = 0;
+
+	int ncand = (int) cand.GetSize();
+	if (!ncand)
+		return FALSE;
+
+	// Longest increasing subsequence of the second file's line numbers,
+	// by patience sorting
+	int *tails = new int[ncand];
+	int *prev = new int[ncand];
+	int len = 0;
+	for (i = 0; i < ncand; i++)
+	{
+		int lo = 0, hi = len;
+		while (lo < hi)
+		{
+			int mid = (lo + hi) / 2;
+			if (cand[tails[mid]].y < cand[i].y)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		prev[i] = lo ? tails[lo - 1] : -1;
+		tails[lo] = i;
+		if (lo == len)
+			len++;
+	}
+
+	anchors.SetSize(len);
+	for (i = tails[len - 1]; len > 0; i = prev[i])
+		anchors[--len] = cand[i];
+
+	delete [] tails;
+	delete [] prev;
+	return TRUE;
+}
+
+// Myers' algorithm, finding the middle snake and recursing on each side of
+// it.  This follows the classic GNU diff implementation, including its cost
+// cutoff, so pathological inputs take a near-minimal diff rather than
+// quadratic time.
+void CP4DiffEngine::CompareSeq(int xoff, int xlim, int yoff, int ylim, BOOL findMinimal)
+{
+	const int *xv = m_File[0].m_Class;
+	const int *yv = m_File[1].m_Class;
+
+	while (xoff < xlim && yoff < ylim && xv[xoff] == yv[yoff])
+		xoff++, yoff++;
+	while (xlim > xoff && ylim > yoff && xv[xlim - 1] == yv[ylim - 1])
+		xlim--, ylim--;
+
+	if (xoff == xlim)
+	{
+		while (yoff < ylim)
+			m_File[1].m_Changed[yoff++] = 1;
+	}
+	else if (yoff == ylim)
+	{
+		while (xoff < xlim)
+			m_File[0].m_Changed[xoff++] = 1;
+	}
+	else
+	{
+		int xmid, ymid;
+		BOOL loMinimal, hiMinimal;
+		Diag(xoff, xlim, yoff, ylim, findMinimal, xmid, ymid, loMinimal, hiMinimal);
+		CompareSeq(xoff, xmid, yoff, ymid, loMinimal);
+		CompareSeq(xmid, xlim, ymid, ylim, hiMinimal);
+	}
+}
+
+void CP4DiffEngine::Diag(int xoff, int xlim, int yoff, int ylim, BOOL findMinimal,
+						 int &xmid, int &ymid, BOOL &loMinimal, BOOL &hiMinimal)
+{
+	const int *xv = m_File[0].m_Class;
+	const int *yv = m_File[1].m_Class;
+	int *fd = m_FDiag + GetLineCount(1) + 1;
+	int *bd = m_BDiag + GetLineCount(1) + 1;
+
+	const int dmin = xoff - ylim;		// minimum valid diagonal
+	const int dmax = xlim - yoff;		// maximum valid diagonal
+	const int fmid = xoff - yoff;		// center diagonal of top-down search
+	const int bmid = xlim - ylim;		// center diagonal of bottom-up search
+	int fmin = fmid, fmax = fmid;
+	int bmin = bmid, bmax = bmid;
+	BOOL odd = (fmid - bmid) & 1;
+	int d;
+
+	fd[fmid] = xoff;
+	bd[bmid] = xlim;
+
+	for (int c = 1; ; c++)
+	{
+		// Extend the top-down search by an edit step in each diagonal
+		if (fmin > dmin)
+			fd[--fmin - 1] = -1;
+		else
+			++fmin;
+		if (fmax < dmax)
+			fd[++fmax + 1] = -1;
+		else
+			--fmax;
+		for (d = fmax; d >= fmin; d -= 2)
+		{
+			int x, y, tlo = fd[d - 1], thi = fd[d + 1];
+			x = tlo >= thi ? tlo + 1 : thi;
+			y = x - d;
+			while (x < xlim && y < ylim && xv[x] == yv[y])
+				x++, y++;
+			fd[d] = x;
+			if (odd && bmin <= d && d <= bmax && bd[d] <= x)
+			{
+				xmid = x;
+				ymid = y;
+				loMinimal = hiMinimal = TRUE;
+				return;
+			}
+		}
+
+		// Similarly extend the bottom-up search
+		if (bmin > dmin)
+			bd[--bmin - 1] = INT_MAX;
+		else
+			++bmin;
+		if (bmax < dmax)
+			bd[++bmax + 1] = INT_MAX;
+		else
+			--bmax;
+		for (d = bmax; d >= bmin; d -= 2)
+		{
+			int x, y, tlo = bd[d - 1], thi = bd[d + 1];
+			x = tlo < thi ? tlo : thi - 1;
+			y = x - d;
+			while (x > xoff && y > yoff && xv[x - 1] == yv[y - 1])
+				x--, y--;
+			bd[d] = x;
+			if (!odd && fmin <= d && d <= fmax && x <= fd[d])
+			{
+				xmid = x;
+				ymid = y;
+				loMinimal = hiMinimal = TRUE;
+				return;
+			}
+		}
+
+		if (findMinimal || c < m_TooExpensive)
+			continue;
+
+		// Gone well beyond the call of duty: split at whichever of the two
+		// searches has got furthest
+		int fxybest = -1, fxbest = 0;
+		for (d = fmax; d >= fmin; d -= 2)
+		{
+			int x = min(fd[d], xlim);
+			int y = x - d;
+			if (ylim < y)
+				x = ylim + d, y = ylim;
+			if (fxybest < x + y)
+			{
+				fxybest = x + y;
+				fxbest = x;
+			}
+		}
+
+		int bxybest = INT_MAX, bxbest = 0;
+		for (d = bmax; d >= bmin; d -= 2)
+		{
+			int x = max(xoff, bd[d]);
+			int y = x - d;
+			if (y < yoff)
+				x = yoff + d, y = yoff;
+			if (x + y < bxybest)
+			{
+				bxybest = x + y;
+				bxbest = x;
+			}
+		}
+
+		if ((xlim + ylim) - bxybest < fxybest - (xoff + yoff))
+		{
+			xmid = fxbest;
+			ymid = fxybest - fxbest;
+			loMinimal = TRUE;
+			hiMinimal = FALSE;
+		}
+		else
+		{
+			xmid = bxbest;
+			ymid = bxybest - bxbest;
+			loMinimal = FALSE;
+			hiMinimal = TRUE;
+		}
+		return;
+	}
+}
+
+void CP4DiffEngine::BuildHunks()
+{
+	int n = GetLineCount(0);
+	int m = GetLineCount(1);
+	const char *chg1 = m_File[0].m_Changed;
+	const char *chg2 = m_File[1].m_Changed;
+	int x = 0, y = 0;
+
+	while (x < n || y < m)
+	{
+		if (x < n && y < m && !chg1[x] && !chg2[y])
+		{
+			x++, y++;
+			continue;
+		}
+
+		DIFFHUNK hunk;
+		hunk.m_Start1 = x;
+		hunk.m_Start2 = y;
+		while (x < n && chg1[x])
+			x++;
+		while (y < m && chg2[y])
+			y++;
+		hunk.m_Count1 = x - hunk.m_Start1;
+		hunk.m_Count2 = y - hunk.m_Start2;
+		m_Hunks.Add(hunk);
+	}
+}
+
+CString CP4DiffEngine::GetLine(int side, int line)
+{
+	const DIFFLINE &l = m_File[side].m_Lines[line];
+	int len = l.m_Length;
+	if (len && l.m_Text[len - 1] == '\r')
+		len--;
+	CStringA str(l.m_Text, len);
+	return CharToCString(str);
+}
+
+// Returns the raw bytes of a line, including its line terminator if any
+void CP4DiffEngine::GetLineText(int side, int line, const char *&text, int &length)
+{
+	const DIFFFILE &f = m_File[side];
+	const DIFFLINE &l = f.m_Lines[line];
+	text = l.m_Text;
+	length = l.m_Length;
+	if (text + length < f.m_Buf + f.m_Size)
+		length++;
+}
+
+BOOL CP4DiffEngine::SameText(int side, const char *text, __int64 length)
+{
+	return length == m_File[side].m_Size && !memcmp(m_File[side].m_Buf, text, (size_t) length);
+}
+
+void CP4DiffEngine::AppendLine(CStringA &out, char prefix, int side, int line)
+{
+	const DIFFLINE &l = m_File[side].m_Lines[line];
+	int len = l.m_Length;
+	if (len && l.m_Text[len - 1] == '\r')
+		len--;
+	out += prefix;
+	out.Append(l.m_Text, len);
+	out += '\n';
+}
+
+// Formats the hunks as "diff -u" would, with hunks whose context would
+// overlap joined together
+CString CP4DiffEngine::GetUnifiedText(LPCTSTR label1, LPCTSTR label2, int context)
+{
+	CStringA out;
+	int n = GetLineCount(0);
+	int count = GetHunkCount();
+
+	for (int h = 0; h < count; )
+	{
+		int first = h, last = h;
+		while (last + 1 < count && m_Hunks[last + 1].m_Start1
+				- (m_Hunks[last].m_Start1 + m_Hunks[last].m_Count1) <= 2 * context)
+			last++;
+
+		const DIFFHUNK &fh = m_Hunks[first];
+		const DIFFHUNK &lh = m_Hunks[last];
+		int s1 = max(0, fh.m_Start1 - context);
+		int s2 = fh.m_Start2 - (fh.m_Start1 - s1);
+		int e1 = min(n, lh.m_Start1 + lh.m_Count1 + context);
+		int e2 = lh.m_Start2 + lh.m_Count2 + (e1 - (lh.m_Start1 + lh.m_Count1));
+
+		CStringA hdr;
+		hdr.Format("@@ -%d,%d +%d,%d @@\n", e1 > s1 ? s1 + 1 : s1, e1 - s1,
+											e2 > s2 ? s2 + 1 : s2, e2 - s2);
+		out += hdr;
+
+		int x = s1, y = s2;
+		for (int k = first; k <= last; k++)
+		{
+			const DIFFHUNK &hk = m_Hunks[k];
+			for ( ; x < hk.m_Start1; x++, y++)
+				AppendLine(out, ' ', 0, x);
+			for (int i = 0; i < hk.m_Count1; i++)
+				AppendLine(out, '-', 0, x++);
+			for (int j = 0; j < hk.m_Count2; j++)
+				AppendLine(out, '+', 1, y++);
+		}
+		for ( ; x < e1; x++, y++)
+			AppendLine(out, ' ', 0, x);
+
+		h = last + 1;
+	}
+
+	CString txt;
+	txt.Format(_T("--- %s\n+++ %s\n"), label1, label2);
+	return txt + CharToCString(out);
+}
+
+// Pairs up the lines of the two files for a side-by-side view.  Changed
+// lines share rows as far as they go.  With a context of -1 every line gets
+// a row, otherwise only the lines within that many rows of a change.
+void CP4DiffEngine::GetSideBySide(CArray<DIFFROW, DIFFROW&> &rows, int context)
+{
+	int n = GetLineCount(0);
+	int count = GetHunkCount();
+	int x = 0, y = 0;
+	DIFFROW row;
+
+	rows.RemoveAll();
+	for (int h = 0; h <= count; h++)
+	{
+		int nextx = h < count ? m_Hunks[h].m_Start1 : n;
+		int after = h ? x + context : 0;			// shown for the hunk above
+		int before = h < count ? nextx - context : n;	// shown for the hunk below
+		for ( ; x < nextx; x++, y++)
+		{
+			if (context >= 0 && x >= after && x < before)
+				continue;
+			row.m_Line1 = x;
+			row.m_Line2 = y;
+			row.m_Type = ' ';
+			rows.Add(row);
+		}
+		if (h == count)
+			break;
+
+		const DIFFHUNK &hunk = m_Hunks[h];
+		int both = min(hunk.m_Count1, hunk.m_Count2);
+		for (int i = 0; i < max(hunk.m_Count1, hunk.m_Count2); i++)
+		{
+			row.m_Line1 = i < hunk.m_Count1 ? x + i : -1;
+			row.m_Line2 = i < hunk.m_Count2 ? y + i : -1;
+			row.m_Type = i < both ? '!' : i < hunk.m_Count1 ? '-' : '+';
+			rows.Add(row);
+		}
+		x += hunk.m_Count1;
+		y += hunk.m_Count2;
+	}
+}
+
+// Appends a line, numbered, with its tabs expanded and cut or padded to
+// width characters; an empty column if line is -1
+void CP4DiffEngine::AppendColumn(CStringA &out, int side, int line, int width)
+{
+	CStringA col;
+	if (line >= 0)
+	{
+		const DIFFLINE &l = m_File[side].m_Lines[line];
+		int len = l.m_Length;
+		if (len && l.m_Text[len - 1] == '\r')
+			len--;
+		int tab = max(1, GET_P4REGPTR()->GetMrgTabWidth());
+		col.Format("%6d  ", line + 1);
+		for (int i = 0; i < len && col.GetLength() < width; i++)
+		{
+			if (l.m_Text[i] == '\t')
+			{
+				do col += ' '; while ((col.GetLength() - 8) % tab);
+			}
+			else
+				col += l.m_Text[i];
+		}
+	}
+	if (col.GetLength() > width)
+		col = col.Left(width);
+	while (col.GetLength() < width)
+		col += ' ';
+	out += col;
+}
+
+// Formats the hunks as two columns, the first file on the left, in the
+// manner of sdiff: '|' marks a changed line, '<' and '>' a line only on
+// that side.  "..." stands for unchanged lines that are left out.
+CString CP4DiffEngine::GetSideBySideText(LPCTSTR label1, LPCTSTR label2, int context)
+{
+	CArray<DIFFROW, DIFFROW&> rows;
+	GetSideBySide(rows, context);
+
+	int width = SIDEBYSIDEWIDTH + 8;
+	CStringA out;
+	int next1 = 0, next2 = 0;
+	for (int r = 0; r < rows.GetSize(); r++)
+	{
+		const DIFFROW &row = rows[r];
+		if ((row.m_Line1 >= 0 && row.m_Line1 != next1)
+		 || (row.m_Line2 >= 0 && row.m_Line2 != next2))
+			out += "...\n";
+		if (row.m_Line1 >= 0)
+			next1 = row.m_Line1 + 1;
+		if (row.m_Line2 >= 0)
+			next2 = row.m_Line2 + 1;
+
+		AppendColumn(out, 0, row.m_Line1, width);
+		switch (row.m_Type)
+		{
+		case '!': out += " | "; break;
+		case '-': out += " < "; break;
+		case '+': out += " > "; break;
+		default:  out += "   "; break;
+		}
+		AppendColumn(out, 1, row.m_Line2, width);
+		out.TrimRight(' ');
+		out += '\n';
+	}
+
+	CString txt;
+	txt.Format(_T("%-*s   %s\n"), width, label1, label2);
+	return txt + CharToCString(out);
+}
@@ -0,0 +1,125 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4DiffEngine.h
+//
+// CP4DiffEngine compares two text files in memory, so a quick look at what
+// changed doesn't have to start an external diff program.  Lines are hashed
+// and numbered into equivalence classes first (honoring the -db, -dw and -dl
+// whitespace options), then the sequences of class numbers are compared:
+// lines that occur exactly once in each file anchor the comparison (the
+// "patience" heuristic, which keeps moved blocks and braces from pairing up
+// badly), and Myers' O(ND) algorithm, in linear space and with a cost cutoff,
+// fills in between the anchors.  The result is a list of hunks, which can be
+// formatted as unified diff text or as side-by-side rows.
+
+#ifndef __P4DIFFENGINE__
+#define __P4DIFFENGINE__
+
+// Values of the QuickDiff setting: how a quick diff is shown
+#define QUICKDIFF_UNIFIED		1
+#define QUICKDIFF_SIDEBYSIDE	2
+
+// Whitespace options, as for "p4 diff -d<flags>"
+#define DIFF_IGNOREWSCHANGES	0x01	// -db
+#define DIFF_IGNOREWS			0x02	// -dw
+#define DIFF_IGNORELE			0x04	// -dl
+
+// A run of lines that differ: m_Count1 lines at m_Start1 in the first file
+// were replaced by m_Count2 lines at m_Start2 in the second (0-based)
+struct DIFFHUNK
+{
+	int m_Start1;
+	int m_Count1;
+	int m_Start2;
+	int m_Count2;
+};
+
+// One row of a side-by-side view; a line number is -1 where that side has
+// no line in the row
+struct DIFFROW
+{
+	int  m_Line1;
+	int  m_Line2;
+	char m_Type;		// ' ' same, '-' only in the first, '+' only in the second, '!' changed
+};
+
+class CP4DiffEngine
+{
+public:
+	CP4DiffEngine();
+	~CP4DiffEngine();
+
+protected:
+	struct DIFFLINE
+	{
+		const char *m_Text;
+		int m_Length;			// without the line terminator
+		DWORD m_Hash;
+	};
+
+	struct DIFFFILE
+	{
+		char *m_Buf;
+		__int64 m_Size;
+		CArray<DIFFLINE, DIFFLINE&> m_Lines;
+		int *m_Class;			// equivalence class of each line
+		char *m_Changed;		// set for each line that is part of a hunk
+	};
+
+	DIFFFILE m_File[2];
+	int m_Flags;
+	int m_NumClasses;
+	CArray<DIFFHUNK, DIFFHUNK&> m_Hunks;
+
+	// Work space for the comparison
+	int *m_FDiag;
+	int *m_BDiag;
+	int m_TooExpensive;
+	int *m_Count[2];
+	int *m_Where[2];
+
+public:
+	static int FlagsFromString(const char *diffFlags);
+	static int FlagsFromOptions();
+	static BOOL QuickDiff(LPCTSTR fileName1, LPCTSTR fileName2,
+						  LPCTSTR label1, LPCTSTR label2, int flags);
+	void SetFlags(int flags) { m_Flags = flags; }
+
+	BOOL LoadFile(int side, LPCTSTR fileName, __int64 maxBytes, CString &errorText);
+	void SetText(int side, const char *text, int length);
+	int  Compare();				// returns the number of hunks
+
+	int GetHunkCount() { return (int) m_Hunks.GetSize(); }
+	const DIFFHUNK &GetHunk(int i) { return m_Hunks[i]; }
+	int GetLineCount(int side) { return (int) m_File[side].m_Lines.GetSize(); }
+	__int64 GetSize(int side) { return m_File[side].m_Size; }
+	CString GetLine(int side, int line);
+	void GetLineText(int side, int line, const char *&text, int &length);
+	BOOL SameText(int side, const char *text, __int64 length);
+	BOOL LinesMatch(const char *a, int alen, const char *b, int blen);
+
+	CString GetUnifiedText(LPCTSTR label1, LPCTSTR label2, int context = 3);
+	void GetSideBySide(CArray<DIFFROW, DIFFROW&> &rows, int context = -1);
+	CString GetSideBySideText(LPCTSTR label1, LPCTSTR label2, int context = 3);
+
+protected:
+	void Reset(int side);
+	void FreeWorkSpace();
+	void SplitLines(int side);
+	DWORD HashLine(const char *p, int len);
+	BOOL LinesEqual(const DIFFLINE &a, const DIFFLINE &b);
+	void Classify();
+	void DiffRange(int xoff, int xlim, int yoff, int ylim, int depth);
+	BOOL FindAnchors(int xoff, int xlim, int yoff, int ylim, CArray<POINT, POINT&> &anchors);
+	void CompareSeq(int xoff, int xlim, int yoff, int ylim, BOOL findMinimal);
+	void Diag(int xoff, int xlim, int yoff, int ylim, BOOL findMinimal,
+			  int &xmid, int &ymid, BOOL &loMinimal, BOOL &hiMinimal);
+	void BuildHunks();
+	void AppendLine(CStringA &out, char prefix, int side, int line);
+	void AppendColumn(CStringA &out, int side, int line, int width);
+};
+
+#endif //__P4DIFFENGINE__
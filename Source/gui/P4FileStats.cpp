@@ -87,6 +87,7 @@ void CP4FileStats::Clear()
 	m_UserParam=0;
 	m_NotInDepot=FALSE;
 	m_FileSize=0;
+	m_StatTime=0;
 
 	m_DepotPath=_T("");
 	m_ClientPath=_T("");
@@ -114,6 +115,7 @@ void CP4FileStats::Create( CP4FileStats *st )
 	m_OtherOpens= st->m_OtherOpens;
 	m_UserParam= st->m_UserParam;
 	m_NotInDepot= st->m_NotInDepot;
+	m_StatTime= st->m_StatTime;
 
 	m_DepotPath= st->m_DepotPath;
 	m_ClientPath= st->m_ClientPath;
@@ -254,6 +256,8 @@ BOOL CP4FileStats::Create(StrDict *client)
 	
 	if( (str= client->GetVar( "unresolved" )) != NULL)
 		m_Unresolved=TRUE;
+	if( (str= client->GetVar( "resolved" )) != NULL)
+		m_Resolved=TRUE;
 
 	str= client->GetVar( "actionOwner" );
     if(str)
@@ -279,6 +283,7 @@ BOOL CP4FileStats::Create(StrDict *client)
 	ASSERT(client->GetVar("headAction")==NULL || m_HeadAction);
 	ASSERT(client->GetVar("action")==NULL || m_MyOpenAction);
 
+	m_StatTime= max(1, GetTickCount());
 
 	return TRUE;
 badFile:
@@ -99,6 +99,7 @@ protected:
 
 	LPARAM m_UserParam;
 	BOOL m_NotInDepot;
+	DWORD m_StatTime;		// tick count when fstat filled it in, 0 if not by fstat
 
 public:
 // Creation and assignment members
@@ -161,6 +162,7 @@ public:
 	LPCTSTR GetOtherUsers() const {return m_OtherUsers;}
 	inline LPARAM GetUserParam() const {return m_UserParam; }
 	inline BOOL IsNotInDepot() const {return m_NotInDepot; }
+	inline DWORD GetStatTime() const {return m_StatTime; }
 
 	BOOL IsTextFile() const;
 	BOOL IsMyOpenExclusive() const;
@@ -0,0 +1,178 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4FolderCompare.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4FolderCompare.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+CP4FolderCompare::CP4FolderCompare()
+{
+	memset(m_Counts, 0, sizeof(m_Counts));
+}
+
+// "//depot/main/...#3" -> "//depot/main/",  "//...@label" -> "//"
+CString CP4FolderCompare::FolderFromSpec(LPCTSTR spec)
+{
+	CString folder = spec;
+	int i;
+	if ((i = folder.Find(_T("..."))) != -1)
+		folder = folder.Left(i);
+	else if ((i = folder.ReverseFind(_T('/'))) != -1)
+		folder = folder.Left(i + 1);
+	return folder;
+}
+
+// Adds a file from fstat.  Deleted revisions count as no file, as they
+// do for diff2.
+BOOL CP4FolderCompare::AddFile(int side, LPCTSTR depotFile, long rev, LPCTSTR type,
+							   LPCTSTR action, LPCTSTR digest, __int64 size)
+{
+	if (!rev || _tcsstr(action, _T("delete")) || !_tcscmp(action, _T("purge")))
+		return FALSE;
+
+	FOLDERFILE file;
+	int lgth = m_Folder[side].GetLength();
+	file.m_Name = nCompare(depotFile, m_Folder[side], lgth) ? depotFile : depotFile + lgth;
+	file.m_Rev = rev;
+	file.m_Size = size;
+
+	int t;
+	for (t = 0; t < m_Types.GetSize() && m_Types[t] != type; t++)
+		;
+	if (t == m_Types.GetSize())
+		m_Types.Add(type);
+	file.m_Type = t;
+
+	// 32 hex digits of MD5; anything else and the file can't be shown to
+	// be the same as any other
+	file.m_HasDigest = lstrlen(digest) == 32;
+	for (int i = 0; file.m_HasDigest && i < 16; i++)
+	{
+		int hi = _istdigit(digest[2*i]) ? digest[2*i] - _T('0') : (_totupper(digest[2*i]) - _T('A') + 10);
+		int lo = _istdigit(digest[2*i+1]) ? digest[2*i+1] - _T('0') : (_totupper(digest[2*i+1]) - _T('A') + 10);
+		if (hi < 0 || hi > 15 || lo < 0 || lo > 15)
+			file.m_HasDigest = FALSE;
+		file.m_Digest[i] = (BYTE)((hi << 4) | lo);
+	}
+	m_Files[side].Add(file);
+	return TRUE;
+}
+
+int CP4FolderCompare::CompareFiles(const void *arg1, const void *arg2)
+{
+	return ::Compare(((const FOLDERFILE *) arg1)->m_Name, ((const FOLDERFILE *) arg2)->m_Name);
+}
+
+BOOL CP4FolderCompare::SameFile(const FOLDERFILE &left, const FOLDERFILE &right)
+{
+	return left.m_HasDigest && right.m_HasDigest
+		&& left.m_Size == right.m_Size
+		&& left.m_Type == right.m_Type
+		&& !memcmp(left.m_Digest, right.m_Digest, sizeof(left.m_Digest));
+}
+
+void CP4FolderCompare::AddRow(int status, int left, int right)
+{
+	m_Counts[status]++;
+	if (status == FOLDER_IDENTICAL)
+		return;
+
+	FOLDERROW row;
+	row.m_Status = status;
+	row.m_Left = left;
+	row.m_Right = right;
+	m_Rows.Add(row);
+}
+
+// Sorts both lists by name and walks them together.  Returns the number of
+// files that are not identical.
+int CP4FolderCompare::Compare()
+{
+	m_Rows.RemoveAll();
+	memset(m_Counts, 0, sizeof(m_Counts));
+	for (int side = 0; side < 2; side++)
+		qsort((void *) m_Files[side].GetData(), m_Files[side].GetSize(), sizeof(FOLDERFILE), CompareFiles);
+
+	int nleft = GetFileCount(0);
+	int nright = GetFileCount(1);
+	m_Rows.SetSize(0, 1024);
+	int i = 0, j = 0;
+	while (i < nleft || j < nright)
+	{
+		int cmp = i == nleft ? 1 : j == nright ? -1 : ::Compare(m_Files[0][i].m_Name, m_Files[1][j].m_Name);
+		if (cmp < 0)
+		{
+			AddRow(FOLDER_LEFTONLY, i++, -1);
+		}
+		else if (cmp > 0)
+		{
+			AddRow(FOLDER_RIGHTONLY, -1, j++);
+		}
+		else
+		{
+			AddRow(SameFile(m_Files[0][i], m_Files[1][j]) ? FOLDER_IDENTICAL : FOLDER_DIFFERENT, i, j);
+			i++;
+			j++;
+		}
+	}
+	m_Rows.FreeExtra();
+	return GetRowCount();
+}
+
+// "name#rev (type)" as diff2 shows it, with or without the folder
+CString CP4FolderCompare::GetFileText(int side, int row, BOOL fullPath)
+{
+	int index = side ? m_Rows[row].m_Right : m_Rows[row].m_Left;
+	if (index < 0)
+		return _T("<none>");
+
+	const FOLDERFILE &file = m_Files[side][index];
+	CString txt;
+	txt.Format(_T("%s%s#%ld (%s)"), fullPath ? m_Folder[side] : _T(""), file.m_Name,
+		file.m_Rev, m_Types[file.m_Type]);
+	return txt;
+}
+
+// The line "diff2 -q" would have printed for the row
+CString CP4FolderCompare::GetRowText(int row)
+{
+	const FOLDERROW &r = m_Rows[row];
+	CString txt = _T("==== ") + GetFileText(0, row, TRUE) + _T(" - ") + GetFileText(1, row, TRUE) + _T(" ====");
+	if (r.m_Status == FOLDER_DIFFERENT)
+	{
+		const FOLDERFILE &left = m_Files[0][r.m_Left];
+		const FOLDERFILE &right = m_Files[1][r.m_Right];
+		txt += left.m_Type != right.m_Type && left.m_HasDigest && right.m_HasDigest
+			&& !memcmp(left.m_Digest, right.m_Digest, sizeof(left.m_Digest))
+			 ? _T(" types") : _T(" content");
+	}
+	return txt;
+}
+
+CString CP4FolderCompare::GetText()
+{
+	CString text;
+	for (int row = 0; row < GetRowCount(); row++)
+		text += GetRowText(row) + _T('\n');
+	return text;
+}
+
+CString CP4FolderCompare::GetSummary()
+{
+	CString txt;
+	txt.Format(_T("Compared %s and %s: %d identical, %d different, %d only in %s, %d only in %s"),
+		m_Folder[0], m_Folder[1], m_Counts[FOLDER_IDENTICAL], m_Counts[FOLDER_DIFFERENT],
+		m_Counts[FOLDER_LEFTONLY], m_Folder[0], m_Counts[FOLDER_RIGHTONLY], m_Folder[1]);
+	return txt;
+}
@@ -0,0 +1,77 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4FolderCompare.h
+//
+// CP4FolderCompare compares two depot folders the way "p4 diff2 -q" does,
+// but on the client: the two file lists, with their digests, come from
+// "fstat -Ol", and a merge join of the sorted lists sorts each file into
+// identical, different, only on the left or only on the right.  Only the
+// files that are not identical are kept as rows, each row just a pair of
+// indexes into the file lists, so the result can back a virtual list.
+
+#ifndef __P4FOLDERCOMPARE__
+#define __P4FOLDERCOMPARE__
+
+#define FOLDER_IDENTICAL	0
+#define FOLDER_DIFFERENT	1
+#define FOLDER_LEFTONLY		2
+#define FOLDER_RIGHTONLY	3
+
+struct FOLDERFILE
+{
+	CString m_Name;				// path below the folder
+	long	m_Rev;
+	int		m_Type;				// index into m_Types
+	BOOL	m_HasDigest;
+	BYTE	m_Digest[16];
+	__int64 m_Size;
+};
+
+struct FOLDERROW
+{
+	int		m_Status;
+	int		m_Left;				// index into the left list, or -1
+	int		m_Right;			// index into the right list, or -1
+};
+
+class CP4FolderCompare
+{
+public:
+	CP4FolderCompare();
+
+protected:
+	CString m_Folder[2];		// depot syntax, with the trailing '/'
+	CArray<FOLDERFILE, FOLDERFILE&> m_Files[2];
+	CStringArray m_Types;		// file types, each held once
+	CArray<FOLDERROW, FOLDERROW&> m_Rows;
+	int		m_Counts[4];
+
+public:
+	void SetFolder(int side, LPCTSTR folder) { m_Folder[side] = folder; }
+	LPCTSTR GetFolder(int side) { return m_Folder[side]; }
+	static CString FolderFromSpec(LPCTSTR spec);
+
+	BOOL AddFile(int side, LPCTSTR depotFile, long rev, LPCTSTR type, LPCTSTR action,
+				 LPCTSTR digest, __int64 size);
+	int  Compare();
+
+	int  GetRowCount() { return (int) m_Rows.GetSize(); }
+	const FOLDERROW &GetRow(int row) { return m_Rows[row]; }
+	int  GetCount(int status) { return m_Counts[status]; }
+	int  GetFileCount(int side) { return (int) m_Files[side].GetSize(); }
+
+	CString GetFileText(int side, int row, BOOL fullPath = FALSE);
+	CString GetRowText(int row);
+	CString GetText();
+	CString GetSummary();
+
+protected:
+	static int CompareFiles(const void *arg1, const void *arg2);
+	BOOL SameFile(const FOLDERFILE &left, const FOLDERFILE &right);
+	void AddRow(int status, int left, int right);
+};
+
+#endif //__P4FOLDERCOMPARE__
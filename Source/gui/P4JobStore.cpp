@@ -0,0 +1,528 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4JobStore.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4Job.h"
+#include "P4JobStore.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+CP4JobStore::CP4JobStore()
+{
+	m_NameField = 0;
+	m_DateField = -1;
+	m_IndexDirty = TRUE;
+	m_Loaded = m_Complete = m_Stale = FALSE;
+	m_LoadTicks = 0;
+	m_Next = 0;
+	m_Failed = FALSE;
+}
+
+CP4JobStore::~CP4JobStore()
+{
+	Clear();
+}
+
+// Takes the field names, codes and types from the jobspec.  Returns TRUE
+// if the spec has changed, in which case the jobs held are thrown away.
+BOOL CP4JobStore::SetSpec(LPCTSTR spec)
+{
+	if (m_Spec == spec)
+		return FALSE;
+
+	Clear();
+	m_Spec = spec;
+
+	// The fields are listed between "Fields:" and "Required:", one to
+	// a line, e.g. "101 Job word 32 required"
+	int start = m_Spec.Find(_T("Fields:"));
+	int end = m_Spec.Find(_T("Required:"));
+	if (start == -1 || end < start)
+		return TRUE;
+	CString fields = m_Spec.Mid(start + lstrlen(_T("Fields:")), end - start - lstrlen(_T("Fields:")));
+
+	int pos = 0;
+	CString line = fields.Tokenize(_T("\r\n"), pos);
+	while (!line.IsEmpty())
+	{
+		int i = 0;
+		CString code = line.Tokenize(_T(" \t"), i);
+		CString name = line.Tokenize(_T(" \t"), i);
+		CString type = line.Tokenize(_T(" \t"), i);
+		if (_ttoi(code) && !name.IsEmpty())
+		{
+			if (_ttoi(code) == JOB_NAME_CODE)
+				m_NameField = (int) m_Names.GetSize();
+			else if (_ttoi(code) == JOB_DATE_CODE && type == _T("date"))
+				m_DateField = (int) m_Names.GetSize();
+			m_Names.Add(name);
+			m_Codes.Add(_ttoi(code));
+			m_IsDate.Add((BYTE)(type == _T("date")));
+		}
+		line = fields.Tokenize(_T("\r\n"), pos);
+	}
+	return TRUE;
+}
+
+// Replaces whatever is held with jobs, which must have been fetched with
+// GetFieldNames() and GetFieldCodes().  The jobs are deleted.
+void CP4JobStore::Load(CObList *jobs, BOOL complete)
+{
+	RemoveAll();
+	Merge(jobs);
+	m_Loaded = TRUE;
+	m_Complete = complete;
+	m_LoadTicks = GetTickCount();
+}
+
+// Adds or updates jobs, which are deleted
+BOOL CP4JobStore::Merge(CObList *jobs)
+{
+	for (POSITION pos = jobs->GetHeadPosition(); pos != NULL; )
+	{
+		CP4Job *job = (CP4Job *) jobs->GetNext(pos);
+		Set(job);
+		delete job;
+	}
+	jobs->RemoveAll();
+	m_Stale = FALSE;
+	return TRUE;
+}
+
+void CP4JobStore::Set(CP4Job *job)
+{
+	CStringArray *values = new CStringArray;
+	for (int i = 0; i < m_Names.GetSize(); i++)
+		values->Add(job->GetJobField(i));
+	CString name = values->GetAt(m_NameField);
+
+	void *p;
+	if (m_ByName.Lookup(name, p))
+	{
+		INT_PTR i = (INT_PTR) p - 1;
+		delete GetJob((int) i);
+		m_Jobs.SetAt(i, values);
+	}
+	else
+		m_ByName.SetAt(name, (void *)(m_Jobs.Add(values) + 1));
+
+	if (m_DateField != -1)
+		NoteDate(values->GetAt(m_DateField));
+	m_IndexDirty = TRUE;
+}
+
+void CP4JobStore::Remove(LPCTSTR jobName)
+{
+	void *p;
+	if (!m_ByName.Lookup(jobName, p))
+		return;
+	INT_PTR i = (INT_PTR) p - 1;
+	delete GetJob((int) i);
+	m_Jobs.RemoveAt(i);
+
+	m_ByName.RemoveAll();
+	for (i = 0; i < m_Jobs.GetSize(); i++)
+		m_ByName.SetAt(GetJob((int) i)->GetAt(m_NameField), (void *)(i + 1));
+	m_IndexDirty = TRUE;
+}
+
+void CP4JobStore::RemoveAll()
+{
+	for (int i = 0; i < m_Jobs.GetSize(); i++)
+		delete GetJob(i);
+	m_Jobs.RemoveAll();
+	m_ByName.RemoveAll();
+	m_MaxDate.Empty();
+	RemoveIndex();
+	m_Loaded = m_Complete = m_Stale = FALSE;
+}
+
+void CP4JobStore::Clear()
+{
+	RemoveAll();
+	m_Spec.Empty();
+	m_Names.RemoveAll();
+	m_Codes.RemoveAll();
+	m_IsDate.RemoveAll();
+	m_NameField = 0;
+	m_DateField = -1;
+}
+
+// Dates come as yyyy/mm/dd or yyyy/mm/dd hh:mm:ss; jobview wants
+// yyyy/mm/dd:hh:mm:ss, which also sorts as a string
+CString CP4JobStore::NormalizeDate(CString date)
+{
+	date.TrimLeft();
+	date.TrimRight();
+	date.Replace(_T(' '), _T(':'));
+	if (date.GetLength() == 10)
+		date += _T(":00:00:00");
+	return date;
+}
+
+void CP4JobStore::NoteDate(const CString &date)
+{
+	CString d = NormalizeDate(date);
+	if (d.Compare(m_MaxDate) > 0)
+		m_MaxDate = d;
+}
+
+// A jobview filter for the jobs modified since the newest one held.  Jobs
+// modified in that same second come back again, which does no harm.
+CString CP4JobStore::GetNewerFilter()
+{
+	ASSERT(CanRefresh());
+	return m_Names.GetAt(m_DateField) + _T(">=") + m_MaxDate;
+}
+
+CP4Job *CP4JobStore::MakeJob(int job)
+{
+	CP4Job *pJob = new CP4Job;
+	pJob->Create(*GetJob(job), m_Codes);
+	return pJob;
+}
+
+LPCTSTR CP4JobStore::GetJobName(int job)
+{
+	return GetJob(job)->GetAt(m_NameField);
+}
+
+void CP4JobStore::RemoveIndex()
+{
+	for (int f = 0; f < m_Index.GetSize(); f++)
+	{
+		CMapStringToPtr *words = (CMapStringToPtr *) m_Index.GetAt(f);
+		if (!words)
+			continue;
+		CString word;
+		void *p;
+		for (POSITION pos = words->GetStartPosition(); pos != NULL; )
+		{
+			words->GetNextAssoc(pos, word, p);
+			delete (CDWordArray *) p;
+		}
+		delete words;
+	}
+	m_Index.RemoveAll();
+	m_IndexDirty = TRUE;
+}
+
+// Indexes the words of every field but the dates, which are compared
+// rather than looked up
+void CP4JobStore::BuildIndex()
+{
+	if (!m_IndexDirty)
+		return;
+	RemoveIndex();
+
+	INT_PTR nFields = m_Names.GetSize();
+	m_Index.SetSize(nFields);
+	for (int f = 0; f < nFields; f++)
+		m_Index.SetAt(f, m_IsDate[f] ? NULL : new CMapStringToPtr);
+
+	for (int j = 0; j < m_Jobs.GetSize(); j++)
+	{
+		CStringArray *values = GetJob(j);
+		for (int f = 0; f < nFields; f++)
+		{
+			CMapStringToPtr *words = (CMapStringToPtr *) m_Index.GetAt(f);
+			if (!words)
+				continue;
+			CStringArray split;
+			CP4ChangeIndex::SplitWords(values->GetAt(f), split);
+			for (int w = 0; w < split.GetSize(); w++)
+			{
+				void *p;
+				CDWordArray *list;
+				if (words->Lookup(split[w], p))
+					list = (CDWordArray *) p;
+				else
+				{
+					list = new CDWordArray;
+					words->SetAt(split[w], list);
+				}
+				INT_PTR n = list->GetSize();
+				if (!n || list->GetAt(n - 1) != (DWORD) j)
+					list->Add((DWORD) j);
+			}
+		}
+	}
+	m_IndexDirty = FALSE;
+}
+
+// Finds the jobs matching a jobview filter; an empty filter matches them
+// all.  Returns FALSE if the filter can't be evaluated here.
+BOOL CP4JobStore::Query(LPCTSTR filter, CDWordArray &jobs)
+{
+	jobs.RemoveAll();
+	BuildIndex();
+	Tokenize(filter);
+	m_Next = 0;
+	m_Failed = FALSE;
+
+	CByteArray result;
+	result.SetSize(m_Jobs.GetSize());
+	if (!m_Tokens.GetSize())
+		memset(result.GetData(), 1, result.GetSize());
+	else
+	{
+		ParseOr(result);
+		if (m_Next < m_Tokens.GetSize())
+			m_Failed = TRUE;
+	}
+	if (m_Failed)
+		return FALSE;
+
+	for (int j = 0; j < result.GetSize(); j++)
+	{
+		if (result[j])
+			jobs.Add((DWORD) j);
+	}
+	return TRUE;
+}
+
+// Splits a filter into terms and the operators ( ) | & ^.  White space
+// between terms means 'and'; a backslash quotes the next character.
+void CP4JobStore::Tokenize(LPCTSTR filter)
+{
+	m_Tokens.RemoveAll();
+	CString token;
+	for (LPCTSTR p = filter; *p; p++)
+	{
+		if (*p == _T('\\') && *(p + 1))
+			token += *++p;
+		else if (_tcschr(_T(" \t\r\n()|&^"), *p))
+		{
+			if (!token.IsEmpty())
+				m_Tokens.Add(token);
+			token.Empty();
+			if (!_istspace(*p))
+				m_Tokens.Add(CString(*p));
+		}
+		else
+			token += *p;
+	}
+	if (!token.IsEmpty())
+		m_Tokens.Add(token);
+}
+
+// a | b, which binds more loosely than 'and'
+void CP4JobStore::ParseOr(CByteArray &result)
+{
+	ParseAnd(result);
+	while (!m_Failed && m_Next < m_Tokens.GetSize() && m_Tokens[m_Next] == _T("|"))
+	{
+		m_Next++;
+		CByteArray other;
+		ParseAnd(other);
+		for (int j = 0; j < result.GetSize() && j < other.GetSize(); j++)
+			result[j] |= other[j];
+	}
+}
+
+// a & b, or just a b
+void CP4JobStore::ParseAnd(CByteArray &result)
+{
+	ParseUnary(result);
+	while (!m_Failed && m_Next < m_Tokens.GetSize()
+		&& m_Tokens[m_Next] != _T("|") && m_Tokens[m_Next] != _T(")"))
+	{
+		if (m_Tokens[m_Next] == _T("&"))
+			m_Next++;
+		CByteArray other;
+		ParseUnary(other);
+		for (int j = 0; j < result.GetSize() && j < other.GetSize(); j++)
+			result[j] &= other[j];
+	}
+}
+
+// ^a, (a), or a term
+void CP4JobStore::ParseUnary(CByteArray &result)
+{
+	result.RemoveAll();
+	result.SetSize(m_Jobs.GetSize());
+	if (m_Next >= m_Tokens.GetSize())
+	{
+		m_Failed = TRUE;
+		return;
+	}
+
+	CString token = m_Tokens[m_Next++];
+	if (token == _T("^"))
+	{
+		ParseUnary(result);
+		for (int j = 0; j < result.GetSize(); j++)
+			result[j] = !result[j];
+	}
+	else if (token == _T("("))
+	{
+		ParseOr(result);
+		if (m_Next < m_Tokens.GetSize() && m_Tokens[m_Next] == _T(")"))
+			m_Next++;
+		else
+			m_Failed = TRUE;
+	}
+	else if (token == _T(")") || token == _T("|") || token == _T("&"))
+		m_Failed = TRUE;
+	else
+		ParseTerm(token, result);
+}
+
+// field=value, field<value etc., or a bare word to look for in every field
+void CP4JobStore::ParseTerm(const CString &term, CByteArray &result)
+{
+	int op = term.FindOneOf(_T("=<>"));
+	if (op == -1)
+	{
+		for (int f = 0; f < m_Names.GetSize(); f++)
+		{
+			if (!m_IsDate[f])
+				MatchWord(f, term, result);
+		}
+		return;
+	}
+
+	int f = FindField(term.Left(op));
+	int len = (term[op] != _T('=') && op + 1 < term.GetLength() && term[op + 1] == _T('=')) ? 2 : 1;
+	CString oper = term.Mid(op, len);
+	CString value = term.Mid(op + len);
+	if (f == -1 || value.IsEmpty())
+	{
+		m_Failed = TRUE;
+		return;
+	}
+
+	if (oper == _T("=") && !m_IsDate[f])
+		MatchWord(f, value, result);
+	else
+		MatchCompare(f, oper, value, result);
+}
+
+// Marks the jobs using word in field.  A word holding '*' is a wildcard;
+// a value that splits into several words needs them all.
+void CP4JobStore::MatchWord(int field, const CString &word, CByteArray &result)
+{
+	CMapStringToPtr *words = (CMapStringToPtr *) m_Index.GetAt(field);
+	void *p;
+
+	if (word.Find(_T('*')) != -1)
+	{
+		CString pattern = word;
+		pattern.MakeLower();
+		CString key;
+		for (POSITION pos = words->GetStartPosition(); pos != NULL; )
+		{
+			words->GetNextAssoc(pos, key, p);
+			if (!WildMatch(pattern, key))
+				continue;
+			CDWordArray *list = (CDWordArray *) p;
+			for (INT_PTR i = 0; i < list->GetSize(); i++)
+				result[list->GetAt(i)] = 1;
+		}
+		return;
+	}
+
+	CStringArray split;
+	CP4ChangeIndex::SplitWords(word, split);
+	if (!split.GetSize())
+	{
+		m_Failed = TRUE;
+		return;
+	}
+
+	CByteArray found;
+	found.SetSize(result.GetSize());
+	for (int w = 0; w < split.GetSize(); w++)
+	{
+		CByteArray has;
+		has.SetSize(result.GetSize());
+		if (words->Lookup(split[w], p))
+		{
+			CDWordArray *list = (CDWordArray *) p;
+			for (INT_PTR i = 0; i < list->GetSize(); i++)
+				has[list->GetAt(i)] = 1;
+		}
+		for (int j = 0; j < found.GetSize(); j++)
+			found[j] = w ? found[j] & has[j] : has[j];
+	}
+	for (int j = 0; j < found.GetSize(); j++)
+		result[j] |= found[j];
+}
+
+// Compares field with value.  Dates given without a time compare by day.
+void CP4JobStore::MatchCompare(int field, LPCTSTR op, const CString &value, CByteArray &result)
+{
+	BOOL isDate = m_IsDate[field];
+	BOOL byDay = isDate && value.GetLength() == 10;
+	CString v = isDate && !byDay ? NormalizeDate(value) : value;
+
+	for (int j = 0; j < m_Jobs.GetSize(); j++)
+	{
+		CString s = GetJob(j)->GetAt(field);
+		if (isDate)
+		{
+			s = NormalizeDate(s);
+			if (s.IsEmpty())
+				continue;
+			if (byDay)
+				s = s.Left(10);
+		}
+		int c = isDate ? s.Compare(v) : s.CompareNoCase(v);
+		BOOL b;
+		if (!_tcscmp(op, _T("=")))
+			b = c == 0;
+		else if (!_tcscmp(op, _T("<")))
+			b = c < 0;
+		else if (!_tcscmp(op, _T(">")))
+			b = c > 0;
+		else if (!_tcscmp(op, _T("<=")))
+			b = c <= 0;
+		else
+			b = c >= 0;
+		if (b)
+			result[j] = 1;
+	}
+}
+
+int CP4JobStore::FindField(const CString &name)
+{
+	for (int f = 0; f < m_Names.GetSize(); f++)
+	{
+		if (!m_Names[f].CompareNoCase(name))
+			return f;
+	}
+	return -1;
+}
+
+BOOL CP4JobStore::WildMatch(LPCTSTR pattern, LPCTSTR str)
+{
+	while (*pattern)
+	{
+		if (*pattern == _T('*'))
+		{
+			while (*pattern == _T('*'))
+				pattern++;
+			if (!*pattern)
+				return TRUE;
+			for ( ; *str; str++)
+			{
+				if (WildMatch(pattern, str))
+					return TRUE;
+			}
+			return FALSE;
+		}
+		if (*pattern++ != *str++)
+			return FALSE;
+	}
+	return !*str;
+}
@@ -0,0 +1,101 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4JobStore.h
+//
+// CP4JobStore keeps every field of every job the jobs pane has fetched, so
+// a new jobview filter or column layout can be answered without going back
+// to the server.  The fields are taken from the jobspec.  Each field has an
+// index from the words used in it to the jobs using them; the indexes are
+// rebuilt the first time a query needs them after the jobs have changed.
+// Query() evaluates a jobview expression - words, field=value, field<value
+// and so on, with &, |, ^ and parentheses - against the indexes.  Anything
+// it doesn't understand makes it return FALSE, and the caller should ask
+// the server instead.
+//
+// Once loaded, the store is brought up to date by asking only for the jobs
+// modified since the newest modification date it holds.
+
+#ifndef __P4JOBSTORE__
+#define __P4JOBSTORE__
+
+class CP4Job;
+
+class CP4JobStore
+{
+public:
+	CP4JobStore();
+	~CP4JobStore();
+
+protected:
+	CString m_Spec;
+	CStringArray m_Names;			// the jobspec's fields, in spec order
+	CDWordArray m_Codes;
+	CByteArray m_IsDate;
+	int		m_NameField;			// the job name (101)
+	int		m_DateField;			// the modification date (104), -1 if none
+
+	CObArray m_Jobs;				// a CStringArray of values per job
+	CMapStringToPtr m_ByName;		// job name -> index in m_Jobs + 1
+	CString m_MaxDate;				// newest modification date held
+
+	CPtrArray m_Index;				// per field: CMapStringToPtr of word -> CDWordArray of jobs
+	BOOL	m_IndexDirty;
+
+	BOOL	m_Loaded;
+	BOOL	m_Complete;				// holds every job on the server
+	BOOL	m_Stale;				// a job was edited here since the last refresh
+	DWORD	m_LoadTicks;
+
+	// the query being evaluated
+	CStringArray m_Tokens;
+	int		m_Next;
+	BOOL	m_Failed;
+
+public:
+	BOOL SetSpec(LPCTSTR spec);
+	CStringArray & GetFieldNames() { return m_Names; }
+	CDWordArray & GetFieldCodes() { return m_Codes; }
+
+	void Load(CObList *jobs, BOOL complete);
+	BOOL Merge(CObList *jobs);
+	void Remove(LPCTSTR jobName);
+	void Clear();
+	void SetStale() { m_Stale = TRUE; }
+
+	BOOL IsLoaded() { return m_Loaded; }
+	BOOL IsComplete() { return m_Complete; }
+	BOOL CanAnswer() { return m_Loaded && m_Complete && !m_Stale; }
+	BOOL CanRefresh() { return m_Loaded && m_DateField != -1 && !m_MaxDate.IsEmpty(); }
+	DWORD GetAge() { return GetTickCount() - m_LoadTicks; }
+	CString GetNewerFilter();
+	int  GetCount() { return (int) m_Jobs.GetSize(); }
+
+	BOOL Query(LPCTSTR filter, CDWordArray &jobs);
+	CP4Job *MakeJob(int job);
+	LPCTSTR GetJobName(int job);
+
+protected:
+	CStringArray *GetJob(int job) { return (CStringArray *) m_Jobs.GetAt(job); }
+	void Set(CP4Job *job);
+	void RemoveAll();
+	void NoteDate(const CString &date);
+	void RemoveIndex();
+	void BuildIndex();
+
+	void Tokenize(LPCTSTR filter);
+	void ParseOr(CByteArray &result);
+	void ParseAnd(CByteArray &result);
+	void ParseUnary(CByteArray &result);
+	void ParseTerm(const CString &term, CByteArray &result);
+	void MatchWord(int field, const CString &word, CByteArray &result);
+	void MatchCompare(int field, LPCTSTR op, const CString &value, CByteArray &result);
+	int  FindField(const CString &name);
+
+	static CString NormalizeDate(CString date);
+	static BOOL WildMatch(LPCTSTR pattern, LPCTSTR str);
+};
+
+#endif //__P4JOBSTORE__
@@ -41,6 +41,7 @@ CP4ListCtrl::CP4ListCtrl()
     m_ContextContext= KEYSTROKED;
 	m_ReadSavedWidths = m_ColsInited = FALSE;
 	m_PostViewUpdateMsg = 0;
+	m_pStartupCancel = NULL;
 	m_LastSelIx = -1;
 	for (int i = -1; ++i < MAX_SORT_COLUMNS; )
 		m_SortColumns[i] = 0;
@@ -67,13 +68,39 @@ void CP4ListCtrl::SetUpdateDone()
 { 
     m_UpdateState = LIST_UPDATED; 
     MainFrame()->SetLastUpdateTime(UPDATE_SUCCESS);
+	if (m_pStartupCancel)
+	{
+		m_pStartupCancel = NULL;
+		MainFrame()->StartupPhaseDone(STARTUP_RIGHTPANE);
+	}
 }
 void CP4ListCtrl::SetUpdateFailed() 
 { 
     m_UpdateState = LIST_CLEAR; 
+	if (m_pStartupCancel)
+	{
+		// Fetched alongside the startup loads, so leave the update
+		// result to them.  Unless it was cancelled, it is fetched again
+		// through the lock, where a password can be asked for
+		BOOL cancelled = *m_pStartupCancel != 0;
+		m_pStartupCancel = NULL;
+		if (!cancelled)
+			MainFrame()->StartupPaneFailed(this);
+		MainFrame()->StartupPhaseDone(STARTUP_RIGHTPANE);
+		return;
+	}
     MainFrame()->SetLastUpdateTime(UPDATE_FAILED);
 }
 
+// Sets up the command that fetches the list: independent if the list is
+// being fetched alongside the startup loads, otherwise through the lock
+void CP4ListCtrl::InitUpdateCmd(CP4Command *pCmd)
+{
+	if (m_pStartupCancel)
+		pCmd->SetIndependent(m_pStartupCancel);
+	pCmd->Init( m_hWnd, RUN_ASYNC);
+}
+
 // Last line of OnViewUpdate() should ALWAYS call this base fn
 void CP4ListCtrl::OnViewUpdate() 
 { 
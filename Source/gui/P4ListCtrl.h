@@ -16,6 +16,8 @@
 #include "P4ListAll.h"
 
 
+class CP4Command;
+
 /////////////////////////////////////////////////////////////////////////////
 // CP4ListCtrl
 
@@ -38,6 +40,8 @@ protected:
 		MOUSEHIT
 	} m_ContextContext;
     CString m_Active;// Name of job, client, user, branch, etc. being edited, described, deleted, etc.
+	volatile LONG *m_pStartupCancel;
+	void InitUpdateCmd(CP4Command *pCmd);
 	CString m_Describing; // Name of job, client, user, branch, etc. being described
 	CString m_ReportedByTitle; // Title of Job Owner field (103)
 	BOOL m_ReadSavedWidths;
@@ -125,6 +129,10 @@ public:
 	// After update attempt, call one of the following:
 	virtual void SetUpdateDone(); 
     virtual void SetUpdateFailed();
+
+	// Makes the next update an independent command, fetched alongside the
+	// startup loads, which is told when it is done (see CP4StartupLoader)
+	void SetStartupLoad(volatile LONG *cancel) { m_pStartupCancel = cancel; }
 	// Need to lose the DYNCREATE rot if this is to be a pure virt
 	virtual void OnContextMenu(CWnd* pWnd, CPoint point) {;}
     
@@ -9,6 +9,7 @@
 #include "stdafx.h"
 #include "p4win.h"
 #include "P4Lists.h"
+#include "P4Change.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -112,104 +113,214 @@ BOOL CRevision::Create(LPCTSTR fname, int fnbr, LPCTSTR text, LPCTSTR branchInfo
 	else
 		m_ChangeDescription=RemoveTabs(buf.Mid(desc));
 
+	AddBranchInfo(branchInfo);
+	return TRUE;
+}
+
+// Tagged filelog output names its fields by revision index n, and each
+// revision's integrations by n,m
+static StrPtr *GetIndexedVar(StrDict *varList, const char *name, int n, int m = -1)
+{
+	char var[64];
+	if (m < 0)
+		sprintf(var, "%s%d", name, n);
+	else
+		sprintf(var, "%s%d,%d", name, n, m);
+	return varList->GetVar(var);
+}
+
+static CString VarText(StrPtr *str)
+{
+	return str ? CharToCString(str->Value()) : CString();
+}
+
+// The tagged start revision is the one before the range ("#none" for the
+// first revision), so show it the way untagged filelog does
+static CString RevRange(const CString &srev, const CString &erev)
+{
+	int s = srev == _T("#none") ? 0 : _ttoi(srev.Mid(1));
+	int e = _ttoi(erev.Mid(1));
+	CString range;
+	if (e <= 0)
+		range = erev;
+	else if (s + 1 >= e)
+		range.Format(_T("#%d"), e);
+	else
+		range.Format(_T("#%d,#%d"), s + 1, e);
+	return range;
+}
+
+// Parsing: the n'th revision of a tagged filelog record, for example
+//
+//	depotFile //depot/main/foo.c
+//	rev0 13  change0 36  action0 edit  type0 text  time0 852940800
+//	user0 NIRIAS  client0 ELWOOD  desc0 Added view function...
+//	how0,0 merge from  file0,0 //depot/rel/foo.c  srev0,0 #2  erev0,0 #4
+//
+// The fields are stored as CRevision::Create(text) would have found them
+// in the untagged output, so the rest of P4Win sees no difference.
+BOOL CRevision::Create(LPCTSTR fname, int fnbr, StrDict *varList, int n)
+{
+	StrPtr *str;
+	if ((str = GetIndexedVar(varList, "rev", n)) == NULL)
+		return FALSE;
+
+	m_FName = fname;
+	m_FNbr  = fnbr;
+	m_RevisionNum = atoi(str->Value());
+	str = GetIndexedVar(varList, "change", n);
+	m_ChangeNum = atoi(!str ? "0" : str->Value());
+	m_ChangeType = VarText(GetIndexedVar(varList, "action", n));
+
+	str = GetIndexedVar(varList, "time", n);
+	TimestampToFormattedTime( atol(!str ? "0" : str->Value()), &m_Date );
+
+	m_User = VarText(GetIndexedVar(varList, "user", n));
+	m_User += _T('@');
+	m_User += VarText(GetIndexedVar(varList, "client", n));
+
+	m_ChangeDescription = _T("(") + VarText(GetIndexedVar(varList, "type", n)) + _T(")\r\n\r\n")
+						+ RemoveTabs(VarText(GetIndexedVar(varList, "desc", n)));
+
+	CString branchInfo;
+	for (int m = 0; (str = GetIndexedVar(varList, "how", n, m)) != NULL; m++)
+	{
+		if (!branchInfo.IsEmpty())
+			branchInfo += _T("; ");
+		branchInfo += CharToCString(str->Value());
+		branchInfo += _T(' ');
+		branchInfo += VarText(GetIndexedVar(varList, "file", n, m));
+		branchInfo += RevRange(VarText(GetIndexedVar(varList, "srev", n, m)),
+							   VarText(GetIndexedVar(varList, "erev", n, m)));
+	}
+	AddBranchInfo(branchInfo);
+	return TRUE;
+}
+
+void CRevision::AddBranchInfo(LPCTSTR branchInfo)
+{
 	if( lstrlen(branchInfo) > 0 )
 	{
 		m_ChangeType += (m_ChangeType == _T("integrate") || m_ChangeType == _T("branch")) ? _T(": ") : _T("; ");
 		m_ChangeType += branchInfo;
 	}
-	
-	return TRUE;
+}
+
+// The revision as untagged "p4 filelog -l" would show it
+CString CRevision::GetFilelogText()
+{
+	CString chgType = m_ChangeType;
+	CString integs = _T("");
+	CString str;
+	int i;
+	if ((i = chgType.Find(_T(": "))) != -1)
+	{
+		integs = chgType.Mid(i + 2);
+		chgType = chgType.Left(i);
+	}
+	str.Format(_T("... #%d change %d %s on %s by %s %s"), 
+		m_RevisionNum, m_ChangeNum, chgType, 
+		m_Date, m_User, m_ChangeDescription);
+	str.Replace(_T("\n"), _T("\n        "));
+	if (integs.GetLength() > 0)
+	{
+		integs.Replace(_T("; "), _T("\n... ... "));
+		str += _T("\n\n... ... ") + integs;
+	}
+	str += _T("\n\n");
+	str.Remove(_T('\r'));
+	return str;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 // CHistory    A collection of CRevisions, to contain all results from "P4 filelog -l"
+//
+// The revisions are kept in arrival order; "latest" iteration walks them
+// backwards and "head" iteration forwards.
 
 CHistory::CHistory()
 {
-	m_pList= new CObList; 
+	m_Pos = -1;
+	m_Revs.SetSize(0, 256);
 }
 
 CHistory::~CHistory()
 {
 	Clear();
-	delete m_pList;
 }
 
 void CHistory::Clear()
 {
-	while(!m_pList->IsEmpty())
-	{
-		if(m_pList->GetHead()->IsKindOf(RUNTIME_CLASS(CRevision)))
-			delete m_pList->GetHead();
-		m_pList->RemoveHead();
-	}
+	for (INT_PTR i = 0; i < m_Revs.GetSize(); i++)
+		delete (CRevision *) m_Revs.GetAt(i);
+	m_Revs.RemoveAll();
+	m_Strings.RemoveAll();
 	m_FileName=_T("");
-	m_pos=NULL;
+	m_Pos = -1;
 }
 
-BOOL CHistory::AddRevision(LPCTSTR fname, int fnbr, LPCTSTR desc, LPCTSTR branchInfo)
+void CHistory::AddRevision(CRevision *rev)
 {
-	ASSERT( _tcsncmp(fname, _T("//"), 2)==0 );
+	ASSERT( _tcsncmp(rev->m_FName, _T("//"), 2)==0 );
 	
 	if( m_FileName.IsEmpty() )
-		m_FileName=fname;
-	
-	CRevision *rev=new CRevision;
-	if(rev->Create(fname, fnbr, desc, branchInfo))
-	{
-		m_pList->AddHead(rev);
-		return TRUE;
-	}
+		m_FileName=rev->m_FName;
+
+	// A long history repeats the same few file and user names over and over;
+	// have the revisions share one copy of each
+	CString shared;
+	if (m_Strings.Lookup(rev->m_FName, shared))
+		rev->m_FName = shared;
 	else
-	{
-		delete rev;
-		return FALSE;
-	}
+		m_Strings.SetAt(rev->m_FName, rev->m_FName);
+	if (m_Strings.Lookup(rev->m_User, shared))
+		rev->m_User = shared;
+	else
+		m_Strings.SetAt(rev->m_User, rev->m_User);
+
+	m_Revs.Add(rev);
 }
 
 
 
 CRevision *CHistory::GetLatestRevision()
 {
-	ASSERT(!m_pList->IsEmpty());
+	ASSERT(m_Revs.GetSize() > 0);
 
-	m_pos=m_pList->GetHeadPosition();
-	// This looks wrong, but m_pos++ happens AFTER the get
-	return (CRevision *) m_pList->GetNext(m_pos);
+	m_Pos = m_Revs.GetSize() - 1;
+	return (CRevision *) m_Revs.GetAt(m_Pos--);
 }
 
 
 CRevision *CHistory::GetNextRevision()
 {
-	ASSERT(!m_pList->IsEmpty());
-	ASSERT(m_pos != NULL);
+	ASSERT(m_Pos >= 0 && m_Pos < m_Revs.GetSize());
 
-	return (CRevision *) m_pList->GetNext(m_pos);
+	return (CRevision *) m_Revs.GetAt(m_Pos--);
 }
 
 	
 CRevision *CHistory::GetHeadRevision()
 {
-	ASSERT(!m_pList->IsEmpty());
+	ASSERT(m_Revs.GetSize() > 0);
 
-	m_pos=m_pList->GetTailPosition();
-	// This looks wrong, but m_pos++ happens AFTER the get
-	return (CRevision *) m_pList->GetPrev(m_pos);
+	m_Pos = 0;
+	return (CRevision *) m_Revs.GetAt(m_Pos++);
 }
 
 
 CRevision *CHistory::GetPrevRevision()
 {
-	if (m_pList->IsEmpty() || m_pos == NULL)
+	if (m_Pos < 0 || m_Pos >= m_Revs.GetSize())
 		return NULL;
 
-	return (CRevision *) m_pList->GetPrev(m_pos);
+	return (CRevision *) m_Revs.GetAt(m_Pos++);
 }
 
 	
 INT_PTR CHistory::GetRevisionCount()
 {
-	return m_pList->GetCount();
+	return m_Revs.GetSize();
 }
 
 
@@ -217,4 +328,3 @@ CString CHistory::GetFileName()
 {
 	return m_FileName;
 }
-
@@ -37,7 +37,12 @@ public:
 // Implementation
 public:
 	BOOL Create(LPCTSTR fname, int fnbr, LPCTSTR text, LPCTSTR branchInfo);
+	BOOL Create(LPCTSTR fname, int fnbr, class StrDict *varList, int n);
+	CString GetFilelogText();
 	virtual ~CRevision();
+
+protected:
+	void AddBranchInfo(LPCTSTR branchInfo);
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -51,13 +56,14 @@ public:
 	
 // Attributes
 protected:
-	CObList* m_pList;
+	CPtrArray m_Revs;		// CRevisions, in the order the server sent them
 	CString m_FileName;
-	POSITION m_pos;
+	INT_PTR m_Pos;			// iteration cursor; out of range when done
+	CMapStringToString m_Strings;	// shared copies of repeated names
 
 // Operations
 public:
-	BOOL AddRevision(LPCTSTR fname, int fnbr, LPCTSTR desc, LPCTSTR branchInfo);
+	void AddRevision(CRevision *rev);
 	CRevision *GetLatestRevision();
 	CRevision *GetNextRevision();
 	CRevision *GetHeadRevision();
@@ -0,0 +1,181 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4LogWriter.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4LogWriter.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+CP4LogWriter::CP4LogWriter()
+{
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_Size = m_MaxSize = 0;
+	m_Dropped = m_DroppedLogged = 0;
+	m_pThread = NULL;
+	m_Stop = 0;
+	m_Failed = m_Reported = FALSE;
+	m_ProblemLevel = SV_MSG;
+}
+
+CP4LogWriter::~CP4LogWriter()
+{
+	Close();
+}
+
+BOOL CP4LogWriter::CreateLogFile()
+{
+	m_hFile = CreateFile(m_FileName, GENERIC_READ | GENERIC_WRITE,
+					FILE_SHARE_READ, 0, CREATE_ALWAYS, 0, 0);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	m_Size = 0;
+#ifdef UNICODE
+	TCHAR msg[] = {0xFEFF};
+	DWORD NumberOfBytesWritten;
+	WriteFile(m_hFile, msg, 2, &NumberOfBytesWritten, NULL);
+	m_Size = NumberOfBytesWritten;
+#endif
+	return TRUE;
+}
+
+// Creates the file, replacing any old one, and starts the worker.  Returns
+// FALSE only if the file can't be created.
+BOOL CP4LogWriter::Open(LPCTSTR fileName, int maxSizeMB)
+{
+	ASSERT(m_hFile == INVALID_HANDLE_VALUE);
+	m_FileName = fileName;
+	m_MaxSize = (__int64) maxSizeMB * 1024 * 1024;
+	if (!CreateLogFile())
+		return FALSE;
+
+	m_Stop = 0;
+	m_pThread = AfxBeginThread(LogThread, (LPVOID) this,
+				THREAD_PRIORITY_BELOW_NORMAL, 0, CREATE_SUSPENDED, NULL);
+	if (!m_pThread)
+	{
+		// Too early for the status pane; the first Write() reports it
+		m_Problem.FormatMessage(IDS_STATUS_LOG_NO_THREAD_s, (LPCTSTR) m_FileName);
+		m_ProblemLevel = SV_WARNING;
+		return TRUE;
+	}
+	m_pThread->m_bAutoDelete = FALSE;	// Close() waits on the handle
+	m_pThread->ResumeThread();
+	return TRUE;
+}
+
+// Stops the worker, writes out what is left and closes the file
+void CP4LogWriter::Close()
+{
+	if (m_pThread)
+	{
+		InterlockedExchange(&m_Stop, 1);
+		m_Wake.SetEvent();
+		WaitForSingleObject(m_pThread->m_hThread, INFINITE);
+		delete m_pThread;
+		m_pThread = NULL;
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		Flush();
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+	m_Failed = m_Reported = FALSE;
+}
+
+// Queues a line, which must include its own line end.  May be called from
+// any thread.  Returns FALSE if the queue is full and the line is dropped.
+BOOL CP4LogWriter::Write(LPCTSTR line)
+{
+	m_Lock.Lock();
+	int count = (int) m_Queue.GetCount();
+	BOOL b = count < LOGQUEUESIZE;
+	if (b)
+		m_Queue.AddTail(line);
+	else
+		m_Dropped++;
+	m_Lock.Unlock();
+
+	if (!m_pThread)
+		Flush();
+	else if (count + 1 == LOGBATCHSIZE)
+		m_Wake.SetEvent();
+	return b;
+}
+
+// Writes everything queued so far.  The worker calls this on its own, but
+// call it before looking at the file to be sure the file is up to date.
+void CP4LogWriter::Flush()
+{
+	m_WriteLock.Lock();
+
+	CString buf;
+	m_Lock.Lock();
+	if (m_Dropped != m_DroppedLogged)
+	{
+		buf.Format(_T("%d %ld status messages were not logged: the log file could not keep up\r\n"),
+			SV_WARNING, m_Dropped - m_DroppedLogged);
+		m_DroppedLogged = m_Dropped;
+	}
+	while (!m_Queue.IsEmpty())
+		buf += m_Queue.RemoveHead();
+	m_Lock.Unlock();
+
+	if (m_Failed && !buf.IsEmpty() && CreateLogFile())
+		m_Failed = FALSE;
+	if (!buf.IsEmpty() && m_hFile != INVALID_HANDLE_VALUE)
+	{
+		DWORD NumberOfBytesWritten;
+		WriteFile(m_hFile, buf, buf.GetLength()*sizeof(TCHAR), &NumberOfBytesWritten, NULL);
+		m_Size += NumberOfBytesWritten;
+		if (m_Size > m_MaxSize)
+			Rotate();
+	}
+
+	CString problem = m_Problem;
+	m_Problem.Empty();
+	m_WriteLock.Unlock();
+
+	if (!problem.IsEmpty())
+		TheApp()->StatusAdd(problem, (StatusView) m_ProblemLevel);
+}
+
+// Keeps the full file as <file>.old and starts a new one.  If the rename
+// fails the file is just emptied.
+void CP4LogWriter::Rotate()
+{
+	CloseHandle(m_hFile);
+	MoveFileEx(m_FileName, m_FileName + _T(".old"), MOVEFILE_REPLACE_EXISTING);
+	if (CreateLogFile())
+		return;
+
+	m_Failed = TRUE;
+	if (!m_Reported)
+	{
+		m_Reported = TRUE;
+		m_Problem.FormatMessage(IDS_UNABLE_TO_CREATE_STATUS_LOG_s, (LPCTSTR) m_FileName);
+		m_ProblemLevel = SV_ERROR;
+	}
+}
+
+UINT CP4LogWriter::LogThread(LPVOID pParam)
+{
+	CP4LogWriter *pWriter = (CP4LogWriter *) pParam;
+	while (!pWriter->m_Stop)
+	{
+		WaitForSingleObject(pWriter->m_Wake.m_hObject, LOGFLUSHINTERVAL);
+		pWriter->Flush();
+	}
+	return 0;
+}
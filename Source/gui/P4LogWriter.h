@@ -0,0 +1,70 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4LogWriter.h
+//
+// CP4LogWriter appends lines to a log file from a background thread, so a
+// slow disk or network share never holds up the thread doing the logging.
+// Write() just queues the line; the worker writes whatever has queued up in
+// one go, every so often or as soon as a batch has built up.  The queue is
+// bounded: lines that arrive while it is full are dropped and counted, and
+// the count goes into the file in their place.  When the file grows past
+// its size limit it is renamed to <file>.old and a new file is started.
+// If the worker can't be started, Write() writes the file itself; if a new
+// file can't be started, the status pane is told once and each flush tries
+// again.
+
+#ifndef __P4LOGWRITER__
+#define __P4LOGWRITER__
+
+#include <afxmt.h>
+
+#define LOGQUEUESIZE		8192	// lines
+#define LOGBATCHSIZE		256		// lines that wake the worker early
+#define LOGFLUSHINTERVAL	500		// ms
+
+class CP4LogWriter
+{
+public:
+	CP4LogWriter();
+	~CP4LogWriter();
+
+protected:
+	CString m_FileName;
+	HANDLE	m_hFile;
+	__int64 m_Size;
+	__int64 m_MaxSize;
+
+	CCriticalSection m_Lock;		// for the queue and the counts
+	CStringList m_Queue;
+	long	m_Dropped;
+	long	m_DroppedLogged;
+	CCriticalSection m_WriteLock;	// for the file, so batches go out in order
+
+	CWinThread *m_pThread;
+	CEvent	m_Wake;
+	volatile LONG m_Stop;
+
+	BOOL	m_Failed;			// the file couldn't be recreated on rotating
+	BOOL	m_Reported;			// and the status pane has been told
+	CString m_Problem;			// to go to the status pane on the next flush
+	int		m_ProblemLevel;		// a StatusView level
+
+public:
+	BOOL Open(LPCTSTR fileName, int maxSizeMB);
+	void Close();
+	BOOL Write(LPCTSTR line);
+	void Flush();
+
+	LPCTSTR GetFileName() { return m_FileName; }
+	long GetDropped() { return m_Dropped; }
+
+protected:
+	static UINT LogThread(LPVOID pParam);
+	BOOL CreateLogFile();
+	void Rotate();
+};
+
+#endif //__P4LOGWRITER__
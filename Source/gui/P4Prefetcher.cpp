@@ -0,0 +1,173 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4Prefetcher.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4Prefetcher.h"
+#include "cmd_prepbrowse.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+// How long Release() waits for a worker in the middle of a print
+#define PREFETCH_STOPWAIT 2000
+
+
+CP4Prefetcher::CP4Prefetcher()
+	: m_Stopped(TRUE, TRUE)		// manual reset, and no worker yet
+{
+	m_Running = m_Released = FALSE;
+	m_Cancel = 0;
+	m_Budget = (__int64)GET_P4REGPTR()->GetPrefetchSize() * 1024 * 1024;
+	m_Fetched = 0;
+}
+
+CP4Prefetcher::~CP4Prefetcher()
+{
+	ClearQueue();
+}
+
+BOOL CP4Prefetcher::IsEnabled()
+{
+	return m_Budget > 0 && !m_Cancel && GET_REVCACHE()->IsEnabled();
+}
+
+void CP4Prefetcher::Add(LPCTSTR depotPath, long rev, LPCTSTR fileType)
+{
+	if (!IsEnabled() || rev <= 0)
+		return;
+
+	CString key;
+	key.Format(_T("%s#%ld"), depotPath, rev);
+	void *p;
+	m_Lock.Lock();
+	if (!m_Done.Lookup(key, p))
+	{
+		CPrefetchRequest *req = new CPrefetchRequest;
+		req->m_DepotPath = depotPath;
+		req->m_Rev = rev;
+		req->m_FileType = fileType;
+		m_Queue.AddTail(req);
+	}
+	m_Lock.Unlock();
+}
+
+void CP4Prefetcher::ClearQueue()
+{
+	m_Lock.Lock();
+	while (!m_Queue.IsEmpty())
+		delete m_Queue.RemoveHead();
+	m_Lock.Unlock();
+}
+
+// Make sure a worker is running if there is anything to fetch.  A worker
+// exits as soon as it finds the queue empty, so start a new one if the
+// last one has gone.  The thread object deletes itself.
+void CP4Prefetcher::Start()
+{
+	if (!IsEnabled())
+		return;
+
+	m_Lock.Lock();
+	if (!m_Running && !m_Queue.IsEmpty())
+	{
+		if (AfxBeginThread(PrefetchThread, (LPVOID) this, THREAD_PRIORITY_IDLE))
+		{
+			m_Running = TRUE;
+			m_Stopped.ResetEvent();
+		}
+	}
+	m_Lock.Unlock();
+}
+
+// Stop the worker, abandoning any print in progress, and give it a short
+// while to exit.  Called by the owner in place of delete: the prefetcher
+// goes now if the worker has stopped, else when the worker does.
+void CP4Prefetcher::Release()
+{
+	InterlockedExchange(&m_Cancel, 1);
+	ClearQueue();
+	WaitForSingleObject(m_Stopped, PREFETCH_STOPWAIT);
+
+	m_Lock.Lock();
+	BOOL running = m_Running;
+	m_Released = TRUE;
+	m_Lock.Unlock();
+	if (!running)
+		delete this;
+}
+
+// Called by the worker as it exits.  Returns TRUE if the owner has already
+// released the prefetcher, so it is now the worker's to delete.
+BOOL CP4Prefetcher::WorkerDone()
+{
+	m_Lock.Lock();
+	m_Running = FALSE;
+	BOOL released = m_Released;
+	m_Stopped.SetEvent();
+	m_Lock.Unlock();
+	return released;
+}
+
+// Returns NULL when the worker should exit: nothing left to do, the budget
+// is spent, or we have been cancelled
+CPrefetchRequest *CP4Prefetcher::NextRequest()
+{
+	CPrefetchRequest *req = NULL;
+	m_Lock.Lock();
+	if (!m_Cancel && m_Fetched < m_Budget && !m_Queue.IsEmpty())
+	{
+		req = (CPrefetchRequest *) m_Queue.RemoveHead();
+		CString key;
+		key.Format(_T("%s#%ld"), req->m_DepotPath, req->m_Rev);
+		m_Done.SetAt(key, NULL);
+	}
+	m_Lock.Unlock();
+	return req;
+}
+
+UINT CP4Prefetcher::PrefetchThread(LPVOID pParam)
+{
+	CP4Prefetcher *pPrefetcher = (CP4Prefetcher *) pParam;
+	pPrefetcher->DoPrefetch();
+	if (pPrefetcher->WorkerDone())
+		delete pPrefetcher;
+	return 0;
+}
+
+void CP4Prefetcher::DoPrefetch()
+{
+	CPrefetchRequest *req;
+	while ((req = NextRequest()) != NULL)
+	{
+		if (APP_ABORTING())
+		{
+			delete req;
+			break;
+		}
+
+		CCmd_PrepBrowse cmd;
+		cmd.SetIndependent(&m_Cancel);
+		cmd.Init(NULL, RUN_SYNC);
+		cmd.SetPrefetch(m_Budget - m_Fetched);
+		if (cmd.Run(req->m_DepotPath, req->m_FileType, req->m_Rev) && cmd.GetPrefetchedBytes())
+		{
+			m_Fetched += cmd.GetPrefetchedBytes();
+			if ( GET_P4REGPTR()->ShowCommandTrace( ) )
+			{
+				CString txt;
+				txt.Format(_T("Prefetched %s#%ld into the local revision cache (%I64d of %I64d KB)"),
+					req->m_DepotPath, req->m_Rev, m_Fetched / 1024, m_Budget / 1024);
+				TheApp()->StatusAdd(txt);
+			}
+		}
+		delete req;
+	}
+}
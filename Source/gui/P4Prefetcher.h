@@ -0,0 +1,65 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4Prefetcher.h
+//
+// CP4Prefetcher prints depot revisions into the revision cache on an idle
+// priority worker thread, ahead of the user asking for them.  Its owner
+// keeps handing it the revisions worth having (each call replaces whatever
+// is still pending), and the worker stops for good once it has fetched its
+// byte budget.  The prints run as independent commands, on their own
+// connection and outside the server lock, so they never hold up the user's
+// commands.  The owner creates it with new and calls Release() instead of
+// deleting it: that stops the worker, waits a short while for it, and if
+// the worker is stuck in a print it is left to delete the prefetcher itself
+// when the print returns.
+
+#ifndef __P4PREFETCHER__
+#define __P4PREFETCHER__
+
+#include <afxmt.h>
+
+class CPrefetchRequest : public CObject
+{
+public:
+	CString m_DepotPath;
+	long	m_Rev;
+	CString m_FileType;
+};
+
+class CP4Prefetcher
+{
+public:
+	CP4Prefetcher();
+
+protected:
+	~CP4Prefetcher();
+
+	CCriticalSection m_Lock;
+	CObList m_Queue;
+	CMapStringToPtr m_Done;		// revisions already tried, so they aren't tried again
+	BOOL	m_Running;			// a worker is active
+	BOOL	m_Released;			// the owner has gone; the worker deletes us
+	CEvent	m_Stopped;			// set while no worker is active
+	volatile LONG m_Cancel;
+	__int64 m_Budget;
+	__int64 m_Fetched;
+
+public:
+	BOOL IsEnabled();
+	void Add(LPCTSTR depotPath, long rev, LPCTSTR fileType);
+	void Start();
+	void ClearQueue();
+	void Release();
+	__int64 GetFetchedBytes() { return m_Fetched; }
+
+protected:
+	static UINT PrefetchThread(LPVOID pParam);
+	void DoPrefetch();
+	CPrefetchRequest *NextRequest();
+	BOOL WorkerDone();
+};
+
+#endif //__P4PREFETCHER__
@@ -175,6 +175,25 @@
 #define ClientFilterOwner	_T("ClientFilterOwner")
 #define ClientFilterHost	_T("ClientFilterHost")
 #define ClientFilterDesc	_T("ClientFilterDesc")
+#define RevCacheSize	_T("RevCacheSize")
+#define PrefetchSize	_T("PrefetchSize")
+#define QuickDiff	_T("QuickDiff")
+#define QuickDiffMaxSize	_T("QuickDiffMaxSize")
+#define ResolvePreviewThreads	_T("ResolvePreviewThreads")
+#define StreamDiffMinSize	_T("StreamDiffMinSize")
+#define LocalFolderCompare	_T("LocalFolderCompare")
+#define SyncThreads	_T("SyncThreads")
+#define StatusLevelFilter	_T("StatusLevelFilter")
+#define StatusLogMaxSize	_T("StatusLogMaxSize")
+#define ListArgBatch	_T("ListArgBatch")
+#define SyncConnections	_T("SyncConnections")
+#define ConnectionLimit	_T("ConnectionLimit")
+#define SyncPreviewMaxAge	_T("SyncPreviewMaxAge")
+#define ChangeIndex	_T("ChangeIndex")
+#define LocalJobQuery	_T("LocalJobQuery")
+#define ChangeCheck	_T("ChangeCheck")
+#define AutoPollBackoff	_T("AutoPollBackoff")
+#define ParallelStartup	_T("ParallelStartup")
 #define WindowPosition		_T("WindowPosition")
 #define WindowIconic		_T("WindowIconic")
 #define WindowRestoreMaximized	_T("WindowRestoreMaximized")
@@ -868,6 +887,63 @@ BOOL CP4Registry::ReadRegistry()
 	if(!GetRegKey( m_ClientFilterDesc, _T("Settings"), ClientFilterDesc, NULL, _T("") ))
 		SetClientFilterDesc( m_ClientFilterDesc );
 
+	if(!GetRegKey( &m_RevCacheSize, _T("Settings"), RevCacheSize, 256 ))
+		SetRevCacheSize( m_RevCacheSize );
+
+	if(!GetRegKey( &m_PrefetchSize, _T("Settings"), PrefetchSize, 16 ))
+		SetPrefetchSize( m_PrefetchSize );
+
+	if(!GetRegKey( &m_QuickDiff, _T("Settings"), QuickDiff, 0 ))
+		SetQuickDiff( m_QuickDiff );
+
+	if(!GetRegKey( &m_QuickDiffMaxSize, _T("Settings"), QuickDiffMaxSize, 32 ))
+		SetQuickDiffMaxSize( m_QuickDiffMaxSize );
+
+	if(!GetRegKey( &m_ResolvePreviewThreads, _T("Settings"), ResolvePreviewThreads, 4 ))
+		SetResolvePreviewThreads( m_ResolvePreviewThreads );
+
+	if(!GetRegKey( &m_StreamDiffMinSize, _T("Settings"), StreamDiffMinSize, 64 ))
+		SetStreamDiffMinSize( m_StreamDiffMinSize );
+
+	if(!GetRegKey( &m_LocalFolderCompare, _T("Settings"), LocalFolderCompare, 1 ))
+		SetLocalFolderCompare( m_LocalFolderCompare );
+
+	if(!GetRegKey( &m_SyncThreads, _T("Settings"), SyncThreads, 0 ))
+		SetSyncThreads( m_SyncThreads );
+
+	if(!GetRegKey( &m_StatusLevelFilter, _T("Settings"), StatusLevelFilter, 255 ))
+		SetStatusLevelFilter( m_StatusLevelFilter );
+
+	if(!GetRegKey( &m_StatusLogMaxSize, _T("Settings"), StatusLogMaxSize, 16 ))
+		SetStatusLogMaxSize( m_StatusLogMaxSize );
+
+	if(!GetRegKey( &m_ListArgBatch, _T("Settings"), ListArgBatch, 1000 ))
+		SetListArgBatch( m_ListArgBatch );
+
+	if(!GetRegKey( &m_SyncConnections, _T("Settings"), SyncConnections, 0 ))
+		SetSyncConnections( m_SyncConnections );
+
+	if(!GetRegKey( &m_ConnectionLimit, _T("Settings"), ConnectionLimit, 8 ))
+		SetConnectionLimit( m_ConnectionLimit );
+
+	if(!GetRegKey( &m_SyncPreviewMaxAge, _T("Settings"), SyncPreviewMaxAge, 300 ))
+		SetSyncPreviewMaxAge( m_SyncPreviewMaxAge );
+
+	if(!GetRegKey( &m_ChangeIndex, _T("Settings"), ChangeIndex, 1 ))
+		SetChangeIndex( m_ChangeIndex );
+
+	if(!GetRegKey( &m_LocalJobQuery, _T("Settings"), LocalJobQuery, 1 ))
+		SetLocalJobQuery( m_LocalJobQuery );
+
+	if(!GetRegKey( &m_ChangeCheck, _T("Settings"), ChangeCheck, 1 ))
+		SetChangeCheck( m_ChangeCheck );
+
+	if(!GetRegKey( &m_AutoPollBackoff, _T("Settings"), AutoPollBackoff, 8 ))
+		SetAutoPollBackoff( m_AutoPollBackoff );
+
+	if(!GetRegKey( &m_ParallelStartup, _T("Settings"), ParallelStartup, 1 ))
+		SetParallelStartup( m_ParallelStartup );
+
 	/////////////
 	// Layout Key
 	
@@ -3285,6 +3361,188 @@ BOOL CP4Registry::SetClientFilterDesc(LPCTSTR clientFilterDesc)
 	return SetRegKey( m_ClientFilterDesc, _T("Settings"), ClientFilterDesc );
 }
 
+BOOL CP4Registry::SetRevCacheSize(int revCacheSize)
+{
+	if (revCacheSize < 0)
+		revCacheSize = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) revCacheSize);
+	m_RevCacheSize= revCacheSize;
+	return SetRegKey( str, _T("Settings"), RevCacheSize );
+}
+
+BOOL CP4Registry::SetPrefetchSize(int prefetchSize)
+{
+	if (prefetchSize < 0)
+		prefetchSize = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) prefetchSize);
+	m_PrefetchSize= prefetchSize;
+	return SetRegKey( str, _T("Settings"), PrefetchSize );
+}
+
+BOOL CP4Registry::SetQuickDiff(int quickDiff)
+{
+	CString str;
+	str.Format(_T("%ld"), (long) quickDiff);
+	m_QuickDiff= quickDiff;
+	return SetRegKey( str, _T("Settings"), QuickDiff );
+}
+
+BOOL CP4Registry::SetQuickDiffMaxSize(int quickDiffMaxSize)
+{
+	if (quickDiffMaxSize < 1)
+		quickDiffMaxSize = 1;
+	CString str;
+	str.Format(_T("%ld"), (long) quickDiffMaxSize);
+	m_QuickDiffMaxSize= quickDiffMaxSize;
+	return SetRegKey( str, _T("Settings"), QuickDiffMaxSize );
+}
+
+BOOL CP4Registry::SetResolvePreviewThreads(int resolvePreviewThreads)
+{
+	if (resolvePreviewThreads < 0)
+		resolvePreviewThreads = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) resolvePreviewThreads);
+	m_ResolvePreviewThreads= resolvePreviewThreads;
+	return SetRegKey( str, _T("Settings"), ResolvePreviewThreads );
+}
+
+BOOL CP4Registry::SetStreamDiffMinSize(int streamDiffMinSize)
+{
+	if (streamDiffMinSize < 0)
+		streamDiffMinSize = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) streamDiffMinSize);
+	m_StreamDiffMinSize= streamDiffMinSize;
+	return SetRegKey( str, _T("Settings"), StreamDiffMinSize );
+}
+
+BOOL CP4Registry::SetLocalFolderCompare(int localFolderCompare)
+{
+	CString str;
+	str.Format(_T("%ld"), (long) localFolderCompare);
+	m_LocalFolderCompare= localFolderCompare;
+	return SetRegKey( str, _T("Settings"), LocalFolderCompare );
+}
+
+BOOL CP4Registry::SetSyncThreads(int syncThreads)
+{
+	if (syncThreads < 0)
+		syncThreads = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) syncThreads);
+	m_SyncThreads= syncThreads;
+	return SetRegKey( str, _T("Settings"), SyncThreads );
+}
+
+BOOL CP4Registry::SetStatusLevelFilter(int statusLevelFilter)
+{
+	if (statusLevelFilter < 0)
+		statusLevelFilter = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) statusLevelFilter);
+	m_StatusLevelFilter= statusLevelFilter;
+	return SetRegKey( str, _T("Settings"), StatusLevelFilter );
+}
+
+BOOL CP4Registry::SetStatusLogMaxSize(int statusLogMaxSize)
+{
+	if (statusLogMaxSize < 1)
+		statusLogMaxSize = 1;
+	CString str;
+	str.Format(_T("%ld"), (long) statusLogMaxSize);
+	m_StatusLogMaxSize= statusLogMaxSize;
+	return SetRegKey( str, _T("Settings"), StatusLogMaxSize );
+}
+
+BOOL CP4Registry::SetListArgBatch(int listArgBatch)
+{
+	if (listArgBatch < 0)
+		listArgBatch = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) listArgBatch);
+	m_ListArgBatch= listArgBatch;
+	return SetRegKey( str, _T("Settings"), ListArgBatch );
+}
+
+BOOL CP4Registry::SetSyncConnections(int syncConnections)
+{
+	if (syncConnections < 0)
+		syncConnections = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) syncConnections);
+	m_SyncConnections= syncConnections;
+	return SetRegKey( str, _T("Settings"), SyncConnections );
+}
+
+BOOL CP4Registry::SetConnectionLimit(int connectionLimit)
+{
+	if (connectionLimit < 1)
+		connectionLimit = 1;
+	CString str;
+	str.Format(_T("%ld"), (long) connectionLimit);
+	m_ConnectionLimit= connectionLimit;
+	return SetRegKey( str, _T("Settings"), ConnectionLimit );
+}
+
+BOOL CP4Registry::SetSyncPreviewMaxAge(int syncPreviewMaxAge)
+{
+	if (syncPreviewMaxAge < 0)
+		syncPreviewMaxAge = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) syncPreviewMaxAge);
+	m_SyncPreviewMaxAge= syncPreviewMaxAge;
+	return SetRegKey( str, _T("Settings"), SyncPreviewMaxAge );
+}
+
+BOOL CP4Registry::SetChangeIndex(int changeIndex)
+{
+	if (changeIndex < 0)
+		changeIndex = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) changeIndex);
+	m_ChangeIndex= changeIndex;
+	return SetRegKey( str, _T("Settings"), ChangeIndex );
+}
+
+BOOL CP4Registry::SetLocalJobQuery(int localJobQuery)
+{
+	if (localJobQuery < 0)
+		localJobQuery = 0;
+	CString str;
+	str.Format(_T("%ld"), (long) localJobQuery);
+	m_LocalJobQuery= localJobQuery;
+	return SetRegKey( str, _T("Settings"), LocalJobQuery );
+}
+
+BOOL CP4Registry::SetChangeCheck(int changeCheck)
+{
+	CString str;
+	str.Format(_T("%ld"), (long) changeCheck);
+	m_ChangeCheck= changeCheck;
+	return SetRegKey( str, _T("Settings"), ChangeCheck );
+}
+
+BOOL CP4Registry::SetAutoPollBackoff(int autoPollBackoff)
+{
+	if (autoPollBackoff < 1)
+		autoPollBackoff = 1;
+	CString str;
+	str.Format(_T("%ld"), (long) autoPollBackoff);
+	m_AutoPollBackoff= autoPollBackoff;
+	return SetRegKey( str, _T("Settings"), AutoPollBackoff );
+}
+
+BOOL CP4Registry::SetParallelStartup(int parallelStartup)
+{
+	CString str;
+	str.Format(_T("%ld"), (long) parallelStartup);
+	m_ParallelStartup= parallelStartup;
+	return SetRegKey( str, _T("Settings"), ParallelStartup );
+}
+
 ///////////////////////////////////////////////////////////////
 // Layout Key
 ///////////////////////////////////////////////////////////////
@@ -248,6 +248,25 @@ protected:
 	CString m_ClientFilterOwner;
 	CString m_ClientFilterHost;
 	CString m_ClientFilterDesc;
+	int m_RevCacheSize;
+	int m_PrefetchSize;
+	int m_QuickDiff;
+	int m_QuickDiffMaxSize;
+	int m_ResolvePreviewThreads;
+	int m_StreamDiffMinSize;
+	int m_LocalFolderCompare;
+	int m_SyncThreads;
+	int m_StatusLevelFilter;
+	int m_StatusLogMaxSize;
+	int m_ListArgBatch;
+	int m_SyncConnections;
+	int m_ConnectionLimit;
+	int m_SyncPreviewMaxAge;
+	int m_ChangeIndex;
+	int m_LocalJobQuery;
+	int m_ChangeCheck;
+	int m_AutoPollBackoff;
+	int m_ParallelStartup;
 
 	//////////////
 	// Layout Key
@@ -724,6 +743,25 @@ public:
 	inline LPCTSTR GetClientFilterOwner() { ASSERT(m_AttemptedRead); return LPCTSTR(m_ClientFilterOwner); }
 	inline LPCTSTR GetClientFilterHost() { ASSERT(m_AttemptedRead); return LPCTSTR(m_ClientFilterHost); }
 	inline LPCTSTR GetClientFilterDesc() { ASSERT(m_AttemptedRead); return LPCTSTR(m_ClientFilterDesc); }
+	inline int GetRevCacheSize() { ASSERT(m_AttemptedRead); return m_RevCacheSize; }
+	inline int GetPrefetchSize() { ASSERT(m_AttemptedRead); return m_PrefetchSize; }
+	inline int GetQuickDiff() { ASSERT(m_AttemptedRead); return m_QuickDiff; }
+	inline int GetQuickDiffMaxSize() { ASSERT(m_AttemptedRead); return m_QuickDiffMaxSize; }
+	inline int GetResolvePreviewThreads() { ASSERT(m_AttemptedRead); return m_ResolvePreviewThreads; }
+	inline int GetStreamDiffMinSize() { ASSERT(m_AttemptedRead); return m_StreamDiffMinSize; }
+	inline int GetLocalFolderCompare() { ASSERT(m_AttemptedRead); return m_LocalFolderCompare; }
+	inline int GetSyncThreads() { ASSERT(m_AttemptedRead); return m_SyncThreads; }
+	inline int GetStatusLevelFilter() { ASSERT(m_AttemptedRead); return m_StatusLevelFilter; }
+	inline int GetStatusLogMaxSize() { ASSERT(m_AttemptedRead); return m_StatusLogMaxSize; }
+	inline int GetListArgBatch() { ASSERT(m_AttemptedRead); return m_ListArgBatch; }
+	inline int GetSyncConnections() { ASSERT(m_AttemptedRead); return m_SyncConnections; }
+	inline int GetConnectionLimit() { ASSERT(m_AttemptedRead); return m_ConnectionLimit; }
+	inline int GetSyncPreviewMaxAge() { ASSERT(m_AttemptedRead); return m_SyncPreviewMaxAge; }
+	inline int GetChangeIndex() { ASSERT(m_AttemptedRead); return m_ChangeIndex; }
+	inline int GetLocalJobQuery() { ASSERT(m_AttemptedRead); return m_LocalJobQuery; }
+	inline int GetChangeCheck() { ASSERT(m_AttemptedRead); return m_ChangeCheck; }
+	inline int GetAutoPollBackoff() { ASSERT(m_AttemptedRead); return m_AutoPollBackoff; }
+	inline int GetParallelStartup() { ASSERT(m_AttemptedRead); return m_ParallelStartup; }
 	BOOL SetAddFileCurDir(LPCTSTR dir);
 	BOOL SetAddFileExtFilter(LPCTSTR exts);
 	BOOL SetAddFileFilter(LPCTSTR filter);
@@ -748,6 +786,25 @@ public:
 	BOOL SetClientFilterOwner(LPCTSTR clientFilterOwner);
 	BOOL SetClientFilterHost(LPCTSTR clientFilterHost);
 	BOOL SetClientFilterDesc(LPCTSTR clientFilterDesc);
+	BOOL SetRevCacheSize(int revCacheSize);
+	BOOL SetPrefetchSize(int prefetchSize);
+	BOOL SetQuickDiff(int quickDiff);
+	BOOL SetQuickDiffMaxSize(int quickDiffMaxSize);
+	BOOL SetResolvePreviewThreads(int resolvePreviewThreads);
+	BOOL SetStreamDiffMinSize(int streamDiffMinSize);
+	BOOL SetLocalFolderCompare(int localFolderCompare);
+	BOOL SetSyncThreads(int syncThreads);
+	BOOL SetStatusLevelFilter(int statusLevelFilter);
+	BOOL SetStatusLogMaxSize(int statusLogMaxSize);
+	BOOL SetListArgBatch(int listArgBatch);
+	BOOL SetSyncConnections(int syncConnections);
+	BOOL SetConnectionLimit(int connectionLimit);
+	BOOL SetSyncPreviewMaxAge(int syncPreviewMaxAge);
+	BOOL SetChangeIndex(int changeIndex);
+	BOOL SetLocalJobQuery(int localJobQuery);
+	BOOL SetChangeCheck(int changeCheck);
+	BOOL SetAutoPollBackoff(int autoPollBackoff);
+	BOOL SetParallelStartup(int parallelStartup);
 	
 	///////////////
 	// Layout Key
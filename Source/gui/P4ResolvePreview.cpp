@@ -0,0 +1,263 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4ResolvePreview.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4ResolvePreview.h"
+#include "merge3engine.h"
+#include "cmd_prepbrowse.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+#define MAXPREVIEWTHREADS	16
+
+
+CP4ResolvePreview::CP4ResolvePreview()
+{
+	m_Next = 0;
+	m_pThread = NULL;
+	m_Cancel = 0;
+}
+
+CP4ResolvePreview::~CP4ResolvePreview()
+{
+	Cancel();
+	for (int i = 0; i < GetCount(); i++)
+		delete GetItem(i);
+}
+
+// Picks apart a "resolve -n -o" line such as
+//   c:\ws\file.c - merging //depot/rel/file.c#3,#5 using base //depot/rel/file.c#2
+// Returns FALSE for anything that isn't a text merge with a known base.
+BOOL CP4ResolvePreview::AddMergeMessage(LPCTSTR data)
+{
+	CString line = data;
+	int i, j;
+	if ((i = line.Find(_T(" - merging "))) == -1
+	 || (j = line.Find(_T(" using base "), i)) == -1)
+		return FALSE;
+
+	CResolvePreviewItem *item = new CResolvePreviewItem;
+	item->m_ClientFile = line.Left(i);
+	i += lstrlen(_T(" - merging "));
+	if (!ParseRev(line.Mid(i, j - i), item->m_TheirFile, item->m_TheirRev)
+	 || !ParseRev(line.Mid(j + lstrlen(_T(" using base "))), item->m_BaseFile, item->m_BaseRev))
+	{
+		delete item;
+		return FALSE;
+	}
+	item->m_Done = FALSE;
+	item->m_YourChunks = item->m_TheirChunks = item->m_BothChunks = item->m_ConflictChunks = 0;
+	m_Items.Add(item);
+	return TRUE;
+}
+
+// "//depot/file.c#3,#5" or "//depot/file.c#5": the last revision is the one wanted
+BOOL CP4ResolvePreview::ParseRev(CString spec, CString &path, long &rev)
+{
+	spec.TrimRight();
+	int i = spec.Find(_T('#'));
+	int j = spec.ReverseFind(_T('#'));
+	if (i <= 0)
+		return FALSE;
+	path = spec.Left(i);
+	rev = _ttol(spec.Mid(j + 1));
+	return rev > 0;
+}
+
+// Runs the preview in the background; returns FALSE if there is nothing
+// to preview or the thread could not be started
+BOOL CP4ResolvePreview::Start()
+{
+	if (!GetCount() || m_pThread)
+		return FALSE;
+
+	m_pThread = AfxBeginThread(RunThread, (LPVOID) this,
+				THREAD_PRIORITY_BELOW_NORMAL, 0, CREATE_SUSPENDED, NULL);
+	if (!m_pThread)
+		return FALSE;
+	m_pThread->m_bAutoDelete = FALSE;	// Cancel() waits on the handle
+	m_pThread->ResumeThread();
+
+	CString txt;
+	txt.FormatMessage(IDS_PREVIEWING_n_MERGES_LOCALLY, GetCount());
+	TheApp()->StatusAdd(txt);
+	return TRUE;
+}
+
+BOOL CP4ResolvePreview::IsRunning()
+{
+	return m_pThread && WaitForSingleObject(m_pThread->m_hThread, 0) == WAIT_TIMEOUT;
+}
+
+// Stop the workers, abandoning any print in progress, and wait for them
+void CP4ResolvePreview::Cancel()
+{
+	InterlockedExchange(&m_Cancel, 1);
+	if (m_pThread)
+	{
+		WaitForSingleObject(m_pThread->m_hThread, INFINITE);
+		delete m_pThread;
+		m_pThread = NULL;
+	}
+}
+
+UINT CP4ResolvePreview::RunThread(LPVOID pParam)
+{
+	CP4ResolvePreview *preview = (CP4ResolvePreview *) pParam;
+	preview->Run();
+	if (!preview->m_Cancel && !APP_ABORTING())
+		preview->ReportResults();
+	return 0;
+}
+
+// Runs the previews on as many workers as there are processors (up to the
+// configured limit) and waits for them all to finish
+void CP4ResolvePreview::Run()
+{
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	int nThreads = min((int) si.dwNumberOfProcessors, GET_P4REGPTR()->GetResolvePreviewThreads());
+	nThreads = max(1, min(min(nThreads, GetCount()), MAXPREVIEWTHREADS));
+
+	CWinThread *threads[MAXPREVIEWTHREADS];
+	HANDLE handles[MAXPREVIEWTHREADS];
+	int n;
+	for (n = 0; n < nThreads; n++)
+	{
+		threads[n] = AfxBeginThread(PreviewThread, (LPVOID) this,
+					THREAD_PRIORITY_BELOW_NORMAL, 0, CREATE_SUSPENDED, NULL);
+		if (!threads[n])
+			break;
+		threads[n]->m_bAutoDelete = FALSE;	// we wait on the handle
+		handles[n] = threads[n]->m_hThread;
+		threads[n]->ResumeThread();
+	}
+	if (!n)
+	{
+		DoPreview();
+		return;
+	}
+	WaitForMultipleObjects(n, handles, TRUE, INFINITE);
+	while (n--)
+		delete threads[n];
+}
+
+UINT CP4ResolvePreview::PreviewThread(LPVOID pParam)
+{
+	((CP4ResolvePreview *) pParam)->DoPreview();
+	return 0;
+}
+
+CResolvePreviewItem *CP4ResolvePreview::NextItem()
+{
+	CResolvePreviewItem *item = NULL;
+	m_Lock.Lock();
+	if (!m_Cancel && m_Next < GetCount())
+		item = GetItem(m_Next++);
+	m_Lock.Unlock();
+	return item;
+}
+
+void CP4ResolvePreview::DoPreview()
+{
+	CResolvePreviewItem *item;
+	while ((item = NextItem()) != NULL && !APP_ABORTING())
+		Preview(item);
+}
+
+void CP4ResolvePreview::Preview(CResolvePreviewItem *item)
+{
+	CString baseName, theirName;
+	if (Fetch(item->m_BaseFile, item->m_BaseRev, baseName, item->m_Error)
+	 && Fetch(item->m_TheirFile, item->m_TheirRev, theirName, item->m_Error))
+	{
+		CMerge3Engine engine;
+		if (engine.LoadFiles(baseName, theirName, item->m_ClientFile,
+				(__int64)GET_P4REGPTR()->GetQuickDiffMaxSize() * 1024 * 1024, item->m_Error))
+		{
+			engine.Merge();
+			item->m_YourChunks = engine.GetYourChunks();
+			item->m_TheirChunks = engine.GetTheirChunks();
+			item->m_BothChunks = engine.GetBothChunks();
+			item->m_ConflictChunks = engine.GetConflictChunks();
+			item->m_Done = TRUE;
+		}
+	}
+
+	// The revision cache keeps its own copy
+	if (!baseName.IsEmpty())
+	{
+		SetFileAttributes(baseName, FILE_ATTRIBUTE_NORMAL);
+		DeleteFile(baseName);
+	}
+	if (!theirName.IsEmpty())
+	{
+		SetFileAttributes(theirName, FILE_ATTRIBUTE_NORMAL);
+		DeleteFile(theirName);
+	}
+}
+
+BOOL CP4ResolvePreview::Fetch(LPCTSTR depotPath, long rev, CString &tempName, CString &errorText)
+{
+	CString fileType = _T("text");
+	CCmd_PrepBrowse cmd;
+	cmd.SetIndependent(&m_Cancel);
+	cmd.Init(NULL, RUN_SYNC);
+	if (!cmd.Run(depotPath, fileType, rev) || cmd.GetError() || cmd.NoFileAtThatRev())
+	{
+		errorText = cmd.GetErrorText();
+		if (errorText.IsEmpty())
+			errorText.FormatMessage(IDS_UNABLE_TO_GET_s_n, depotPath, rev);
+		return FALSE;
+	}
+	tempName = cmd.GetTempName();
+	return TRUE;
+}
+
+// A line per file with the chunk counts the merge would produce, then a
+// summary line
+void CP4ResolvePreview::ReportResults()
+{
+	int files = 0, conflicted = 0, conflicts = 0, failed = 0;
+	CString txt;
+	for (int i = 0; i < GetCount(); i++)
+	{
+		CResolvePreviewItem *item = GetItem(i);
+		if (!item->m_Done)
+		{
+			failed++;
+			CString err = item->m_Error;
+			err.TrimRight();
+			txt.FormatMessage(IDS_s_NOT_PREVIEWED_s, (LPCTSTR) item->m_ClientFile, (LPCTSTR) err);
+			TheApp()->StatusAdd(txt, SV_WARNING);
+			continue;
+		}
+		files++;
+		if (item->m_ConflictChunks)
+		{
+			conflicted++;
+			conflicts += item->m_ConflictChunks;
+		}
+		txt.FormatMessage(IDS_s_MERGE_PREVIEW_n_n_n_n, (LPCTSTR) item->m_ClientFile,
+			item->m_YourChunks, item->m_TheirChunks, item->m_BothChunks, item->m_ConflictChunks);
+		TheApp()->StatusAdd(txt, item->m_ConflictChunks ? SV_WARNING : SV_MSG);
+	}
+
+	txt.FormatMessage(IDS_MERGE_PREVIEW_n_FILES_n_CONFLICTED_n_CHUNKS, files, conflicted, conflicts);
+	if (failed)
+	{
+		CString more;
+		more.FormatMessage(IDS_n_COULD_NOT_BE_PREVIEWED, failed);
+		txt += more;
+	}
+	TheApp()->StatusAdd(txt, conflicted || failed ? SV_WARNING : SV_COMPLETION);
+}
@@ -0,0 +1,75 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4ResolvePreview.h
+//
+// CP4ResolvePreview works out, for each file an automatic resolve would
+// merge, how the three-way merge would come out: how many chunks come
+// from yours, from theirs, from both, and how many conflict.  The base and
+// their revisions are printed through the revision cache and merged in
+// memory with CMerge3Engine, on several worker threads at once.  Start()
+// runs the whole preview in the background once the resolve -n has
+// finished and let go of the server lock; the prints run as independent
+// commands, each worker on its own connection, so they never hold up the
+// user's commands.  Cancel() abandons the preview and waits for it; it
+// must be called before the owner goes away.
+
+#ifndef __P4RESOLVEPREVIEW__
+#define __P4RESOLVEPREVIEW__
+
+#include <afxmt.h>
+
+class CResolvePreviewItem : public CObject
+{
+public:
+	CString m_ClientFile;		// yours, in local syntax
+	CString m_TheirFile;
+	long	m_TheirRev;
+	CString m_BaseFile;
+	long	m_BaseRev;
+
+	// Results
+	BOOL	m_Done;
+	CString m_Error;
+	int		m_YourChunks;
+	int		m_TheirChunks;
+	int		m_BothChunks;
+	int		m_ConflictChunks;
+};
+
+class CP4ResolvePreview
+{
+public:
+	CP4ResolvePreview();
+	~CP4ResolvePreview();
+
+protected:
+	CCriticalSection m_Lock;
+	CObArray m_Items;
+	int		m_Next;				// next item for a worker to take
+	CWinThread *m_pThread;		// runs the workers and reports the results
+	volatile LONG m_Cancel;
+
+public:
+	BOOL AddMergeMessage(LPCTSTR data);
+	int  GetCount() { return (int) m_Items.GetSize(); }
+	CResolvePreviewItem *GetItem(int i) { return (CResolvePreviewItem *) m_Items.GetAt(i); }
+	BOOL Start();
+	BOOL IsRunning();
+	void Cancel();
+
+protected:
+	static BOOL ParseRev(CString spec, CString &path, long &rev);
+	static UINT RunThread(LPVOID pParam);
+	static UINT PreviewThread(LPVOID pParam);
+	void Run();
+	void ReportResults();
+	void DoPreview();
+	CResolvePreviewItem *NextItem();
+	void Preview(CResolvePreviewItem *item);
+	BOOL Fetch(LPCTSTR depotPath, long rev, CString &tempName, CString &errorText);
+};
+
+#endif //__P4RESOLVEPREVIEW__
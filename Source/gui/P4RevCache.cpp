@@ -0,0 +1,581 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4RevCache.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4RevCache.h"
+#include "md5.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+#define REVCACHE_DIR	_T("P4WinCache")
+#define REVCACHE_INDEX	_T("P4WinCache.idx")
+
+// Never let a single revision take more than this fraction of the cache,
+// or one huge file would flush everything else out
+#define REVCACHE_MAXENTRYDIV 4
+
+// The index is written at most this often while the cache is in use, and
+// at exit; a file stored since the last write is swept up at next startup
+#define REVCACHE_SAVEINTERVAL 60000
+
+
+CP4RevCache::CP4RevCache()
+{
+	m_Loaded = m_Dirty = FALSE;
+	m_SavedAt = 0;
+	m_Clock = 0;
+	m_TotalBytes = 0;
+	m_Hits = m_Misses = 0;
+	m_BytesSaved = 0;
+}
+
+CP4RevCache::~CP4RevCache()
+{
+	Flush();
+	RemoveAll();
+}
+
+// The client's line endings and the charset both change what the server
+// sends, so they are part of the key too
+CString CP4RevCache::MakeKey(LPCTSTR port, LPCTSTR depotPath, long rev, LPCTSTR variant)
+{
+	CString lineEnd = TheApp()->m_ClientLineEnd;
+	if (lineEnd.IsEmpty())
+		lineEnd = TheApp()->m_bNoCRLF ? _T("nocrlf") : _T("crlf");
+	CString key;
+	key.Format(_T("%s|%s|%s|%s|%s#%ld"), port, GET_P4REGPTR()->GetP4Charset(),
+		lineEnd, variant, depotPath, rev);
+	return key;
+}
+
+CString CP4RevCache::GetCacheDir()
+{
+	CString dir = GET_P4REGPTR()->GetTempDir();
+	dir.TrimRight(_T('\\'));
+	return dir + _T('\\') + REVCACHE_DIR;
+}
+
+__int64 CP4RevCache::GetMaxBytes()
+{
+	return (__int64)GET_P4REGPTR()->GetRevCacheSize() * 1024 * 1024;
+}
+
+BOOL CP4RevCache::IsEnabled()
+{
+	return GetMaxBytes() > 0;
+}
+
+// Must be called with m_Lock held
+void CP4RevCache::Load()
+{
+	CString dir = GetCacheDir();
+	if (m_Loaded && dir == m_Dir)
+		return;
+
+	// The temp directory moved - write out the old index before switching
+	if (m_Loaded)
+	{
+		Save();
+		RemoveAll();
+	}
+	m_Dir = dir;
+	m_Loaded = TRUE;
+	m_Dirty = FALSE;
+	m_Clock = 0;
+	m_TotalBytes = 0;
+	CreateDirectory(m_Dir, NULL);
+
+	HANDLE hFile;
+	if ((hFile = CreateFile(m_Dir + _T('\\') + REVCACHE_INDEX, GENERIC_READ,
+				FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0)) == INVALID_HANDLE_VALUE)
+	{
+		SweepOrphans();
+		return;
+	}
+
+	DWORD NumberOfBytesRead;
+	DWORD fsize = GetFileSize(hFile, NULL);
+	LPTSTR pBuf = new TCHAR[fsize/sizeof(TCHAR) + 1];
+	BOOL b = ReadFile(hFile, pBuf, fsize, &NumberOfBytesRead, NULL);
+	CloseHandle(hFile);
+	pBuf[b ? NumberOfBytesRead/sizeof(TCHAR) : 0] = _T('\0');
+
+	LPTSTR pStr = pBuf;
+#ifdef UNICODE
+	if (*pStr == 0xFEFF)
+		pStr++;
+#endif
+	CString index = pStr;
+	delete [] pBuf;
+
+	// Each line is: key, file, size, type, digest, server digest, LRU stamp
+	int beg = 0;
+	int end;
+	while ((end = index.Find(_T('\n'), beg)) != -1)
+	{
+		CString line = index.Mid(beg, end - beg);
+		beg = end + 1;
+		line.TrimRight(_T("\r"));
+
+		CString fld[7];
+		int i, f, pos = 0;
+		for (f = 0; f < 7 && pos <= line.GetLength(); f++)
+		{
+			if ((i = line.Find(_T('\t'), pos)) == -1)
+				i = line.GetLength();
+			fld[f] = line.Mid(pos, i - pos);
+			pos = i + 1;
+		}
+		if (f < 7 || fld[0].IsEmpty() || fld[1].IsEmpty())
+			continue;
+
+		CRevCacheEntry *entry = new CRevCacheEntry;
+		entry->m_Key = fld[0];
+		entry->m_FileName = fld[1];
+		entry->m_Size = _ttoi64(fld[2]);
+		entry->m_Type = _ttoi(fld[3]);
+		entry->m_Digest = fld[4];
+		entry->m_ServerDigest = fld[5] == _T("-") ? _T("") : fld[5];
+		entry->m_LastUsed = _tcstoul(fld[6], NULL, 10);
+
+		CObject *old;
+		if (m_Entries.Lookup(entry->m_Key, old))
+		{
+			m_TotalBytes -= ((CRevCacheEntry *)old)->m_Size;
+			delete old;
+		}
+		m_Entries.SetAt(entry->m_Key, entry);
+		m_TotalBytes += entry->m_Size;
+		if (entry->m_LastUsed > m_Clock)
+			m_Clock = entry->m_LastUsed;
+	}
+	SweepOrphans();
+}
+
+// Must be called with m_Lock held
+void CP4RevCache::Save()
+{
+	if (!m_Loaded || !m_Dirty)
+		return;
+
+	HANDLE hFile;
+	if ((hFile = CreateFile(m_Dir + _T('\\') + REVCACHE_INDEX, GENERIC_READ | GENERIC_WRITE,
+				FILE_SHARE_READ, 0, CREATE_ALWAYS, 0, 0)) == INVALID_HANDLE_VALUE)
+		return;
+
+	CString index;
+#ifdef UNICODE
+	index += (TCHAR)0xFEFF;
+#endif
+	CString key;
+	CObject *obj;
+	for (POSITION pos = m_Entries.GetStartPosition(); pos != NULL; )
+	{
+		m_Entries.GetNextAssoc(pos, key, obj);
+		CRevCacheEntry *entry = (CRevCacheEntry *)obj;
+		CString recd;
+		recd.Format(_T("%s\t%s\t%I64d\t%d\t%s\t%s\t%lu\r\n"),
+			entry->m_Key, entry->m_FileName, entry->m_Size, entry->m_Type,
+			entry->m_Digest, entry->m_ServerDigest.IsEmpty() ? _T("-") : entry->m_ServerDigest,
+			entry->m_LastUsed);
+		index += recd;
+	}
+	DWORD NumberOfBytesWritten;
+	WriteFile(hFile, index, index.GetLength()*sizeof(TCHAR), &NumberOfBytesWritten, NULL);
+	CloseHandle(hFile);
+	m_Dirty = FALSE;
+	m_SavedAt = GetTickCount();
+}
+
+// Must be called with m_Lock held
+void CP4RevCache::SaveIfDue()
+{
+	if (m_Dirty && GetTickCount() - m_SavedAt >= REVCACHE_SAVEINTERVAL)
+		Save();
+}
+
+void CP4RevCache::Flush()
+{
+	m_Lock.Lock();
+	Save();
+	m_Lock.Unlock();
+}
+
+// Delete any file in the cache directory that the index doesn't know about;
+// these are left behind if P4Win exits before the index is written.
+// Must be called with m_Lock held
+void CP4RevCache::SweepOrphans()
+{
+	CMapStringToPtr known;
+	CString key;
+	CObject *obj;
+	for (POSITION pos = m_Entries.GetStartPosition(); pos != NULL; )
+	{
+		m_Entries.GetNextAssoc(pos, key, obj);
+		known.SetAt(((CRevCacheEntry *)obj)->m_FileName, NULL);
+	}
+
+	WIN32_FIND_DATA fd;
+	HANDLE hFind = FindFirstFile(m_Dir + _T("\\*"), &fd);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		void *p;
+		if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		 || !lstrcmpi(fd.cFileName, REVCACHE_INDEX)
+		 || known.Lookup(fd.cFileName, p))
+			continue;
+		CString path = m_Dir + _T('\\') + fd.cFileName;
+		SetFileAttributes(path, FILE_ATTRIBUTE_NORMAL);
+		DeleteFile(path);
+	} while (FindNextFile(hFind, &fd));
+	FindClose(hFind);
+}
+
+// Must be called with m_Lock held
+void CP4RevCache::Remove(CRevCacheEntry *entry)
+{
+	CString path = m_Dir + _T('\\') + entry->m_FileName;
+	SetFileAttributes(path, FILE_ATTRIBUTE_NORMAL);
+	DeleteFile(path);
+	m_TotalBytes -= entry->m_Size;
+	m_Entries.RemoveKey(entry->m_Key);
+	delete entry;
+	m_Dirty = TRUE;
+}
+
+// Drop the in-memory index only; the files stay on disk
+void CP4RevCache::RemoveAll()
+{
+	CString key;
+	CObject *obj;
+	for (POSITION pos = m_Entries.GetStartPosition(); pos != NULL; )
+	{
+		m_Entries.GetNextAssoc(pos, key, obj);
+		delete obj;
+	}
+	m_Entries.RemoveAll();
+	m_TotalBytes = 0;
+}
+
+static int compareLastUsed(const void *arg1, const void *arg2)
+{
+	DWORD a = (*(CRevCacheEntry **)arg1)->m_LastUsed;
+	DWORD b = (*(CRevCacheEntry **)arg2)->m_LastUsed;
+	return a < b ? -1 : a > b ? 1 : 0;
+}
+
+// Removes the least recently used entries until the cache fits.
+// Must be called with m_Lock held
+void CP4RevCache::Evict(__int64 maxBytes)
+{
+	if (m_TotalBytes <= maxBytes)
+		return;
+
+	int count = (int)m_Entries.GetCount();
+	CRevCacheEntry **entries = new CRevCacheEntry *[count];
+	CString key;
+	CObject *obj;
+	int n = 0;
+	for (POSITION pos = m_Entries.GetStartPosition(); pos != NULL; )
+	{
+		m_Entries.GetNextAssoc(pos, key, obj);
+		entries[n++] = (CRevCacheEntry *)obj;
+	}
+	qsort(entries, n, sizeof(CRevCacheEntry *), compareLastUsed);
+	for (int i = 0; i < n && m_TotalBytes > maxBytes; i++)
+		Remove(entries[i]);
+	delete [] entries;
+}
+
+BOOL CP4RevCache::DigestOf(LPCTSTR fileName, int fileSysType, CString &digest)
+{
+	Error e;
+	FileSys *f = FileSys::Create( (enum FileSysType) fileSysType );
+	StrBuf path;
+	path << CharFromCString(fileName);
+	f->Set(path);
+
+	StrBuf md5;
+	f->Digest(&md5, &e);
+	delete f;
+	if (e.Test())
+		return FALSE;
+	digest = CharToCString(md5.Value());
+	return TRUE;
+}
+
+BOOL CP4RevCache::Contains(LPCTSTR key)
+{
+	if (!IsEnabled())
+		return FALSE;
+
+	CObject *obj;
+	m_Lock.Lock();
+	Load();
+	BOOL found = m_Entries.Lookup(key, obj);
+	m_Lock.Unlock();
+	return found;
+}
+
+// Copy a cached revision to destName and make the copy read-only.
+// Returns FALSE on a miss, or if the cached copy fails its integrity check.
+BOOL CP4RevCache::Fetch(LPCTSTR key, LPCTSTR destName, LPCTSTR serverDigest/*=NULL*/)
+{
+	if (!IsEnabled())
+		return FALSE;
+
+	CObject *obj;
+	m_Lock.Lock();
+	Load();
+	if (!m_Entries.Lookup(key, obj))
+	{
+		m_Misses++;
+		m_Lock.Unlock();
+		return FALSE;
+	}
+	CRevCacheEntry *entry = (CRevCacheEntry *)obj;
+
+	// If the server reports a different digest for this revision (e.g. it
+	// was obliterated and resubmitted), the entry is stale
+	if (serverDigest && *serverDigest && !entry->m_ServerDigest.IsEmpty()
+	 && entry->m_ServerDigest != serverDigest)
+	{
+		Remove(entry);
+		m_Misses++;
+		m_Lock.Unlock();
+		return FALSE;
+	}
+	CString path = m_Dir + _T('\\') + entry->m_FileName;
+	CString digest = entry->m_Digest;
+	__int64 size = entry->m_Size;
+	int type = entry->m_Type;
+	m_Lock.Unlock();
+
+	// Integrity check, done without the lock since it reads the whole file
+	CString actual;
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	BOOL good = GetFileAttributesEx(path, GetFileExInfoStandard, &fad)
+			 && ((__int64)fad.nFileSizeHigh << 32 | fad.nFileSizeLow) == size
+			 && DigestOf(path, type, actual) && actual == digest;
+	if (good)
+	{
+		SetFileAttributes(destName, FILE_ATTRIBUTE_NORMAL);
+		good = CopyFile(path, destName, FALSE);
+		if (good)
+			SetFileAttributes(destName, FILE_ATTRIBUTE_READONLY);
+	}
+
+	// Another thread may have replaced the entry while the lock was free;
+	// only touch it if it is still the one that was checked
+	m_Lock.Lock();
+	if (m_Entries.Lookup(key, obj) && obj == entry
+	 && entry->m_Digest == digest && entry->m_Size == size)
+	{
+		if (good)
+		{
+			entry->m_LastUsed = ++m_Clock;
+			m_Dirty = TRUE;
+		}
+		else
+			Remove(entry);
+	}
+	if (good)
+	{
+		m_Hits++;
+		m_BytesSaved += size;
+	}
+	else
+		m_Misses++;
+	m_Lock.Unlock();
+	return good;
+}
+
+// Copy a freshly printed revision into the cache
+BOOL CP4RevCache::Store(LPCTSTR key, LPCTSTR srcName, int fileSysType, LPCTSTR serverDigest/*=NULL*/)
+{
+	__int64 maxBytes = GetMaxBytes();
+	if (maxBytes <= 0)
+		return FALSE;
+
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	if (!GetFileAttributesEx(srcName, GetFileExInfoStandard, &fad))
+		return FALSE;
+	__int64 size = (__int64)fad.nFileSizeHigh << 32 | fad.nFileSizeLow;
+	if (size > maxBytes / REVCACHE_MAXENTRYDIV)
+		return FALSE;
+
+	CString digest;
+	if (!DigestOf(srcName, fileSysType, digest))
+		return FALSE;
+
+	// Name the copy after a hash of the key, but keep the file's own
+	// name on the end so its extension still means something
+	MD5 md5;
+	StrBuf keyBuf;
+	StrBuf hash;
+	keyBuf.Set(CharFromCString(key));
+	md5.Update(keyBuf);
+	md5.Final(hash);
+	CString leaf = srcName;
+	int i;
+	if ((i = leaf.ReverseFind(_T('\\'))) != -1)
+		leaf = leaf.Mid(i+1);
+	if ((i = CString(key).ReverseFind(_T('/'))) != -1)
+	{
+		leaf = CString(key).Mid(i+1);
+		if ((i = leaf.ReverseFind(_T('#'))) != -1)
+			leaf = leaf.Left(i);
+	}
+	CString fileName = CharToCString(hash.Text()) + _T('-') + leaf;
+
+	BOOL stored = FALSE;
+	m_Lock.Lock();
+	Load();
+	CObject *obj;
+	if (m_Entries.Lookup(key, obj))
+		Remove((CRevCacheEntry *)obj);
+
+	CString path = m_Dir + _T('\\') + fileName;
+	SetFileAttributes(path, FILE_ATTRIBUTE_NORMAL);
+	if (CopyFile(srcName, path, FALSE))
+	{
+		SetFileAttributes(path, FILE_ATTRIBUTE_READONLY);
+
+		CRevCacheEntry *entry = new CRevCacheEntry;
+		entry->m_Key = key;
+		entry->m_FileName = fileName;
+		entry->m_Size = size;
+		entry->m_Type = fileSysType;
+		entry->m_Digest = digest;
+		entry->m_ServerDigest = serverDigest ? serverDigest : _T("");
+		entry->m_LastUsed = ++m_Clock;
+		m_Entries.SetAt(entry->m_Key, entry);
+		m_TotalBytes += size;
+		m_Dirty = TRUE;
+		stored = TRUE;
+
+		Evict(maxBytes);
+	}
+	SaveIfDue();
+	m_Lock.Unlock();
+	return stored;
+}
+
+// Text entries go through a temp file of their own, named for the thread
+// so that commands running side by side don't trip over each other
+CString CP4RevCache::GetTextTempName()
+{
+	CString name;
+	CString dir = GET_P4REGPTR()->GetTempDir();
+	dir.TrimRight(_T('\\'));
+	name.Format(_T("%s\\P4WinText-%lx.txt"), dir, GetCurrentThreadId());
+	return name;
+}
+
+BOOL CP4RevCache::FetchText(LPCTSTR key, CString &text, LPCTSTR serverDigest/*=NULL*/)
+{
+	if (!Contains(key))
+		return FALSE;
+
+	CString tempName = GetTextTempName();
+	if (!Fetch(key, tempName, serverDigest))
+		return FALSE;
+
+	BOOL b = FALSE;
+	HANDLE hFile;
+	if ((hFile = CreateFile(tempName, GENERIC_READ, 
+				FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0)) != INVALID_HANDLE_VALUE)
+	{
+		DWORD NumberOfBytesRead;
+		DWORD fsize = GetFileSize(hFile, NULL);
+		LPTSTR pBuf = new TCHAR[fsize/sizeof(TCHAR) + 1];
+		b = ReadFile(hFile, pBuf, fsize, &NumberOfBytesRead, NULL);
+		CloseHandle(hFile);
+		pBuf[b ? NumberOfBytesRead/sizeof(TCHAR) : 0] = _T('\0');
+
+		LPTSTR pStr = pBuf;
+#ifdef UNICODE
+		if (*pStr == 0xFEFF)
+			pStr++;
+#endif
+		text = pStr;
+		delete [] pBuf;
+	}
+	SetFileAttributes(tempName, FILE_ATTRIBUTE_NORMAL);
+	DeleteFile(tempName);
+	return b;
+}
+
+BOOL CP4RevCache::StoreText(LPCTSTR key, LPCTSTR text, LPCTSTR serverDigest/*=NULL*/)
+{
+	if (!IsEnabled())
+		return FALSE;
+
+	CString tempName = GetTextTempName();
+	HANDLE hFile;
+	SetFileAttributes(tempName, FILE_ATTRIBUTE_NORMAL);
+	if ((hFile = CreateFile(tempName, GENERIC_READ | GENERIC_WRITE, 
+				0, 0, CREATE_ALWAYS, 0, 0)) == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	DWORD NumberOfBytesWritten;
+#ifdef UNICODE
+	TCHAR uhdr[] = {0xFEFF};
+	WriteFile(hFile, uhdr, 2, &NumberOfBytesWritten, NULL);
+#endif
+	BOOL b = WriteFile(hFile, text, lstrlen(text)*sizeof(TCHAR), &NumberOfBytesWritten, NULL);
+	CloseHandle(hFile);
+
+	if (b)
+		b = Store(key, tempName, FST_BINARY, serverDigest);
+	DeleteFile(tempName);
+	return b;
+}
+
+// Drop every entry whose key ends with suffix, e.g. all the cached
+// variants of one change
+void CP4RevCache::RemoveKeysEndingWith(LPCTSTR suffix)
+{
+	if (!IsEnabled())
+		return;
+
+	int lgth = lstrlen(suffix);
+	CObList matches;
+	CString key;
+	CObject *obj;
+	m_Lock.Lock();
+	Load();
+	for (POSITION pos = m_Entries.GetStartPosition(); pos != NULL; )
+	{
+		m_Entries.GetNextAssoc(pos, key, obj);
+		if (key.Right(lgth) == suffix)
+			matches.AddTail(obj);
+	}
+	while (!matches.IsEmpty())
+		Remove((CRevCacheEntry *)matches.RemoveHead());
+	SaveIfDue();
+	m_Lock.Unlock();
+}
+
+CString CP4RevCache::GetStatsText()
+{
+	CString txt;
+	m_Lock.Lock();
+	long total = m_Hits + m_Misses;
+	txt.Format(_T("Revision cache: %ld hits, %ld misses (%ld%%), %I64d KB saved, %I64d KB in %d files"),
+		m_Hits, m_Misses, total ? (m_Hits * 100) / total : 0L,
+		m_BytesSaved / 1024, m_TotalBytes / 1024, (int)m_Entries.GetCount());
+	m_Lock.Unlock();
+	return txt;
+}
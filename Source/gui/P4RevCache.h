@@ -0,0 +1,86 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4RevCache.h
+//
+// CP4RevCache is an on-disk cache of depot file revisions, shared by every
+// command that prints a revision to a temp file (browse, diff, annotate and
+// merge).  Entries are keyed by server port, charset, client line endings,
+// output variant and depot path#rev, and the cache is held under a size
+// cap by evicting the least recently used entries.  Each entry records the digest of the cached copy,
+// which is rechecked before the copy is handed out, so a damaged entry is
+// simply dropped and refetched from the server.  Command output that never
+// changes once written (submitted change descriptions and the like) is kept
+// here too, as text entries.
+
+#ifndef __P4REVCACHE__
+#define __P4REVCACHE__
+
+#include <afxmt.h>
+
+class CRevCacheEntry : public CObject
+{
+public:
+	CString m_Key;
+	CString m_FileName;		// name of the cached copy, relative to the cache directory
+	__int64 m_Size;
+	int		m_Type;			// FileSysType the copy was written (and is digested) as
+	CString m_Digest;		// digest of the cached copy
+	CString m_ServerDigest;	// the server's digest for the revision, if known
+	DWORD	m_LastUsed;		// LRU stamp
+};
+
+class CP4RevCache
+{
+public:
+	CP4RevCache();
+	~CP4RevCache();
+
+protected:
+	CCriticalSection m_Lock;
+	CMapStringToOb m_Entries;
+	CString m_Dir;
+	BOOL	m_Loaded;
+	BOOL	m_Dirty;
+	DWORD	m_SavedAt;			// tick count of the last index write
+	DWORD	m_Clock;
+	__int64 m_TotalBytes;
+
+	// Statistics, for this session only
+	long	m_Hits;
+	long	m_Misses;
+	__int64 m_BytesSaved;
+
+public:
+	static CString MakeKey(LPCTSTR port, LPCTSTR depotPath, long rev, LPCTSTR variant);
+
+	BOOL IsEnabled();
+	BOOL Contains(LPCTSTR key);
+	BOOL Fetch(LPCTSTR key, LPCTSTR destName, LPCTSTR serverDigest=NULL);
+	BOOL Store(LPCTSTR key, LPCTSTR srcName, int fileSysType, LPCTSTR serverDigest=NULL);
+	BOOL FetchText(LPCTSTR key, CString &text, LPCTSTR serverDigest=NULL);
+	BOOL StoreText(LPCTSTR key, LPCTSTR text, LPCTSTR serverDigest=NULL);
+	void RemoveKeysEndingWith(LPCTSTR suffix);
+	void Flush();
+
+	long GetHits() { return m_Hits; }
+	long GetMisses() { return m_Misses; }
+	CString GetStatsText();
+
+protected:
+	CString GetCacheDir();
+	__int64 GetMaxBytes();
+	void Load();
+	void Save();
+	void SaveIfDue();
+	void Evict(__int64 maxBytes);
+	void Remove(CRevCacheEntry *entry);
+	void RemoveAll();
+	void SweepOrphans();
+	BOOL DigestOf(LPCTSTR fileName, int fileSysType, CString &digest);
+	CString GetTextTempName();
+};
+
+#endif //__P4REVCACHE__
@@ -0,0 +1,183 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4StartupLoader.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4StartupLoader.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+#define PHASE_WAITING	0
+#define PHASE_RUNNING	1
+#define PHASE_DONE		2
+#define PHASE_SKIPPED	3
+
+static const struct
+{
+	LPCTSTR name;
+	int		after;		// the phase this one waits for, -1 for none
+} Phases[STARTUP_PHASES] =
+{
+	{ _T("depot list"),			-1 },
+	{ _T("depot tree"),			STARTUP_DEPOTS },
+	{ _T("pending changes"),	STARTUP_DEPOTTREE },
+	{ NULL,						-1 },		// the right pane, named when started
+};
+
+
+CP4StartupLoader::CP4StartupLoader()
+{
+	m_Loading = FALSE;
+	m_Alongside = FALSE;
+	m_Cancel = 0;
+	m_Start = 0;
+	for (int i = 0; i < STARTUP_PHASES; i++)
+	{
+		m_Begun[i] = m_Done[i] = 0;
+		m_State[i] = PHASE_WAITING;
+	}
+}
+
+// Starts timing a new set of loads.  The phases that wait for nothing are
+// running from now; the right pane is skipped unless StartAlongside() is
+// called for it.  A right pane load still out from last time is for the
+// old connection, so it is cancelled.
+void CP4StartupLoader::Begin()
+{
+	if (m_Alongside)
+		InterlockedExchange(&m_Cancel, 1);
+	m_Loading = TRUE;
+	m_Start = GetTickCount();
+	for (int i = 0; i < STARTUP_PHASES; i++)
+	{
+		m_Begun[i] = m_Start;
+		m_Done[i] = 0;
+		m_State[i] = Phases[i].after == -1 ? PHASE_RUNNING : PHASE_WAITING;
+	}
+	m_State[STARTUP_RIGHTPANE] = PHASE_SKIPPED;
+}
+
+// Returns FALSE if the right pane can't be fetched alongside, because the
+// last one fetched that way hasn't come back yet.  Otherwise the caller
+// should start the load with GetCancelFlag(), and call Done() or Skip()
+// for STARTUP_RIGHTPANE when it is finished or couldn't start.
+BOOL CP4StartupLoader::StartAlongside(LPCTSTR paneName)
+{
+	if (m_Alongside || !m_Loading)
+		return FALSE;
+	m_Alongside = TRUE;
+	m_Cancel = 0;
+	m_RightPane = paneName;
+	m_State[STARTUP_RIGHTPANE] = PHASE_RUNNING;
+	m_Begun[STARTUP_RIGHTPANE] = GetTickCount();
+	return TRUE;
+}
+
+void CP4StartupLoader::Skip(int phase)
+{
+	if (phase == STARTUP_RIGHTPANE)
+		m_Alongside = FALSE;
+	if (m_Loading && m_State[phase] == PHASE_RUNNING)
+	{
+		m_State[phase] = PHASE_SKIPPED;
+		Done(phase);
+	}
+}
+
+// Marks a phase finished and starts the phases waiting for it.  Calls for
+// phases that aren't being timed are ignored, since the same code runs for
+// every refresh.
+void CP4StartupLoader::Done(int phase)
+{
+	if (phase == STARTUP_RIGHTPANE)
+		m_Alongside = FALSE;
+	if (!m_Loading || m_State[phase] == PHASE_DONE || m_State[phase] == PHASE_WAITING)
+		return;
+
+	DWORD now = GetTickCount();
+	if (m_State[phase] == PHASE_RUNNING)
+	{
+		m_State[phase] = PHASE_DONE;
+		m_Done[phase] = now;
+	}
+	for (int i = 0; i < STARTUP_PHASES; i++)
+	{
+		if (Phases[i].after == phase && m_State[i] == PHASE_WAITING)
+		{
+			m_State[i] = PHASE_RUNNING;
+			m_Begun[i] = now;
+		}
+	}
+	CheckFinished();
+}
+
+// Ends the phases through the server lock when one of them failed, since
+// the rest of that chain won't run.  A load running alongside carries on.
+void CP4StartupLoader::Fail()
+{
+	if (!m_Loading)
+		return;
+	for (int i = 0; i < STARTUP_PHASES; i++)
+	{
+		if (i != STARTUP_RIGHTPANE
+		 && (m_State[i] == PHASE_WAITING || m_State[i] == PHASE_RUNNING))
+			m_State[i] = PHASE_SKIPPED;
+	}
+	CheckFinished();
+}
+
+void CP4StartupLoader::CheckFinished()
+{
+	for (int i = 0; i < STARTUP_PHASES; i++)
+	{
+		if (m_State[i] == PHASE_WAITING || m_State[i] == PHASE_RUNNING)
+			return;
+	}
+	m_Loading = FALSE;
+	Report();
+}
+
+// Stops timing, and stops any load running alongside
+void CP4StartupLoader::Cancel()
+{
+	m_Loading = FALSE;
+	if (m_Alongside)
+		InterlockedExchange(&m_Cancel, 1);
+}
+
+BOOL CP4StartupLoader::IsPending(int phase)
+{
+	return m_Loading && (m_State[phase] == PHASE_WAITING || m_State[phase] == PHASE_RUNNING);
+}
+
+void CP4StartupLoader::Report()
+{
+	DWORD last = m_Start;
+	CString txt = _T("Startup load:");
+	for (int i = 0; i < STARTUP_PHASES; i++)
+	{
+		if (m_State[i] != PHASE_DONE)
+			continue;
+		CString phase;
+		phase.Format(_T(" %s %lu ms%s,"), i == STARTUP_RIGHTPANE ? LPCTSTR(m_RightPane) : Phases[i].name,
+			m_Done[i] - m_Begun[i], Phases[i].after == -1 && i != STARTUP_DEPOTS ? _T(" (alongside)") : _T(""));
+		txt += phase;
+		if (m_Done[i] - m_Start > last - m_Start)
+			last = m_Done[i];
+	}
+	CString total;
+	total.Format(_T(" ready after %lu ms"), last - m_Start);
+	txt += total;
+
+	XTRACE(_T("%s\n"), LPCTSTR(txt));
+	if ( GET_P4REGPTR()->ShowCommandTrace( ) )
+		TheApp()->StatusAdd(txt);
+}
@@ -0,0 +1,64 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4StartupLoader.h
+//
+// CP4StartupLoader keeps track of the loads that fill the panes at startup
+// and after a connection change, and how long each takes.  The phases and
+// what each has to wait for are in the table in P4StartupLoader.cpp: the
+// depot list, then the depot tree, then the pending changes all go through
+// the server lock one after another, but the right pane depends on none of
+// them, so it is fetched alongside on its own connection.  Panes that are
+// not showing are not loaded until they are shown.
+//
+// Each phase is timed from when what it waits for finished, and once all
+// are done the times, and the time until the window could be used, are
+// written to the status pane when command tracing is on.
+
+#ifndef __P4STARTUPLOADER__
+#define __P4STARTUPLOADER__
+
+enum StartupPhase
+{
+	STARTUP_DEPOTS,
+	STARTUP_DEPOTTREE,
+	STARTUP_CHANGES,
+	STARTUP_RIGHTPANE,
+	STARTUP_PHASES
+};
+
+class CP4StartupLoader
+{
+public:
+	CP4StartupLoader();
+
+protected:
+	BOOL	m_Loading;
+	DWORD	m_Start;
+	DWORD	m_Begun[STARTUP_PHASES];
+	DWORD	m_Done[STARTUP_PHASES];
+	BYTE	m_State[STARTUP_PHASES];
+	CString m_RightPane;			// the pane fetched alongside, for the report
+
+	volatile LONG m_Cancel;
+	BOOL	m_Alongside;			// a load on its own connection is still out
+
+public:
+	void Begin();
+	BOOL StartAlongside(LPCTSTR paneName);
+	void Skip(int phase);
+	void Done(int phase);
+	void Fail();
+	void Cancel();
+
+	BOOL IsPending(int phase);
+	volatile LONG *GetCancelFlag() { return &m_Cancel; }
+
+protected:
+	void CheckFinished();
+	void Report();
+};
+
+#endif //__P4STARTUPLOADER__
@@ -0,0 +1,114 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4StatusLog.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4StatusLog.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+CP4StatusLog::CP4StatusLog()
+{
+	for (LONG i = 0; i < STATUSLOGSIZE; i++)
+		m_Slots[i].m_Seq = i;
+	m_Head = m_Tail = 0;
+	m_Overflowed = FALSE;
+}
+
+CP4StatusLog::~CP4StatusLog()
+{
+	STATUSMSG msg;
+	while (Remove(msg))
+		delete [] msg.m_Text;
+}
+
+// May be called from any thread
+void CP4StatusLog::Add(LPCTSTR txt, StatusView level, bool showDialog)
+{
+	STATUSMSG msg;
+	msg.m_Text = new TCHAR[ lstrlen( txt ) + 1 ];
+	lstrcpy( msg.m_Text, txt );
+	msg.m_Level = level;
+	msg.m_ShowDialog = showDialog;
+
+	// Once anything has gone to the overflow list, everything else must go
+	// there too until the list is emptied, or a later message could be read
+	// before an earlier one
+	if (!m_Overflowed && Push(msg))
+		return;
+
+	m_Lock.Lock();
+	m_Overflow.AddTail(msg);
+	m_Overflowed = TRUE;
+	m_Lock.Unlock();
+}
+
+BOOL CP4StatusLog::Push(STATUSMSG &msg)
+{
+	LONG pos = m_Head;
+	STATUSSLOT *slot;
+	for (;;)
+	{
+		slot = &m_Slots[pos & (STATUSLOGSIZE - 1)];
+		LONG dif = slot->m_Seq - pos;
+		if (dif == 0)
+		{
+			// the slot is free - try to claim it
+			LONG was = InterlockedCompareExchange(&m_Head, pos + 1, pos);
+			if (was == pos)
+				break;
+			pos = was;
+		}
+		else if (dif < 0)
+			return FALSE;	// full: the reader hasn't got this far round yet
+		else
+			pos = m_Head;	// another thread claimed it first
+	}
+	slot->m_Msg = msg;
+	InterlockedExchange(&slot->m_Seq, pos + 1);
+	return TRUE;
+}
+
+// UI thread only
+BOOL CP4StatusLog::Pop(STATUSMSG &msg)
+{
+	STATUSSLOT *slot = &m_Slots[m_Tail & (STATUSLOGSIZE - 1)];
+	if (slot->m_Seq - (m_Tail + 1) < 0)
+		return FALSE;	// empty, or the writer hasn't finished with it
+	msg = slot->m_Msg;
+	InterlockedExchange(&slot->m_Seq, m_Tail + STATUSLOGSIZE);
+	m_Tail++;
+	return TRUE;
+}
+
+// UI thread only.  The caller must delete [] msg.m_Text.
+BOOL CP4StatusLog::Remove(STATUSMSG &msg)
+{
+	if (Pop(msg))
+		return TRUE;
+	if (!m_Overflowed)
+		return FALSE;
+
+	m_Lock.Lock();
+	BOOL b = !m_Overflow.IsEmpty();
+	if (b)
+		msg = m_Overflow.RemoveHead();
+	if (m_Overflow.IsEmpty())
+		m_Overflowed = FALSE;
+	m_Lock.Unlock();
+	return b;
+}
+
+BOOL CP4StatusLog::IsEmpty()
+{
+	return m_Slots[m_Tail & (STATUSLOGSIZE - 1)].m_Seq - (m_Tail + 1) < 0 && !m_Overflowed;
+}
@@ -0,0 +1,64 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4StatusLog.h
+//
+// CP4StatusLog is the queue between the threads that write status messages
+// and the status pane.  Any thread may add to it without taking a lock:
+// each writer claims a slot in a fixed ring with an interlocked compare and
+// exchange, fills it in, then publishes it by bumping the slot's sequence
+// number.  The UI thread is the only reader; the status pane empties the
+// queue on a timer and adds the whole batch to its list at once, rather
+// than handling a posted message for every line.  Should the ring fill up
+// before the UI gets to it, messages go to an overflow list under a lock
+// until the next time the queue is emptied, so nothing is lost and each
+// thread's messages stay in order.
+
+#ifndef __P4STATUSLOG__
+#define __P4STATUSLOG__
+
+#include <afxmt.h>
+
+#define STATUSLOGSIZE	8192		// must be a power of 2
+
+struct STATUSMSG
+{
+	LPTSTR	m_Text;					// allocated by Add(), freed by the reader
+	StatusView m_Level;
+	bool	m_ShowDialog;
+};
+
+class CP4StatusLog
+{
+public:
+	CP4StatusLog();
+	~CP4StatusLog();
+
+protected:
+	struct STATUSSLOT
+	{
+		volatile LONG m_Seq;		// == position when free, position+1 when filled
+		STATUSMSG m_Msg;
+	};
+
+	STATUSSLOT m_Slots[STATUSLOGSIZE];
+	volatile LONG m_Head;			// next position to claim
+	LONG	m_Tail;					// next position to read, UI thread only
+
+	CCriticalSection m_Lock;		// for the overflow list only
+	volatile LONG m_Overflowed;
+	CList<STATUSMSG, STATUSMSG&> m_Overflow;
+
+public:
+	void Add(LPCTSTR txt, StatusView level, bool showDialog);
+	BOOL Remove(STATUSMSG &msg);
+	BOOL IsEmpty();
+
+protected:
+	BOOL Push(STATUSMSG &msg);
+	BOOL Pop(STATUSMSG &msg);
+};
+
+#endif //__P4STATUSLOG__
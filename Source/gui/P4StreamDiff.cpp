@@ -0,0 +1,452 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4StreamDiff.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "MainFrm.h"
+#include "P4StreamDiff.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+#define WINDOWLINES		100000		// most lines compared at once, per file
+#define OUTPUTFLUSH		(1024*1024)	// bytes of output held before writing
+#define CANCELCHECKLINES	0xFFFF	// common lines skipped between cancel checks
+
+volatile LONG CP4StreamDiff::s_Running = 0;
+volatile LONG CP4StreamDiff::s_Cancel = 0;
+
+CP4StreamDiff::CP4StreamDiff()
+{
+	for (int side = 0; side < 2; side++)
+	{
+		STREAMFILE &f = m_File[side];
+		f.m_hFile = INVALID_HANDLE_VALUE;
+		f.m_hMap = NULL;
+		f.m_Size = f.m_ViewStart = f.m_Pos = 0;
+		f.m_ViewSize = 0;
+		f.m_View = NULL;
+		f.m_LineNo = 0;
+	}
+	m_hOut = INVALID_HANDLE_VALUE;
+	m_Hunks = 0;
+	m_Percent = -1;
+	m_Cancelled = FALSE;
+
+	// The memory cap for quick diffs is shared between the two windows and
+	// the views they are taken from
+	m_WindowBytes = max(256 * 1024, GET_P4REGPTR()->GetQuickDiffMaxSize() * 1024 * 1024 / 8);
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	m_ViewBytes = 2 * m_WindowBytes + si.dwAllocationGranularity;
+}
+
+CP4StreamDiff::~CP4StreamDiff()
+{
+	Close();
+}
+
+void CP4StreamDiff::Close()
+{
+	for (int side = 0; side < 2; side++)
+	{
+		STREAMFILE &f = m_File[side];
+		if (f.m_View)
+			UnmapViewOfFile(f.m_View);
+		if (f.m_hMap)
+			CloseHandle(f.m_hMap);
+		if (f.m_hFile != INVALID_HANDLE_VALUE)
+			CloseHandle(f.m_hFile);
+		f.m_View = NULL;
+		f.m_hMap = NULL;
+		f.m_hFile = INVALID_HANDLE_VALUE;
+	}
+	if (m_hOut != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hOut);
+		m_hOut = INVALID_HANDLE_VALUE;
+	}
+}
+
+// Returns TRUE if either file is at least StreamDiffMinSize MB
+BOOL CP4StreamDiff::IsLarge(LPCTSTR fileName1, LPCTSTR fileName2)
+{
+	__int64 minSize = (__int64)GET_P4REGPTR()->GetStreamDiffMinSize() * 1024 * 1024;
+	if (!minSize)
+		return FALSE;
+
+	LPCTSTR names[2] = { fileName1, fileName2 };
+	for (int i = 0; i < 2; i++)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA fad;
+		if (GetFileAttributesEx(names[i], GetFileExInfoStandard, &fad)
+		 && (((__int64) fad.nFileSizeHigh << 32) | fad.nFileSizeLow) >= minSize)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+// Diffs two large text files and shows the result: in a describe window
+// if it is of a size that quick diffs handle, otherwise left in a temp
+// file whose name goes to the status pane.  Progress is shown on the
+// status bar.  Returns FALSE if the files could not be read or the output
+// written, so the caller can fall back on the external diff program; a
+// cancelled diff counts as handled.
+BOOL CP4StreamDiff::StreamDiff(LPCTSTR fileName1, LPCTSTR fileName2,
+							   LPCTSTR label1, LPCTSTR label2, int flags)
+{
+	CString outName;
+	CString dir = GET_P4REGPTR()->GetTempDir();
+	dir.TrimRight(_T('\\'));
+	outName.Format(_T("%s\\P4WinDiff-%lx-%lx.txt"), dir, GetCurrentThreadId(), GetTickCount());
+
+	// The first diff to start clears any cancel left from earlier ones
+	if (InterlockedIncrement(&s_Running) == 1)
+		InterlockedExchange(&s_Cancel, 0);
+
+	CString errorText;
+	CString txt;
+	CP4StreamDiff diff;
+	diff.SetFlags(flags);
+	BOOL b = diff.Open(fileName1, fileName2, outName, errorText)
+		  && diff.Run(label1, label2, errorText);
+	diff.Close();
+	InterlockedDecrement(&s_Running);
+	::PostMessage(MainFrame()->m_hWnd, WM_DIFFPROGRESS, (WPARAM) -1, 0);
+
+	if (!b)
+	{
+		TheApp()->StatusAdd(errorText, diff.m_Cancelled ? SV_WARNING : SV_ERROR);
+		DeleteFile(outName);
+		return diff.m_Cancelled;
+	}
+	if (!diff.GetHunkCount())
+	{
+		txt.FormatMessage(IDS_NO_DIFFERENCES_s_s, label1, label2);
+		TheApp()->StatusAdd(txt);
+		DeleteFile(outName);
+		return TRUE;
+	}
+
+	// Small enough to show?
+	HANDLE hFile;
+	__int64 maxBytes = (__int64)GET_P4REGPTR()->GetQuickDiffMaxSize() * 1024 * 1024;
+	LARGE_INTEGER size;
+	if ((hFile = CreateFile(outName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+				FILE_FLAG_SEQUENTIAL_SCAN, 0)) != INVALID_HANDLE_VALUE)
+	{
+		if (GetFileSizeEx(hFile, &size) && size.QuadPart <= maxBytes)
+		{
+			CStringA out;
+			DWORD NumberOfBytesRead = 0;
+			char *p = out.GetBuffer((int) size.QuadPart);
+			b = ReadFile(hFile, p, (DWORD) size.QuadPart, &NumberOfBytesRead, NULL);
+			out.ReleaseBuffer(b ? NumberOfBytesRead : 0);
+			CloseHandle(hFile);
+			if (b)
+			{
+				DeleteFile(outName);
+
+				// MainFrame owns the array from here on
+				CStringArray *pArgs = new CStringArray;
+				txt.Format(_T("%s <> %s"), label1, label2);
+				pArgs->Add(txt);
+				pArgs->Add(CharToCString(out));
+				pArgs->Add(label2);
+				::PostMessage(MainFrame()->m_hWnd, WM_SHOWQUICKDIFF, 0, (LPARAM)pArgs);
+				return TRUE;
+			}
+		}
+		else
+			CloseHandle(hFile);
+	}
+
+	txt.FormatMessage(IDS_n_DIFFERENCES_s_s_ARE_IN_s,
+		diff.GetHunkCount(), label1, label2, (LPCTSTR) outName);
+	TheApp()->StatusAdd(txt, SV_COMPLETION);
+	return TRUE;
+}
+
+BOOL CP4StreamDiff::Open(LPCTSTR fileName1, LPCTSTR fileName2, LPCTSTR outName, CString &errorText)
+{
+	if (!OpenFile(0, fileName1, errorText) || !OpenFile(1, fileName2, errorText))
+		return FALSE;
+
+	m_OutName = outName;
+	if ((m_hOut = CreateFile(outName, GENERIC_WRITE, 0, 0, CREATE_ALWAYS,
+				FILE_ATTRIBUTE_TEMPORARY, 0)) == INVALID_HANDLE_VALUE)
+	{
+		errorText.FormatMessage(IDS_UNABLE_TO_CREATE_s, outName);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+BOOL CP4StreamDiff::OpenFile(int side, LPCTSTR fileName, CString &errorText)
+{
+	STREAMFILE &f = m_File[side];
+	LARGE_INTEGER size;
+	if ((f.m_hFile = CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+				FILE_FLAG_SEQUENTIAL_SCAN, 0)) == INVALID_HANDLE_VALUE
+	 || !GetFileSizeEx(f.m_hFile, &size))
+	{
+		errorText.FormatMessage(IDS_UNABLE_TO_OPEN_s, fileName);
+		return FALSE;
+	}
+	f.m_Size = size.QuadPart;
+
+	// An empty file can't be mapped, and needn't be
+	if (f.m_Size && (f.m_hMap = CreateFileMapping(f.m_hFile, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL)
+	{
+		errorText.FormatMessage(IDS_UNABLE_TO_MAP_s, fileName);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Makes sure the view covers a full window from the current position
+BOOL CP4StreamDiff::MapView(int side, CString &errorText)
+{
+	STREAMFILE &f = m_File[side];
+	__int64 viewEnd = f.m_ViewStart + f.m_ViewSize;
+	if (!f.m_Size || (f.m_View && f.m_Pos >= f.m_ViewStart
+	 && (viewEnd == f.m_Size || f.m_Pos + m_WindowBytes <= viewEnd)))
+		return TRUE;
+
+	if (f.m_View)
+		UnmapViewOfFile(f.m_View);
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	f.m_ViewStart = f.m_Pos - f.m_Pos % si.dwAllocationGranularity;
+	f.m_ViewSize = (DWORD) min((__int64) m_ViewBytes, f.m_Size - f.m_ViewStart);
+	f.m_View = (const char *) MapViewOfFile(f.m_hMap, FILE_MAP_READ,
+			(DWORD)(f.m_ViewStart >> 32), (DWORD)(f.m_ViewStart & 0xFFFFFFFF), f.m_ViewSize);
+	if (!f.m_View)
+	{
+		errorText = LoadStringResource(IDS_UNABLE_TO_MAP_DIFF_VIEW);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Finds the line at pos, which must be in the view.  Returns the number of
+// bytes it takes up, newline included.  A line too long for the view is
+// cut at the end of it.
+int CP4StreamDiff::NextLine(int side, __int64 pos, const char *&text, int &len)
+{
+	STREAMFILE &f = m_File[side];
+	text = f.m_View + (pos - f.m_ViewStart);
+	int avail = (int)(f.m_ViewStart + f.m_ViewSize - pos);
+	const char *nl = (const char *) memchr(text, '\n', avail);
+	len = nl ? (int)(nl - text) : avail;
+	return nl ? len + 1 : len;
+}
+
+// Takes as many lines from the current position as fit in a window.
+// Returns the offset just past them.
+__int64 CP4StreamDiff::CollectWindow(int side, int &lines)
+{
+	STREAMFILE &f = m_File[side];
+	__int64 pos = f.m_Pos;
+	__int64 limit = min(f.m_Size, f.m_Pos + m_WindowBytes);
+	const char *text;
+	int len;
+
+	lines = 0;
+	while (pos < f.m_Size && lines < WINDOWLINES)
+	{
+		int bytes = NextLine(side, pos, text, len);
+		if (lines && pos + bytes > limit)
+			break;
+		pos += bytes;
+		lines++;
+	}
+	return pos;
+}
+
+BOOL CP4StreamDiff::Run(LPCTSTR label1, LPCTSTR label2, CString &errorText)
+{
+	CStringA hdr;
+	hdr.Format("==== %s - %s ====\n", (const char *) CharFromCString(label1),
+									 (const char *) CharFromCString(label2));
+	m_Out = hdr;
+
+	const char *a, *b;
+	int alen, blen;
+	for (;;)
+	{
+		if (!CheckCancel(errorText))
+			return FALSE;
+
+		// Skip the lines the files have in common
+		int skipped = 0;
+		while (!AtEnd(0) && !AtEnd(1))
+		{
+			if (!(++skipped & CANCELCHECKLINES))
+			{
+				if (!CheckCancel(errorText))
+					return FALSE;
+				Progress();
+			}
+			if (!MapView(0, errorText) || !MapView(1, errorText))
+				return FALSE;
+			int len0 = NextLine(0, m_File[0].m_Pos, a, alen);
+			int len1 = NextLine(1, m_File[1].m_Pos, b, blen);
+			if (!m_Diff.LinesMatch(a, alen, b, blen))
+				break;
+			m_File[0].m_Pos += len0;
+			m_File[1].m_Pos += len1;
+			m_File[0].m_LineNo++;
+			m_File[1].m_LineNo++;
+		}
+		if (AtEnd(0) && AtEnd(1))
+			break;
+		if (!MapView(0, errorText) || !MapView(1, errorText))
+			return FALSE;
+
+		// Compare a window of lines from each
+		int n[2];
+		BOOL eof[2];
+		int side;
+		for (side = 0; side < 2; side++)
+		{
+			STREAMFILE &f = m_File[side];
+			__int64 end = CollectWindow(side, n[side]);
+			eof[side] = end >= f.m_Size;
+			m_Diff.SetText(side, f.m_Size ? f.m_View + (f.m_Pos - f.m_ViewStart) : "",
+						   (int)(end - f.m_Pos));
+		}
+		int count = m_Diff.Compare();
+		ASSERT(count > 0);
+
+		// Write out the hunks that are clear of the end of the window, but
+		// at least one, so as to make progress.  Near the end of a window
+		// the comparison hasn't seen enough to be trusted.
+		int lim0 = eof[0] ? n[0] : n[0] - n[0] / 4;
+		int lim1 = eof[1] ? n[1] : n[1] - n[1] / 4;
+		int last = 0;
+		for (int h = 1; h < count; h++)
+		{
+			const DIFFHUNK &hunk = m_Diff.GetHunk(h);
+			if (hunk.m_Start1 + hunk.m_Count1 > lim0 || hunk.m_Start2 + hunk.m_Count2 > lim1)
+				break;
+			last = h;
+		}
+		for (int h = 0; h <= last; h++)
+			EmitHunk(m_Diff.GetHunk(h));
+
+		// and start the next window after the last of them
+		const DIFFHUNK &hunk = m_Diff.GetHunk(last);
+		int cut[2] = { hunk.m_Start1 + hunk.m_Count1, hunk.m_Start2 + hunk.m_Count2 };
+		for (side = 0; side < 2; side++)
+		{
+			if (!cut[side])
+				continue;
+			const char *first, *text;
+			int len;
+			m_Diff.GetLineText(side, 0, first, len);
+			m_Diff.GetLineText(side, cut[side] - 1, text, len);
+			m_File[side].m_Pos += (text + len) - first;
+			m_File[side].m_LineNo += cut[side];
+		}
+
+		if (!Flush(FALSE))
+		{
+			errorText.FormatMessage(IDS_UNABLE_TO_WRITE_s, (LPCTSTR) m_OutName);
+			return FALSE;
+		}
+		Progress();
+	}
+
+	if (!Flush(TRUE))
+	{
+		errorText.FormatMessage(IDS_UNABLE_TO_WRITE_s, (LPCTSTR) m_OutName);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Writes a hunk as "p4 diff" does, e.g. "12,14c12,15", then the lines
+void CP4StreamDiff::EmitHunk(const DIFFHUNK &hunk)
+{
+	int s1 = m_File[0].m_LineNo + hunk.m_Start1;
+	int s2 = m_File[1].m_LineNo + hunk.m_Start2;
+	char type = !hunk.m_Count1 ? 'a' : !hunk.m_Count2 ? 'd' : 'c';
+
+	CStringA range1, range2;
+	if (hunk.m_Count1 > 1)
+		range1.Format("%d,%d", s1 + 1, s1 + hunk.m_Count1);
+	else
+		range1.Format("%d", hunk.m_Count1 ? s1 + 1 : s1);
+	if (hunk.m_Count2 > 1)
+		range2.Format("%d,%d", s2 + 1, s2 + hunk.m_Count2);
+	else
+		range2.Format("%d", hunk.m_Count2 ? s2 + 1 : s2);
+	m_Out += range1;
+	m_Out += type;
+	m_Out += range2;
+	m_Out += '\n';
+
+	AppendLines('<', 0, hunk.m_Start1, hunk.m_Count1);
+	if (type == 'c')
+		m_Out += "---\n";
+	AppendLines('>', 1, hunk.m_Start2, hunk.m_Count2);
+	m_Hunks++;
+}
+
+void CP4StreamDiff::AppendLines(char prefix, int side, int start, int count)
+{
+	for (int i = start; i < start + count; i++)
+	{
+		const char *text;
+		int len;
+		m_Diff.GetLineText(side, i, text, len);
+		while (len && (text[len - 1] == '\n' || text[len - 1] == '\r'))
+			len--;
+		m_Out += prefix;
+		m_Out += ' ';
+		m_Out.Append(text, len);
+		m_Out += '\n';
+	}
+}
+
+BOOL CP4StreamDiff::Flush(BOOL force)
+{
+	if (!force && m_Out.GetLength() < OUTPUTFLUSH)
+		return TRUE;
+
+	DWORD NumberOfBytesWritten = 0;
+	BOOL b = !m_Out.GetLength()
+		  || (WriteFile(m_hOut, (LPCSTR) m_Out, m_Out.GetLength(), &NumberOfBytesWritten, NULL)
+		   && NumberOfBytesWritten == (DWORD) m_Out.GetLength());
+	m_Out.Empty();
+	return b;
+}
+
+void CP4StreamDiff::Progress()
+{
+	__int64 total = m_File[0].m_Size + m_File[1].m_Size;
+	int percent = total ? (int)((m_File[0].m_Pos + m_File[1].m_Pos) * 100 / total) : 100;
+	if (percent != m_Percent)
+	{
+		m_Percent = percent;
+		::PostMessage(MainFrame()->m_hWnd, WM_DIFFPROGRESS, (WPARAM) percent, 0);
+	}
+}
+
+// Returns FALSE once the Cancel button has been pressed, or P4Win is closing
+BOOL CP4StreamDiff::CheckCancel(CString &errorText)
+{
+	if (!s_Cancel && !APP_ABORTING())
+		return TRUE;
+	m_Cancelled = TRUE;
+	errorText = LoadStringResource(IDS_DIFF_CANCELED);
+	return FALSE;
+}
@@ -0,0 +1,83 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4StreamDiff.h
+//
+// CP4StreamDiff compares text files too large to hold in memory.  Both
+// files are read through sliding memory-mapped views, lines in common are
+// skipped as they are read, and where the files differ a bounded window
+// of lines from each is handed to CP4DiffEngine.  Hunks well inside the
+// window are written out, and the next window starts after the last of
+// them, so the output is produced as the files are read and memory use
+// depends only on the window size.  Output is in the "p4 diff" normal
+// format, written to a temp file.  The comparison runs without the server
+// lock, so the Cancel button stops it through Cancel() rather than
+// global_cancel.
+
+#ifndef __P4STREAMDIFF__
+#define __P4STREAMDIFF__
+
+#include "P4DiffEngine.h"
+
+class CP4StreamDiff
+{
+public:
+	CP4StreamDiff();
+	~CP4StreamDiff();
+
+protected:
+	struct STREAMFILE
+	{
+		HANDLE m_hFile;
+		HANDLE m_hMap;
+		__int64 m_Size;
+		__int64 m_ViewStart;
+		DWORD m_ViewSize;
+		const char *m_View;
+		__int64 m_Pos;			// offset of the first line not yet dealt with
+		int m_LineNo;			// and its line number, 0-based
+	};
+
+	STREAMFILE m_File[2];
+	CP4DiffEngine m_Diff;
+	DWORD m_WindowBytes;
+	DWORD m_ViewBytes;
+	CStringA m_Out;
+	HANDLE m_hOut;
+	CString m_OutName;
+	int m_Hunks;
+	int m_Percent;
+	BOOL m_Cancelled;
+
+	static volatile LONG s_Running;		// diffs in progress
+	static volatile LONG s_Cancel;		// set to stop them
+
+public:
+	static BOOL IsLarge(LPCTSTR fileName1, LPCTSTR fileName2);
+	static BOOL StreamDiff(LPCTSTR fileName1, LPCTSTR fileName2,
+						   LPCTSTR label1, LPCTSTR label2, int flags);
+	static BOOL IsRunning() { return s_Running > 0; }
+	static void Cancel() { InterlockedExchange(&s_Cancel, 1); }
+
+	void SetFlags(int flags) { m_Diff.SetFlags(flags); }
+	BOOL Open(LPCTSTR fileName1, LPCTSTR fileName2, LPCTSTR outName, CString &errorText);
+	BOOL Run(LPCTSTR label1, LPCTSTR label2, CString &errorText);
+	int GetHunkCount() { return m_Hunks; }
+
+protected:
+	void Close();
+	BOOL OpenFile(int side, LPCTSTR fileName, CString &errorText);
+	BOOL MapView(int side, CString &errorText);
+	BOOL AtEnd(int side) { return m_File[side].m_Pos >= m_File[side].m_Size; }
+	int  NextLine(int side, __int64 pos, const char *&text, int &len);
+	__int64 CollectWindow(int side, int &lines);
+	void EmitHunk(const DIFFHUNK &hunk);
+	void AppendLines(char prefix, int side, int start, int count);
+	BOOL Flush(BOOL force);
+	void Progress();
+	BOOL CheckCancel(CString &errorText);
+};
+
+#endif //__P4STREAMDIFF__
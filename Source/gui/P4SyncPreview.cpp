@@ -0,0 +1,69 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4SyncPreview.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4FileStats.h"
+#include "P4SyncPreview.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+CP4SyncPreview::CP4SyncPreview()
+{
+	m_MaxAge = (DWORD) GET_P4REGPTR()->GetSyncPreviewMaxAge() * 1000;
+	m_AddCount = m_UpToDate = 0;
+}
+
+// Returns TRUE if the file's part of the preview is known from its stats,
+// FALSE if it has to go to the server
+BOOL CP4SyncPreview::Preview(CP4FileStats *stats)
+{
+	if (!m_MaxAge || !stats || !stats->GetStatTime()
+	 || GetTickCount() - stats->GetStatTime() > m_MaxAge)
+		return FALSE;
+	if (stats->IsNotInDepot() || !stats->InClientView() || stats->IsMyOpen()
+	 || stats->GetHeadRev() <= 0)
+		return FALSE;
+
+	long head = stats->GetHeadRev();
+	long have = stats->GetHaveRev();
+	BOOL deleted = stats->GetHeadAction() == F_DELETE || stats->GetHeadAction() == F_MODEDELETE;
+
+	CString line;
+	if (deleted)
+	{
+		if (have <= 0)
+		{
+			m_UpToDate++;
+			return TRUE;
+		}
+		line.Format(_T("%s#%ld - deleted as %s"), stats->GetFullDepotPath(), head,
+			stats->GetFullClientPath());
+		m_RemoveList.AddHead(line);
+	}
+	else if (have == head)
+		m_UpToDate++;
+	else if (have <= 0)
+	{
+		line.Format(_T("%s#%ld - added as %s"), stats->GetFullDepotPath(), head,
+			stats->GetFullClientPath());
+		m_GetList.AddHead(line);
+		m_AddCount++;
+	}
+	else
+	{
+		line.Format(_T("%s#%ld - updating %s"), stats->GetFullDepotPath(), head,
+			stats->GetFullClientPath());
+		m_GetList.AddHead(line);
+	}
+	return TRUE;
+}
@@ -0,0 +1,42 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4SyncPreview.h
+//
+// CP4SyncPreview answers a sync preview (sync -n to the head revision) for
+// the files whose have and head revisions the depot pane already holds,
+// so they need not go to the server.  Only files whose stats came from an
+// fstat within the last SyncPreviewMaxAge seconds are answered; opened
+// files, files outside the view and files with older or unknown stats are
+// left for the server, since the pane can't be sure what it would do.
+
+#ifndef __P4SYNCPREVIEW__
+#define __P4SYNCPREVIEW__
+
+class CP4FileStats;
+
+class CP4SyncPreview
+{
+public:
+	CP4SyncPreview();
+
+protected:
+	DWORD	m_MaxAge;			// ms; 0 to send everything to the server
+	CStringList m_GetList;		// in the form CCmd_Get puts them in its lists
+	CStringList m_RemoveList;
+	int		m_AddCount;
+	int		m_UpToDate;
+
+public:
+	BOOL Preview(CP4FileStats *stats);
+
+	CStringList *GetGetList() { return &m_GetList; }
+	CStringList *GetRemoveList() { return &m_RemoveList; }
+	int GetAddCount() const { return m_AddCount; }
+	int GetUpToDate() const { return m_UpToDate; }
+	int GetCount() const { return (int) (m_GetList.GetCount() + m_RemoveList.GetCount()) + m_UpToDate; }
+};
+
+#endif //__P4SYNCPREVIEW__
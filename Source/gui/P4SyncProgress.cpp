@@ -0,0 +1,166 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4SyncProgress.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "MainFrm.h"
+#include "P4SyncProgress.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+#define PUBLISHINTERVAL	500		// ms between status bar updates
+
+
+CP4SyncProgress::CP4SyncProgress()
+{
+	Start(1);
+}
+
+void CP4SyncProgress::Start(int workers, int serverThreads)
+{
+	m_Lock.Lock();
+	m_StartTicks = GetTickCount();
+	m_LastPublish = 0;
+	m_Files = m_TotalFiles = 0;
+	m_Bytes = m_TotalBytes = 0;
+	m_Workers = max(1, min(workers, MAXSYNCWORKERS));
+	m_ServerThreads = serverThreads;
+	memset(m_Worker, 0, sizeof(m_Worker));
+	m_Lock.Unlock();
+}
+
+// The server gives the totals for each sync command it runs
+void CP4SyncProgress::AddTotals(int files, __int64 bytes)
+{
+	m_Lock.Lock();
+	m_TotalFiles += files;
+	m_TotalBytes += bytes;
+	m_Lock.Unlock();
+}
+
+void CP4SyncProgress::FileDone(int worker, __int64 bytes)
+{
+	ASSERT(worker >= 0 && worker < m_Workers);
+	m_Lock.Lock();
+	m_Files++;
+	m_Worker[worker].m_Files++;
+	if (bytes > 0)
+	{
+		m_Bytes += bytes;
+		m_Worker[worker].m_Bytes += bytes;
+	}
+	m_Lock.Unlock();
+}
+
+void CP4SyncProgress::WorkerDone(int worker)
+{
+	m_Lock.Lock();
+	m_Worker[worker].m_Ticks = GetTickCount() - m_StartTicks;
+	m_Worker[worker].m_Done = TRUE;
+	m_Lock.Unlock();
+}
+
+// Posts the progress to the status bar, but not more often than every
+// PUBLISHINTERVAL ms
+void CP4SyncProgress::Publish(BOOL force)
+{
+	DWORD now = GetTickCount();
+	m_Lock.Lock();
+	BOOL b = force || now - m_LastPublish >= PUBLISHINTERVAL;
+	if (b)
+		m_LastPublish = now;
+	m_Lock.Unlock();
+	if (b)
+		::PostMessage(MainFrame()->m_hWnd, WM_SYNCPROGRESS, 0, (LPARAM) new CString(GetProgressText()));
+}
+
+void CP4SyncProgress::Clear()
+{
+	::PostMessage(MainFrame()->m_hWnd, WM_SYNCPROGRESS, 0, (LPARAM) new CString);
+}
+
+CString CP4SyncProgress::FormatBytes(__int64 bytes)
+{
+	CString txt;
+	if (bytes < 1024 * 1024)
+		txt.Format(_T("%.1f KB"), bytes / 1024.0);
+	else if (bytes < (__int64) 1024 * 1024 * 1024)
+		txt.Format(_T("%.1f MB"), bytes / (1024.0 * 1024.0));
+	else
+		txt.Format(_T("%.2f GB"), bytes / (1024.0 * 1024.0 * 1024.0));
+	return txt;
+}
+
+// e.g. "Syncing 1200 of 5000 files, 40.5 MB of 210.0 MB - 150 files/s, 5.1 MB/s, 33 s left"
+CString CP4SyncProgress::GetProgressText()
+{
+	m_Lock.Lock();
+	double secs = max(1, GetTickCount() - m_StartTicks) / 1000.0;
+	double fileRate = m_Files / secs;
+	double byteRate = m_Bytes / secs;
+
+	CString txt, str;
+	if (m_TotalFiles && m_TotalFiles >= m_Files)
+		txt.Format(_T("Syncing %d of %d files"), m_Files, m_TotalFiles);
+	else
+		txt.Format(_T("Syncing %d files"), m_Files);
+	if (m_TotalBytes && m_TotalBytes >= m_Bytes)
+		str.Format(_T(", %s of %s"), FormatBytes(m_Bytes), FormatBytes(m_TotalBytes));
+	else
+		str.Format(_T(", %s"), FormatBytes(m_Bytes));
+	txt += str;
+	str.Format(_T(" - %.0f files/s, %s/s"), fileRate, FormatBytes((__int64) byteRate));
+	txt += str;
+
+	// Go by bytes if we can: file sizes vary too much for the count to say
+	// much about the time left
+	int left = -1;
+	if (m_TotalBytes > m_Bytes && byteRate > 0)
+		left = (int)((m_TotalBytes - m_Bytes) / byteRate);
+	else if (m_TotalFiles > m_Files && fileRate > 0)
+		left = (int)((m_TotalFiles - m_Files) / fileRate);
+	if (left >= 0)
+	{
+		str.Format(_T(", %d s left"), left);
+		txt += str;
+	}
+	m_Lock.Unlock();
+	return txt;
+}
+
+CString CP4SyncProgress::GetSummary()
+{
+	m_Lock.Lock();
+	double secs = max(1, GetTickCount() - m_StartTicks) / 1000.0;
+	CString txt;
+	txt.Format(_T("Synced %d files, %s in %.1f s (%.0f files/s, %s/s)"), m_Files, FormatBytes(m_Bytes),
+		secs, m_Files / secs, FormatBytes((__int64)(m_Bytes / secs)));
+	if (m_ServerThreads > 1)
+	{
+		CString str;
+		str.Format(_T(", %d transfer threads per connection"), m_ServerThreads);
+		txt += str;
+	}
+	m_Lock.Unlock();
+	return txt;
+}
+
+CString CP4SyncProgress::GetWorkerSummary(int worker)
+{
+	m_Lock.Lock();
+	SYNCWORKER &w = m_Worker[worker];
+	double secs = max(1, w.m_Done ? w.m_Ticks : GetTickCount() - m_StartTicks) / 1000.0;
+	CString txt;
+	txt.Format(_T("Connection %d: %d files, %s in %.1f s (%s/s)"), worker + 1, w.m_Files,
+		FormatBytes(w.m_Bytes), secs, FormatBytes((__int64)(w.m_Bytes / secs)));
+	m_Lock.Unlock();
+	return txt;
+}
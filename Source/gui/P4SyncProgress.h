@@ -0,0 +1,64 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4SyncProgress.h
+//
+// CP4SyncProgress keeps the running totals for a sync: files and bytes
+// transferred, overall and for each connection doing the transferring,
+// and the totals the server said to expect.  From these it works out the
+// file and byte rates and the time left, which it posts to the status bar
+// every so often in place of a status pane line for every file.  It may
+// be updated from several threads at once.
+
+#ifndef __P4SYNCPROGRESS__
+#define __P4SYNCPROGRESS__
+
+#include <afxmt.h>
+
+#define MAXSYNCWORKERS	16
+
+class CP4SyncProgress
+{
+public:
+	CP4SyncProgress();
+
+protected:
+	struct SYNCWORKER
+	{
+		int		m_Files;
+		__int64 m_Bytes;
+		DWORD	m_Ticks;			// time spent, once finished
+		BOOL	m_Done;
+	};
+
+	CCriticalSection m_Lock;
+	DWORD	m_StartTicks;
+	DWORD	m_LastPublish;
+	int		m_Files;
+	__int64 m_Bytes;
+	int		m_TotalFiles;			// 0 if the server didn't say
+	__int64 m_TotalBytes;
+	int		m_Workers;
+	int		m_ServerThreads;		// for transfers in parallel, per connection
+	SYNCWORKER m_Worker[MAXSYNCWORKERS];
+
+public:
+	void Start(int workers, int serverThreads = 0);
+	void AddTotals(int files, __int64 bytes);
+	void FileDone(int worker, __int64 bytes);
+	void WorkerDone(int worker);
+	void Publish(BOOL force = FALSE);
+	void Clear();
+
+	int  GetFiles() { return m_Files; }
+	__int64 GetBytes() { return m_Bytes; }
+	CString GetProgressText();
+	CString GetSummary();
+	CString GetWorkerSummary(int worker);
+
+	static CString FormatBytes(__int64 bytes);
+};
+
+#endif //__P4SYNCPROGRESS__
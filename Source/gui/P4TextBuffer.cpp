@@ -0,0 +1,74 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4TextBuffer.cpp
+
+#include "stdafx.h"
+#include "P4Win.h"
+#include "P4TextBuffer.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+CP4TextBuffer::CP4TextBuffer()
+{
+	m_LastUsed = TEXTCHUNKSIZE;
+	m_Length = 0;
+}
+
+CP4TextBuffer::~CP4TextBuffer()
+{
+	Empty();
+}
+
+void CP4TextBuffer::Append(LPCTSTR txt, int len)
+{
+	m_Length += len;
+	while (len > 0)
+	{
+		if (m_LastUsed == TEXTCHUNKSIZE)
+		{
+			m_Chunks.Add(new TCHAR[TEXTCHUNKSIZE]);
+			m_LastUsed = 0;
+		}
+		int n = min(len, TEXTCHUNKSIZE - m_LastUsed);
+		LPTSTR chunk = (LPTSTR) m_Chunks.GetAt(m_Chunks.GetUpperBound());
+		memcpy(chunk + m_LastUsed, txt, n * sizeof(TCHAR));
+		m_LastUsed += n;
+		txt += n;
+		len -= n;
+	}
+}
+
+// Adds the whole text to the end of str
+void CP4TextBuffer::AppendTo(CString &str)
+{
+	if (!m_Length)
+		return;
+
+	int had = str.GetLength();
+	LPTSTR p = str.GetBuffer(had + m_Length) + had;
+	int last = (int) m_Chunks.GetUpperBound();
+	for (int i = 0; i <= last; i++)
+	{
+		int n = i == last ? m_LastUsed : TEXTCHUNKSIZE;
+		memcpy(p, m_Chunks.GetAt(i), n * sizeof(TCHAR));
+		p += n;
+	}
+	str.ReleaseBuffer(had + m_Length);
+}
+
+void CP4TextBuffer::Empty()
+{
+	for (int i = 0; i < m_Chunks.GetSize(); i++)
+		delete [] (LPTSTR) m_Chunks.GetAt(i);
+	m_Chunks.RemoveAll();
+	m_LastUsed = TEXTCHUNKSIZE;
+	m_Length = 0;
+}
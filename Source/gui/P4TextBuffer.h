@@ -0,0 +1,40 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// P4TextBuffer.h
+//
+// CP4TextBuffer collects command output a line at a time in fixed size
+// chunks.  Appending never moves what is already there, so building up a
+// large describe costs one copy of each line rather than a reallocation
+// and copy of everything so far each time the string outgrows its buffer.
+// AppendTo() joins the chunks onto a CString with a single allocation.
+
+#ifndef __P4TEXTBUFFER__
+#define __P4TEXTBUFFER__
+
+#define TEXTCHUNKSIZE	65536	// TCHARs per chunk
+
+class CP4TextBuffer
+{
+public:
+	CP4TextBuffer();
+	~CP4TextBuffer();
+
+protected:
+	CPtrArray m_Chunks;			// all full but the last
+	int		m_LastUsed;			// TCHARs used in the last chunk
+	int		m_Length;
+
+public:
+	void Append(LPCTSTR txt, int len);
+	void Append(LPCTSTR txt) { Append(txt, lstrlen(txt)); }
+	void AppendTo(CString &str);
+	void Empty();
+
+	int  GetLength() { return m_Length; }
+	BOOL IsEmpty() { return m_Length == 0; }
+};
+
+#endif //__P4TEXTBUFFER__
@@ -577,19 +577,15 @@ void CP4winApp::StatusAdd( LPCTSTR txt, StatusView level, bool showDialog )
 	if ( lstrlen( txt ) < 1 )
 		return;
 
-	LPTSTR msg = new TCHAR[ lstrlen( txt ) + 1 ];
-	lstrcpy( msg, txt );
-
-	//		don't post the message until we get a window. since i 
-	//		put up messages constantly, i can easily post before a 
+	//		don't log the message until we get a window. since i 
+	//		put up messages constantly, i can easily log before a 
 	//		window is up. this is cheesy, but simpler than doing an
 	//		onidle(), and after all, these are just boring status messages.
+	//		the status pane picks up what is logged on a timer.
 	//
 	CWnd *pWnd = AfxGetApp( )->m_pMainWnd;
 	if ( pWnd )
-		::PostMessage( pWnd->m_hWnd, WM_STATUSADD, ( WPARAM ) msg, MAKELPARAM(level, showDialog ? 1 : 0));	
-	else
-		delete [ ] msg;
+		m_StatusLog.Add( txt, level, showDialog );
 }
 
 void CP4winApp::StatusAdd( CStringArray *pArray, StatusView level, bool showDialog )
@@ -599,17 +595,20 @@ void CP4winApp::StatusAdd( CStringArray *pArray, StatusView level, bool showDial
 	if ( pArray == NULL )
 		return;
 	
-	//		don't post the message until we get a window. since i 
-	//		put up messages constantly, i can easily post before a 
+	//		don't log the messages until we get a window. since i 
+	//		put up messages constantly, i can easily log before a 
 	//		window is up. this is cheesy, but simpler than doing an
 	//		onidle(), and after all, these are just boring status messages.
 	//
 
 	CWnd *pWnd = AfxGetApp( )->m_pMainWnd;
 	if ( pWnd )
-		::PostMessage( pWnd->m_hWnd, WM_STATUSADDARRAY, ( WPARAM ) pArray, MAKELPARAM(level, showDialog ? 1 : 0));	
-	else
-		delete [ ] pArray;
+	{
+		for( int i= 0; i < pArray->GetSize(); i++ )
+			if ( !pArray->GetAt(i).IsEmpty() )
+				m_StatusLog.Add( pArray->GetAt(i), level, showDialog );
+	}
+	delete pArray;
 }
 
 
@@ -30,12 +30,15 @@
 #include "P4Registry.h"
 #include "P4FileStats.h"
 #include "P4CommandStatus.h"
+#include "P4RevCache.h"
+#include "P4ChangeIndex.h"
 #include "StringUtil.h"
 #include "Utf8String.h"
 #include "P4GuiApp.h"
 #include "P4ListBox.h"
 
 #include "StatusView.h"
+#include "P4StatusLog.h"
 
 // RunApp() modes
 enum RunAppMode
@@ -171,6 +174,8 @@ typedef	struct	_RUNAPPTHREADINFO	// This whole struct is passed to the worker th
 
 // A handy macro for getting at the registry from other modules
 #define GET_P4REGPTR() ((CP4winApp *) AfxGetApp())->GetRegPtr()
+#define GET_REVCACHE() (&((CP4winApp *) AfxGetApp())->m_RevCache)
+#define GET_CHANGEINDEX() (&((CP4winApp *) AfxGetApp())->m_ChangeIndex)
 #define SERVER_BUSY() ((CP4winApp *) AfxGetApp())->m_CS.IsServerBusy()
 #define CLEAR_SERVERINFO() ((CP4winApp *) AfxGetApp())->m_CS.Reset()
 #define QUEUE_COMMAND(x) ((CP4winApp *) AfxGetApp())->m_CS.QueueCommand(x)
@@ -260,7 +265,11 @@ public:
 	BOOL m_WarningDialog;
 	BOOL m_TestFlag;
 	CP4CommandStatus m_CS;
+	CP4RevCache m_RevCache;
+	CP4ChangeIndex m_ChangeIndex;
+	CP4StatusLog m_StatusLog;
 	BOOL m_bNoCRLF;
+	CString m_ClientLineEnd;	// client spec's LineEnd field, if it has one
 	BOOL m_HasPlusMapping;
 	int m_ClientSubOpts;
 	CString m_ClientRoot;
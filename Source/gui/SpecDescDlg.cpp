@@ -43,6 +43,7 @@ static char THIS_FILE[] = __FILE__;
 #define UPDATE_STATUS(x) ((CMainFrame *)AfxGetMainWnd())->UpdateStatus(x)
 #define	ID_EMAIL ID_EMAIL_PERFORCE
 #define ID_URL   ID_WWW_PERFORCE_COM
+#define DESCMAXLENGTH	256000	// longer descriptions are truncated to this
 
 static bool sbHasWingDings = false;
 
@@ -298,7 +299,10 @@ CSpecDescDlg::CSpecDescDlg(CWnd* pParent /*=NULL*/)
     , m_SkipLines(0)
     , m_ScrollPastComments(false)
     , m_numHotSpots(0)
+    , m_FormattingHotSpots(FALSE)
     , m_DescriptionW(0)
+    , m_pHotSpotThread(0)
+    , m_StopHotSpots(0)
 {
 	//{{AFX_DATA_INIT(CSpecDescDlg)
 	//}}AFX_DATA_INIT
@@ -353,6 +357,7 @@ CSpecDescDlg::~CSpecDescDlg()
 		mainWnd->SetGotUserInput( );
 		mainWnd->WaitAWhileToPoll( );
 	}
+	StopHotSpots();
 #ifndef UNICODE
     // for UNICODE build, m_DescriptionW just points at m_Description
     delete const_cast<LPWCH>(m_DescriptionW);
@@ -381,6 +386,8 @@ void CSpecDescDlg::DoDataExchange(CDataExchange* pDX)
 
 BEGIN_MESSAGE_MAP(CSpecDescDlg, CDialog)
 	ON_NOTIFY(EN_MSGFILTER, IDC_DESCRIPTION, OnMsgfilterDescription)
+	ON_NOTIFY(EN_SELCHANGE, IDC_DESCRIPTION, OnSelchangeDescription)
+	ON_EN_VSCROLL(IDC_DESCRIPTION, OnVscrollDescription)
 	//{{AFX_MSG_MAP(CSpecDescDlg)
 	ON_WM_SIZE()
 	ON_WM_CLOSE()
@@ -478,6 +485,7 @@ BEGIN_MESSAGE_MAP(CSpecDescDlg, CDialog)
 	ON_MESSAGE(WM_NEWUSER, OnNewUser )
 	ON_MESSAGE(WM_QUITTING, OnQuitting )
 	ON_MESSAGE(WM_FINDPATTERN, OnFindPattern )
+	ON_MESSAGE(WM_HOTSPOTSFOUND, OnHotSpotsFound )
     ON_WM_INITMENUPOPUP()
     ON_REGISTERED_MESSAGE( WM_FINDREPLACE, OnFindReplace )
 END_MESSAGE_MAP()
@@ -556,7 +564,7 @@ BOOL CSpecDescDlg::OnInitDialog()
 	m_WinPos.RestoreWindowPosition();
 
     SetEditText();
-    m_Text.SetEventMask(ENM_KEYEVENTS|ENM_LINK);
+    m_Text.SetEventMask(ENM_KEYEVENTS|ENM_LINK|ENM_SCROLL|ENM_SELCHANGE);
 	m_Text.SetBackgroundColor(FALSE, GetSysColor(COLOR_BTNFACE));	// set background color to gray
 
     CHARFORMAT cf;
@@ -679,8 +687,13 @@ void CSpecDescDlg::SetDescription(LPCTSTR txt, BOOL scrollPastComments /*=TRUE*/
     // equivalent to but much, much faster than: 
     // m_Description = txt;
     // m_Description.Replace(_T("\r\n"), _T("\n"));
-	LPTSTR pDesc = m_Description.GetBufferSetLength(lstrlen(txt)+1);
-    while(*txt)
+	StopHotSpots();
+
+	// nothing past DESCMAXLENGTH is shown, so there's no need to copy it all
+	int size = int(_tcsnlen(txt, DESCMAXLENGTH + 1));
+	LPTSTR pDesc = m_Description.GetBufferSetLength(size+2);
+	LPTSTR pEnd = pDesc + size;
+    while(*txt && pDesc < pEnd)
     {
         if(*txt == _T('\r') && txt[1] == _T('\n'))
         {
@@ -720,8 +733,8 @@ void CSpecDescDlg::SetDescription(LPCTSTR txt, BOOL scrollPastComments /*=TRUE*/
 		{
 			if (osVer.dwMajorVersion < 5)
 				trunc = 60000;
-			else if (lgth > 256000)
-				trunc = 256000;
+			else if (lgth > DESCMAXLENGTH)
+				trunc = DESCMAXLENGTH;
 		}
 		if (trunc)
 		{
@@ -803,6 +816,7 @@ void CSpecDescDlg::OnSize(UINT nType, int cx, int cy)
 
 		// Increase the size of the edit control above the button
 		m_Text.MoveWindow(4, 4, x-8, y-rect.Height()-14, TRUE);
+		FormatVisibleHotSpots();
 	}
 }
 
@@ -1161,17 +1175,23 @@ void CSpecDescDlg::SetMenuFlags()
 	}
 }
 
+// The hot spots are in text order, so this can do a binary search
 int CSpecDescDlg::IsItaHotSpot(int nStartChar, int nEndChar)
 {
-	int i;
-	for (i = -1; ++i < m_numHotSpots; )
+	int lo = 0;
+	int hi = m_numHotSpots;
+	while (lo < hi)
 	{
-		int	b = m_HotSpotBgn.GetAt(i);
-		int	e = m_HotSpotEnd.GetAt(i);
-		if ((nStartChar == b) && (nEndChar == e))
-			return i;
-		else if (nStartChar < b)
-			break;
+		int i = (lo + hi) / 2;
+		if ((int) m_HotSpotBgn.GetAt(i) < nStartChar)
+			lo = i + 1;
+		else
+			hi = i;
+	}
+	for ( ; lo < m_numHotSpots && (int) m_HotSpotBgn.GetAt(lo) == nStartChar; lo++)
+	{
+		if ((int) m_HotSpotEnd.GetAt(lo) == nEndChar)
+			return lo;
 	}
 	return -1;
 }
@@ -2470,6 +2490,7 @@ LRESULT CSpecDescDlg::OnP4Fixes(WPARAM wParam, LPARAM lParam)
 		}
 
         theFixes.Replace(_T("\r\n"), _T("\n"));
+		StopHotSpots();
 		m_Description += theFixes;
         SetEditText();
 		m_Text.LineScroll(0 - m_Text.GetFirstVisibleLine());
@@ -2622,7 +2643,7 @@ void CSpecDescDlg::OnHelp()
 }
 
 int
-CSpecDescDlg::AddHotSpotWord(int idx, int offset, int lineStart, int lgth, BOOL bAtSign)
+CSpecDescDlg::AddHotSpotWord(HOTSPOTSCAN &scan, int offset, int lineStart, int lgth, BOOL bAtSign)
 {
     LPCWSTR line = m_DescriptionW + lineStart;
 
@@ -2667,13 +2688,13 @@ CSpecDescDlg::AddHotSpotWord(int idx, int offset, int lineStart, int lgth, BOOL
     // calculate indexes, and add hotspot
     int b = int(pBegin - line) + lineStart;
     int e = int(pEnd - line) + lineStart;
-	m_HotSpotBgn.InsertAt(idx, b);
-	m_HotSpotEnd.InsertAt(idx, e);
+	scan.m_Bgn.Add(b);
+	scan.m_End.Add(e);
 	return(e);
 }
 
 int
-CSpecDescDlg::AddHotSpotFile(int idx, int offset, int lineStart, int lgth, BOOL bQuoted)
+CSpecDescDlg::AddHotSpotFile(HOTSPOTSCAN &scan, int offset, int lineStart, int lgth, BOOL bQuoted)
 {
     // b points to either "// or -// or //
 
@@ -2731,32 +2752,21 @@ CSpecDescDlg::AddHotSpotFile(int idx, int offset, int lineStart, int lgth, BOOL
     	}
     }
     int e = int(pEnd - m_DescriptionW);
-	m_HotSpotBgn.InsertAt(idx, b);
-	m_HotSpotEnd.InsertAt(idx, e);
+	scan.m_Bgn.Add(b);
+	scan.m_End.Add(e);
 	return(e);
 }
 #define STRLENW(s) (sizeof(s)/sizeof(WCHAR)-1)
 
-void CSpecDescDlg::SetHotSpots()
+// Scans from scan.m_At, adding to scan's arrays, until the first line that
+// starts at or after stopChar.  Returns FALSE if it got to the end of the text.
+BOOL CSpecDescDlg::ScanHotSpots(HOTSPOTSCAN &scan, int stopChar)
 {
-    int lgth = int(wcslen(m_DescriptionW));
+    int lgth = scan.m_Length;
     LPCWSTR pLastMinus1 = m_DescriptionW + (lgth ? lgth - 1 : 0);
-	BOOL bInJobs = FALSE;
-	BOOL bInFixes = FALSE;
-	BOOL bInDiffs = FALSE;
-
-    // preallocate arrays, and set grow-by size
-    m_HotSpotBgn.RemoveAll();
-    m_HotSpotEnd.RemoveAll();
-    m_HotSpotType.RemoveAll();
-	m_HotSpotBgn.SetSize(m_Text.GetLineCount() - m_Text.GetFirstVisibleLine(), 10);
-	m_HotSpotEnd.SetSize(m_Text.GetLineCount() - m_Text.GetFirstVisibleLine(), 10);
-	m_HotSpotType.SetSize(m_Text.GetLineCount() - m_Text.GetFirstVisibleLine(), 10);
-    m_numHotSpots = 0;
+    int beginChar = scan.m_LineStart;
 
-    int beginChar = m_Text.LineIndex();
-
-	for (LPCWSTR pAt = m_DescriptionW + beginChar; *pAt; pAt++ )
+	for (LPCWSTR pAt = m_DescriptionW + scan.m_At; *pAt; pAt++ )
 	{
         // some strings we look for:
         static const WCHAR strModifiedBy[] = L"ModifiedBy:\t";
@@ -2834,7 +2844,14 @@ void CSpecDescDlg::SetHotSpots()
 
         int i = int(pAt - m_DescriptionW);
 
-        if(bInDiffs && i == beginChar)
+        // stop at a line start, so the next call can pick up from there
+        if(i == beginChar && i >= stopChar)
+        {
+            scan.m_At = scan.m_LineStart = i;
+            return TRUE;
+        }
+
+        if(scan.m_InDiffs && i == beginChar)
         {
             if(wcsncmp(pAt, L"==== ", 5))
             {
@@ -2863,25 +2880,25 @@ void CSpecDescDlg::SetHotSpots()
             if(*pBeforeAt <= ' ')
                 continue;
 
-			int newi = AddHotSpotWord(m_numHotSpots, i, beginChar, lgth, TRUE);
+			int newi = AddHotSpotWord(scan, i, beginChar, lgth, TRUE);
 			if (newi == i)
 				pAt++;	// word contained a / \ or : which is not in a user, client or email addr - so skip it
 			else
 			{
-				LPCWSTR pDot = wcschr(m_DescriptionW+i+1, '.');
-				if(pDot && pDot < m_DescriptionW+newi)
+				LPCWSTR pDot = wmemchr(m_DescriptionW+i+1, '.', newi - i - 1);
+				if(pDot)
 				{
 					// found '.' following '@', so assume email address
-					m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAEMAIL);
+					scan.m_Type.Add(HS_ISAEMAIL);
 				}
 				else
 				{
 					// no '.' following '@', so assume user@client
-					m_HotSpotEnd.SetAt(m_numHotSpots, i);
-					m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAUSER);
-					m_HotSpotBgn.InsertAt(m_numHotSpots, i+1);
-					m_HotSpotEnd.InsertAt(m_numHotSpots, newi);
-					m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISACLIENT);
+					scan.m_End.SetAt(scan.m_End.GetUpperBound(), i);
+					scan.m_Type.Add(HS_ISAUSER);
+					scan.m_Bgn.Add(i+1);
+					scan.m_End.Add(newi);
+					scan.m_Type.Add(HS_ISACLIENT);
 				}
 				pAt += newi - i - 1;
 			}
@@ -2895,15 +2912,15 @@ void CSpecDescDlg::SetHotSpots()
 			if (*(pAt+3) <= ' ')	// depot names don't have a white space after the //
 				continue;
             bool bQuoted = *pAt == L'\"';
-   			int newi = AddHotSpotFile(m_numHotSpots, i, beginChar, lgth, bQuoted);
-    		m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAFILE);
+   			int newi = AddHotSpotFile(scan, i, beginChar, lgth, bQuoted);
+    		scan.m_Type.Add(HS_ISAFILE);
             // don't lose trailing delimiter
             pAt += newi - i - 1;
         }
         else if(!wcsncmp(pAt, L"http://", 7) || !wcsncmp(pAt, L"https://", 8))
         {
-    		int newi = AddHotSpotWord(m_numHotSpots, i, beginChar, lgth, FALSE) - 1;
-	    	m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAURL);
+    		int newi = AddHotSpotWord(scan, i, beginChar, lgth, FALSE) - 1;
+	    	scan.m_Type.Add(HS_ISAURL);
             pAt += newi - i;
         }
         else if(i == beginChar)
@@ -2911,22 +2928,22 @@ void CSpecDescDlg::SetHotSpots()
             int newi = i;
             if(!wcsncmp(pAt, strReportedBy, strReportedByLen))
             {
-                newi = AddHotSpotWord(m_numHotSpots, i + strReportedByLen, beginChar, lgth, FALSE);
-                m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAUSER);
+                newi = AddHotSpotWord(scan, i + strReportedByLen, beginChar, lgth, FALSE);
+                scan.m_Type.Add(HS_ISAUSER);
             }
             else if(!wcsncmp(pAt, strModifiedBy, strModifiedByLen))
             {
-                newi = AddHotSpotWord(m_numHotSpots, i + strModifiedByLen, beginChar, lgth, FALSE);
-                m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAUSER);
+                newi = AddHotSpotWord(scan, i + strModifiedByLen, beginChar, lgth, FALSE);
+                scan.m_Type.Add(HS_ISAUSER);
             }
             else if((m_viewType != P4USER_SPEC) && !wcsncmp(pAt, strUser, strUserLen))
             {
-                newi = AddHotSpotWord(m_numHotSpots, i + strUserLen, beginChar, lgth, FALSE);
-                m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAUSER);
+                newi = AddHotSpotWord(scan, i + strUserLen, beginChar, lgth, FALSE);
+                scan.m_Type.Add(HS_ISAUSER);
             }
             else if(!wcsncmp(pAt, strJobsFixed, strJobsFixedLen))
             {
-                bInJobs = TRUE;
+                scan.m_InJobs = TRUE;
                 newi = i + strJobsFixedLen;
             }
             // note: depending on whether a submitted or unsubmitted change is 
@@ -2935,18 +2952,18 @@ void CSpecDescDlg::SetHotSpots()
             // stringtable.  We don't know which it is here, so try both.
             else if(!wcsncmp(pAt, strAffectedFiles, strAffectedFilesLen))
             {
-                bInJobs = FALSE;
+                scan.m_InJobs = FALSE;
                 newi = i + strAffectedFilesLen;
             }
             else if(!wcsncmp(pAt, strAffectedFilesEnglish, strAffectedFilesEnglishLen))
             {
-                bInJobs = FALSE;
+                scan.m_InJobs = FALSE;
                 newi = i + strAffectedFilesEnglishLen;
             }
-			else if (bInJobs && (*pAt > ' '))
+			else if (scan.m_InJobs && (*pAt > ' '))
 			{
-				newi = AddHotSpotWord(m_numHotSpots, i, beginChar, lgth, FALSE);
-				m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAJOB);
+				newi = AddHotSpotWord(scan, i, beginChar, lgth, FALSE);
+				scan.m_Type.Add(HS_ISAJOB);
                 pAt += newi - i;
                 i = newi;
 
@@ -2956,13 +2973,13 @@ void CSpecDescDlg::SetHotSpots()
                 static const int strDateLen = STRLENW(strDate);
 				if (!wcsncmp(pAt + strDateLen, strBy, strByLen))
 				{
-					newi = AddHotSpotWord(m_numHotSpots, i + strDateLen + strByLen, beginChar, lgth, FALSE);
-					m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISAUSER);
+					newi = AddHotSpotWord(scan, i + strDateLen + strByLen, beginChar, lgth, FALSE);
+					scan.m_Type.Add(HS_ISAUSER);
 				}
 			}
             else if(!wcsncmp(pAt, strFixes, strFixesLen))
             {
-                bInFixes = TRUE;
+                scan.m_InFixes = TRUE;
                 newi = i + strFixesLen;
                 if(pAt[strFixesLen] == '\n')
                 {
@@ -2970,14 +2987,14 @@ void CSpecDescDlg::SetHotSpots()
                     newi--;
                 }
             }
-			else if (bInFixes && !wcsncmp(pAt, strChange, strChangeLen))
+			else if (scan.m_InFixes && !wcsncmp(pAt, strChange, strChangeLen))
 			{
-                newi = AddHotSpotWord(m_numHotSpots, i + strChangeLen, beginChar, lgth, FALSE);
-				m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISACHG);
+                newi = AddHotSpotWord(scan, i + strChangeLen, beginChar, lgth, FALSE);
+				scan.m_Type.Add(HS_ISACHG);
 			}
 			else if (!wcsncmp(pAt, strDifferences, strDifferencesLen))
 			{
-                bInDiffs = TRUE;
+                scan.m_InDiffs = TRUE;
                 newi = i + strDifferencesLen;
 			}
             pAt += newi - i;
@@ -2992,22 +3009,182 @@ void CSpecDescDlg::SetHotSpots()
 
             if(pChar > pAt)
             {
-			    i = AddHotSpotWord(m_numHotSpots, i, beginChar, int(pChar - pAt), FALSE);
+			    i = AddHotSpotWord(scan, i, beginChar, int(pChar - pAt), FALSE);
                 pAt = pChar;
-			    m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISACHG);
+			    scan.m_Type.Add(HS_ISACHG);
             }
 		}
 		else if (m_bDiffOutput && !wcsncmp(pAt, strEqContent, strEqContentLen))
 		{
-			i = AddHotSpotWord(m_numHotSpots, i+5, beginChar, strEqContentLen-5, FALSE);
+			i = AddHotSpotWord(scan, i+5, beginChar, strEqContentLen-5, FALSE);
             pAt += strChangelistLen;
-			m_HotSpotType.InsertAt(m_numHotSpots++, HS_ISDIFF2);
+			scan.m_Type.Add(HS_ISDIFF2);
 		}
         // if at end of line, note start of next line
         if(*pAt == '\n')
             beginChar = int((pAt + 1) - m_DescriptionW);
 	}
-	if (m_numHotSpots == 0)
+	scan.m_At = lgth;
+	return FALSE;
+}
+
+// Finds the hot spots in the text.  Those on screen are found and formatted
+// now; a background thread works through the rest a chunk at a time.  Hot
+// spots are only made links once they scroll into view - see
+// FormatVisibleHotSpots().
+void CSpecDescDlg::SetHotSpots()
+{
+	StopHotSpots();
+    m_HotSpotBgn.RemoveAll();
+    m_HotSpotEnd.RemoveAll();
+    m_HotSpotType.RemoveAll();
+    m_HotSpotDone.RemoveAll();
+    m_numHotSpots = 0;
+
+	m_Scan.m_Length = int(wcslen(m_DescriptionW));
+	m_Scan.m_At = m_Scan.m_LineStart = m_Text.LineIndex();
+	m_Scan.m_InJobs = m_Scan.m_InFixes = m_Scan.m_InDiffs = FALSE;
+	m_Scan.m_Bgn.RemoveAll();
+	m_Scan.m_End.RemoveAll();
+	m_Scan.m_Type.RemoveAll();
+
+	CRect rect;
+	m_Text.GetRect(&rect);
+	int lastLine = m_Text.LineFromChar(m_Text.CharFromPos(CPoint(rect.left, rect.bottom - 1)));
+	int stopChar = m_Text.LineIndex(lastLine + 1);
+	if (stopChar == -1)
+		stopChar = m_Scan.m_Length;
+	BOOL more = ScanHotSpots(m_Scan, stopChar);
+
+	m_HotSpotBgn.Copy(m_Scan.m_Bgn);
+	m_HotSpotEnd.Copy(m_Scan.m_End);
+	m_HotSpotType.Copy(m_Scan.m_Type);
+	m_numHotSpots = (int) m_HotSpotBgn.GetSize();
+	m_HotSpotDone.SetSize(m_numHotSpots);
+	m_Scan.m_Bgn.RemoveAll();
+	m_Scan.m_End.RemoveAll();
+	m_Scan.m_Type.RemoveAll();
+	FormatVisibleHotSpots();
+
+	if (more)
+	{
+		m_StopHotSpots = 0;
+		m_pHotSpotThread = AfxBeginThread(HotSpotThread, (LPVOID) this,
+					THREAD_PRIORITY_BELOW_NORMAL, 0, CREATE_SUSPENDED, NULL);
+		m_pHotSpotThread->m_bAutoDelete = FALSE;	// StopHotSpots() waits on the handle
+		m_pHotSpotThread->ResumeThread();
+	}
+}
+
+// Must be called before m_Description or m_DescriptionW is changed, since
+// the thread reads m_DescriptionW
+void CSpecDescDlg::StopHotSpots()
+{
+	if (m_pHotSpotThread)
+	{
+		InterlockedExchange(&m_StopHotSpots, 1);
+		WaitForSingleObject(m_pHotSpotThread->m_hThread, INFINITE);
+		delete m_pHotSpotThread;
+		m_pHotSpotThread = NULL;
+	}
+	m_HotSpotLock.Lock();
+	m_PendingBgn.RemoveAll();
+	m_PendingEnd.RemoveAll();
+	m_PendingType.RemoveAll();
+	m_HotSpotLock.Unlock();
+}
+
+UINT CSpecDescDlg::HotSpotThread(LPVOID pParam)
+{
+	CSpecDescDlg *pDlg = (CSpecDescDlg *) pParam;
+	HOTSPOTSCAN &scan = pDlg->m_Scan;
+	BOOL more = TRUE;
+	while (more && !pDlg->m_StopHotSpots)
+	{
+		more = pDlg->ScanHotSpots(scan, scan.m_At + HOTSPOTCHUNK);
+		if (scan.m_Bgn.GetSize())
+		{
+			pDlg->m_HotSpotLock.Lock();
+			pDlg->m_PendingBgn.Append(scan.m_Bgn);
+			pDlg->m_PendingEnd.Append(scan.m_End);
+			pDlg->m_PendingType.Append(scan.m_Type);
+			pDlg->m_HotSpotLock.Unlock();
+			scan.m_Bgn.RemoveAll();
+			scan.m_End.RemoveAll();
+			scan.m_Type.RemoveAll();
+			::PostMessage(pDlg->m_hWnd, WM_HOTSPOTSFOUND, 0, 0);
+		}
+	}
+	return 0;
+}
+
+LRESULT CSpecDescDlg::OnHotSpotsFound(WPARAM wParam, LPARAM lParam)
+{
+	m_HotSpotLock.Lock();
+	m_HotSpotBgn.Append(m_PendingBgn);
+	m_HotSpotEnd.Append(m_PendingEnd);
+	m_HotSpotType.Append(m_PendingType);
+	m_PendingBgn.RemoveAll();
+	m_PendingEnd.RemoveAll();
+	m_PendingType.RemoveAll();
+	m_HotSpotLock.Unlock();
+	m_numHotSpots = (int) m_HotSpotBgn.GetSize();
+	m_HotSpotDone.SetSize(m_numHotSpots);
+	FormatVisibleHotSpots();
+	return 0;
+}
+
+void CSpecDescDlg::OnSelchangeDescription(NMHDR* pNMHDR, LRESULT* pResult)
+{
+	*pResult = 0;
+	FormatVisibleHotSpots();
+}
+
+void CSpecDescDlg::OnVscrollDescription()
+{
+	FormatVisibleHotSpots();
+}
+
+// Makes links of the hot spots on the visible lines that aren't links yet.
+// Formatting has to select each one, so this is put off while the user has
+// text selected - the selection could not be put back the way it was made -
+// and done when it is cleared or the text is next scrolled.
+void CSpecDescDlg::FormatVisibleHotSpots()
+{
+	if (!m_numHotSpots || m_FormattingHotSpots || !IsWindow(m_Text.m_hWnd))
+		return;
+
+	long orgb, orge;
+	m_Text.GetSel(orgb, orge);
+	if (orgb != orge)
+		return;
+
+	CRect rect;
+	m_Text.GetRect(&rect);
+	int firstLine = m_Text.GetFirstVisibleLine();
+	int lastLine = m_Text.LineFromChar(m_Text.CharFromPos(CPoint(rect.left, rect.bottom - 1)));
+	int bgnChar = m_Text.LineIndex(firstLine);
+	int endChar = m_Text.LineIndex(lastLine + 1);
+	if (endChar == -1)
+		endChar = m_Text.GetTextLength();
+
+	// find the first hot spot ending past the top of the window
+	int lo = 0;
+	int hi = m_numHotSpots;
+	while (lo < hi)
+	{
+		int i = (lo + hi) / 2;
+		if ((int) m_HotSpotEnd.GetAt(i) <= bgnChar)
+			lo = i + 1;
+		else
+			hi = i;
+	}
+	int last;
+	BOOL todo = FALSE;
+	for (last = lo; last < m_numHotSpots && (int) m_HotSpotBgn.GetAt(last) < endChar; last++)
+		if (!m_HotSpotDone.GetAt(last))
+			todo = TRUE;
+	if (!todo)
 		return;
 
     CHARFORMAT cf;
@@ -3026,16 +3203,22 @@ void CSpecDescDlg::SetHotSpots()
 		cf.crTextColor = txtcolor;
 	}
 
-	long orgb, orge;
-	m_Text.GetSel(orgb, orge);
-	for (int i = -1; ++i < m_numHotSpots; )
+	// selecting fires EN_SELCHANGE back at us
+	m_FormattingHotSpots = TRUE;
+	m_Text.SetRedraw(FALSE);
+	for (int i = lo; i < last; i++)
 	{
-		int	b = m_HotSpotBgn.GetAt(i);
-		int	e = m_HotSpotEnd.GetAt(i);
-		m_Text.SetSel(b, e);
+		if (m_HotSpotDone.GetAt(i))
+			continue;
+		m_Text.SetSel(m_HotSpotBgn.GetAt(i), m_HotSpotEnd.GetAt(i));
 		m_Text.SetSelectionCharFormat(cf);
+		m_HotSpotDone.SetAt(i, 1);
 	}
 	m_Text.SetSel(orgb, orge);
+	m_Text.LineScroll(firstLine - m_Text.GetFirstVisibleLine());
+	m_Text.SetRedraw(TRUE);
+	m_Text.Invalidate();
+	m_FormattingHotSpots = FALSE;
 }
 
 /*  _________________________________________________________________
@@ -3267,6 +3450,7 @@ void CSpecDescDlg::OnGetMinMaxInfo(MINMAXINFO FAR* lpMMI)
 // MainFrame which will delete the 'this' object
 void CSpecDescDlg::OnDestroy()
 {
+	StopHotSpots();
 	if (m_Modeless)
 		::PostMessage(MainFrame()->m_hWnd, WM_P4DLGDESTROY, 0, (LPARAM)this);
 }
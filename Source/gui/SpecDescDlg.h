@@ -8,6 +8,7 @@
 // SpecDescDlg.h : header file
 //
 
+#include <afxmt.h>
 #include "WinPos.h"
 #include "P4Menu.h"
 #include "CoolBtn.h"
@@ -28,6 +29,23 @@
 #define	HS_ISAURL		0x81
 #define	HS_ISDIFF2		0x82
 
+#define HOTSPOTCHUNK	65536	// characters the hot spot thread scans between posts
+
+// Where a hot spot scan has got to, so it can stop at the end of a line and
+// carry on from there later, and the hot spots it has found since then
+struct HOTSPOTSCAN
+{
+	int m_At;
+	int m_LineStart;
+	int m_Length;
+	BOOL m_InJobs;
+	BOOL m_InFixes;
+	BOOL m_InDiffs;
+	CDWordArray m_Bgn;
+	CDWordArray m_End;
+	CByteArray m_Type;
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // a subclass of CButton to pass Ctrl+F, F3 and Shift F3 to the parent window
 class CKeyDownButton : public CButton
@@ -128,7 +146,16 @@ protected:
 	CDWordArray m_HotSpotBgn;
 	CDWordArray m_HotSpotEnd;
 	CByteArray m_HotSpotType;
+	CByteArray m_HotSpotDone;		// nonzero once made a link
     int m_numHotSpots;
+	BOOL m_FormattingHotSpots;
+	HOTSPOTSCAN m_Scan;
+	CWinThread *m_pHotSpotThread;
+	volatile LONG m_StopHotSpots;
+	CCriticalSection m_HotSpotLock;	// for the pending arrays
+	CDWordArray m_PendingBgn;		// found by the thread, not yet formatted
+	CDWordArray m_PendingEnd;
+	CByteArray m_PendingType;
 	DWORD m_LButtonDownTime;
 	CString m_SelItem;
 	int  m_SelType;
@@ -228,8 +255,13 @@ protected:
 	void OnDescItem(HWND hWnd, int viewType, int flag = 0);
 	void OnDescChgLong(int flag);
 	void SetHotSpots();
-	int  AddHotSpotWord(int index, int offset, int lineStart, int lgth, BOOL bAtSign);
-	int  AddHotSpotFile(int index, int offset, int lineStart, int lgth, BOOL bQuoted);
+	void StopHotSpots();
+	BOOL ScanHotSpots(HOTSPOTSCAN &scan, int stopChar);
+	void FormatVisibleHotSpots();
+	static UINT HotSpotThread(LPVOID pParam);
+	LRESULT OnHotSpotsFound(WPARAM wParam, LPARAM lParam);
+	int  AddHotSpotWord(HOTSPOTSCAN &scan, int offset, int lineStart, int lgth, BOOL bAtSign);
+	int  AddHotSpotFile(HOTSPOTSCAN &scan, int offset, int lineStart, int lgth, BOOL bQuoted);
 	int  IsItaHotSpot(int nStartChar, int nEndChar);
 	BOOL PumpMessages( );
 	LRESULT OnP4Diff2(WPARAM wParam, LPARAM lParam);
@@ -238,6 +270,8 @@ protected:
     void OnInitMenuPopup(CMenu *pPopupMenu, UINT nIndex,BOOL bSysMenu);
 
     void OnMsgfilterDescription(NMHDR* pNMHDR, LRESULT* pResult);
+    void OnSelchangeDescription(NMHDR* pNMHDR, LRESULT* pResult);
+    void OnVscrollDescription();
     void OnPageSetup();
 	void OnShowDiffs(int flag);
 
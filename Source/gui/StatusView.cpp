@@ -20,6 +20,22 @@
 static char THIS_FILE[] = __FILE__;
 #endif
 
+#define DRAININTERVAL	100		// ms between moving logged messages into the pane
+
+// The levels each item on the Show Levels menu turns on and off
+static const struct
+{
+	UINT	id;
+	int		levels;
+	UINT	text;
+} ShowLevels[] =
+{
+	{ ID_STATUS_SHOWCOMPLETIONS,	1 << SV_COMPLETION,							IDS_STATUS_SHOWCOMPLETIONS },
+	{ ID_STATUS_SHOWWARNINGS,		(1 << SV_WARNING) | (1 << SV_WARNSUMMARY),	IDS_STATUS_SHOWWARNINGS },
+	{ ID_STATUS_SHOWERRORS,			1 << SV_ERROR,								IDS_STATUS_SHOWERRORS },
+	{ ID_STATUS_SHOWTOOLOUTPUT,		1 << SV_TOOL,								IDS_STATUS_SHOWTOOLOUTPUT },
+};
+
 
 /////////////////////////////////////////////////////////////////////////////
 // CStatusView
@@ -28,9 +44,15 @@ IMPLEMENT_DYNCREATE(CStatusView, CListView)
 
 CStatusView::CStatusView()
 {
-	m_HeadIndex=0;
 	m_ErrFound = m_RowAdded = FALSE;
 	m_ShowStatusMsgs = GET_P4REGPTR()->GetShowStatusMsgs();
+	m_LevelFilter = GET_P4REGPTR()->GetStatusLevelFilter();
+	m_MaxStatusLines = 0;
+	m_FirstRow = 0;
+	m_RowCount = 0;
+	m_Visible.SetSize(0, 1024);
+	m_Draining = m_Pending = FALSE;
+	m_Sound = NULL;
 	OnMaxStatusLines();
 
     CString tempPath= GET_P4REGPTR()->GetTempDir();
@@ -38,23 +60,15 @@ CStatusView::CStatusView()
 	for (int i = -1; ++i < 256; )
 	{
 		m_ErrFile.Format(_T("%s\\P4Werr%02x.txt"), tempPath, i);
-		if ((m_hErrFile=CreateFile(m_ErrFile, GENERIC_READ | GENERIC_WRITE, 
-					FILE_SHARE_READ, 0, CREATE_ALWAYS, 0, 0)) != INVALID_HANDLE_VALUE)
-		{
-#ifdef UNICODE
-			TCHAR msg[] = {0xFEFF};
-			DWORD NumberOfBytesWritten;
-			WriteFile(m_hErrFile, msg, 2, &NumberOfBytesWritten, NULL);
-#endif
+		if (m_ErrLog.Open(m_ErrFile, GET_P4REGPTR()->GetStatusLogMaxSize()))
 			break;
-		}
 	}
 	EnableToolTips();
 }
 
 CStatusView::~CStatusView()
 {
-	CloseHandle(m_hErrFile);
+	m_ErrLog.Close();
 }
 
 
@@ -66,6 +80,8 @@ BEGIN_MESSAGE_MAP(CStatusView, CListView)
 	ON_WM_CONTEXTMENU()
 	ON_NOTIFY_EX( TTN_NEEDTEXTW, 0, OnToolTipText )
 	ON_NOTIFY_EX( TTN_NEEDTEXTA, 0, OnToolTipText )
+	ON_NOTIFY_REFLECT(LVN_GETDISPINFO, OnGetdispinfo)
+	ON_WM_TIMER()
 	ON_COMMAND(ID_WINDOW_CLEAR, OnWindowClear)
 	ON_COMMAND(ID_SHOW_COMMAND_TRACE, OnShowCommandTrace )
 	ON_COMMAND(ID_SHOW_TIMESTAMP, OnShowTimestamp)
@@ -83,6 +99,7 @@ BEGIN_MESSAGE_MAP(CStatusView, CListView)
 	ON_COMMAND(ID_PERFORCE_OPTIONS, OnPerforceOptions)
 	//}}AFX_MSG_MAP
 	ON_MESSAGE( WM_FINDPATTERN, OnFindPattern )
+	ON_COMMAND_RANGE(ID_STATUS_SHOWCOMPLETIONS, ID_STATUS_SHOWTOOLOUTPUT, OnShowLevel)
 	ON_WM_SYSCOLORCHANGE()
 END_MESSAGE_MAP()
 
@@ -108,7 +125,10 @@ void CStatusView::Dump(CDumpContext& dc) const
 void CStatusView::Clear()
 {
 	ListView_DeleteAllItems(m_hWnd);
-	m_HeadIndex=0;
+	m_FirstRow += m_RowCount;
+	m_RowCount = 0;
+	m_Visible.RemoveAll();
+	m_Pending = FALSE;
 }
 
 
@@ -127,6 +147,58 @@ void CStatusView::OnInitialUpdate()
 	lvCol.cx=1800;  
 			
 	list.InsertColumn(0, &lvCol);
+
+	// Messages from StatusAdd() wait in the status log until the timer
+	// moves them into the pane
+	SetTimer(STATUS_TIMER, DRAININTERVAL, NULL);
+}
+
+void CStatusView::OnTimer(UINT_PTR nIDEvent) 
+{
+	if (nIDEvent == STATUS_TIMER)
+		DrainStatusLog();
+	else
+		CListView::OnTimer(nIDEvent);
+}
+
+// Adds everything waiting in the status log to the pane, then updates the
+// list just the once
+void CStatusView::DrainStatusLog()
+{
+	// A message box for an error in the batch may be up, with the timer
+	// still running under it
+	if (m_Draining)
+		return;
+	m_Draining = TRUE;
+
+	STATUSMSG msg;
+	while (TheApp()->m_StatusLog.Remove(msg))
+	{
+		MainFrame()->AddToStatusLog(msg.m_Text, msg.m_Level, msg.m_ShowDialog);
+		delete [] msg.m_Text;
+	}
+	UpdateList(TRUE);
+	if (m_Sound)
+	{
+		PlaySound(m_Sound, NULL, SND_ALIAS | SND_ASYNC | SND_NOWAIT | SND_NODEFAULT);
+		m_Sound = NULL;
+	}
+	m_Draining = FALSE;
+}
+
+void CStatusView::OnGetdispinfo(NMHDR* pNMHDR, LRESULT* pResult) 
+{
+	LV_DISPINFO *pDispInfo = (LV_DISPINFO*)pNMHDR;
+	LV_ITEM *pItem = &pDispInfo->item;
+	*pResult = 0;
+
+	if (pItem->iItem < 0 || pItem->iItem >= m_Visible.GetSize())
+		return;
+	STATUSROW &row = GetRow(pItem->iItem);
+	if (pItem->mask & LVIF_TEXT)
+		lstrcpyn(pItem->pszText, row.m_Text, pItem->cchTextMax);
+	if (pItem->mask & LVIF_IMAGE)
+		pItem->iImage = CP4ViewImageList::VI_STATUS_MSG + row.m_Level;
 }
 
 void CStatusView::AddItem(LPCTSTR text, StatusView level, bool showDialog, BOOL ensureVisible /*=TRUE */) 
@@ -134,7 +206,6 @@ void CStatusView::AddItem(LPCTSTR text, StatusView level, bool showDialog, BOOL
 	ASSERT(	text != NULL);
 	ASSERT( level >= SV_MSG && level < SV_MAX);
 
-	int len= lstrlen(text);
 	BOOL didFirstRow= FALSE;
 	BOOL write2file = (showDialog==true	|| level==SV_WARNING
 		|| level==SV_ERROR || level==SV_WARNSUMMARY) ? TRUE : FALSE;
@@ -142,9 +213,7 @@ void CStatusView::AddItem(LPCTSTR text, StatusView level, bool showDialog, BOOL
 	if (write2file && TheApp()->m_RunClientWizOnly)
 		showDialog = TRUE;
 
-	// Alloc a large enough buffer and initialize cleanText
-	CString cleanText(_T(' '), len + 10);   
-	cleanText.Empty();
+	CString stamp;
 	if (GET_P4REGPTR()->ShowStatusTime())
 	{
 		SYSTEMTIME	st;
@@ -152,63 +221,46 @@ void CStatusView::AddItem(LPCTSTR text, StatusView level, bool showDialog, BOOL
 		GetLocalTime(&st);
 		if (GET_P4REGPTR()->Use24hourClock())
 		{
-			cleanText.Format(_T("%02d:%02d:%02d "), st.wHour, st.wMinute, st.wSecond);
+			stamp.Format(_T("%02d:%02d:%02d "), st.wHour, st.wMinute, st.wSecond);
 		}
 		else
 		{
-			cleanText.Format(_T("%d:%02d:%02d "), 
+			stamp.Format(_T("%d:%02d:%02d "), 
 				(st.wHour > 12) ? st.wHour - 12 : st.wHour, 
 				st.wMinute, st.wSecond);
 		}
 	}
 
-	for(int i=0; i < len; i++)
+	// Split out multiple rows as required
+	CString row;
+	for (LPCTSTR p = text; *p; )
 	{
-		// Split out multiple rows as required
-		if(text[i] == _T('\n') && cleanText.GetLength() > 0)
-		{
-			if(!didFirstRow)
-			{
-				AddOneRow(cleanText, level, ensureVisible, write2file);
-				didFirstRow= TRUE;
-			}
-			else
-			{
-				// Dont show bitmap for continuation lines
-				AddOneRow(cleanText, SV_BLANK, ensureVisible, write2file);
-			}
-
-			cleanText.Empty();
-		}
+		LPCTSTR q = _tcschr(p, _T('\n'));
+		int lgth = q ? (int)(q - p) : lstrlen(p);
+		row = didFirstRow ? CString() : stamp;
+		row += CString(p, lgth);
 
 		// Get rid of misc control chars
-		else if(text[i] != _T('\r') && text[i] != _T('\t') && text[i] != _T('\n'))	
-			cleanText+= text[i];
-	}
-
-	if(cleanText.GetLength() > 0)
-	{
-		if(!didFirstRow)
-		{
-			AddOneRow(cleanText, level, ensureVisible, write2file);
-			didFirstRow=TRUE;
-		}
-		else
+		row.Remove(_T('\r'));
+		row.Remove(_T('\t'));
+		if (!row.IsEmpty())
 		{
 			// Dont show bitmap for continuation lines
-			AddOneRow(cleanText, SV_BLANK, ensureVisible, write2file);
+			AddOneRow(row, didFirstRow ? SV_BLANK : level, level, write2file);
+			didFirstRow= TRUE;
 		}
+		p += q ? lgth + 1 : lgth;
 	}
 
 	if(didFirstRow)
 	{
-		// Play a sound.  The nodefault flag is used so PlaySound is silent when the
-		// sound is not defined.  
-		if(level== SV_WARNING)
-			PlaySound(_T("PerforceWarning"), NULL, SND_ALIAS | SND_ASYNC | SND_NOWAIT | SND_NODEFAULT);
-			
-		else if(level== SV_COMPLETION)
-			PlaySound(_T("PerforceCompleted"), NULL, SND_ALIAS | SND_ASYNC | SND_NOWAIT | SND_NODEFAULT);
+		// Rows added from the status log are shown when the batch is done,
+		// unless a message box is about to go up
+		if (!m_Draining || level == SV_ERROR || showDialog)
+			UpdateList(ensureVisible);
+
+		if(level== SV_WARNING || level== SV_COMPLETION)
+			PlayLevelSound(level);
 	
 		else if(level== SV_ERROR)
 		{
@@ -284,59 +336,118 @@ void CStatusView::AddItem(LPCTSTR text, StatusView level, bool showDialog, BOOL
 	}
 }
 
-void CStatusView::AddOneRow(LPCTSTR text, StatusView level, BOOL ensureVisible, BOOL write2file, BOOL bSave/*=TRUE*/) 
+void CStatusView::AddOneRow(LPCTSTR text, StatusView level, StatusView filter, BOOL write2file) 
 {
-	DWORD NumberOfBytesWritten;
-
 	ASSERT(	text != NULL);
 	ASSERT( level >= SV_MSG && level < SV_MAX);
 
-	// Add the image and text
-	LV_ITEM lvItem;
-			
-	lvItem.mask=LVIF_TEXT | LVIF_IMAGE | LVIF_PARAM;
-	lvItem.iItem= m_HeadIndex;
-	lvItem.iSubItem= 0;
-	lvItem.iImage = CP4ViewImageList::VI_STATUS_MSG + level;
-	lvItem.pszText= const_cast<LPTSTR>(text); 
-	lvItem.lParam= level;
-
-	if (write2file || m_ShowStatusMsgs 
-	 || level== SV_COMPLETION || level== SV_WARNING || level== SV_ERROR || level== SV_WARNSUMMARY)
+	// If the pane has too many rows, the oldest goes
+	if (m_RowCount == m_MaxStatusLines)
 	{
-		// If the output window has too many rows, delete oldest row
-		if(ListView_GetItemCount(m_hWnd) >= m_MaxStatusLines)
-			ListView_DeleteItem(m_hWnd, 0);
-		// Add the item to the status listview
-		m_HeadIndex=ListView_InsertItem(m_hWnd, &lvItem);
-		if( ensureVisible )
-			ListView_EnsureVisible(m_hWnd, m_HeadIndex, FALSE);
-		m_HeadIndex++;
-		m_RowAdded = TRUE;
+		m_FirstRow++;
+		m_RowCount--;
 	}
-
-	CString msg;
-	msg.Format(_T("%d %s\r\n"), level, text);
-	if (bSave)
+	DWORD n = m_FirstRow + m_RowCount++;
+	STATUSROW &row = m_Rows[n % m_MaxStatusLines];
+	row.m_Text = text;
+	row.m_Level = (BYTE) level;
+	row.m_Filter = (BYTE) filter;
+	row.m_Logged = (BYTE) write2file;
+	if (IsRowVisible(row))
 	{
-		if (m_StatusRows.GetCount() > m_MaxSaveLines)
-			m_StatusRows.RemoveHead();
-		m_StatusRows.AddTail(msg);
+		m_Visible.Add(n);
+		m_RowAdded = TRUE;
 	}
+	m_Pending = TRUE;
 
 	if (write2file)
 	{
+		CString msg;
+		msg.Format(_T("%d %s\r\n"), level, text);
 		m_ErrFound = TRUE;
-		WriteFile(m_hErrFile, msg, msg.GetLength()*sizeof(TCHAR), &NumberOfBytesWritten, NULL);
+		m_ErrLog.Write(msg);
 		MainFrame()->SetStatusBarLevel(level);
 	}
+}
+
+BOOL CStatusView::IsRowVisible(const STATUSROW &row)
+{
+	if (!(m_LevelFilter & (1 << row.m_Filter)))
+		return FALSE;
+	return m_ShowStatusMsgs || row.m_Logged
+		|| row.m_Filter== SV_COMPLETION || row.m_Filter== SV_WARNING
+		|| row.m_Filter== SV_ERROR || row.m_Filter== SV_WARNSUMMARY;
+}
+
+// Tells the list about the rows added since the last time
+void CStatusView::UpdateList(BOOL ensureVisible)
+{
+	if (!m_Pending || !m_hWnd)
+		return;
+	m_Pending = FALSE;
+
+	// Rows that have gone from the ring go from the top of the list,
+	// and the selection moves up with the rest
+	int gone = 0;
+	while (gone < m_Visible.GetSize() && (LONG)(m_Visible[gone] - m_FirstRow) < 0)
+		gone++;
+	CDWordArray selected;
+	if (gone)
+	{
+		for (int i = -1; (i = ListView_GetNextItem(m_hWnd, i, LVNI_SELECTED)) != -1; )
+			if (i >= gone)
+				selected.Add(i - gone);
+		ListView_SetItemState(m_hWnd, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+		m_Visible.RemoveAt(0, gone);
+	}
+
+	int count = (int) m_Visible.GetSize();
+	ListView_SetItemCountEx(m_hWnd, count, gone ? 0 : LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+	for (int j = 0; j < selected.GetSize(); j++)
+		ListView_SetItemState(m_hWnd, selected[j], LVIS_SELECTED, LVIS_SELECTED);
+	if (ensureVisible && count)
+		ListView_EnsureVisible(m_hWnd, count - 1, FALSE);
+
 	if (GET_P4REGPTR()->GetStatusUpdateInterval() && m_ShowStatusMsgs)
 		SendMessage(WM_SETREDRAW, FALSE, 0);
 }
 
+// Works out which rows to show again, after the filter has changed
+void CStatusView::RebuildVisible()
+{
+	m_Visible.RemoveAll();
+	for (int i = 0; i < m_RowCount; i++)
+	{
+		if (IsRowVisible(m_Rows[(m_FirstRow + i) % m_MaxStatusLines]))
+			m_Visible.Add(m_FirstRow + i);
+	}
+	m_Pending = FALSE;
+	if (!m_hWnd)
+		return;
+
+	int count = (int) m_Visible.GetSize();
+	ListView_SetItemState(m_hWnd, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+	ListView_SetItemCountEx(m_hWnd, count, 0);
+	if (count)
+		ListView_EnsureVisible(m_hWnd, count - 1, FALSE);
+	Invalidate();
+}
+
+// The nodefault flag is used so PlaySound is silent when the sound is not
+// defined.  A batch from the status log gets one sound at the end, not one
+// for every message.
+void CStatusView::PlayLevelSound(StatusView level)
+{
+	LPCTSTR sound = level == SV_WARNING ? _T("PerforceWarning") : _T("PerforceCompleted");
+	if (!m_Draining)
+		PlaySound(sound, NULL, SND_ALIAS | SND_ASYNC | SND_NOWAIT | SND_NODEFAULT);
+	else if (!m_Sound || level == SV_WARNING)
+		m_Sound = sound;
+}
+
 BOOL CStatusView::PreCreateWindow(CREATESTRUCT& cs) 
 {
-	cs.style|= LVS_NOCOLUMNHEADER | LVS_SHAREIMAGELISTS | LVS_ALIGNLEFT | LVS_REPORT;
+	cs.style|= LVS_NOCOLUMNHEADER | LVS_SHAREIMAGELISTS | LVS_ALIGNLEFT | LVS_REPORT | LVS_OWNERDATA;
 	return CListView::PreCreateWindow(cs);
 }
 
@@ -378,6 +489,14 @@ void CStatusView::OnContextMenu(CWnd* pWnd, CPoint point)
     popMenu.GetSubMenu(0)->CheckMenuItem(ID_SHOW_STATUSMSGS, MF_BYCOMMAND | 
         (GET_P4REGPTR()->GetShowStatusMsgs( ) ? MF_CHECKED : MF_UNCHECKED));
 
+
+	CMenu levelMenu;
+	levelMenu.CreatePopupMenu();
+	for (int i = 0; i < sizeof(ShowLevels) / sizeof(ShowLevels[0]); i++)
+		levelMenu.AppendMenu(MF_STRING | ((m_LevelFilter & ShowLevels[i].levels) ? MF_CHECKED : MF_UNCHECKED),
+							 ShowLevels[i].id, LoadStringResource(ShowLevels[i].text));
+	popMenu.GetSubMenu(0)->AppendMenu(MF_POPUP, (UINT_PTR) levelMenu.Detach(), LoadStringResource(IDS_STATUS_SHOWLEVELS));
+
 	popMenu.GetSubMenu(0)->TrackPopupMenu( TPM_LEFTALIGN | TPM_RIGHTBUTTON, point.x, point.y, AfxGetMainWnd( ));
 	MainFrame()->m_InPopUpMenu = FALSE;
 }
@@ -407,14 +526,43 @@ void CStatusView::CallOnUpdateViewWarnAndErrs(CCmdUI* pCmdUI)
 
 void CStatusView::OnMaxStatusLines() 
 {
-	m_MaxStatusLines = GET_P4REGPTR()->GetMaxStatusLines();
-	m_MaxSaveLines = min(2000, max(m_MaxStatusLines >> 4, 250));
-	if (m_MaxSaveLines > m_MaxStatusLines)
-		m_MaxSaveLines = m_MaxStatusLines;
+	int maxLines = GET_P4REGPTR()->GetMaxStatusLines();
+	if (maxLines == m_MaxStatusLines)
+		return;
+
+	// Keep the newest rows that fit
+	int keep = min(m_RowCount, maxLines);
+	DWORD first = m_FirstRow + m_RowCount - keep;
+	CArray<STATUSROW, STATUSROW&> rows;
+	rows.SetSize(maxLines);
+	for (int i = 0; i < keep; i++)
+		rows[(first + i) % maxLines] = m_Rows[(first + i) % m_MaxStatusLines];
+	m_Rows.Copy(rows);
+	m_FirstRow = first;
+	m_RowCount = keep;
+	m_MaxStatusLines = maxLines;
+	RebuildVisible();
+}
+
+void CStatusView::OnShowLevel(UINT nID)
+{
+	for (int i = 0; i < sizeof(ShowLevels) / sizeof(ShowLevels[0]); i++)
+	{
+		if (ShowLevels[i].id == nID)
+		{
+			if (m_LevelFilter & ShowLevels[i].levels)
+				m_LevelFilter &= ~ShowLevels[i].levels;
+			else
+				m_LevelFilter |= ShowLevels[i].levels;
+		}
+	}
+	GET_P4REGPTR()->SetStatusLevelFilter(m_LevelFilter);
+	RebuildVisible();
 }
 
 void CStatusView::OnViewWarnAndErrs() 
 {
+	m_ErrLog.Flush();
 	if (GET_P4REGPTR()->UseNotepad4WarnAndErr())
 	{
 #ifdef UNICODE
@@ -465,53 +613,45 @@ void CStatusView::OnWindowCopyselected()
 
 void CStatusView::GetPaneText( CString &txt, BOOL onlySelectedText) 
 {
-	TCHAR buf[1024];
 	txt.Empty();
 	
-	for( int i = 0;  i < ListView_GetItemCount( m_hWnd ); i++ )
+	int count = (int) m_Visible.GetSize();
+	for( int i = -1; ; )
 	{
-		if( !onlySelectedText || 
-			ListView_GetItemState( m_hWnd, i, LVIS_SELECTED ) == LVIS_SELECTED )
+		i = onlySelectedText ? ListView_GetNextItem( m_hWnd, i, LVNI_SELECTED ) : i + 1;
+		if( i < 0 || i >= count )
+			break;
+		switch( GetRowLevel( i ) )
 		{
-			ListView_GetItemText( m_hWnd, i, 0, buf, 1023 );
-
-			switch( GetListCtrl().GetItemData( i ) )
-			{
-			case SV_TOOL:
-				txt+= LoadStringResource(IDS_STATUS_TOOL); break;
-			case SV_DEBUG:
-				txt+= LoadStringResource(IDS_STATUS_DEBUG); break;
-			case SV_WARNING:
-				txt+= LoadStringResource(IDS_STATUS_WARNING); break;
-			case SV_ERROR:
-				txt+= LoadStringResource(IDS_STATUS_ERROR); break;
-			case SV_MSG:
-				txt+= LoadStringResource(IDS_STATUS_STATUS); break;
-			case SV_COMPLETION:
-			case SV_WARNSUMMARY:
-				txt+= LoadStringResource(IDS_STATUS_COMPLETION); break;
-			case SV_BLANK:
-				// Indent rows following lead row
-				txt+= _T("    "); break;
-			default:
-				break;
-			}
-			
-			txt+= buf;
-			txt+= _T("\r\n");
+		case SV_TOOL:
+			txt+= LoadStringResource(IDS_STATUS_TOOL); break;
+		case SV_DEBUG:
+			txt+= LoadStringResource(IDS_STATUS_DEBUG); break;
+		case SV_WARNING:
+			txt+= LoadStringResource(IDS_STATUS_WARNING); break;
+		case SV_ERROR:
+			txt+= LoadStringResource(IDS_STATUS_ERROR); break;
+		case SV_MSG:
+			txt+= LoadStringResource(IDS_STATUS_STATUS); break;
+		case SV_COMPLETION:
+		case SV_WARNSUMMARY:
+			txt+= LoadStringResource(IDS_STATUS_COMPLETION); break;
+		case SV_BLANK:
+			// Indent rows following lead row
+			txt+= _T("    "); break;
+		default:
+			break;
 		}
+		
+		txt+= GetRow( i ).m_Text;
+		txt+= _T("\r\n");
 	}
 }
 
 
 int CStatusView::GetSelectedCount()
 {
-	int selected= 0;
-	for( int i = 0;  i < ListView_GetItemCount( m_hWnd ); i++ )
-		if( ListView_GetItemState( m_hWnd, i, LVIS_SELECTED ) == LVIS_SELECTED )
-			selected++;
-	
-	return selected;
+	return ListView_GetSelectedCount( m_hWnd );
 }
 
 void CStatusView::OnUpdateEditSelectAll(CCmdUI* pCmdUI) 
@@ -521,9 +661,8 @@ void CStatusView::OnUpdateEditSelectAll(CCmdUI* pCmdUI)
 
 void CStatusView::OnEditSelectAll() 
 {
-	for( int i = 0;  i < ListView_GetItemCount( m_hWnd ); i++ )
-		ListView_SetItemState( m_hWnd, i, LVIS_SELECTED, LVIS_SELECTED );
-	
+	ListView_SetItemState( m_hWnd, -1, LVIS_SELECTED, LVIS_SELECTED );
+
 }
 
 void CStatusView::OnShowTimestamp() 
@@ -536,53 +675,7 @@ void CStatusView::OnShowStatusMsgs()
 {
 	m_ShowStatusMsgs = !GET_P4REGPTR()->GetShowStatusMsgs( );
 	GET_P4REGPTR()->SetShowStatusMsgs( m_ShowStatusMsgs );
-
-	int i;
-	LPTSTR p, q;
-	OnWindowClear();
-	if (m_ShowStatusMsgs)
-	{
-		CString row;
-		for (POSITION pos = m_StatusRows.GetHeadPosition(); pos != NULL; )
-		{
-			row = m_StatusRows.GetNext(pos);
-			p = row.GetBuffer(row.GetLength()+1);
-			i = _tstoi(p);
-			while (*++p != _T(' '))
-				;
-			q = p++;
-			while(*++q != _T('\r'))
-				;
-			*q = _T('\0');
-			AddOneRow(p, (StatusView)i, TRUE, FALSE, FALSE);
-		}
-	}
-	else
-	{
-		DWORD dw = GetFileSize(m_hErrFile, 0);
-		CString buf(_T('\0'), dw+1);
-		if (dw)
-		{
-			SetFilePointer(m_hErrFile, 0, 0, FILE_BEGIN);
-			if (ReadFile(m_hErrFile, p = buf.GetBuffer(dw+1), dw, &dw, 0))
-			{
-				while(*p)
-				{
-					i = _tstoi(p);
-					while (*++p != _T(' '))
-						;
-					q = p++;
-					while(*++q != _T('\r'))
-						;
-					*q = _T('\0');
-					AddOneRow(p, (StatusView)i, TRUE, FALSE, FALSE);
-					for (p = q; *++p && *p < _T(' '); )
-						;
-				}
-			}
-			SetFilePointer(m_hErrFile, 0, 0, FILE_END);
-		}
-	}
+	RebuildVisible();
 }
 
 CString CStatusView::Extract1stFilename(CString &str) 
@@ -780,9 +873,9 @@ LRESULT CStatusView::OnFindPattern(WPARAM wParam, LPARAM lParam)
 		{
 			for (j =-1; ++j < columns; )
 			{
-				ListView_GetItemText( m_hWnd, i, j, str, sizeof(str)/sizeof(TCHAR) );
+				lstrcpyn( str, GetRow(i).m_Text, sizeof(str)/sizeof(TCHAR) );
 				text = _T("");
-				switch( GetListCtrl().GetItemData( i ) )
+				switch( GetRowLevel( i ) )
 				{
 				case SV_ERROR:
 					text = LoadStringResource(IDS_STATUS_ERROR);
@@ -835,9 +928,9 @@ LRESULT CStatusView::OnFindPattern(WPARAM wParam, LPARAM lParam)
 		{
 			for (j =-1; ++j < columns; )
 			{
-				ListView_GetItemText( m_hWnd, i, j, str, sizeof(str)/sizeof(TCHAR) );
+				lstrcpyn( str, GetRow(i).m_Text, sizeof(str)/sizeof(TCHAR) );
 				text = _T("");
-				switch( GetListCtrl().GetItemData( i ) )
+				switch( GetRowLevel( i ) )
 				{
 				case SV_ERROR:
 					text = LoadStringResource(IDS_STATUS_ERROR);
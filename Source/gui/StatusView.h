@@ -4,6 +4,8 @@
 #ifndef __STATUSVIEW__
 #define __STATUSVIEW__
 
+#include "P4LogWriter.h"
+
 
 /////////////////////////////////////////////////////////////////////////////
 // CStatusView view
@@ -27,6 +29,14 @@ enum StatusView
 
 class CP4winApp;
 
+struct STATUSROW
+{
+	CString	m_Text;
+	BYTE	m_Level;		// icon to show; SV_BLANK for continuation lines
+	BYTE	m_Filter;		// level of the message the line belongs to
+	BYTE	m_Logged;		// also written to the warnings and errors file
+};
+
 class CStatusView : public CListView
 {
 public:
@@ -36,15 +46,23 @@ public:
 // Attributes
 protected:
 	int m_MaxStatusLines;
-	int m_MaxSaveLines;
-	int m_HeadIndex;
 	BOOL m_ErrFound;
 	BOOL m_RowAdded;
 	BOOL m_ShowStatusMsgs;
-	HANDLE m_hErrFile;
+	int  m_LevelFilter;			// bit per StatusView level
+	CP4LogWriter m_ErrLog;
 	CString m_ErrFile;
-	CStringList m_StatusRows;
 	CString m_ToolTipText;
+
+	// The last m_MaxStatusLines rows, as a ring; row n is at n % m_MaxStatusLines.
+	// The list is virtual, showing the rows numbered in m_Visible.
+	CArray<STATUSROW, STATUSROW&> m_Rows;
+	DWORD m_FirstRow;
+	int   m_RowCount;
+	CDWordArray m_Visible;
+	BOOL  m_Draining;
+	BOOL  m_Pending;			// rows added that the list doesn't know about yet
+	LPCTSTR m_Sound;			// sound to play when the batch is done
 	
 // Operations
 protected:
@@ -56,9 +74,16 @@ public:
 	void CallOnViewWarnAndErrs();
 	void OnMaxStatusLines();
 	void SetShowStatusMsgs(BOOL b) { m_ShowStatusMsgs = b; }
+	void DrainStatusLog();
 
 protected:
-	void AddOneRow(LPCTSTR text, StatusView level, BOOL ensureVisible, BOOL write2file, BOOL bSave=TRUE);
+	void AddOneRow(LPCTSTR text, StatusView level, StatusView filter, BOOL write2file);
+	BOOL IsRowVisible(const STATUSROW &row);
+	STATUSROW &GetRow(int item) { return m_Rows[m_Visible[item] % m_MaxStatusLines]; }
+	int  GetRowLevel(int item) { return GetRow(item).m_Level; }
+	void RebuildVisible();
+	void UpdateList(BOOL ensureVisible);
+	void PlayLevelSound(StatusView level);
 	int GetSelectedCount();
 	void GetPaneText( CString &txt, BOOL onlySelectedText); 
 	CString Extract1stFilename(CString &str);
@@ -107,7 +132,10 @@ protected:
 	afx_msg void OnSysColorChange();
 	afx_msg void OnPerforceOptions();
 	afx_msg BOOL OnToolTipText( UINT id, NMHDR * pNMHDR, LRESULT * pResult );
+	afx_msg void OnGetdispinfo(NMHDR* pNMHDR, LRESULT* pResult);
+	afx_msg void OnTimer(UINT_PTR nIDEvent);
 	//}}AFX_MSG
+	afx_msg void OnShowLevel(UINT nID);
 	LRESULT OnFindPattern(WPARAM wParam, LPARAM lParam);
 
 	DECLARE_MESSAGE_MAP()
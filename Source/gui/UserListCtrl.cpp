@@ -206,7 +206,7 @@ void CUserListCtrl::OnViewUpdate()
 {	
 	m_Active = GetSelectedItemText();
 	CCmd_Users *pCmd= new CCmd_Users;
-	pCmd->Init( m_hWnd, RUN_ASYNC);
+	InitUpdateCmd(pCmd);
 	if( pCmd->Run( ) )
 	{
         MainFrame()->UpdateStatus( LoadStringResource(IDS_REQUESTING_USER_LISTING) );
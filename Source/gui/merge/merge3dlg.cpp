@@ -44,10 +44,15 @@ CMerge3Dlg::CMerge3Dlg(CWnd* pParent /*=NULL*/)
 	m_LastWidth = 0;
 	m_pMerge= NULL;
 	m_bHeadIsText= FALSE;
+	m_pEngine= NULL;
+	m_bEngineTried= FALSE;
+	m_OrigSize= m_CheckedSize= -1;
 }
 
 CMerge3Dlg::~CMerge3Dlg()
 {
+	delete m_pEngine;
+
 	// can't use MainFrame()-> construct
 	// because mainfram might have closed.
 	CMainFrame * mainWnd = MainFrame();
@@ -126,7 +131,8 @@ BOOL CMerge3Dlg::OnInitDialog()
 	if (!GET_P4REGPTR()->GetMergeInternal())
 	{
 	    CString appName= GET_P4REGPTR()->GetMergeApp();
-		if( !appName.GetLength() )
+		// with no merge app, Run Merge previews our own merge if it can
+		if( !appName.GetLength() && !(GET_P4REGPTR()->GetQuickDiff() && m_TextualMerge) )
 			GetDlgItem(IDC_BRUNMERGE)->EnableWindow(FALSE);
     }
 
@@ -173,6 +179,11 @@ BOOL CMerge3Dlg::OnInitDialog()
 					+ FormatError(&e);
 		TheApp()->StatusAdd(msg, SV_ERROR);
 	}
+	else if (GetResultStamp(m_OrigSize, m_OrigTime))
+	{
+		m_CheckedSize = m_OrigSize;
+		m_CheckedTime = m_OrigTime;
+	}
 
 	// Save the flag that indicates if we know the head rev is TEXT
 	m_bHeadIsText = m_pMerge->GetHeadIsText();
@@ -224,7 +235,16 @@ void CMerge3Dlg::OnAcceptmerged()
 {
 	Error e;
 	StrBuf md5;
-	m_pMerge->ResultFile()->Digest(&md5, &e);
+	__int64 size;
+	FILETIME time;
+
+	// If the result file hasn't been touched since it was merged there is
+	// no need to digest it again
+	if (m_OrigSize >= 0 && GetResultStamp(size, time)
+	 && size == m_OrigSize && !CompareFileTime(&time, &m_OrigTime))
+		md5.Set(m_MD5);
+	else
+		m_pMerge->ResultFile()->Digest(&md5, &e);
 	if (e.Test())
 	{
 		CString msg = CString(_T("Skipping - Merge File Error: "))
@@ -245,6 +265,16 @@ void CMerge3Dlg::OnAcceptmerged()
 		// Is current resultfile (md5) the same as original merge file (m__MD5)?
 		if (md5.Compare(m_MD5) == 0)
 			m_pMerge->SetStatus(CMS_MERGED);
+		else if (GetEngine())	// not a pure merge; compare with yours and theirs in memory
+		{
+			CString resultName = CharToCString(m_pMerge->ResultFile()->Name());
+			if (m_pEngine->IsSameAsYours(resultName))
+				m_pMerge->SetStatus(CMS_YOURS);
+			else if (m_pEngine->IsSameAsTheirs(resultName))
+				m_pMerge->SetStatus(CMS_THEIRS);
+			else
+				m_pMerge->SetStatus(CMS_EDIT);
+		}
 		else	// not a pure merge
 		{
 			StrBuf md5_yt;
@@ -512,6 +542,11 @@ void CMerge3Dlg::OnViewtheirs()
 void CMerge3Dlg::OnRunmerge() 
 {
 	OnRadio3();
+	if (!GET_P4REGPTR()->GetMergeInternal() && GET_P4REGPTR()->GetMergeApp().IsEmpty())
+	{
+		PreviewMerge();
+		return;
+	}
 	Merge(m_pMerge->BaseFile(), m_pMerge->TheirFile(), 
 			m_pMerge->YourFile(), m_pMerge->ResultFile(),
 			m_pMerge->TheirFileName(), m_pMerge->BaseFileName() );
@@ -729,6 +764,16 @@ void CMerge3Dlg::Diff(FileSys *file1, FileSys *file2,
 	if ( isUnicode && ((file1->GetType() & FST_MASK) == FST_UTF16 
 					|| (file2->GetType() & FST_MASK) == FST_UTF16 ))
 		isUnicode = 16;
+
+	// Show text diffs in a window of our own if the user prefers that
+	CString name1 = CharToCString(file1->Name());
+	CString name2 = CharToCString(file2->Name());
+	if (GET_P4REGPTR()->GetQuickDiff() && isUnicode != 16
+	 && file1->IsTextual() && file2->IsTextual()
+	 && CP4DiffEngine::QuickDiff(name1, name2, display1 ? display1 : name1, 
+								 display2 ? display2 : name2, CP4DiffEngine::FlagsFromOptions()))
+		return;
+
 	if( !TheApp()->RunApp(DIFF_APP, RA_WAIT, m_hWnd, isUnicode, NULL, 
 								errorText, 
                                 CharToCString(file1->Name()), 
@@ -740,6 +785,17 @@ void CMerge3Dlg::Diff(FileSys *file1, FileSys *file2,
 
 void CMerge3Dlg::CheckResult()
 {
+	// Nothing to do if the result file is as it was when last scanned
+	__int64 size;
+	FILETIME time;
+	if (GetResultStamp(size, time))
+	{
+		if (size == m_CheckedSize && !CompareFileTime(&time, &m_CheckedTime))
+			return;
+		m_CheckedSize = size;
+		m_CheckedTime = time;
+	}
+
 	// Scan result file for markers and update conflict chunks
 	m_pMerge->CheckResultFile();
 	m_ConflictsRemaining = LoadStringResource(m_pMerge->IsAcceptable() ? IDS_NOCONFLICTSREMAINING 
@@ -747,6 +803,75 @@ void CMerge3Dlg::CheckResult()
 	UpdateData(FALSE);
 }
 
+//////////////////////////////////////////
+// Show the in-memory merge, conflict markers and all, without changing
+// the result file
+//
+void CMerge3Dlg::PreviewMerge()
+{
+	if (!GetEngine())
+	{
+		AfxMessageBox(IDS_CANT_MERGE_IN_MEMORY, MB_ICONEXCLAMATION);
+		return;
+	}
+
+	CStringA out;
+	m_pEngine->GetMergedText(out, m_BaseFile, m_TheirFile, m_YourFile);
+
+	CString txt;
+	CStringArray *pArgs = new CStringArray;	// MainFrame deletes it
+	txt.FormatMessage(IDS_MERGE_PREVIEW_FOR_s_n_n_n_n, 
+		(LPCTSTR) m_YourFile, m_pEngine->GetYourChunks(), 
+		m_pEngine->GetTheirChunks(), m_pEngine->GetBothChunks(), m_pEngine->GetConflictChunks());
+	pArgs->Add(txt);
+	pArgs->Add(CharToCString(out));
+	pArgs->Add(m_YourFile);
+	::PostMessage(MainFrame()->m_hWnd, WM_SHOWQUICKDIFF, 0, (LPARAM)pArgs);
+}
+
+BOOL CMerge3Dlg::GetResultStamp(__int64 &size, FILETIME &time)
+{
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	if (!GetFileAttributesEx(CharToCString(m_pMerge->ResultFile()->Name()), 
+							GetFileExInfoStandard, &fad))
+		return FALSE;
+	size = ((__int64) fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+	time = fad.ftLastWriteTime;
+	return TRUE;
+}
+
+// Loads base, theirs and yours for an in-memory merge.  Returns NULL for
+// binary and UTF-16 files, and for files over the quick diff size limit.
+CMerge3Engine *CMerge3Dlg::GetEngine()
+{
+	if (m_bEngineTried)
+		return m_pEngine;
+	m_bEngineTried = TRUE;
+
+	FileSys *base = m_pMerge->BaseFile();
+	FileSys *theirs = m_pMerge->TheirFile();
+	FileSys *yours = m_pMerge->YourFile();
+	if (!m_TextualMerge
+	 || (base->GetType() & FST_MASK) == FST_UTF16 
+	 || (theirs->GetType() & FST_MASK) == FST_UTF16
+	 || (yours->GetType() & FST_MASK) == FST_UTF16 )
+		return NULL;
+
+	CString errorText;
+	CMerge3Engine *engine = new CMerge3Engine;
+	if (!engine->LoadFiles(CharToCString(base->Name()), CharToCString(theirs->Name()),
+						   CharToCString(yours->Name()),
+						   (__int64)GET_P4REGPTR()->GetQuickDiffMaxSize() * 1024 * 1024, errorText))
+	{
+		if ( GET_P4REGPTR()->ShowCommandTrace( ) )
+			TheApp()->StatusAdd(errorText);
+		delete engine;
+		return NULL;
+	}
+	engine->Merge();
+	return m_pEngine = engine;
+}
+
 BOOL CMerge3Dlg::Verify( LPCTSTR txt )
 {
 	if(AfxMessageBox(txt, MB_ICONQUESTION|MB_YESNO) == IDYES)
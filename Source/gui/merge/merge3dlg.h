@@ -6,6 +6,7 @@
 /////////////////////////////////////////////////////////////////////////////
 // CMerge3Dlg dialog
 #include "GuiClientMerge.h"
+#include "merge3engine.h"
 #include "CoolBtn.h"
 #include "WinPos.h"
 
@@ -64,8 +65,22 @@ protected:
 	// MD5 for the original version of the m_pMerge->ResultFile()
 	StrBuf m_MD5;
 
+	// Size and write time of the result file as merged, and as last
+	// scanned for conflict markers, so unchanged files aren't reread
+	__int64 m_OrigSize;
+	FILETIME m_OrigTime;
+	__int64 m_CheckedSize;
+	FILETIME m_CheckedTime;
+
+	// In-memory merge of base, theirs and yours; loaded when first needed
+	CMerge3Engine *m_pEngine;
+	BOOL m_bEngineTried;
+
 	BOOL Verify( LPCTSTR txt );
 	void CheckResult();
+	BOOL GetResultStamp(__int64 &size, FILETIME &time);
+	CMerge3Engine *GetEngine();
+	void PreviewMerge();
 	void Diff(FileSys *file1, FileSys *file2, LPCTSTR flag1=NULL, LPCTSTR display1=NULL, LPCTSTR flag2=NULL, LPCTSTR display2=NULL);
 	BOOL Edit(FileSys *file);
 	void Merge(FileSys *base, FileSys *theirs, 
@@ -0,0 +1,242 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// merge3engine.cpp
+
+#include "stdafx.h"
+#include "p4win.h"
+#include "merge3engine.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+CMerge3Engine::CMerge3Engine()
+{
+	memset(m_Counts, 0, sizeof(m_Counts));
+}
+
+// Base is loaded once for each comparison; it is side 0 of both engines
+BOOL CMerge3Engine::LoadFiles(LPCTSTR baseName, LPCTSTR theirName, LPCTSTR yourName,
+							  __int64 maxBytes, CString &errorText)
+{
+	return m_Yours.LoadFile(0, baseName, maxBytes, errorText)
+		&& m_Yours.LoadFile(1, yourName, maxBytes, errorText)
+		&& m_Theirs.LoadFile(0, baseName, maxBytes, errorText)
+		&& m_Theirs.LoadFile(1, theirName, maxBytes, errorText);
+}
+
+int CMerge3Engine::Merge()
+{
+	m_Chunks.RemoveAll();
+	memset(m_Counts, 0, sizeof(m_Counts));
+	m_Yours.Compare();
+	m_Theirs.Compare();
+
+	int nyours = m_Yours.GetHunkCount();
+	int ntheirs = m_Theirs.GetHunkCount();
+	int nbase = m_Yours.GetLineCount(0);
+	int i = 0, j = 0;
+	int base = 0;				// first base line not yet in a chunk
+	int dyours = 0;				// yours line - base line, between hunks
+	int dtheirs = 0;			// theirs line - base line, between hunks
+
+	while (i < nyours || j < ntheirs)
+	{
+		int lo = min(i < nyours ? m_Yours.GetHunk(i).m_Start1 : INT_MAX,
+					 j < ntheirs ? m_Theirs.GetHunk(j).m_Start1 : INT_MAX);
+		if (lo > base)
+			AddChunk(MERGE_BASE, base, lo, base + dyours, lo + dyours, base + dtheirs, lo + dtheirs);
+
+		// Gather every hunk, from either side, that overlaps or touches
+		// the base lines gathered so far
+		int hi = lo;
+		int i0 = i, j0 = j;
+		BOOL more = TRUE;
+		while (more)
+		{
+			more = FALSE;
+			if (i < nyours && m_Yours.GetHunk(i).m_Start1 <= hi)
+			{
+				const DIFFHUNK &h = m_Yours.GetHunk(i++);
+				hi = max(hi, h.m_Start1 + h.m_Count1);
+				more = TRUE;
+			}
+			if (j < ntheirs && m_Theirs.GetHunk(j).m_Start1 <= hi)
+			{
+				const DIFFHUNK &h = m_Theirs.GetHunk(j++);
+				hi = max(hi, h.m_Start1 + h.m_Count1);
+				more = TRUE;
+			}
+		}
+
+		int ys = lo + dyours, ye = hi + dyours;
+		if (i > i0)
+		{
+			const DIFFHUNK &first = m_Yours.GetHunk(i0);
+			const DIFFHUNK &last = m_Yours.GetHunk(i - 1);
+			ys = first.m_Start2 - (first.m_Start1 - lo);
+			ye = last.m_Start2 + last.m_Count2 + (hi - (last.m_Start1 + last.m_Count1));
+			dyours = ye - hi;
+		}
+		int ts = lo + dtheirs, te = hi + dtheirs;
+		if (j > j0)
+		{
+			const DIFFHUNK &first = m_Theirs.GetHunk(j0);
+			const DIFFHUNK &last = m_Theirs.GetHunk(j - 1);
+			ts = first.m_Start2 - (first.m_Start1 - lo);
+			te = last.m_Start2 + last.m_Count2 + (hi - (last.m_Start1 + last.m_Count1));
+			dtheirs = te - hi;
+		}
+
+		int type;
+		if (i > i0 && j > j0)
+			type = SameLines(ys, ye - ys, ts, te - ts) ? MERGE_BOTH : MERGE_CONFLICT;
+		else
+			type = i > i0 ? MERGE_YOURS : MERGE_THEIRS;
+		AddChunk(type, lo, hi, ys, ye, ts, te);
+		base = hi;
+	}
+	if (nbase > base)
+		AddChunk(MERGE_BASE, base, nbase, base + dyours, nbase + dyours, base + dtheirs, nbase + dtheirs);
+
+	return m_Counts[MERGE_CONFLICT];
+}
+
+void CMerge3Engine::AddChunk(int type, int baseStart, int baseEnd, int yourStart, int yourEnd,
+							 int theirStart, int theirEnd)
+{
+	MERGECHUNK chunk;
+	chunk.m_Type = type;
+	chunk.m_BaseStart = baseStart;
+	chunk.m_BaseCount = baseEnd - baseStart;
+	chunk.m_YourStart = yourStart;
+	chunk.m_YourCount = yourEnd - yourStart;
+	chunk.m_TheirStart = theirStart;
+	chunk.m_TheirCount = theirEnd - theirStart;
+	m_Chunks.Add(chunk);
+	m_Counts[type]++;
+}
+
+// Both sides made the same change if the new lines match, line ends aside
+BOOL CMerge3Engine::SameLines(int yourStart, int yourCount, int theirStart, int theirCount)
+{
+	if (yourCount != theirCount)
+		return FALSE;
+
+	for (int i = 0; i < yourCount; i++)
+	{
+		const char *ytext, *ttext;
+		int ylen, tlen;
+		m_Yours.GetLineText(1, yourStart + i, ytext, ylen);
+		m_Theirs.GetLineText(1, theirStart + i, ttext, tlen);
+		while (ylen && (ytext[ylen - 1] == '\n' || ytext[ylen - 1] == '\r'))
+			ylen--;
+		while (tlen && (ttext[tlen - 1] == '\n' || ttext[tlen - 1] == '\r'))
+			tlen--;
+		if (ylen != tlen || memcmp(ytext, ttext, ylen))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+void CMerge3Engine::AppendLines(CStringA &out, CP4DiffEngine &diff, int side, int start, int count)
+{
+	for (int i = start; i < start + count; i++)
+	{
+		const char *text;
+		int len;
+		diff.GetLineText(side, i, text, len);
+		out.Append(text, len);
+	}
+}
+
+// Builds the merged file: all the non-conflicting changes, and for each
+// conflict the base, their and your lines between markers
+void CMerge3Engine::GetMergedText(CStringA &out, LPCTSTR baseLabel, LPCTSTR theirLabel, LPCTSTR yourLabel)
+{
+	// Markers get the same line ends as the file
+	const char *text;
+	int len;
+	const char *eol = "\n";
+	if (m_Yours.GetLineCount(1))
+	{
+		m_Yours.GetLineText(1, 0, text, len);
+		if (len > 1 && text[len - 2] == '\r')
+			eol = "\r\n";
+	}
+
+	out.Empty();
+	out.Preallocate((int) m_Yours.GetSize(1) + 1024);
+	for (int c = 0; c < GetChunkCount(); c++)
+	{
+		const MERGECHUNK &chunk = m_Chunks[c];
+		switch (chunk.m_Type)
+		{
+		case MERGE_BASE:
+			AppendLines(out, m_Yours, 0, chunk.m_BaseStart, chunk.m_BaseCount);
+			break;
+		case MERGE_YOURS:
+		case MERGE_BOTH:
+			AppendLines(out, m_Yours, 1, chunk.m_YourStart, chunk.m_YourCount);
+			break;
+		case MERGE_THEIRS:
+			AppendLines(out, m_Theirs, 1, chunk.m_TheirStart, chunk.m_TheirCount);
+			break;
+		case MERGE_CONFLICT:
+			if (!out.IsEmpty() && out[out.GetLength() - 1] != '\n')
+				out += eol;
+			out += ">>>> ORIGINAL ";
+			out += (const char *) CharFromCString(baseLabel);
+			out += eol;
+			AppendLines(out, m_Yours, 0, chunk.m_BaseStart, chunk.m_BaseCount);
+			if (out[out.GetLength() - 1] != '\n')
+				out += eol;
+			out += "==== THEIRS ";
+			out += (const char *) CharFromCString(theirLabel);
+			out += eol;
+			AppendLines(out, m_Theirs, 1, chunk.m_TheirStart, chunk.m_TheirCount);
+			if (out[out.GetLength() - 1] != '\n')
+				out += eol;
+			out += "==== YOURS ";
+			out += (const char *) CharFromCString(yourLabel);
+			out += eol;
+			AppendLines(out, m_Yours, 1, chunk.m_YourStart, chunk.m_YourCount);
+			if (out[out.GetLength() - 1] != '\n')
+				out += eol;
+			out += "<<<<";
+			out += eol;
+			break;
+		}
+	}
+}
+
+// Compares a file with the second side of a comparison, already in memory.
+// Most of the time the sizes differ and the file need not be read at all.
+BOOL CMerge3Engine::IsSameAs(CP4DiffEngine &diff, LPCTSTR fileName)
+{
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	if (!GetFileAttributesEx(fileName, GetFileExInfoStandard, &fad))
+		return FALSE;
+	__int64 size = ((__int64) fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+	if (size != diff.GetSize(1))
+		return FALSE;
+
+	HANDLE hFile;
+	if ((hFile = CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+				0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0)) == INVALID_HANDLE_VALUE)
+		return FALSE;
+	char *buf = new char[(size_t) size + 1];
+	DWORD NumberOfBytesRead = 0;
+	BOOL b = ReadFile(hFile, buf, (DWORD) size, &NumberOfBytesRead, NULL)
+		  && NumberOfBytesRead == (DWORD) size
+		  && diff.SameText(1, buf, size);
+	CloseHandle(hFile);
+	delete [] buf;
+	return b;
+}
@@ -0,0 +1,73 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// merge3engine.h
+//
+// CMerge3Engine does a three-way merge of text files in memory.  Base is
+// compared with yours and with theirs using CP4DiffEngine, and the two sets
+// of hunks are walked together over the base lines.  Each stretch of the
+// base comes out as a chunk: unchanged, changed only in yours, changed only
+// in theirs, changed the same way in both, or changed differently in each
+// (a conflict).  The merged text takes every non-conflicting change and
+// marks the conflicts the way "p4 resolve" does.
+
+#ifndef __MERGE3ENGINE__
+#define __MERGE3ENGINE__
+
+#include "P4DiffEngine.h"
+
+#define MERGE_BASE		0		// chunk types
+#define MERGE_YOURS		1
+#define MERGE_THEIRS	2
+#define MERGE_BOTH		3
+#define MERGE_CONFLICT	4
+
+// Line ranges (0-based) of a chunk in each of the three files
+struct MERGECHUNK
+{
+	int m_Type;
+	int m_BaseStart;
+	int m_BaseCount;
+	int m_YourStart;
+	int m_YourCount;
+	int m_TheirStart;
+	int m_TheirCount;
+};
+
+class CMerge3Engine
+{
+public:
+	CMerge3Engine();
+
+protected:
+	CP4DiffEngine m_Yours;		// base vs yours
+	CP4DiffEngine m_Theirs;		// base vs theirs
+	CArray<MERGECHUNK, MERGECHUNK&> m_Chunks;
+	int m_Counts[MERGE_CONFLICT + 1];
+
+public:
+	BOOL LoadFiles(LPCTSTR baseName, LPCTSTR theirName, LPCTSTR yourName,
+				   __int64 maxBytes, CString &errorText);
+	int  Merge();				// returns the number of conflicts
+
+	int GetChunkCount() { return (int) m_Chunks.GetSize(); }
+	int GetYourChunks() { return m_Counts[MERGE_YOURS]; }
+	int GetTheirChunks() { return m_Counts[MERGE_THEIRS]; }
+	int GetBothChunks() { return m_Counts[MERGE_BOTH]; }
+	int GetConflictChunks() { return m_Counts[MERGE_CONFLICT]; }
+
+	void GetMergedText(CStringA &out, LPCTSTR baseLabel, LPCTSTR theirLabel, LPCTSTR yourLabel);
+	BOOL IsSameAsYours(LPCTSTR fileName) { return IsSameAs(m_Yours, fileName); }
+	BOOL IsSameAsTheirs(LPCTSTR fileName) { return IsSameAs(m_Theirs, fileName); }
+
+protected:
+	void AddChunk(int type, int baseStart, int baseEnd, int yourStart, int yourEnd,
+				  int theirStart, int theirEnd);
+	BOOL SameLines(int yourStart, int yourCount, int theirStart, int theirCount);
+	void AppendLines(CStringA &out, CP4DiffEngine &diff, int side, int start, int count);
+	BOOL IsSameAs(CP4DiffEngine &diff, LPCTSTR fileName);
+};
+
+#endif //__MERGE3ENGINE__
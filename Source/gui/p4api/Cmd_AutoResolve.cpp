@@ -8,6 +8,7 @@
 #include "stdafx.h"
 #include "p4win.h"
 #include "cmd_autoresolve.h"
+#include "P4ResolvePreview.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -23,6 +24,12 @@ CCmd_AutoResolve::CCmd_AutoResolve(CGuiClient *client) : CP4Command(client)
 {
 	m_ReplyMsg= WM_P4AUTORESOLVE;
 	m_TaskName= "AutoResolve";
+	m_pLocalPreview= NULL;
+}
+
+CCmd_AutoResolve::~CCmd_AutoResolve()
+{
+	delete m_pLocalPreview;
 }
 
 BOOL CCmd_AutoResolve::Run(CStringList *files, int type, BOOL preview, BOOL force, 
@@ -59,7 +66,18 @@ BOOL CCmd_AutoResolve::Run(CStringList *files, int type, BOOL preview, BOOL forc
 		break;
 	}
 	if(preview)
+	{
+		// Have the server name the base of each merge (2004.2 or later), so
+		// the merges can be previewed here in detail.  The "their file"
+		// lookups use a preview too, but only want the first line of it.
+		if(GET_P4REGPTR()->GetResolvePreviewThreads() && GET_SERVERLEVEL() >= 18
+		 && m_ReplyMsg == WM_P4AUTORESOLVE)
+		{
+			m_pLocalPreview= new CP4ResolvePreview;
+			m_BaseArgs=AddArg(_T("-o"));
+		}
 		m_BaseArgs=AddArg(_T("-n"));
+	}
 	if(force)
 		m_BaseArgs=AddArg(_T("-f"));
 	if(textmerge)
@@ -108,6 +126,8 @@ void CCmd_AutoResolve::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 		TheApp()->StatusAdd(temp);
 		if(m_Preview)
 			m_StrListOut.AddHead(data);
+		if(m_pLocalPreview)
+			m_pLocalPreview->AddMergeMessage(data);
 		processedOutput=TRUE;
 	}
 	else if(StrStr(data, _T(" - binary/binary merge")))
@@ -152,6 +172,15 @@ void CCmd_AutoResolve::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 		CP4Command::OnOutputInfo(level, data, msg);
 }
 
+// The local merge preview is left to the caller to start once the server
+// lock is released, and outlives the command
+CP4ResolvePreview *CCmd_AutoResolve::DetachLocalPreview()
+{
+	CP4ResolvePreview *preview= m_pLocalPreview;
+	m_pLocalPreview= NULL;
+	return preview;
+}
+
 
 // Wrenched out of dmtypes.cc
 static LPCTSTR DmtIntegHowFmt[] = { 
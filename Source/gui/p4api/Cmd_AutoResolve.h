@@ -8,21 +8,26 @@
 
 #include "P4Command.h"
 
+class CP4ResolvePreview;
+
 class CCmd_AutoResolve : public CP4Command
 {
     // Construction
 public:
     CCmd_AutoResolve(CGuiClient *client=NULL);
+    ~CCmd_AutoResolve();
     DECLARE_DYNCREATE(CCmd_AutoResolve)
 				    
     BOOL Run(CStringList *files, int type, BOOL preview, BOOL force, BOOL textmerge, int whtSp);
 	    
     CStringList *GetList() { return &m_StrListOut; }
     BOOL IsPreview() { return m_Preview; }
+    CP4ResolvePreview *DetachLocalPreview();
 
     // Attributes	
 protected:
     BOOL m_Preview;
+    CP4ResolvePreview *m_pLocalPreview;		// per-file chunk counts for a preview
     BOOL IsValidMergeMessage(CString const & data);
 
     // CP4Command overrides
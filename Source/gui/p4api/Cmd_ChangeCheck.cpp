@@ -0,0 +1,157 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// Cmd_ChangeCheck.cpp
+
+#include "stdafx.h"
+#include "p4win.h"
+#include "Cmd_ChangeCheck.h"
+#include "Cmd_MaxChange.h"
+#include "Cmd_Opened.h"
+#include "Cmd_Describe.h"
+#include "Cmd_Clients.h"
+#include "P4Client.h"
+#include "md5.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+IMPLEMENT_DYNCREATE(CCmd_ChangeCheck, CP4Command)
+
+
+CCmd_ChangeCheck::CCmd_ChangeCheck(CGuiClient *client) : CP4Command(client)
+{
+	m_ReplyMsg= WM_P4CHANGECHECK;
+	m_TaskName= _T("ChangeCheck");
+	m_State.m_MaxSubmitted= m_State.m_MaxChange= 0;
+	m_State.m_OpenedCount= 0;
+	m_State.m_OpenedChecked= m_State.m_ClientChecked= FALSE;
+	m_CheckOpened= TRUE;
+}
+
+BOOL CCmd_ChangeCheck::Run( BOOL checkOpened )
+{
+	m_CheckOpened= checkOpened;
+	return CP4Command::Run();
+}
+
+void CCmd_ChangeCheck::PreProcess(BOOL& done)
+{
+	Error e;
+	BOOL b;
+	done=TRUE;
+
+	// Newest submitted change - anything new in the depot pane
+	// has to come with one of these
+	CCmd_MaxChange cmd1(m_pClient);
+	cmd1.Init(NULL, RUN_SYNC);
+	b= cmd1.Run( TRUE ) && !cmd1.GetError();
+	cmd1.CloseConn(&e);
+	if(!b)
+	{
+		m_ErrorTxt= "Unable to Run MaxChange";
+		m_FatalError=TRUE;
+		return;
+	}
+	m_State.m_MaxSubmitted= cmd1.GetMaxChange();
+
+	// Newest change of any status - a new pending change
+	CCmd_MaxChange cmd2(m_pClient);
+	cmd2.Init(NULL, RUN_SYNC);
+	b= cmd2.Run( FALSE ) && !cmd2.GetError();
+	cmd2.CloseConn(&e);
+	if(!b)
+	{
+		m_ErrorTxt= "Unable to Run MaxChange";
+		m_FatalError=TRUE;
+		return;
+	}
+	m_State.m_MaxChange= cmd2.GetMaxChange();
+
+	// When the client spec was last changed - a new view or root
+	// means everything has to be fetched again.  Newer servers list
+	// just this client; older ones only give it with the whole spec,
+	// so that is fetched along with the opened files
+	if( GET_SERVERLEVEL() >= 26 )	// 2008.2 or later?
+	{
+		CCmd_Clients cmd4(m_pClient);
+		cmd4.Init(NULL, RUN_SYNC);
+		b= cmd4.Run( GET_P4REGPTR()->GetP4Client() ) && !cmd4.GetError();
+		cmd4.CloseConn(&e);
+
+		// A client that doesn't exist yet isn't listed, and has no Update time
+		CObList *list= cmd4.GetList();
+		if( b && !list->IsEmpty() )
+			m_State.m_ClientUpdate= ((CP4Client *) list->GetHead())->GetDate();
+		while( !list->IsEmpty() )
+			delete (CP4Client *) list->RemoveHead();
+		if(!b)
+		{
+			m_ErrorTxt= "Unable to Run Clients";
+			m_FatalError=TRUE;
+			return;
+		}
+		m_State.m_ClientChecked= TRUE;
+	}
+	else if( m_CheckOpened )
+	{
+		CCmd_Describe cmd4(m_pClient);
+		cmd4.Init(NULL, RUN_SYNC);
+		b= cmd4.Run( P4CLIENT_SPEC, GET_P4REGPTR()->GetP4Client() ) && !cmd4.GetError();
+		cmd4.CloseConn(&e);
+		if(!b)
+		{
+			m_ErrorTxt= "Unable to Run Client";
+			m_FatalError=TRUE;
+			return;
+		}
+		m_State.m_ClientUpdate= TheApp()->GetClientSpecField( _T("Update"), cmd4.GetDescription() );
+		m_State.m_ClientChecked= TRUE;
+	}
+
+	if( !m_CheckOpened )
+		return;
+
+	// Files opened on this client.  Keep a digest rather than the list,
+	// so moving a file between changes or changing its action shows up
+	// even when the count stays the same
+	CCmd_Opened cmd3(m_pClient);
+	cmd3.Init(NULL, RUN_SYNC);
+	b= cmd3.Run( FALSE ) && !cmd3.GetError();
+	cmd3.CloseConn(&e);
+
+	MD5 md5;
+	StrBuf buf;
+	StrBuf hash;
+	CObList *list= cmd3.GetList();
+	m_State.m_OpenedCount= (int) list->GetCount();
+	for( POSITION pos= list->GetHeadPosition(); pos!= NULL; )
+	{
+		CP4FileStats *stats= (CP4FileStats *) list->GetNext(pos);
+		if(b)
+		{
+			CString str;
+			str.Format(_T("%s#%ld#%d#%d\n"), stats->GetFullDepotPath(), 
+				stats->GetOpenChangeNum(), stats->GetMyOpenAction(), stats->IsMyLock());
+			buf.Set(CharFromCString(str));
+			md5.Update(buf);
+		}
+		delete stats;
+	}
+	list->RemoveAll();
+	if(!b)
+	{
+		m_ErrorTxt= "Unable to Run Opened";
+		m_FatalError=TRUE;
+		return;
+	}
+	md5.Final(hash);
+	m_State.m_OpenedDigest= CharToCString(hash.Text());
+	m_State.m_OpenedChecked= TRUE;
+}
@@ -0,0 +1,46 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// Cmd_ChangeCheck.h
+//
+// Gathers the few numbers that say whether the depot and changes panes
+// could be out of date: the newest submitted change, the newest change of
+// any status, the files opened on this client and when the client spec was
+// last updated.  The auto-poll compares them with the last check and only
+// refreshes the panes whose inputs moved.  The opened files are the costly
+// part, so they are only checked when asked for.
+
+#include "P4Command.h"
+
+struct CHANGESTATE
+{
+	long	m_MaxSubmitted;		// newest submitted change
+	long	m_MaxChange;		// newest change, pending or submitted
+	BOOL	m_OpenedChecked;	// FALSE if the next two weren't fetched
+	int		m_OpenedCount;		// files opened on this client
+	CString	m_OpenedDigest;		// MD5 of their paths, changes and actions
+	BOOL	m_ClientChecked;	// FALSE if the next one wasn't fetched
+	CString	m_ClientUpdate;		// client spec Update field
+};
+
+class CCmd_ChangeCheck : public CP4Command
+{
+    // Construction
+public:
+    CCmd_ChangeCheck(CGuiClient *client=NULL);
+    DECLARE_DYNCREATE(CCmd_ChangeCheck)
+
+    BOOL Run( BOOL checkOpened );
+
+    const CHANGESTATE &GetState() const { return m_State; }
+
+protected:
+    // Attributes
+    CHANGESTATE m_State;
+	BOOL m_CheckOpened;
+
+    // CP4Command overrides
+    virtual void PreProcess(BOOL& done);
+};
@@ -113,7 +113,10 @@ void CCmd_Changes::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 	// Parse into a CP4Change and send that back
 	CP4Change *change= new CP4Change;
 	if( change->Create(data) )
+	{
        	m_Changes.Add(change);
+		GET_CHANGEINDEX()->Add(change);
+	}
     else
     {
         #ifdef _DEBUG
@@ -129,7 +132,10 @@ void CCmd_Changes::OnOutputStat( StrDict *varList )
 {
 	CP4Change *change= new CP4Change;
 	if( change->Create(varList) )
+	{
        	m_Changes.Add(change);
+		GET_CHANGEINDEX()->Add(change);
+	}
     else
     {
         #ifdef _DEBUG
@@ -26,10 +26,15 @@ CCmd_Clients::CCmd_Clients(CGuiClient *client) : CP4Command(client)
 	m_TaskName= _T("Clients");
 }
 
-BOOL CCmd_Clients::Run()
+BOOL CCmd_Clients::Run(LPCTSTR nameFilter /*=NULL*/)
 {
 	ClearArgs();
 	AddArg(_T("clients"));
+	if( nameFilter && GET_SERVERLEVEL() >= 26 )	// 2008.2 or later?
+	{
+		AddArg(_T("-e"));
+		AddArg(nameFilter);
+	}
 
 	m_UsedTagged = GET_SERVERLEVEL() >= 8 ? TRUE : FALSE;
 
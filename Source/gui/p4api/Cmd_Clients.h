@@ -15,7 +15,7 @@ public:
     CCmd_Clients(CGuiClient *client=NULL);
     DECLARE_DYNCREATE(CCmd_Clients)
 				    
-    BOOL Run();
+    BOOL Run(LPCTSTR nameFilter=NULL);
 
     CObList *GetList() { return &m_List; }			
 
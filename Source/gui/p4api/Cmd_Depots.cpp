@@ -263,6 +263,7 @@ void CCmd_Depots::PostProcess()
     {
         // get client spec, and set NOCRLF flag and Client root in app
         TheApp()->m_bNoCRLF = IsLFonly(cmd.GetDescription());
+        TheApp()->m_ClientLineEnd = TheApp()->GetClientSpecField( _T("LineEnd"), cmd.GetDescription());
         TheApp()->Set_m_ClientRoot(TheApp()->GetClientSpecField( _T("Root"), cmd.GetDescription()));
 		if (GET_SERVERLEVEL() >= 22)
 	        TheApp()->Set_m_ClientSubOpts(TheApp()->GetClientSpecField( _T("SubmitOptions"), cmd.GetDescription()));
@@ -270,6 +271,7 @@ void CCmd_Depots::PostProcess()
     else
     {
 		TheApp()->m_ClientRoot.Empty();
+		TheApp()->m_ClientLineEnd.Empty();
         m_ErrorTxt= LoadStringResource(IDS_UNABLE_TO_GET_CLIENT_DESCRIPTION);
         m_FatalError=TRUE;
 		return;
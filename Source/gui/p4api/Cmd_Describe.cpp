@@ -20,7 +20,6 @@ static char THIS_FILE[] = __FILE__;
 IMPLEMENT_DYNCREATE(CCmd_Describe, CP4Command)
 
 
-
 CCmd_Describe::CCmd_Describe(CGuiClient *client) : CP4Command(client)
 {
 	m_ReplyMsg= WM_P4DESCRIBE;
@@ -28,6 +27,8 @@ CCmd_Describe::CCmd_Describe(CGuiClient *client) : CP4Command(client)
 	m_Flag = 0;
 	m_bLong = FALSE;
 	m_CallingListCtrl = NULL;
+	m_CacheChange = 0;
+	m_FromCache = FALSE;
 }
 
 BOOL CCmd_Describe::Run(int descType, LPCTSTR reference, 
@@ -124,20 +125,32 @@ BOOL CCmd_Describe::Run(int descType, LPCTSTR reference,
 	}
 	else m_Reference = _T("");
 	m_Description=_T("");
+	m_Text.Empty();
+
+	// Output for a change number may come from the describe cache
+	if (m_SpecType == P4DESCRIBE && !m_Reference.IsEmpty() 
+	 && m_Reference.SpanIncluding(_T("0123456789")) == m_Reference
+	 && GET_REVCACHE()->IsEnabled())
+	{
+		m_CacheChange = _ttol(m_Reference);
+		m_CacheVariant = _T("describe");
+		for (int i = 1; i < GetArgc() - 1; i++)
+			m_CacheVariant += GetArgv(i);
+	}
 
 	return CP4Command::Run();
 }
 
 void CCmd_Describe::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 {
-	m_Description += data;
-    m_Description += g_CRLF;
+	m_Text.Append(data);
+	m_Text.Append(g_CRLF);
 }
 
 void CCmd_Describe::OnOutputText(LPCTSTR data, int length)
 {
-	CString txt(data, length);
-	m_Description += txt + g_CRLF;
+	m_Text.Append(data, length);
+	m_Text.Append(g_CRLF);
 }
 
 void CCmd_Describe::OnOutputStat( StrDict *varList )
@@ -146,6 +159,13 @@ void CCmd_Describe::OnOutputStat( StrDict *varList )
 
 void CCmd_Describe::PostProcess()
 {
+	TakeText();
+
+	// Only a submitted change is worth keeping; a pending one can change any time
+	if (m_CacheChange && !m_FromCache && !m_Description.IsEmpty()
+	 && m_Description.SpanExcluding(_T("\r\n")).Find(_T("*pending*")) == -1)
+		GET_REVCACHE()->StoreText(GetCacheKey(), m_Description);
+
 	//		Lose the trailing crlf 
 	//
 	int len=m_Description.GetLength();
@@ -233,8 +253,8 @@ BOOL CCmd_Describe::HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg)
 		WideCharToMultiByte(CP_ACP, 0, utf16, -1, buf, len, NULL, NULL);
 
 		// append to description
-		m_Description += buf;
-		m_Description += g_CRLF;
+		m_Text.Append(buf);
+		m_Text.Append(g_CRLF);
 
 		::VirtualFree(buf, 0, MEM_RELEASE);
 		::VirtualFree(utf16, 0, MEM_RELEASE);
@@ -248,3 +268,47 @@ BOOL CCmd_Describe::HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg)
 	}
 	return handledError;
 }
+
+
+////////////////////////////////////////////////////////////////////////////
+// Describe cache support
+//
+// A submitted change's files and diffs never change, but its description,
+// user and client can still be edited.  Asking the server for the change
+// spec to check each cached describe would cost about as much as the
+// describe itself, so instead the cached describes of a change are dropped
+// whenever P4Win edits it.
+
+CString CCmd_Describe::GetCacheKey()
+{
+	return CP4RevCache::MakeKey(CharToCString(m_pClient->GetPort().Text()), 
+								_T("change"), m_CacheChange, m_CacheVariant);
+}
+
+// We just edited the change, so its cached describes are out of date
+void CCmd_Describe::ChangeEdited(long changeNum)
+{
+	CString suffix;
+	suffix.Format(_T("|change#%ld"), changeNum);
+	GET_REVCACHE()->RemoveKeysEndingWith(suffix);
+}
+
+void CCmd_Describe::PreProcess(BOOL& done)
+{
+	done = FALSE;
+	if (!m_CacheChange)
+		return;
+
+	if (GET_REVCACHE()->FetchText(GetCacheKey(), m_Description))
+	{
+		if ( GET_P4REGPTR()->ShowCommandTrace( ) )
+		{
+			CString temp;
+			temp.Format(_T("Retrieved change %ld from the local describe cache"), m_CacheChange);
+			TheApp()->StatusAdd(temp);
+		}
+		m_FromCache = done = TRUE;
+	}
+	else
+		m_Description.Empty();
+}
@@ -10,6 +10,7 @@
 //
 
 #include "P4Command.h"
+#include "P4TextBuffer.h"
 
 
 class CCmd_Describe : public CP4Command
@@ -21,9 +22,9 @@ public:
 
     BOOL Run(int descType, LPCTSTR reference, LPCTSTR templateName=NULL, BOOL force=FALSE, int flag=0, BOOL uFlag=FALSE);
     LPCTSTR GetReference() const { return m_Reference; }
-    LPCTSTR GetDescription() const { return m_Description; }
+    LPCTSTR GetDescription() { TakeText(); return m_Description; }
 	void SetCaller(CWnd *caller) { m_Caller = caller; }
-    void SetDescription(CString str) { m_Description= str; }
+    void SetDescription(CString str) { m_Text.Empty(); m_Description= str; }
     void SetSpecStr(LPCTSTR str) { m_SpecStr= str; }
 	void SetListCtrl(CWnd *plc) { m_CallingListCtrl = plc; }
 	void SetSpecDescDlg(CWnd *pWnd) { m_SpecDescDlg = pWnd; }
@@ -34,6 +35,8 @@ public:
     BOOL IsLongSpec() const { return m_bLong; }
 	int GetSpecType() { return m_SpecType; }
 	int GetFlag() { return m_Flag; }
+	BOOL IsFromCache() { return m_FromCache; }
+	static void ChangeEdited(long changeNum);
 
     // Attributes	
 protected:
@@ -42,12 +45,22 @@ protected:
 	CWnd * m_SpecDescDlg;
     CString m_Reference;
     CString m_Description;
+    CP4TextBuffer m_Text;		// output as it comes in, not yet added to m_Description
     CString m_SpecStr;
     int m_SpecType;
 	int m_Flag;
     BOOL m_bLong;
+
+	// Describe cache support
+	long m_CacheChange;			// submitted change number, if the output is cacheable
+	CString m_CacheVariant;
+	BOOL m_FromCache;
+
+	void TakeText() { m_Text.AppendTo(m_Description); m_Text.Empty(); }
+	CString GetCacheKey();
 	    
     // CP4Command overrides
+	virtual void PreProcess(BOOL& done);
     virtual void OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg);
     virtual void OnOutputText(LPCTSTR data, int length);
     virtual void OnOutputStat( StrDict *varList );
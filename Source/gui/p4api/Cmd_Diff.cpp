@@ -10,6 +10,8 @@
 #include <sys\stat.h>
 #include "p4win.h"
 #include "cmd_diff.h"
+#include "P4DiffEngine.h"
+#include "P4StreamDiff.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -150,6 +152,29 @@ void CCmd_Diff::Diff( FileSys *f1, FileSys *f2, int doPage, char * diffFlags, Er
 		CString fname1 = CharToCString(f1->Name());
 		CString fname2 = CharToCString(f2->Name());
 		CString errorText;
+
+		// Show plain text diffs in a window of our own, unless a diff
+		// program has been set up for this kind of file
+		if (GET_P4REGPTR()->GetQuickDiff() && isUnicode != 16
+		 && GET_P4REGPTR()->GetAssociatedDiff(GetFilesExtension(fname2)).IsEmpty())
+		{
+			CString label1 = fname2;
+			int i;
+			if ((i = label1.ReverseFind(_T('\\'))) != -1)
+				label1 = label1.Mid(i+1);
+			label1 += LoadStringResource(IDS__IN_DEPOT);
+			int flags = diffFlags && *diffFlags ? CP4DiffEngine::FlagsFromString(diffFlags)
+												: CP4DiffEngine::FlagsFromOptions();
+
+			// The comparison is all local, so let other commands run meanwhile
+			if (!m_HoldServerLock)
+				ReleaseServerLock();
+			if (CP4StreamDiff::IsLarge(fname1, fname2)
+					? CP4StreamDiff::StreamDiff(fname1, fname2, label1, fname2, flags)
+					: CP4DiffEngine::QuickDiff(fname1, fname2, label1, fname2, flags))
+				return;
+		}
+
 		RunAppMode mode;
 		RUNAPPTHREADINFO *lprati;
 		if (f1->IsDeleteOnClose() || f2->IsDeleteOnClose())
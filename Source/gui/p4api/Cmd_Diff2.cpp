@@ -10,6 +10,10 @@
 #include "cmd_diff2.h"
 #include "cmd_prepbrowse.h"
 #include "cmd_where.h"
+#include "cmd_folderstat.h"
+#include "P4FolderCompare.h"
+#include "P4DiffEngine.h"
+#include "P4StreamDiff.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -25,6 +29,12 @@ CCmd_Diff2::CCmd_Diff2(CGuiClient *client) : CP4Command(client)
 {
 	m_ReplyMsg= WM_P4DIFF2;
 	m_TaskName= _T("Diff2");
+	m_pFolderCompare= NULL;
+}
+
+CCmd_Diff2::~CCmd_Diff2()
+{
+	delete m_pFolderCompare;
 }
 
 
@@ -61,10 +71,12 @@ void CCmd_Diff2::PreProcess(BOOL& done)
 	m_InfoText.Empty();
 
 	// If we are going to actually run the command on the server
-	// then there is no preprocessing to do.
+	// then there is no preprocessing to do - unless the server can give
+	// us digests, in which case folders are compared here instead.
 	if (m_DoIt)
 	{
-		done=FALSE;
+		done= GET_SERVERLEVEL() >= 19 && GET_P4REGPTR()->GetLocalFolderCompare()
+			&& CompareFolders();
 		return;
 	}
 
@@ -245,7 +257,18 @@ void CCmd_Diff2::PreProcess(BOOL& done)
 			buf2.Format(_T("%s#%ld"), m_FileName[1], m_FileRev[1]);
 		else
 			buf2.Format(_T("%s"), m_FileName[1]);
-		if( !TheApp()->RunApp(DIFF_APP, RA_NOWAIT, NULL, isUnicode, NULL, 
+		BOOL bQuick = GET_P4REGPTR()->GetQuickDiff() && isTextual1 && isTextual2 
+				&& isUnicode != 16 && GET_P4REGPTR()->GetAssociatedDiff(GetFilesExtension(fn2)).IsEmpty();
+
+		// Both revisions are printed; the comparison is all local, so let
+		// other commands run meanwhile
+		if (bQuick && !m_HoldServerLock)
+			ReleaseServerLock();
+		bQuick = bQuick
+				&& (CP4StreamDiff::IsLarge(fn1, fn2)
+					? CP4StreamDiff::StreamDiff(fn1, fn2, buf1, buf2, CP4DiffEngine::FlagsFromOptions())
+					: CP4DiffEngine::QuickDiff(fn1, fn2, buf1, buf2, CP4DiffEngine::FlagsFromOptions()));
+		if( !bQuick && !TheApp()->RunApp(DIFF_APP, RA_NOWAIT, NULL, isUnicode, NULL, 
 								errorText, fn1, fn2, _T("-l"), buf1, _T("-r"), buf2) )
 		TheApp()->StatusAdd(errorText, SV_ERROR );
 	}
@@ -257,6 +280,65 @@ void CCmd_Diff2::PreProcess(BOOL& done)
 	done=TRUE;
 }
 
+// Lists both folders with fstat and compares the lists.  Returns FALSE if
+// diff2 should be run after all.
+BOOL CCmd_Diff2::CompareFolders()
+{
+	if (m_FileName[0].Find(_T("...")) == -1 || m_FileName[1].Find(_T("...")) == -1)
+		return FALSE;
+
+	Error e;
+	BOOL success;
+	CP4FolderCompare *pCompare = new CP4FolderCompare;
+	for (int side = 0; side < 2; side++)
+	{
+		CString folder = CP4FolderCompare::FolderFromSpec(m_FileName[side]);
+		if (folder.Left(2) != _T("//"))		// local syntax
+		{
+			folder.TrimRight(_T('\\'));
+			CCmd_Where cmd(m_pClient);
+			cmd.Init(NULL, RUN_SYNC, HOLD_LOCK);
+			success = cmd.Run(folder) && !cmd.GetError() && cmd.GetDepotFiles()->GetCount();
+			if (success)
+				folder = cmd.GetDepotSyntax() + _T('/');
+			cmd.CloseConn(&e);
+			if (!success)
+			{
+				delete pCompare;
+				return FALSE;
+			}
+		}
+		pCompare->SetFolder(side, folder);
+
+		CCmd_FolderStat cmd(m_pClient);
+		cmd.Init(NULL, RUN_SYNC, HOLD_LOCK);
+		success = cmd.Run(m_FileName[side], pCompare, side) && !cmd.GetError();
+		cmd.CloseConn(&e);
+		if (!success)
+		{
+			delete pCompare;
+			return FALSE;
+		}
+	}
+
+	pCompare->Compare();
+	TheApp()->StatusAdd(pCompare->GetSummary());
+	if (!pCompare->GetRowCount())
+	{
+		TheApp()->StatusAdd(LoadStringResource(IDS_NOFILESDIFFER), SV_COMPLETION);
+		delete pCompare;
+	}
+	else if (m_Output2Dlg)
+		m_pFolderCompare = pCompare;		// for the caller's dialog
+	else
+	{
+		for (int row = 0; row < pCompare->GetRowCount(); row++)
+			TheApp()->StatusAdd(pCompare->GetRowText(row));
+		delete pCompare;
+	}
+	return TRUE;
+}
+
 void CCmd_Diff2::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 {
 	if (m_DoIt && level == _T('0'))
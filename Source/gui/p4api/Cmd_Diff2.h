@@ -9,12 +9,14 @@
 
 #include "P4Command.h"
 
+class CP4FolderCompare;
 
 class CCmd_Diff2 : public CP4Command
 {
     // Construction
 public:
     CCmd_Diff2(CGuiClient *client=NULL);
+    ~CCmd_Diff2();
     DECLARE_DYNCREATE(CCmd_Diff2)
 
     BOOL Run(LPCTSTR file1, LPCTSTR file2, 
@@ -26,6 +28,8 @@ public:
 	void SetOutput2Dlg(BOOL b) { m_Output2Dlg = b; }
 	BOOL IsOutput2Dlg() { return m_Output2Dlg; }
 	CString &GetFileName(int i) { return m_FileName[i ? 1 : 0]; }
+	CP4FolderCompare *DetachFolderCompare() 
+		{ CP4FolderCompare *p = m_pFolderCompare; m_pFolderCompare = NULL; return p; }
 
 protected:
     CString m_InfoText;
@@ -35,9 +39,11 @@ protected:
 	BOOL m_LocalFlag[2];
 	BOOL m_DoIt;
 	BOOL m_Output2Dlg;
+	CP4FolderCompare *m_pFolderCompare;	// folder diff done on the client
 		    
     // CP4Command overrides
     virtual void PreProcess(BOOL& done);
+	BOOL CompareFolders();
 	virtual void OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg);
 	virtual BOOL HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg);
 };
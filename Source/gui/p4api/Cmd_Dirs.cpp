@@ -85,6 +85,31 @@ BOOL CCmd_Dirs::Run( CStringList *specList, BOOL bShowEntireDepot )
 	return CP4Command::Run( );
 }
 
+// Lists the subfolders a sync of spec can touch: with bHaveOnly, those
+// holding files the client has, otherwise those in the client view holding
+// files, deleted or not, at the head revision
+BOOL CCmd_Dirs::RunForSync( LPCTSTR spec, BOOL bHaveOnly )
+{
+	ClearArgs( );
+	m_BaseArgs= AddArg( _T("dirs") );
+
+	if ( bHaveOnly )
+		m_BaseArgs= AddArg( _T("-H") );
+	else
+	{
+		m_BaseArgs= AddArg ( g_sClientViewOnly );
+		m_BaseArgs= AddArg( g_ShowDeletedFiles );
+	}
+
+	m_SpecList.RemoveAll();
+	m_SpecList.AddHead( spec );
+	m_posStrListIn= m_SpecList.GetHeadPosition();
+	m_pStrListIn= &m_SpecList;
+	NextListArgs();
+
+	return CP4Command::Run( );
+}
+
 
 /*
 	_________________________________________________________________
@@ -24,6 +24,7 @@ public:
     CStringList *GetErrors() { return &m_ErrorList; }
     BOOL Run( LPCTSTR spec, BOOL bShowEntireDepot);
     BOOL Run( CStringList *specList, BOOL bShowEntireDepot ); 
+    BOOL RunForSync( LPCTSTR spec, BOOL bHaveOnly );
 
     int GetUpdateType() const { return m_UpdateType; }
     BOOL GetFullUpdate() const { return m_FullUpdate; }
@@ -0,0 +1,76 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// Cmd_FolderStat.cpp
+
+#include "stdafx.h"
+#include "p4win.h"
+#include "cmd_folderstat.h"
+#include "P4FolderCompare.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+
+IMPLEMENT_DYNCREATE(CCmd_FolderStat, CP4Command)
+
+
+CCmd_FolderStat::CCmd_FolderStat(CGuiClient *client) : CP4Command(client)
+{
+	m_ReplyMsg= WM_P4FSTAT;
+	m_TaskName= _T("FolderStat");
+	m_pCompare= NULL;
+	m_Side= 0;
+}
+
+// Needs a 2005.1 or later server for the digests
+BOOL CCmd_FolderStat::Run(LPCTSTR spec, CP4FolderCompare *pCompare, int side)
+{
+	ASSERT(GET_SERVERLEVEL() >= 19);
+	m_pCompare= pCompare;
+	m_Side= side;
+
+	ClearArgs();
+	AddArg(_T("fstat"));
+	AddArg(_T("-Ol"));
+	AddArg(spec);
+			
+	return CP4Command::Run();
+}
+
+void CCmd_FolderStat::OnOutputStat( StrDict *varList )
+{
+	// Check for possible abort request
+	if(APP_ABORTING())
+	{
+		ReleaseServerLock();
+		ExitThread(0);
+	}
+
+	StrPtr *depotFile= varList->GetVar( "depotFile" );
+	StrPtr *headRev= varList->GetVar( "headRev" );
+	if (!depotFile || !headRev)
+		return;
+	StrPtr *headType= varList->GetVar( "headType" );
+	StrPtr *headAction= varList->GetVar( "headAction" );
+	StrPtr *digest= varList->GetVar( "digest" );
+	StrPtr *fileSize= varList->GetVar( "fileSize" );
+
+	m_pCompare->AddFile(m_Side, CharToCString(depotFile->Value()), atol(headRev->Value()),
+		headType ? CharToCString(headType->Value()) : CString(_T("text")),
+		headAction ? CharToCString(headAction->Value()) : CString(),
+		digest ? CharToCString(digest->Value()) : CString(),
+		fileSize ? _atoi64(fileSize->Value()) : -1);
+}
+
+BOOL CCmd_FolderStat::HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg)
+{
+	// An empty folder is just a folder with every file on the other side
+	return StrStr(errBuf, _T("no such file")) != 0 
+		|| StrStr(errBuf, _T(" - file(s) not in client view")) != 0;
+}
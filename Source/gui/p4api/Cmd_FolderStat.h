@@ -0,0 +1,32 @@
+//
+// Copyright 1997 Nicholas J. Irias.  All rights reserved.
+//
+//
+
+// Cmd_FolderStat.h   
+//
+// Runs "fstat -Ol" on a folder and hands each file, with its digest,
+// to one side of a CP4FolderCompare
+
+#include "P4Command.h"
+
+class CP4FolderCompare;
+
+class CCmd_FolderStat : public CP4Command
+{
+    // Construction
+public:
+    CCmd_FolderStat(CGuiClient *client=NULL);
+    DECLARE_DYNCREATE(CCmd_FolderStat)
+				    
+    BOOL Run(LPCTSTR spec, CP4FolderCompare *pCompare, int side);
+
+    // Attributes	
+protected:
+    CP4FolderCompare *m_pCompare;
+    int m_Side;
+
+    // CP4Command overrides
+	virtual void OnOutputStat( StrDict *varList );
+	virtual BOOL HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg);
+};
@@ -8,6 +8,8 @@
 #include "stdafx.h"
 #include "p4win.h"
 #include "cmd_get.h"
+#include "cmd_dirs.h"
+#include "cmd_maxchange.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -29,6 +31,15 @@ CCmd_Get::CCmd_Get(CGuiClient *client) : CP4Command(client)
 	m_bOpeningForEdit = FALSE;
 	m_RevHistWnd = 0;
 	m_RevReq = 0;
+	m_pProgress = &m_Progress;
+	m_Threads = 0;
+	m_pParent = NULL;
+	m_Worker = 0;
+	m_ShardWorkers = 0;
+	m_NextWorker = 0;
+	m_ShardCancel = 0;
+	m_FilesShard = FALSE;
+	m_CachedFiles = 0;
 }
 
 BOOL CCmd_Get::Run(CStringList *files, BOOL whatIf, BOOL bRefresh )
@@ -39,6 +50,11 @@ BOOL CCmd_Get::Run(CStringList *files, BOOL whatIf, BOOL bRefresh )
 	m_OutputRows= 0;
 
 	m_WhatIf= whatIf;
+	m_bRefresh= bRefresh;
+
+	// Tagged output can be decoded without guessing at the text, and
+	// carries the file sizes needed for the progress rates
+	m_UsedTagged = GET_SERVERLEVEL() >= 20;		// 2005.2 or later?
 
 	// Set the base of arg list
 	ClearArgs();
@@ -48,6 +64,25 @@ BOOL CCmd_Get::Run(CStringList *files, BOOL whatIf, BOOL bRefresh )
 		m_BaseArgs=AddArg(_T("-n"));
 	if ( bRefresh )
 		m_BaseArgs = AddArg( _T("-f") );
+
+	// Have the server send files over several connections at once
+	int threads = GET_P4REGPTR()->GetSyncThreads();
+	if(!whatIf && threads > 1 && GET_SERVERLEVEL() >= 37)	// 2014.1 or later?
+	{
+		CString str;
+		str.Format(_T("--parallel=threads=%d"), threads);
+		m_BaseArgs = AddArg( str );
+	}
+	else
+		threads = 0;
+	m_Threads = threads;
+
+	// A shard worker takes its files from the parent's shards, and counts
+	// them in the parent's progress
+	if (m_pParent)
+		return NextShard() && CP4Command::Run();
+
+	m_Progress.Start(1, threads);
 	
 	if (files)
 	{
@@ -61,6 +96,49 @@ BOOL CCmd_Get::Run(CStringList *files, BOOL whatIf, BOOL bRefresh )
 	return CP4Command::Run();
 }
 
+// Takes the part of a preview that was answered without the server (see
+// CP4SyncPreview), so the reply covers all the files.  Call before Run().
+void CCmd_Get::SetCachedPreview(CP4SyncPreview *preview)
+{
+	CString prefix = LoadStringResource(IDS_SYNC_PREVIEW);
+	CStringList *list = preview->GetGetList();
+	for (POSITION pos = list->GetHeadPosition(); pos != NULL; )
+	{
+		CString line = list->GetNext(pos);
+		TheApp()->StatusAdd(prefix + line + _T(" (cached)"));
+		m_GetList.AddHead(line);
+	}
+	list = preview->GetRemoveList();
+	for (POSITION pos = list->GetHeadPosition(); pos != NULL; )
+	{
+		CString line = list->GetNext(pos);
+		TheApp()->StatusAdd(prefix + line + _T(" (cached)"));
+		m_RemoveList.AddHead(line);
+	}
+	m_AddCount += preview->GetAddCount();
+	m_CachedFiles = preview->GetCount();
+}
+
+// When the cache answered the whole preview there is nothing to run, so
+// reply as if the command had
+void CCmd_Get::PostCachedPreview()
+{
+	ASSERT(m_ReplyWnd != NULL);
+	m_WhatIf = TRUE;
+	ReportCachedPreview(TRUE);
+	::PostMessage( m_ReplyWnd, m_ReplyMsg, (WPARAM) this, 0);
+}
+
+void CCmd_Get::ReportCachedPreview(BOOL all)
+{
+	CString txt;
+	if (!all)
+		txt.Format(_T("Sync preview: %d files answered from cached state, the rest by the server"), m_CachedFiles);
+	else
+		txt.Format(_T("Sync preview: all %d files answered from cached state"), m_CachedFiles);
+	TheApp()->StatusAdd(txt);
+}
+
 void CCmd_Get::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 {
 	CString prefix;
@@ -116,6 +194,283 @@ void CCmd_Get::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 }
 
 
+// A tagged sync record, e.g.
+//   depotFile //depot/main/file.c  clientFile c:\ws\main\file.c
+//   rev 5  action updated  fileSize 1234
+// The first record of each sync also has totalFileCount and totalFileSize.
+// Each file goes on the get or remove list as the untagged line would have.
+void CCmd_Get::OnOutputStat( StrDict *varList )
+{
+	StrPtr *str;
+	if ((str = varList->GetVar( "totalFileCount" )) != NULL)
+	{
+		StrPtr *size = varList->GetVar( "totalFileSize" );
+		m_pProgress->AddTotals(atoi(str->Value()), size ? _atoi64(size->Value()) : 0);
+	}
+
+	StrPtr *depotFile = varList->GetVar( "depotFile" );
+	StrPtr *clientFile = varList->GetVar( "clientFile" );
+	StrPtr *rev = varList->GetVar( "rev" );
+	StrPtr *action = varList->GetVar( "action" );
+	if (!depotFile || !clientFile || !rev || !action)
+		return;
+
+	m_OutputRows++;
+
+	CString act = CharToCString(action->Value());
+	CString line;
+	if (act == _T("added"))
+	{
+		line.Format(_T("%s#%s - added as %s"), CharToCString(depotFile->Value()),
+			CharToCString(rev->Value()), CharToCString(clientFile->Value()));
+		m_GetList.AddHead(line);
+		m_AddCount++;
+	}
+	else if (act == _T("deleted"))
+	{
+		line.Format(_T("%s#%s - deleted as %s"), CharToCString(depotFile->Value()),
+			CharToCString(rev->Value()), CharToCString(clientFile->Value()));
+		m_RemoveList.AddHead(line);
+	}
+	else
+	{
+		line.Format(act == _T("refreshed") ? _T("%s#%s - refreshing %s") : _T("%s#%s - updating %s"),
+			CharToCString(depotFile->Value()), CharToCString(rev->Value()),
+			CharToCString(clientFile->Value()));
+		m_GetList.AddHead(line);
+	}
+
+	str = varList->GetVar( "fileSize" );
+	m_pProgress->FileDone(m_Worker, str ? _atoi64(str->Value()) : 0);
+
+	// A preview is for seeing the files, so it still lists them
+	if(m_WhatIf)
+		TheApp()->StatusAdd(LoadStringResource(IDS_SYNC_PREVIEW) + line);
+	else
+		m_pProgress->Publish();
+}
+
+// Runs the sync as shards over several connections when that is turned on
+// and the sync is of whole folders.  The workers do all the syncing, so the
+// command itself has nothing left to run.
+void CCmd_Get::PreProcess(BOOL& done)
+{
+	if (m_pParent || !m_UsedTagged || GET_P4REGPTR()->GetSyncConnections() < 2
+	 || !m_pStrListIn || !m_pStrListIn->IsEmpty() || !MakeShards())
+		return;
+
+	if (RunShards())
+		done = TRUE;
+	else
+		m_Shards.RemoveAll();
+}
+
+// A shard worker goes on to the next shard until there are none left
+void CCmd_Get::ProcessResults(BOOL& done)
+{
+	if (m_pParent)
+		done = !NextShard();
+	else
+		CP4Command::ProcessResults(done);
+}
+
+void CCmd_Get::PostProcess()
+{
+	if(m_WhatIf && m_CachedFiles)
+		ReportCachedPreview(FALSE);
+	if(!m_pParent && m_UsedTagged && !m_WhatIf && m_Progress.GetFiles())
+	{
+		if (!m_ShardWorkers)
+			m_Progress.WorkerDone(0);
+		m_Progress.Clear();
+		TheApp()->StatusAdd(m_Progress.GetSummary());
+		for (int i = 0; i < m_ShardWorkers; i++)
+			TheApp()->StatusAdd(m_Progress.GetWorkerSummary(i));
+	}
+}
+
+// Splits the sync into a shard per subfolder of each folder being synced,
+// plus one for the files directly in the folder.  Only a sync whose every
+// argument is a folder, e.g. "//depot/main/..." or "//depot/main/...@1234",
+// can be split.  A folder given without a revision is synced to the latest
+// submitted change as of now, so that every shard syncs to the same point
+// however long the others take.  Returns FALSE if there would be fewer
+// than two shards.
+BOOL CCmd_Get::MakeShards()
+{
+	m_Shards.RemoveAll();
+	if (GetArgc() <= m_BaseArgs)
+		return FALSE;
+
+	CString head;
+
+	for (int i = m_BaseArgs; i < GetArgc(); i++)
+	{
+		CString spec = GetArgv(i);
+		int dots = spec.Find(_T("/..."));
+		if (dots < 0)
+			dots = spec.Find(_T("\\..."));
+		if (dots < 0)
+			return FALSE;
+		CString rev = spec.Mid(dots + 4);
+		if (!rev.IsEmpty() && rev[0] != _T('#') && rev[0] != _T('@'))
+			return FALSE;
+		if (rev.IsEmpty())
+		{
+			if (head.IsEmpty())
+			{
+				CCmd_MaxChange cmd(m_pClient);
+				cmd.Init(NULL, RUN_SYNC);
+				if (!cmd.Run(TRUE) || cmd.GetError() || cmd.GetMaxChange() <= 0)
+					return FALSE;
+				head.Format(_T("@%d"), cmd.GetMaxChange());
+			}
+			rev = head;
+		}
+		if (!AddFolderShards(spec.Left(dots + 1), rev))
+			return FALSE;
+	}
+	return m_Shards.GetCount() > 1;
+}
+
+// folder ends with its separator.  Asks for the subfolders of both what the
+// client has and what is in the view, so that a shard exists for everything
+// the sync could add, update or delete.  The folder's own files are a shard
+// too; if it turns out to have none, the worker ignores the "no such file"
+// that shard gets back.
+BOOL CCmd_Get::AddFolderShards(LPCTSTR folder, LPCTSTR rev)
+{
+	CStringList dirs;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		CCmd_Dirs cmd;
+		cmd.SetIndependent(&m_ShardCancel);
+		cmd.Init(NULL, RUN_SYNC);
+		if (!cmd.RunForSync(CString(folder) + _T("*"), pass == 0) || cmd.GetError())
+			return FALSE;
+		CStringList *list = cmd.GetList();
+		for (POSITION pos = list->GetHeadPosition(); pos != NULL; )
+		{
+			CString dir = list->GetNext(pos);
+			if (!dirs.Find(dir))
+				dirs.AddTail(dir);
+		}
+	}
+
+	for (POSITION pos = dirs.GetHeadPosition(); pos != NULL; )
+		m_Shards.AddTail(dirs.GetNext(pos) + _T("/...") + rev);
+
+	// The depot root holds no files of its own
+	if (CString(folder) != _T("//"))
+		m_Shards.AddTail(CString(folder) + _T("*") + rev);
+	return TRUE;
+}
+
+// Starts a worker for each connection that is free, up to SyncConnections,
+// and waits for them all.  Each worker's connection counts against the
+// ConnectionLimit that all independent commands share.  Returns 0 if it
+// couldn't start at least two, leaving the caller to sync the usual way.
+int CCmd_Get::RunShards()
+{
+	int n = min(min(GET_P4REGPTR()->GetSyncConnections(), (int) m_Shards.GetCount()),
+					MAXSYNCWORKERS);
+	n = min(n, GetFreeConnections());
+	if (n < 2)
+		return 0;
+
+	m_Progress.Start(n, m_Threads);
+	m_NextWorker = 0;
+	m_ShardCancel = 0;
+
+	CWinThread *threads[MAXSYNCWORKERS];
+	HANDLE handles[MAXSYNCWORKERS];
+	int started;
+	for (started = 0; started < n; started++)
+	{
+		threads[started] = AfxBeginThread(ShardThread, (LPVOID) this,
+					THREAD_PRIORITY_NORMAL, 0, CREATE_SUSPENDED, NULL);
+		if (!threads[started])
+			break;
+		threads[started]->m_bAutoDelete = FALSE;	// we wait on the handle
+		handles[started] = threads[started]->m_hThread;
+		threads[started]->ResumeThread();
+	}
+	m_ShardWorkers = started;
+	if (!started)
+		return 0;
+
+	// The workers don't look at global_cancel, so pass a cancel on to them
+	while (WaitForMultipleObjects(started, handles, TRUE, 250) == WAIT_TIMEOUT)
+	{
+		if (global_cancel || APP_ABORTING())
+		{
+			global_cancel = 0;
+			InterlockedExchange(&m_ShardCancel, 1);
+		}
+	}
+	while (started--)
+		delete threads[started];
+	return m_ShardWorkers;
+}
+
+UINT CCmd_Get::ShardThread(LPVOID pParam)
+{
+	CCmd_Get *parent = (CCmd_Get *) pParam;
+	CCmd_Get cmd;
+	cmd.m_pParent = parent;
+	cmd.m_pProgress = &parent->m_Progress;
+	cmd.m_Worker = InterlockedIncrement(&parent->m_NextWorker) - 1;
+	cmd.SetIndependent(&parent->m_ShardCancel);
+	cmd.Init(NULL, RUN_SYNC);
+	cmd.SetRunIntegAfterSync(parent->m_bIntegAfterSync);
+	cmd.SetOpenAfterSync(parent->m_bOpenAfterSync);
+	cmd.SetOpeningForEdit(parent->m_bOpeningForEdit);
+	cmd.Run(NULL, parent->m_WhatIf, parent->m_bRefresh);
+
+	parent->m_Progress.WorkerDone(cmd.m_Worker);
+	parent->MergeShard(&cmd);
+	return 0;
+}
+
+BOOL CCmd_Get::NextShard()
+{
+	CString shard;
+	m_pParent->m_ShardLock.Lock();
+	BOOL b = !m_pParent->m_ShardCancel && !m_pParent->m_Shards.IsEmpty();
+	if (b)
+		shard = m_pParent->m_Shards.RemoveHead();
+	m_pParent->m_ShardLock.Unlock();
+
+	if (b)
+	{
+		ClearArgs(m_BaseArgs);
+		AddArg(shard);
+		m_FilesShard = shard.Find(_T("...")) == -1;
+	}
+	return b;
+}
+
+// Adds a worker's results to this sync's, so the caller updates the views
+// once for the whole sync.  A worker that failed is reported as a warning,
+// since the other shards may well have synced.
+void CCmd_Get::MergeShard(CCmd_Get *worker)
+{
+	m_ShardLock.Lock();
+	m_GetList.AddTail(&worker->m_GetList);
+	m_RemoveList.AddTail(&worker->m_RemoveList);
+	m_Warnings.Append(worker->m_Warnings);
+	m_AddCount += worker->m_AddCount;
+	m_OutputRows += worker->m_OutputRows;
+	if (worker->GetError())
+	{
+		CString txt = worker->GetErrorText();
+		if (txt.IsEmpty())
+			txt = _T("a sync connection failed");
+		m_Warnings.Add(txt);
+	}
+	m_ShardLock.Unlock();
+}
+
 void CCmd_Get::OnOutputError(char level, LPCTSTR errBuf, LPCTSTR errMsg)
 {
 	CString txt(errBuf);
@@ -137,6 +492,8 @@ void CCmd_Get::OnOutputError(char level, LPCTSTR errBuf, LPCTSTR errMsg)
 		TheApp()->StatusAdd(msg);  // Not really an error
 	else if ((IsRunIntegAfterSync()) && (txt.Find(_T("no such file"))>=0))
 		;										// Not really an error if sync for integ
+	else if (m_FilesShard && txt.Find(_T("no such file"))>=0)
+		;										// The folder has only subfolders
 	else if(txt.Find(_T("Can't clobber writeable file")) >=0 ||
 	   txt.Find(_T("can't create directory for")) >=0 ||
 	   txt.Find(_T("filename, directory name, or volume label syntax is incorrect")) >=0 )
@@ -7,6 +7,8 @@
 //
 
 #include "P4Command.h"
+#include "P4SyncProgress.h"
+#include "P4SyncPreview.h"
 
 class CCmd_Get : public CP4Command
 {
@@ -16,6 +18,8 @@ public:
     DECLARE_DYNCREATE(CCmd_Get)
 				    
     BOOL Run(CStringList *files, BOOL whatIf, BOOL bRefresh = FALSE );
+    void SetCachedPreview(CP4SyncPreview *preview);
+    void PostCachedPreview();
 
     CStringList *GetGetList() { return &m_GetList; }
     CStringList *GetRecover() { return &m_Recover; }
@@ -37,6 +41,8 @@ public:
 	int  GetRevReq() { return m_RevReq; }
 	void Add2SelSet(HTREEITEM item) { m_SelectionSet.Add(item); }
 	CPtrArray *GetSelectionSet() { return &m_SelectionSet; }
+	CP4SyncProgress *GetProgress() { return &m_Progress; }
+	int GetShardWorkers() const { return m_ShardWorkers; }
 
     // Attributes	
 protected:
@@ -53,7 +59,28 @@ protected:
     int m_OutputRows;
     CStringArray m_Warnings;
 
+    // Totals and rates for a tagged sync, which reports these
+    // instead of a status line per file
+    CP4SyncProgress m_Progress;
+    CP4SyncProgress *m_pProgress;	// the parent's, in a shard worker
+    int m_Threads;
+
+    // A sync of a big folder can be split by subfolder into shards, which
+    // workers on their own connections take one at a time until there are
+    // none left (see SyncConnections).  Each worker is a CCmd_Get whose
+    // m_pParent is the sync that made the shards; the workers' results go
+    // into the parent's lists, so to the caller it is one sync.
+    CCmd_Get *m_pParent;
+    int m_Worker;					// index into the progress workers
+    int m_ShardWorkers;				// workers this sync ran, 0 if not sharded
+    LONG m_NextWorker;
+    CStringList m_Shards;
+    BOOL m_FilesShard;				// this worker's shard is a folder's own files
+    CCriticalSection m_ShardLock;	// for m_Shards and merging results
+    volatile LONG m_ShardCancel;
+
     BOOL m_WhatIf;
+    int m_CachedFiles;		// preview files answered from the depot pane's stats
     BOOL m_bRefresh;
     BOOL m_bIntegAfterSync;
     BOOL m_bOpenAfterSync;
@@ -66,9 +93,20 @@ protected:
 	int	 m_RevReq;
 
     void RemoveLastFromGetList();
+    void ReportCachedPreview(BOOL all);
+    BOOL MakeShards();
+    BOOL AddFolderShards(LPCTSTR folder, LPCTSTR rev);
+    int RunShards();
+    BOOL NextShard();
+    void MergeShard(CCmd_Get *worker);
+    static UINT ShardThread(LPVOID pParam);
 
     // CP4Command overrides
     virtual void OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg);
+    virtual void OnOutputStat( StrDict *varList );
+    virtual void PreProcess(BOOL& done);
+    virtual void ProcessResults(BOOL& done);
+    virtual void PostProcess();
     virtual void OnOutputError(char level, LPCTSTR errBuf, LPCTSTR errMsg);
 };
 
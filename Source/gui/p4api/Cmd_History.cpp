@@ -35,6 +35,9 @@ CCmd_History::CCmd_History(CGuiClient *client) : CP4Command(client)
 	m_WriteToTempFile = FALSE;
 	m_pOutputFile = NULL;
 	m_KeyToHold = 0;
+	m_HeadChange = m_HeadRev = 0;
+	m_MaxRevs = m_TopRevs = 0;
+	m_Incremental = m_DropLive = m_FromCache = FALSE;
 }
 
 CCmd_History::~CCmd_History()
@@ -106,6 +109,27 @@ BOOL CCmd_History::Run(LPCTSTR fileSpec)
 	}
 	AddArg(fileSpec);
 
+	// Tagged output comes already split into fields, so there is no text to
+	// pick apart for each revision
+	m_UsedTagged = GET_SERVERLEVEL() >= 14;
+
+	// A depot file's history may come from the filelog cache
+	m_CacheSpec.Empty();
+	m_CacheRecords.Empty();
+	m_Cached.Empty();
+	m_HeadChange = m_HeadRev = 0;
+	m_MaxRevs = TheApp()->m_RevHistLast;
+	m_TopRevs = 0;
+	m_Incremental = m_DropLive = m_FromCache = FALSE;
+	if (m_IsAFile && GET_REVCACHE()->IsEnabled() && !_tcsncmp(fileSpec, _T("//"), 2)
+	 && !_tcspbrk(fileSpec, _T("@#*%")) && !_tcsstr(fileSpec, _T("...")))
+	{
+		m_CacheSpec = fileSpec;
+		m_CacheVariant = m_UsedTagged ? _T("history-ztag") : _T("history");
+		for (i = 1; i < GetArgc() - 1; i++)
+			m_CacheVariant += GetArgv(i);
+	}
+
 	m_TextOut.Empty();
 	m_BranchInfo.Empty();
 
@@ -157,6 +181,8 @@ void CCmd_History::PreProcess(BOOL &done)
 			m_pOutputFile=NULL;
 			done=TRUE;
 		}
+		else if (!m_CacheSpec.IsEmpty() && GetHeadInfo())
+			UseCache(done);
 		return;
 	}			// end of write to temp file code; normal operation follows
 	
@@ -179,6 +205,8 @@ void CCmd_History::PreProcess(BOOL &done)
 					delete fs;
 				}
 			}
+			if (!m_CacheSpec.IsEmpty() && GetHeadInfo())
+				UseCache(done);
 			return;
 		}
 	}
@@ -191,43 +219,17 @@ void CCmd_History::PreProcess(BOOL &done)
 
 void CCmd_History::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 {
-	// if we are to just write this to a temp file,
-	// write the data to a new line and we are done.
-	if (m_WriteToTempFile)
-	{
-		CString str = data;
-		StrBuf sptr;
-		Error e;
-		if (str[0] == _T('/'))
-			str += _T('\n');
-		else if (str[0] == _T('#'))
-			str = _T("... ") + str;
-		else if (str[0] > _T(' '))
-			str = _T("... ... ") + str + _T("\n\n");
-		sptr.Set(const_cast<char*>((const char*)CharFromCString(str)));
-		m_pOutputFile->Write( &sptr, &e );
-		if(e.Test())
-			m_FatalError= TRUE;
-		return;
-	}
-
-	// Server spews filename, followed by changedescription,
-	// followed optionally by branchinfo
+	// Untagged output (older servers): server spews filename, followed by
+	// changedescription, followed optionally by branchinfo
 	switch(level)
 	{
 	case '0': 
-		if( !m_TextOut.IsEmpty() )
-			m_History.AddRevision(m_FileName, m_FileNbr, m_TextOut, m_BranchInfo);
-		m_TextOut.Empty();
-		m_BranchInfo.Empty();
-		m_FileName= data;
-		m_FileNbr++;
+		FlushRevision();
+		NewFile(data);
 		break;
 	case '1':
-		if( !m_TextOut.IsEmpty() )
-			m_History.AddRevision(m_FileName, m_FileNbr, m_TextOut, m_BranchInfo);
+		FlushRevision();
 		m_TextOut= data;
-		m_BranchInfo.Empty();
 		break;
 	case '2':
 		if( !m_BranchInfo.IsEmpty() )
@@ -239,8 +241,126 @@ void CCmd_History::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 	}
 }
 
+// Tagged output: one record per file, holding all of its revisions
+void CCmd_History::OnOutputStat( StrDict *varList )
+{
+	StrPtr *str = varList->GetVar( "depotFile" );
+	if (!str)
+		return;
+
+	NewFile(CharToCString(str->Value()));
+	for (int n = 0; ; n++)
+	{
+		CRevision *rev = new CRevision;
+		if (!rev->Create(m_FileName, m_FileNbr, varList, n))
+		{
+			delete rev;
+			break;
+		}
+		AddRevision(rev);
+	}
+}
+
+void CCmd_History::FlushRevision()
+{
+	if( !m_TextOut.IsEmpty() )
+	{
+		CRevision *rev = new CRevision;
+		if (rev->Create(m_FileName, m_FileNbr, m_TextOut, m_BranchInfo))
+			AddRevision(rev);
+		else
+			delete rev;
+	}
+	m_TextOut.Empty();
+	m_BranchInfo.Empty();
+}
+
+// Every file and revision, whether from the server or the filelog cache,
+// comes through NewFile() and AddRevision()
+void CCmd_History::NewFile(LPCTSTR fileName)
+{
+	if (!m_CacheSpec.IsEmpty())
+	{
+		// An incremental fetch only wants the first file's new revisions;
+		// everything after them is already in the cache
+		if (m_Incremental && m_FileNbr > 0)
+			m_DropLive = TRUE;
+		if (m_DropLive)
+			return;
+		if (!m_FromCache)
+		{
+			m_CacheRecords += _T('f');
+			CacheField(fileName);
+		}
+	}
+
+	m_FileName= fileName;
+	m_FileNbr++;
+
+	if (m_WriteToTempFile)
+		WriteTempText(m_FileName + _T('\n'));
+}
+
+void CCmd_History::AddRevision(CRevision *rev)
+{
+	if (!m_CacheSpec.IsEmpty())
+	{
+		if (m_DropLive)
+		{
+			delete rev;
+			return;
+		}
+		if (m_FileNbr == 1)
+			m_TopRevs++;
+		if (!m_FromCache)
+		{
+			CString num;
+			m_CacheRecords += _T('r');
+			num.Format(_T("%d"), rev->m_RevisionNum);
+			CacheField(num);
+			num.Format(_T("%d"), rev->m_ChangeNum);
+			CacheField(num);
+			CacheField(rev->m_Date);
+			CacheField(rev->m_User);
+			CacheField(rev->m_ChangeType);
+			CacheField(rev->m_ChangeDescription);
+		}
+	}
+
+	// if we are to just write this to a temp file,
+	// write the revision as filelog would show it and we are done.
+	if (m_WriteToTempFile)
+	{
+		WriteTempText(rev->GetFilelogText());
+		delete rev;
+	}
+	else
+		m_History.AddRevision(rev);
+}
+
+void CCmd_History::WriteTempText(LPCTSTR text)
+{
+	StrBuf sptr;
+	Error e;
+	CString str = text;
+	sptr.Set(const_cast<char*>((const char*)CharFromCString(str)));
+	m_pOutputFile->Write( &sptr, &e );
+	if(e.Test())
+		m_FatalError= TRUE;
+}
+
 void CCmd_History::PostProcess()
 {
+	// Catch any straggler data 
+	FlushRevision();
+
+	// An incremental fetch got the newest revisions; the rest come from the cache
+	if (!m_Cached.IsEmpty())
+	{
+		Replay(m_Cached, TRUE);
+		m_Cached.Empty();
+	}
+
 	// if we are to just write this to a temp file,
 	// close the file and we are done.
 	if (m_WriteToTempFile)
@@ -250,9 +370,14 @@ void CCmd_History::PostProcess()
 		m_pOutputFile->Close(&e);
 	}
 
-	// Catch any straggler data 
-	if( !m_TextOut.IsEmpty() )
-		m_History.AddRevision(m_FileName, m_FileNbr, m_TextOut, m_BranchInfo);
+	// Keep the whole history, tagged with the head it goes up to
+	if (!m_CacheSpec.IsEmpty() && !m_FromCache && m_HeadChange > 0 && m_FileNbr > 0)
+	{
+		CString header;
+		header.Format(_T("%ld\t%ld\n"), m_HeadChange, m_HeadRev);
+		GET_REVCACHE()->StoreText(GetCacheKey(), header + m_CacheRecords);
+	}
+	m_CacheRecords.Empty();
 }
 
 BOOL CCmd_History::HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg)
@@ -267,3 +392,155 @@ BOOL CCmd_History::HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg)
 
 	return handledError;
 }
+
+
+////////////////////////////////////////////////////////////////////////////
+// Filelog cache support
+//
+// A file's history only ever grows at the head, so the filelog output for
+// a depot file is cached along with the head change and revision it goes
+// up to, as the fstat that every history starts with reports them.  If the
+// head hasn't moved, the cached output is replayed and the server is not
+// asked at all.  If it has, only the newer revisions are fetched, and the
+// cached output is replayed below them.
+//
+// The cached history is a run of records, 'f' for a file name and 'r' for
+// a revision, each followed by its fields.  A field is its length, a colon
+// and the text itself, so multi-line descriptions need no escaping.  The
+// first line of the entry holds the head change and revision.
+
+CString CCmd_History::GetCacheKey()
+{
+	return CP4RevCache::MakeKey(CharToCString(m_pClient->GetPort().Text()), 
+								m_CacheSpec, 0, m_CacheVariant);
+}
+
+BOOL CCmd_History::GetHeadInfo()
+{
+	if (m_pFileStats)
+	{
+		m_HeadChange = m_pFileStats->GetHeadChangeNum();
+		m_HeadRev = m_pFileStats->GetHeadRev();
+	}
+	else
+	{
+		Error e;
+		CCmd_Fstat cmd(m_pClient);
+		cmd.Init(NULL, RUN_SYNC);
+		if (cmd.Run(TRUE, m_CacheSpec, TRUE) && !cmd.GetError())
+		{
+			CObList *list = cmd.GetFileList();
+			if (list->GetCount() == 1)
+			{
+				CP4FileStats *stats = (CP4FileStats *) list->GetHead();
+				m_HeadChange = stats->GetHeadChangeNum();
+				m_HeadRev = stats->GetHeadRev();
+			}
+			for (POSITION pos = list->GetHeadPosition(); pos != NULL; )
+				delete list->GetNext(pos);
+			list->RemoveAll();
+		}
+		cmd.CloseConn(&e);
+	}
+	return m_HeadChange > 0 && m_HeadRev > 0;
+}
+
+void CCmd_History::UseCache(BOOL &done)
+{
+	CString text;
+	if (!GET_REVCACHE()->FetchText(GetCacheKey(), text))
+		return;
+
+	LPTSTR end;
+	long cachedChange = _tcstol(text, &end, 10);
+	long cachedRev = _tcstol(end, &end, 10);
+	if (*end != _T('\n') || cachedChange <= 0 || cachedRev <= 0)
+		return;
+	LPCTSTR records = end + 1;
+
+	if (cachedChange == m_HeadChange && cachedRev == m_HeadRev)
+	{
+		m_FromCache = done = TRUE;
+		Replay(records, FALSE);
+		if ( GET_P4REGPTR()->ShowCommandTrace( ) )
+		{
+			CString temp;
+			temp.Format(_T("Retrieved the history of %s from the local filelog cache"), m_CacheSpec);
+			TheApp()->StatusAdd(temp);
+		}
+	}
+	else if (cachedChange < m_HeadChange && cachedRev < m_HeadRev
+		  && m_CacheVariant.Find(_T("-h")) == -1)	// -h history can be rewritten by later copies
+	{
+		m_Cached = records;
+		m_Incremental = TRUE;
+
+		CString range;
+		range.Format(_T("%s#%ld,#%ld"), m_CacheSpec, cachedRev + 1, m_HeadRev);
+		ClearArgs(int(GetArgc()) - 1);
+		AddArg(range);
+	}
+}
+
+void CCmd_History::CacheField(LPCTSTR field)
+{
+	CString len;
+	len.Format(_T("%d:"), lstrlen(field));
+	m_CacheRecords += len;
+	m_CacheRecords += field;
+}
+
+// Reads one field; returns where the next one starts, or NULL if the field
+// is damaged
+static LPCTSTR NextField(LPCTSTR p, LPCTSTR last, CString &field)
+{
+	LPTSTR end;
+	long len = _tcstol(p, &end, 10);
+	if (*end != _T(':') || len < 0 || len > last - (end + 1))
+		return NULL;
+	field.SetString(end + 1, len);
+	return end + 1 + len;
+}
+
+// Feed cached revisions back in, just as if the server had sent them.
+// After an incremental fetch the server has already sent the first file's
+// name, so the cached copy is skipped, and no more of the first file's
+// revisions are added once there are as many as -m asked for.
+void CCmd_History::Replay(LPCTSTR records, BOOL skipFirstName)
+{
+	m_Incremental = m_DropLive = FALSE;
+
+	CString field[6];
+	LPCTSTR p = records;
+	LPCTSTR last = records + lstrlen(records);
+	while (p < last)
+	{
+		TCHAR tag = *p++;
+		int nFields = tag == _T('f') ? 1 : tag == _T('r') ? 6 : 0;
+		for (int i = 0; i < nFields && p; i++)
+			p = NextField(p, last, field[i]);
+		if (!nFields || !p)
+			break;		// damaged entry - show what we have
+
+		if (tag == _T('f'))
+		{
+			BOOL skip = skipFirstName && m_FileNbr > 0;
+			skipFirstName = FALSE;
+			if (!skip)
+				NewFile(field[0]);
+		}
+		else if (!(m_MaxRevs && m_FileNbr == 1 && m_TopRevs >= m_MaxRevs))
+		{
+			CRevision *rev = new CRevision;
+			rev->m_FName = m_FileName;
+			rev->m_FNbr = m_FileNbr;
+			rev->m_RevisionNum = _ttoi(field[0]);
+			rev->m_ChangeNum = _ttoi(field[1]);
+			rev->m_Date = field[2];
+			rev->m_User = field[3];
+			rev->m_ChangeType = field[4];
+			rev->m_ChangeDescription = field[5];
+			AddRevision(rev);
+		}
+	}
+}
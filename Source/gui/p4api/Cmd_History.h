@@ -46,6 +46,7 @@ public:
     FileSys *GetTempFile() { return m_pOutputFile; }
 	void SetKeyToHold(int k) { m_KeyToHold = k; }
 	int GetKeyToHold() { return m_KeyToHold; }
+	BOOL IsFromCache() { return m_FromCache; }
 
     // Attributes	
 protected:
@@ -79,9 +80,34 @@ protected:
     FileSys *m_pOutputFile;
 	int m_KeyToHold;
 
+	// Filelog cache support
+	CString m_CacheSpec;		// depot path, if the result is cacheable
+	CString m_CacheVariant;		// the filelog flags
+	CString m_CacheRecords;		// this run's revisions, serialized for the cache
+	CString m_Cached;			// cached revisions to be appended to an incremental fetch
+	long m_HeadChange;
+	long m_HeadRev;
+	int  m_MaxRevs;				// -m value, or 0
+	int  m_TopRevs;				// revisions seen so far for the first file
+	BOOL m_Incremental;
+	BOOL m_DropLive;
+	BOOL m_FromCache;
+
+	CString GetCacheKey();
+	BOOL GetHeadInfo();
+	void UseCache(BOOL &done);
+	void CacheField(LPCTSTR field);
+	void Replay(LPCTSTR records, BOOL skipFirstName);
+
+	void FlushRevision();
+	void NewFile(LPCTSTR fileName);
+	void AddRevision(CRevision *rev);
+	void WriteTempText(LPCTSTR text);
+
     // CP4Command overrides
     virtual void PreProcess(BOOL &done);
     virtual void OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg);
+    virtual void OnOutputStat( StrDict *varList );
     virtual void PostProcess();
 	virtual BOOL HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg);
 };
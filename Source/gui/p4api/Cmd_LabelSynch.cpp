@@ -51,7 +51,8 @@ BOOL CCmd_LabelSynch::Run(LPCTSTR labelName, CStringList *files,
 	m_posStrListIn=files->GetHeadPosition();
 	m_pStrListIn=files;  
 
-	// Put the first few files into the arg list
+	// Send the whole list in one command, rather than a few files at a time
+	StreamList();
 	NextListArgs();
 		
 	return CP4Command::Run();
@@ -60,6 +61,7 @@ BOOL CCmd_LabelSynch::Run(LPCTSTR labelName, CStringList *files,
 void CCmd_LabelSynch::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 {
 	m_StrListOut.AddHead(data);
+	AddListResult(data);
 }
 
 
@@ -107,7 +107,8 @@ BOOL CCmd_ListOp::Run(CStringList *files, int command, long changeNum, LPCTSTR n
 	m_posStrListIn=files->GetHeadPosition();
 	m_pStrListIn=files;  
 	
-	// Put the first few files into the arg list
+	// Send the whole list in one command, rather than a few files at a time
+	StreamList();
 	NextListArgs();
 	
 	return CP4Command::Run();
@@ -186,7 +187,9 @@ void CCmd_ListOp::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 		ASSERT(0);
 	}
 
-	if(!processedMessage)
+	if(processedMessage)
+		AddListResult(data);
+	else
 	{
 		TheApp()->StatusAdd(msg, SV_WARNING);
 		if(m_WarnIfLocked && StrStr(data, _T(" - locked by ")))
@@ -59,7 +59,6 @@ BOOL CCmd_ListOpStat::Run(CStringList *files, int command, long changeNum/*=0*/,
 
 void CCmd_ListOpStat::PreProcess(BOOL& done)
 {
-	int i;
 	POSITION pos;
 
 	CCmd_ListOp cmd1(m_pClient);
@@ -80,13 +79,12 @@ void CCmd_ListOpStat::PreProcess(BOOL& done)
 				for( pos= pSyncList->GetHeadPosition(); pos!= NULL; )
 					m_Unsynced.AddHead( pSyncList->GetNext(pos) );
 				
-				CStringList * pEditList = cmd1.GetList();
-				for( pos= pEditList->GetHeadPosition(); pos!= NULL; )
+				const CMapStringToString *pEdited = cmd1.GetListResults();
+				CString path, row;
+				for( pos= pEdited->GetStartPosition(); pos!= NULL; )
 				{
-					CString txt = pEditList->GetNext(pos);
-					if ((i = txt.Find(_T('#'))) != -1)
-						txt = txt.Left(i);
-					m_RevertIfCancel.AddHead( txt );
+					pEdited->GetNextAssoc(pos, path, row);
+					m_RevertIfCancel.AddHead( path );
 				}
 			}
 			else m_ChkForSyncs = FALSE;
@@ -148,7 +146,7 @@ void CCmd_ListOpStat::PreProcess(BOOL& done)
 			}
 		}
 		else
-			PrepareStatInfo();
+			PrepareStatInfo(cmd1.GetListResults());
 	}
 
 	// Post the completion message
@@ -247,81 +245,29 @@ void CCmd_ListOpStat::PreProcess(BOOL& done)
 // into the appropriate CP4FileStat objects, to avoid complexities
 // in the list process handlers of the depot and changes windows
 
-void CCmd_ListOpStat::PrepareStatInfo()
+void CCmd_ListOpStat::PrepareStatInfo(const CMapStringToString *results)
 {
 	POSITION pos;
-	CString listRow, fname, fRev;
-	int separator;
-	int pound = -1;
-	int lastSlash;
+	CString listRow, fname;
 	int rev = -1;
-	BOOL rowError;
 
-	for(pos=m_StrListOut.GetHeadPosition(); pos !=NULL; )
+	// ListOp has already matched each row to its depot path
+	for(pos=results->GetStartPosition(); pos !=NULL; )
 	{
-		listRow=fname=m_StrListOut.GetNext(pos);
-		rowError=FALSE;
+		results->GetNextAssoc(pos, fname, listRow);
 
-		//////////////
-		// Separate the filename from the action description
-		// For all operations but lock and unlock, this amounts to a
-		// quick search for '#'.  In the case of the lock commands, 
-		// there is no revision number, so search for the action text itself
-
-		switch(m_Command)
-		{
-		case P4LOCK:
-			// For Lock and Unlock, server doesnt send rev number
-			separator= listRow.Find(_T(" - locking"));   
-			if(separator == -1)
-				rowError=TRUE;
-			break;
-
-		case P4UNLOCK:
-			// For Lock and Unlock, server doesnt send rev number
-			separator= listRow.Find(_T(" - unlocking"));
-			if(separator == -1)
-				rowError=TRUE;
-			break;
-
-		default:
-			pound= listRow.Find(_T('#'));
-			if(pound == -1)
-			{
-				separator = -1;	// this is just to make the compiler shut up
-				rowError=TRUE;
-				break;
-			}
-
-			separator= pound+1;
-			int len= listRow.GetLength();
-			for( ; separator < len ; separator++)
-			{
-				if(listRow[separator]==_T(' ') && listRow[separator+1]==_T('-') && listRow[separator+2]==_T(' '))
-				break;
-			}
-			if(separator==len)
-				rowError=TRUE;
-		}
-
-		if(rowError)
-		{ 
-			// doesnt look like a valid row, report it and skip it
-			ASSERT(0); 
-			listRow= _T("Invalid listRow: ") + listRow;
-			TheApp()->StatusAdd(listRow, SV_WARNING);
-			continue; 
-		}	
-					
-		fname=fname.Left(separator);
-		lastSlash=fname.ReverseFind(_T('/'));
-		
 		// For Lock and Unlock, server doesnt send rev number
 		if(m_Command != P4LOCK && m_Command != P4UNLOCK)
 		{
-			fRev=fname.Mid(pound+1);
-			rev=_ttol(fRev);
-			fname=fname.Left(pound);		// full name without revision
+			if(listRow.GetLength() <= fname.GetLength() || listRow[fname.GetLength()] != _T('#'))
+			{ 
+				// doesnt look like a valid row, report it and skip it
+				ASSERT(0); 
+				listRow= _T("Invalid listRow: ") + listRow;
+				TheApp()->StatusAdd(listRow, SV_WARNING);
+				continue; 
+			}	
+			rev=_ttol(listRow.Mid(fname.GetLength()+1));
 		}
 
 		CP4FileStats *fs= new CP4FileStats;
@@ -92,7 +92,7 @@ protected:
     CStringList m_RevertIfCancel;
     CStringList m_RevertAdds;
 
-    void PrepareStatInfo();
+    void PrepareStatInfo(const CMapStringToString *results);
 
     // CP4Command overrides
     virtual void PreProcess(BOOL& done);
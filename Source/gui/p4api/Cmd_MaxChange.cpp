@@ -30,12 +30,15 @@ CCmd_MaxChange::CCmd_MaxChange(CGuiClient *client) : CP4Command(client)
 		m_StartedNoServerLevel=FALSE;
 }
 
-BOOL CCmd_MaxChange::Run( )
+BOOL CCmd_MaxChange::Run( BOOL submittedOnly /*=TRUE*/ )
 {
 	ClearArgs();
 	AddArg(_T("changes"));
-	AddArg(_T("-s"));
-	AddArg(_T("submitted"));
+	if( submittedOnly )
+	{
+		AddArg(_T("-s"));
+		AddArg(_T("submitted"));
+	}
 	AddArg(_T("-m"));
 	AddArg(_T("1"));
 	
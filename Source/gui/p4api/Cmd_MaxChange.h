@@ -15,7 +15,7 @@ public:
     CCmd_MaxChange(CGuiClient *client=NULL);
     DECLARE_DYNCREATE(CCmd_MaxChange)
 
-    BOOL Run(  );
+    BOOL Run( BOOL submittedOnly=TRUE );
 
     int GetMaxChange() const { return m_MaxChange; }
 
@@ -22,10 +22,11 @@ static char THIS_FILE[] = __FILE__;
 #endif
 
 int compareOpenFiles( const void *arg1, const void *arg2 );
-int compareUnresolvedFiles( const void *arg1, const void *arg2 );
 	
 IMPLEMENT_DYNCREATE(CCmd_Ostat, CP4Command)
 
+static CString s_CheckedClient;		// port and client last found valid by info
+
 
 CCmd_Ostat::CCmd_Ostat(CGuiClient *client) : CP4Command(client)
 {
@@ -56,24 +57,33 @@ void CCmd_Ostat::PreProcess(BOOL& done)
     m_ResolvedArray.SetSize(0,500);
 
 	BOOL b = FALSE;
+	BOOL bResolveState = FALSE;
 	if(GET_SERVERLEVEL() >= 19)			// 2005.1 or later?
 	{
-		// first make sure the client is valid
-	    CCmd_Info cmd(m_pClient);
-		cmd.Init( NULL, RUN_SYNC );
-		if( cmd.Run( ) && !cmd.GetError() )
+		// first make sure the client is valid - once is enough for each
+		// port and client, rather than an extra command every refresh
+		CString client = CharToCString(m_pClient->GetPort().Text())
+					   + _T(' ') + GET_P4REGPTR()->GetP4Client();
+		if (client != s_CheckedClient)
 		{
-			CP4Info const &info = cmd.GetInfo();
-			if (info.m_ClientRoot.IsEmpty( ))
+			CCmd_Info cmd(m_pClient);
+			cmd.Init( NULL, RUN_SYNC );
+			if( cmd.Run( ) && !cmd.GetError() )
 			{
-				HWND hWnd= AfxGetMainWnd()->m_hWnd;
-				if( hWnd != NULL )
+				CP4Info const &info = cmd.GetInfo();
+				if (info.m_ClientRoot.IsEmpty( ))
 				{
-					::PostMessage(hWnd, WM_CLIENTERROR, 0, 0);
-					m_FatalError= -1;
-					done=TRUE;
-					return;
+					HWND hWnd= AfxGetMainWnd()->m_hWnd;
+					if( hWnd != NULL )
+					{
+						::PostMessage(hWnd, WM_CLIENTERROR, 0, 0);
+						m_FatalError= -1;
+						done=TRUE;
+						return;
+					}
 				}
+				else
+					s_CheckedClient = client;
 			}
 		}
 
@@ -94,7 +104,13 @@ void CCmd_Ostat::PreProcess(BOOL& done)
 	        mylist= cmd0.GetFileList();
 			for( pos= mylist->GetHeadPosition(); pos!= NULL; )
 				m_OpenArray.Add( mylist->GetNext(pos) );
+
+			// Later servers also report which files have been resolved, so
+			// there is no need to ask with resolve -n and resolved
+			bResolveState = GET_SERVERLEVEL() >= 30;	// 2010.2 or later?
 		}
+		else
+			s_CheckedClient.Empty();
 	}
 
 	if (!b || m_AllOpenFiles)
@@ -149,22 +165,8 @@ void CCmd_Ostat::PreProcess(BOOL& done)
 		}
 	}
 
-	if(!m_FatalError && !m_OpenArray.IsEmpty())
+	if(!m_FatalError && !m_OpenArray.IsEmpty() && !bResolveState)
 	{
-		if (list && list->GetCount() > 0)
-		{
-			for( pos= list->GetHeadPosition(); pos!= NULL; )
-			{
-				CP4FileStats *stats= (CP4FileStats *) list->GetNext(pos);
-				if( b && ( stats->IsMyOpen() || stats->IsOtherUserMyClient() ) )
-				{
-					delete stats;
-					continue;
-				}
-				m_OpenArray.Add( stats );
-			}
-		}
-
      	// Set up and run unresolved (p4 resolve-n)
 	    CCmd_Unresolved cmd2(m_pClient);
 		cmd2.Init(NULL, RUN_SYNC);
@@ -221,87 +223,57 @@ void CCmd_Ostat::PreProcess(BOOL& done)
          // Sort the results from opened
         SortOpened();
 
-    if( !m_FatalError && m_UnresolvedArray.GetSize() > 0 )
-        // Sort the results from Unresolved
-        SortUnresolved();
-
-    if( !m_FatalError && m_ResolvedArray.GetSize() > 0 )
-        // Sort the results from Unresolved
-        SortResolved();
-
     
 	///////////////
-	// Update files in m_OpenList.  The array of opened files is sorted
-    // by myopen+changeno+filename, so search should never look at another
-    // user's open files.  Files appearing in the m_Unresolved list
+	// Update files in m_OpenList.  Files appearing in the m_Unresolved list
 	// must have the unresolved att set; Files appearing in the m_Resolved list
-	// must have the resolved att set
+	// must have the resolved att set.  Only my open files are looked at:
+	// 'p4 resolve -n' can return unresolved files on my client that were
+	// opened by another user, and for now those are not shown as unresolved.
 
 	if(!m_FatalError && ((m_UnresolvedArray.GetSize() > 0) || (m_ResolvedArray.GetSize() > 0)))
 	{
-        INT_PTR maxR= m_ResolvedArray.GetSize();
-        INT_PTR maxU= m_UnresolvedArray.GetSize();
-        INT_PTR maxO= m_OpenArray.GetSize();
-
-        CString fName;
-        CP4FileStats *stats;
+        CMapStringToPtr myOpens;
+        myOpens.InitHashTable(max(17, (int) m_OpenArray.GetSize() * 5 / 4) | 1);
 
 		int i;
-        for( i=0; i<maxU; i++)
+        for( i=0; i<m_OpenArray.GetSize(); i++ )
         {
-            fName= m_UnresolvedArray.GetAt(i);
+            CP4FileStats *stats= (CP4FileStats *) m_OpenArray.GetAt(i);
+            if( !stats->IsMyOpen() )
+                break;	// my open files are sorted to the front
+            myOpens.SetAt(stats->GetFullDepotPath(), stats);
+        }
 
-            for( int j=0; j<maxO; j++ )
-            {
-                stats= (CP4FileStats *) m_OpenArray.GetAt(j);
-                if(stats->IsMyOpen() && fName == stats->GetFullDepotPath())
-                {
-					// Update the unresolved flag for file 
-					stats->SetUnresolved(TRUE);
-					break;
-				}
-                if( !stats->IsMyOpen() )
-                {
-                    // It is possible that 'p4 resolve -n' returned unresolved files on
-                    // my client that were opened by another user.  In 99.1 we may try to
-                    // display these.  For now, do not show these files as unresolved, so
-                    // break off the search for opened files as soon as we hit a file that
-                    // is not my open.
-                    break;
-                }
-            }
+        void *p;
+        for( i=0; i<m_UnresolvedArray.GetSize(); i++)
+        {
+            if( myOpens.Lookup(m_UnresolvedArray.GetAt(i), p) )
+                ((CP4FileStats *) p)->SetUnresolved(TRUE);
         }
-        for( i=0; i<maxR; i++)
+        for( i=0; i<m_ResolvedArray.GetSize(); i++)
         {
-            fName= m_ResolvedArray.GetAt(i);
-
-            for( int j=0; j<maxO; j++ )
-            {
-                stats= (CP4FileStats *) m_OpenArray.GetAt(j);
-                if(stats->IsMyOpen() && fName == stats->GetFullDepotPath())
-                {
-					// Update the resolved flag for file 
-					stats->SetResolved(TRUE);
-					break;
-				}
-                if( !stats->IsMyOpen() )
-                {
-                    // It is possible that 'p4 resolved' returned unresolved files on
-                    // my client that were opened by another user.  In 99.1 we may try to
-                    // display these.  For now, do not show these files as unresolved, so
-                    // break off the search for opened files as soon as we hit a file that
-                    // is not my open.
-                    break;
-                }
-            }
+            if( myOpens.Lookup(m_ResolvedArray.GetAt(i), p) )
+                ((CP4FileStats *) p)->SetResolved(TRUE);
         }
     }
 
     // Provide statistics if requested
     if( GET_P4REGPTR()->ShowCommandTrace( ) )
     {
+        INT_PTR unresolved= m_UnresolvedArray.GetSize();
+        INT_PTR resolved= m_ResolvedArray.GetSize();
+        if( bResolveState )
+        {
+            for( int i=0; i<m_OpenArray.GetSize(); i++ )
+            {
+                CP4FileStats *stats= (CP4FileStats *) m_OpenArray.GetAt(i);
+                unresolved += stats->IsUnresolved();
+                resolved += stats->IsResolved();
+            }
+        }
         CString statistics;
-        statistics.Format(_T("     Found %ld opened files with %ld unresolved files and %ld resolved files"), m_OpenArray.GetSize(), m_UnresolvedArray.GetSize(), m_ResolvedArray.GetSize());
+        statistics.Format(_T("     Found %ld opened files with %ld unresolved files and %ld resolved files"), m_OpenArray.GetSize(), unresolved, resolved);
         TheApp()->StatusAdd(statistics);
     }
     done=TRUE;
@@ -336,35 +308,6 @@ void CCmd_Ostat::SortOpened()
     qsort( (void *) array, size, sizeof( CObject *), compareOpenFiles );
 }
 
-void CCmd_Ostat::SortUnresolved()
-{
-    // Sort the m_UnresolvedArray of CP4FileStats according to:
-    // 1) my open files first, other's open files later
-    // 2) change number
-    // 3) file name
-
-    INT_PTR size= m_UnresolvedArray.GetSize();
-    CString *array= m_UnresolvedArray.GetData();
-
-    setupCompare();
-    qsort( (void *) array, size, sizeof( CString * ), compareUnresolvedFiles );
-}
-
-
-void CCmd_Ostat::SortResolved()
-{
-    // Sort the m_ResolvedArray of CP4FileStats according to:
-    // 1) my open files first, other's open files later
-    // 2) change number
-    // 3) file name
-
-    INT_PTR size= m_ResolvedArray.GetSize();
-    CString *array= m_ResolvedArray.GetData();
-
-    setupCompare();
-    qsort( (void *) array, size, sizeof( CString * ), compareUnresolvedFiles );
-}
-
 // return <0 if arg1 < arg2, 0 if arg1=arg2, >0 if arg1 > arg2
 int compareOpenFiles( const void *arg1, const void *arg2 )
 {
@@ -394,12 +337,3 @@ int compareOpenFiles( const void *arg1, const void *arg2 )
 done:
     return result;
 }
-
-// return <0 if arg1 < arg2, 0 if arg1=arg2, >0 if arg1 > arg2
-int compareUnresolvedFiles( const void *arg1, const void *arg2 )
-{
-    CString *f1= (CString *) arg1;
-    CString *f2= (CString *) arg2;
-    ASSERT(pCompare);
-    return pCompare(*f1,*f2);
-}
@@ -29,8 +29,6 @@ protected:
     CStringArray m_UnresolvedArray;
     CStringArray m_ResolvedArray;
 
-    void SortResolved();
-    void SortUnresolved();
     void SortOpened();
 
     // CP4Command overrides
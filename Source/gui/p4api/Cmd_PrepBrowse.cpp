@@ -8,6 +8,7 @@
 #include "stdafx.h"
 #include "p4win.h"
 #include "cmd_prepbrowse.h"
+#include "cmd_fstat.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -27,12 +28,25 @@ CCmd_PrepBrowse::CCmd_PrepBrowse(CGuiClient *client) : CP4Command(client)
 	m_Annotating = m_bP4a = m_NoFileAtRev = FALSE;
 	m_FileRev = -1;
 	m_Type = FST_CANTTELL;
+	m_CacheRev = 0;
+	m_ResolveHead = m_FromCache = m_OutputDone = FALSE;
+	m_PrintSkipped = m_PrintFailed = FALSE;
+	m_CacheRevSize = 0;
+	m_Prefetch = FALSE;
+	m_PrefetchMax = m_PrefetchedBytes = 0;
 }
 
 CCmd_PrepBrowse::~CCmd_PrepBrowse()
 {
 	if(m_pOutputFile != NULL)
 		delete m_pOutputFile;
+
+	// A prefetched revision lives on only in the revision cache
+	if (m_Prefetch && !m_TempName.IsEmpty())
+	{
+		SetFileAttributes(m_TempName, FILE_ATTRIBUTE_NORMAL);
+		DeleteFile(m_TempName);
+	}
 }
 
 // Normal p4 print of file
@@ -63,6 +77,10 @@ BOOL CCmd_PrepBrowse::Run(LPCTSTR fileSpec, CString &fileType,
 		DepotName.Format(_T("%s#%d"), fileSpec, fileRev);
 	AddArg(DepotName);
 
+	CString variant;
+	variant.Format(_T("print-%d"), m_pOutputFile->GetType());
+	SetupCache(fileSpec, fileRev, variant);
+
 	return CP4Command::Run();
 }
 
@@ -119,6 +137,15 @@ BOOL CCmd_PrepBrowse::Run(BOOL bUseP4A, LPCTSTR fileSpec, CString &fileType,
 	}
 	AddArg(DepotName);
 
+	// p4a output is a work file for P4V, so only plain annotations are cached
+	if (!m_bP4a)
+	{
+		CString variant= _T("annotate");
+		for (int i = 1; i < GetArgc() - 1; i++)
+			variant += GetArgv(i);
+		SetupCache(fileSpec, fileRev, variant);
+	}
+
 	return CP4Command::Run();
 }
 
@@ -172,10 +199,12 @@ void CCmd_PrepBrowse::OnOutputText(LPCTSTR data, int length)
 			temp.Format(_T("Retrieved %s, %ld bytes"), CharToCString(m_pOutputFile->Name()), m_ByteCount);													
 
 
-		TheApp()->StatusAdd(temp); 
+		if (!m_Prefetch)
+			TheApp()->StatusAdd(temp); 
 		// Dont delete the file before the viewer can see it!
 		m_pOutputFile->ClearDeleteOnClose();
 		m_pOutputFile->Close(&e);
+		m_OutputDone = !e.Test();
 	}
 }
 
@@ -284,7 +313,9 @@ BOOL CCmd_PrepBrowse::SetupPrint(LPCTSTR fileSpec, CString &fileType,
 				break;
 		}
 		e.Clear();
-		if (Symbol.IsEmpty())
+		if (m_Prefetch)		// other prefetch threads may be picking names too
+			m_TempName.Format(_T("%s\\Prefetch-%lx-%d-%s"), TempPath, GetCurrentThreadId(), i, FileName);
+		else if (Symbol.IsEmpty())
 			m_TempName.Format(_T("%s\\ReadOnly-%d-Rev-%d-%s"), TempPath, i, fileRev, FileName);
 		else
 			m_TempName.Format(_T("%s\\ReadOnly-%d-%s-%s"), TempPath, i, Symbol, FileName);
@@ -345,6 +376,7 @@ void CCmd_PrepBrowse::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 			ExitThread(0);
 		}
 
+		m_PrintFailed = TRUE;
 		TheApp()->StatusAdd(msg, SV_WARNING);
 	}
 }
@@ -354,5 +386,161 @@ BOOL CCmd_PrepBrowse::HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg )
 	if ( StrStr(errBuf, _T(" - no file(s) at that revision")) 
 	 ||	 StrStr(errBuf, _T(" - no such file(s)")) )
 		m_NoFileAtRev = TRUE ; 
-	return ( FALSE );
+	m_PrintFailed = TRUE;
+
+	// Nobody asked for a prefetch, so nobody needs to hear it failed
+	return ( m_Prefetch );
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// Revision cache support
+//
+// A revision named by number never changes, so its printed (or annotated)
+// content can be reused from the local revision cache instead of being
+// downloaded again.  Head requests are first resolved to a number with a
+// quick fstat, so they can be served from the cache as well.
+
+void CCmd_PrepBrowse::SetupCache(LPCTSTR fileSpec, long fileRev, LPCTSTR variant)
+{
+	if (!GET_REVCACHE()->IsEnabled() || _tcspbrk(fileSpec, _T("@#*")) || _tcsstr(fileSpec, _T("...")))
+		return;
+
+	m_CacheSpec = fileSpec;
+	m_CacheVariant = variant;
+	if (fileRev > 0)
+		m_CacheRev = fileRev;
+	else if (fileRev == 0x80000000 && GET_SERVERLEVEL() >= 19)	// 2005.1 or later has digests
+		m_ResolveHead = TRUE;
+	else
+		m_CacheSpec.Empty();
+}
+
+// Fstat the revision to be printed, to learn its number (for head requests),
+// its digest and its size.  Returns FALSE if there is no such revision.
+BOOL CCmd_PrepBrowse::StatCacheRev()
+{
+	Error e;
+	BOOL found = FALSE;
+	CString spec = m_CacheSpec;
+	if (m_CacheRev > 0)
+		spec.Format(_T("%s#%ld"), m_CacheSpec, m_CacheRev);
+
+	CCmd_Fstat cmd(m_pClient);
+	cmd.InheritIndependence(this);
+	cmd.Init(NULL, RUN_SYNC);
+	if (cmd.Run(FALSE, spec, TRUE) && !cmd.GetError())
+	{
+		CObList *list = cmd.GetFileList();
+		if (list->GetCount() == 1)
+		{
+			CP4FileStats *stats = (CP4FileStats *) list->GetHead();
+			if (stats->GetHeadRev() > 0 && stats->GetHeadAction() != F_DELETE)
+			{
+				m_ServerDigest = stats->GetDigest();
+				m_CacheRevSize = stats->GetFileSize();
+				found = TRUE;
+				if (m_CacheRev <= 0)
+				{
+					m_CacheRev = stats->GetHeadRev();
+
+					// Print exactly the revision we are going to cache it as,
+					// in case a submit sneaks in between the fstat and the print
+					CString depotName;
+					depotName.Format(_T("%s#%ld"), m_CacheSpec, m_CacheRev);
+					ClearArgs(int(GetArgc()) - 1);
+					AddArg(depotName);
+				}
+			}
+		}
+		for (POSITION pos = list->GetHeadPosition(); pos != NULL; )
+			delete list->GetNext(pos);
+		list->RemoveAll();
+	}
+	cmd.CloseConn(&e);
+	return found;
+}
+
+CString CCmd_PrepBrowse::GetCacheKey()
+{
+	return CP4RevCache::MakeKey(CharToCString(m_pClient->GetPort().Text()), 
+								m_CacheSpec, m_CacheRev, m_CacheVariant);
+}
+
+void CCmd_PrepBrowse::PreProcess(BOOL& done)
+{
+	done = FALSE;
+	if (m_Prefetch)
+	{
+		// Only fetch what the cache doesn't have, and what fits the budget
+		done = m_CacheSpec.IsEmpty() || m_CacheRev <= 0
+			|| GET_REVCACHE()->Contains(GetCacheKey())
+			|| (GET_SERVERLEVEL() >= 19 && (!StatCacheRev() || m_CacheRevSize > m_PrefetchMax));
+		m_PrintSkipped = done;
+		return;
+	}
+	if (m_CacheSpec.IsEmpty())
+		return;
+
+	if (m_ResolveHead)
+		StatCacheRev();
+	if (m_CacheRev <= 0)
+		return;
+
+	CString key = GetCacheKey();
+	if (!GET_REVCACHE()->Contains(key))
+		return;
+
+	// The temp file must be closed before the cached copy can replace it
+	Error e;
+	if (IsOutputFileOpen())
+	{
+		m_pOutputFile->ClearDeleteOnClose();
+		m_pOutputFile->Close(&e);
+	}
+	if (GET_REVCACHE()->Fetch(key, m_TempName, m_ServerDigest))
+	{
+		CString temp;
+		temp.Format(_T("Retrieved %s#%ld from the local revision cache"), m_CacheSpec, m_CacheRev);
+		TheApp()->StatusAdd(temp);
+		if ( GET_P4REGPTR()->ShowCommandTrace( ) )
+			TheApp()->StatusAdd(GET_REVCACHE()->GetStatsText());
+		m_FromCache = m_PrintSkipped = done = TRUE;
+	}
+	else if (IsOutputFileOpen())
+	{
+		// Failed the integrity check - fall back to fetching from the server
+		e.Clear();
+		m_pOutputFile->Perms( m_Annotating && m_bP4a ? FPM_RW : FPM_RO );
+		m_pOutputFile->Open( FOM_WRITE, &e );
+		if (e.Test())
+		{
+			m_ErrorTxt.Format(_T("Error opening temporary file:\n %s"), m_TempName);
+			TheApp()->StatusAdd(m_ErrorTxt, SV_ERROR);
+			m_FatalError = m_PrintSkipped = done = TRUE;
+		}
+	}
+}
+
+void CCmd_PrepBrowse::PostProcess()
+{
+	// Nothing was printed, so the temp file is either the cached copy or
+	// the empty placeholder left by SetupPrint - neither belongs in the cache
+	if (m_PrintSkipped)
+		return;
+
+	// With print -o the client api has written and closed the file by now
+	if (!IsOutputFileOpen())
+		m_OutputDone = TRUE;
+
+	if (m_OutputDone && m_CacheRev > 0 && !m_PrintFailed && !GetError())
+	{
+		if (m_Prefetch)
+		{
+			WIN32_FILE_ATTRIBUTE_DATA fad;
+			if (GetFileAttributesEx(m_TempName, GetFileExInfoStandard, &fad))
+				m_PrefetchedBytes = (__int64)fad.nFileSizeHigh << 32 | fad.nFileSizeLow;
+		}
+		GET_REVCACHE()->Store(GetCacheKey(), m_TempName, m_pOutputFile->GetType(), m_ServerDigest);
+	}
 }
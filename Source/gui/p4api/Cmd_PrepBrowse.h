@@ -32,6 +32,9 @@ public:
 	FileSysType GetFileType() { return m_Type; }
 	void SetTempFilelog(CString &fn) { m_TempFilelogName = fn; }
 	CString &GetTempFilelog() { return m_TempFilelogName; }
+	BOOL IsFromCache() { return m_FromCache; }
+	void SetPrefetch(__int64 maxBytes) { m_Prefetch = TRUE; m_PrefetchMax = maxBytes; }
+	__int64 GetPrefetchedBytes() { return m_PrefetchedBytes; }
 
 protected:
     // Attributes
@@ -45,9 +48,32 @@ protected:
 	BOOL m_bP4a;
 	BOOL m_NoFileAtRev;
 
+	// Revision cache support
+	CString m_CacheSpec;		// depot path, if the revision is cacheable
+	CString m_CacheVariant;		// distinguishes print/annotate flavors of the same rev
+	CString m_ServerDigest;
+	long m_CacheRev;
+	BOOL m_ResolveHead;			// find the head rev number first, so head can be cached
+	BOOL m_FromCache;
+	BOOL m_OutputDone;
+	BOOL m_PrintSkipped;		// PreProcess answered the request without printing
+	BOOL m_PrintFailed;			// the server reported a problem with the print
+	unsigned long m_CacheRevSize;	// from fstat, if known
+
+	// Prefetch support: print straight into the revision cache
+	BOOL m_Prefetch;
+	__int64 m_PrefetchMax;
+	__int64 m_PrefetchedBytes;
+
     BOOL SetupPrint(LPCTSTR fileSpec, CString &fileType, long fileRev, BOOL bForce2Binary);
+	void SetupCache(LPCTSTR fileSpec, long fileRev, LPCTSTR variant);
+	BOOL StatCacheRev();
+	CString GetCacheKey();
+	BOOL IsOutputFileOpen() { return m_Annotating || GET_SERVERLEVEL() < 10; }
 				     
     // CP4Command overrides
+	virtual void PreProcess(BOOL& done);
+	virtual void PostProcess();
     virtual void OnOutputText(LPCTSTR data, int length);
 	virtual void OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg);
 	virtual BOOL HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg);
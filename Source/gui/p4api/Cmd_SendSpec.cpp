@@ -10,6 +10,7 @@
 #include "stdafx.h"
 #include "p4win.h"
 #include "Cmd_SendSpec.h"
+#include "Cmd_Describe.h"
 
 
 #ifdef _DEBUG
@@ -176,6 +177,7 @@ void CCmd_SendSpec::OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg)
 			{
 				m_NewChangeNum= _ttol(data+7);
 				ASSERT(m_NewChangeNum);
+				CCmd_Describe::ChangeEdited(m_NewChangeNum);
 				processedMessage=TRUE;
 			}
 			break;
@@ -28,12 +28,19 @@ static char THIS_FILE[] = __FILE__;
 // MultiProcessorSleep reg setting: 0==off; ODD == GUI sleep; > EVEN == worker sleep
 static int m_MultiProcessorSleep = 0;
 
+#define CONNSLOTWAIT	100		// ms between looks for a free connection
+
+volatile LONG CP4Command::s_Connections = 0;
+
 //		Prototype for taskthread
 //
 UINT TaskThread( LPVOID pParam );
 
 int P4KeepAlive::IsAlive()
 {
+	if (m_pCancel)
+		return !*m_pCancel && !APP_ABORTING();
+
 	if (global_cancel)
 	{
 		global_cancel = 0; 
@@ -56,6 +63,11 @@ CP4Command::CP4Command(CGuiClient *client /* =NULL */) : m_pClient(client)
     m_HaveServerLock = FALSE;
 	m_HitMaxFileSeeks= FALSE;
 	m_RedoOpenedFilter=FALSE;
+	m_Independent=FALSE;
+	m_HaveConnSlot=FALSE;
+	m_ListBatch= 20;
+	m_ListTotal= m_ListDone= 0;
+	m_LastListProgress= 0;
 	m_FatalError = m_FatalErrorCleared = m_TriggerError = m_IgnorePermissionErrs = FALSE;
 
 	if(m_pClient != NULL)
@@ -146,6 +158,11 @@ void CP4Command::CloseConn(Error *e)
             delete m_pClient;
 			m_pClient = 0;
 	    }
+	    if(m_HaveConnSlot)
+	    {
+		    InterlockedDecrement(&s_Connections);
+		    m_HaveConnSlot=FALSE;
+	    }
 	    m_ClosedConn=TRUE;
     }
 	else if (!m_IsChildTask && m_pClient)
@@ -157,7 +174,7 @@ void CP4Command::CloseConn(Error *e)
 BOOL CP4Command::Init(HWND replyWnd, BOOL asynch, BOOL holdLock/*=FALSE*/, int key/*=0*/)
 {
     // We need a reply window
-	ASSERT( m_pClient != NULL || IsWindow(replyWnd) );
+	ASSERT( m_pClient != NULL || m_Independent || IsWindow(replyWnd) );
 
    	m_ReplyWnd= replyWnd;
 	m_Asynchronous= asynch;
@@ -174,9 +191,35 @@ BOOL CP4Command::Init(HWND replyWnd, BOOL asynch, BOOL holdLock/*=FALSE*/, int k
 	return TRUE;
 }
 
+// An independent command runs on its own connection and never takes or
+// waits for the server lock, so it can do background work (prefetching and
+// the like) while the user carries on with other commands.  Run RUN_SYNC,
+// it must be from a worker thread that the caller owns, with no reply
+// window.  Run RUN_ASYNC, it gets a task thread of its own straight away,
+// and posts its reply like any other command.  Either way it never prompts,
+// it is cancelled through the caller's flag rather than the global cancel,
+// and it waits for a free connection under ConnectionLimit before
+// connecting.  Call before Init().
+void CP4Command::SetIndependent(volatile LONG *cancel/*=NULL*/)
+{
+	ASSERT(!m_IsChildTask);
+	m_Independent = TRUE;
+	m_cb.m_pCancel = cancel;
+}
+
+// A child task run on an independent command's connection must not prompt
+// or post errors to the UI any more than its parent may, and is cancelled
+// by the same flag.  Call before Init().
+void CP4Command::InheritIndependence(const CP4Command *parent)
+{
+	ASSERT(m_IsChildTask);
+	m_Independent = parent->m_Independent;
+	m_cb.m_pCancel = parent->m_cb.m_pCancel;
+}
+
 BOOL CP4Command::Run()
 {
-    if(!m_IsChildTask)
+    if(!m_IsChildTask && !m_Independent)
     {
         //  In general, no command can start unless SERVER_BUSY() is false
         //  or the command carries the key in m_pSingleLock.  The exception is:
@@ -197,7 +240,12 @@ BOOL CP4Command::Run()
 		}
 	}
     
-	if(m_Asynchronous)
+	if(m_Asynchronous && m_Independent)
+	{
+		ASSERT(!m_IsChildTask && !m_HaveServerLock);
+		AsyncExecCommand();
+	}
+	else if(m_Asynchronous)
 	{
 		ASSERT(!m_IsChildTask);
         if( !IsQueueable() && SERVER_BUSY() && !m_HaveServerLock )
@@ -270,9 +318,10 @@ BOOL CP4Command::NextListArgs()
 
     ASSERT(m_posStrListIn != NULL);
 	
-	// Pull another 10 files off the list
-	for(int i=0; m_posStrListIn != NULL && i<20; i++)
-		AddArg(m_pStrListIn->GetNext(m_posStrListIn));
+	// Pull another m_ListBatch files off the list - or all of them.  These
+	// can go past MAX_P4ARGS, so don't use AddArg()
+	for(int i=0; m_posStrListIn != NULL && (m_ListBatch <= 0 || i<m_ListBatch); i++)
+		m_args.Add(m_pStrListIn->GetNext(m_posStrListIn));
 
 	// Caller knows not to call again when the list is empty
 	if(m_posStrListIn == NULL)
@@ -323,6 +372,12 @@ BOOL CP4Command::InitConnection()
 		m_pClient->SetVar( "prog", "P4Win");
 		return TRUE;
 	}
+	else if(m_Independent && !AcquireConnectionSlot())
+	{
+		// Cancelled while waiting; the caller has nothing to report
+		m_FatalError=TRUE;
+		return FALSE;
+	}
 	else
 	{
 		Error e;
@@ -338,7 +393,8 @@ BOOL CP4Command::InitConnection()
 			m_RanInit=TRUE;
 
 			// Allow the user to Cancel the command if desired
-			global_cancel = 0;		// don't want a stale value!
+			if (!m_Independent)
+				global_cancel = 0;		// don't want a stale value!
 			m_pClient->SetBreak( &m_cb );
 
 			// Notify that we are p4win
@@ -407,6 +463,35 @@ BOOL CP4Command::InitConnection()
 	}
 }
 
+// Waits for one of the ConnectionLimit connections that independent
+// commands - sync shards, prefetches, merge previews, startup fetches -
+// share between them, so background work can't swamp the server.  Returns
+// FALSE if the command is cancelled, or P4Win closes, while it waits.
+BOOL CP4Command::AcquireConnectionSlot()
+{
+	for(;;)
+	{
+		LONG n= s_Connections;
+		if(n < GET_P4REGPTR()->GetConnectionLimit())
+		{
+			if(InterlockedCompareExchange(&s_Connections, n + 1, n) == n)
+			{
+				m_HaveConnSlot= TRUE;
+				return TRUE;
+			}
+			continue;
+		}
+		if((m_cb.m_pCancel && *m_cb.m_pCancel) || APP_ABORTING())
+			return FALSE;
+		Sleep(CONNSLOTWAIT);
+	}
+}
+
+int CP4Command::GetFreeConnections()
+{
+	return max(0, GET_P4REGPTR()->GetConnectionLimit() - (int) s_Connections);
+}
+
 void CP4Command::ExecCommand()
 {
 	BOOL done=FALSE;
@@ -429,6 +514,12 @@ void CP4Command::ExecCommand()
 		// Check for possible abort request
 		if(APP_ABORTING())
 		{
+			if(m_Independent)
+			{
+				// Our caller owns the thread, so let it clean up
+				m_FatalError=TRUE;
+				break;
+			}
 			ReleaseServerLock();
 			ExitThread(0);
 		}
@@ -475,7 +566,7 @@ void CP4Command::ExecCommand()
 			}
 			else
 #endif
-			if (PWDRequired() && (GET_PWD_ERROR() 
+			if (PWDRequired() && !m_Independent && (GET_PWD_ERROR() 
 							   || GET_NOPWD_SET() || GET_PWDNOTALLOW()))	// Password Error?
 			{
 				CString password;
@@ -599,7 +690,7 @@ void CP4Command::ExecCommand()
 		    ReleaseServerLock();
 
         // Clear any password error if the PWD worked
-        if(!m_FatalError && PWDRequired())
+        if(!m_FatalError && PWDRequired() && !m_Independent)
 		{
             SET_PWD_ERROR(FALSE);
 			SET_NOPWD_SET(FALSE);
@@ -719,6 +810,12 @@ void CP4Command::OnOutputError(char level, LPCTSTR errBuf, LPCTSTR errMsg)
 	if (( txt.Find( _T("Perforce password") ) > -1 ) 
 	 || ( txt.Find( _T("please login") ) > -1 ))
 	{
+		// A background command leaves the password prompt to the next foreground one
+		if (m_Independent)
+		{
+			m_FatalError=TRUE;
+			return;
+		}
 		SET_PWD_ERROR(TRUE);
         TheApp()->StatusAdd( msg, SV_WARNING );
 		m_ErrorTxt= LoadStringResource(IDS_OPERATION_CANNOT_COMPLETED_BECAUSE_BAD_PASSWORD);
@@ -727,7 +824,8 @@ void CP4Command::OnOutputError(char level, LPCTSTR errBuf, LPCTSTR errMsg)
 	}
 	if ( txt.Find( _T("Password not allowed at this server security level") ) > -1 ) 
 	{
-		SET_PWDNOTALLOW(TRUE);
+		if (!m_Independent)
+			SET_PWDNOTALLOW(TRUE);
 		m_ErrorTxt= msg;
         m_FatalError=TRUE;
 		return;
@@ -737,7 +835,7 @@ void CP4Command::OnOutputError(char level, LPCTSTR errBuf, LPCTSTR errMsg)
 	{
 		m_FatalError=TRUE;
 		HWND hWnd= AfxGetMainWnd()->GetSafeHwnd();
-		if( hWnd != NULL )
+		if( hWnd != NULL && !m_Independent )
 		{
 	        TheApp()->StatusAdd( m_ErrorTxt = msg, SV_WARNING );
 			BOOL b = false;
@@ -834,7 +932,8 @@ void CP4Command::OnOutputError(char level, LPCTSTR errBuf, LPCTSTR errMsg)
 	if( txt.Find( _T("Must create client ")) != -1 ||
 		txt.Find( _T(" - use 'client' command to create it.") ) != -1 )
 	{
-        PostClientError();
+		if (!m_Independent)
+			PostClientError();
 		m_FatalError = TRUE; 
 		return;
 	}
@@ -880,6 +979,46 @@ BOOL CP4Command::HandledCmdSpecificError(LPCTSTR errBuf, LPCTSTR errMsg)
 	return FALSE;
 }
 
+// Runs the input list through server commands of up to ListArgBatch files
+// each (all of them in one command if the setting is 0), rather than the
+// usual 20.  Call from Run(), after m_pStrListIn is set and before
+// NextListArgs().
+void CP4Command::StreamList()
+{
+	m_ListBatch= GET_P4REGPTR()->GetListArgBatch();
+	m_ListTotal= int(m_pStrListIn->GetCount());
+	m_ListDone= 0;
+	m_ListResults.RemoveAll();
+	m_ListResults.InitHashTable(max(17, m_ListTotal + m_ListTotal / 4));
+}
+
+// Records a per-file result line, "//depot/path#rev - what happened" or
+// "//depot/path - what happened", under its depot path, and shows how far
+// the command has got on the status bar
+void CP4Command::AddListResult(LPCTSTR data)
+{
+	LPCTSTR p= StrChr(data, _T('#'));
+	if(!p || !StrStr(p, _T(" - ")))
+		p= StrStr(data, _T(" - "));
+	CString path(data, p ? int(p - data) : lstrlen(data));
+	m_ListResults.SetAt(path, data);
+	m_ListDone++;
+
+	DWORD now= GetTickCount();
+	if(m_ListTotal > 1 && now - m_LastListProgress >= 500)
+	{
+		m_LastListProgress= now;
+		CString *txt= new CString;
+		txt->Format(_T("p4 %s: %d of %d files"), (LPCTSTR) m_Function, m_ListDone, m_ListTotal);
+		::PostMessage(MainFrame()->m_hWnd, WM_SYNCPROGRESS, 0, (LPARAM) txt);
+	}
+}
+
+BOOL CP4Command::GetListResult(LPCTSTR depotPath, CString &result)
+{
+	return m_ListResults.Lookup(depotPath, result);
+}
+
 void CP4Command::OnErrorPause(LPCTSTR errBuf, Error *e)
 {
 	// Check for possible abort request
@@ -900,6 +1039,12 @@ void CP4Command::ProcessResults(BOOL& done)
 		done = TRUE;
 	else if(!done)
 		done = NextListArgs();
+
+	if(done && m_LastListProgress)
+	{
+		m_LastListProgress= 0;
+		::PostMessage(MainFrame()->m_hWnd, WM_SYNCPROGRESS, 0, (LPARAM) new CString);
+	}
 }
 
 void CP4Command::PreProcess(BOOL& done)
@@ -961,9 +1106,16 @@ CString CP4Command::GetP4Command( )
 	{
 		INT_PTR args = m_args.GetSize() ;
 		
-		while ( args-- )
-			msg = CString ( _T(" ") ) + m_args[ args ] + msg;
-		msg = _T("p4") + msg;
+		// a streamed file list can run to thousands of args; just show the first few
+		msg = _T("p4");
+		for ( INT_PTR i = 0; i < args && i < MAX_P4ARGS; i++ )
+			msg += CString ( _T(" ") ) + m_args[ i ];
+		if ( args > MAX_P4ARGS )
+		{
+			CString more;
+			more.Format(_T(" ... (%d more)"), int(args - MAX_P4ARGS));
+			msg += more;
+		}
 	}
 	return msg;
 }
@@ -1006,9 +1158,10 @@ BOOL CP4Command::GetServerLock(DWORD timeout)
 
 void CP4Command::ReleaseServerLock()
 {
-    if(m_Asynchronous)
+    // A command may let go early, before a long bit of local work, and
+    // then reaches the usual release at the end without the lock
+    if(m_Asynchronous && !m_Independent && m_HaveServerLock)
     {
-        ASSERT(m_HaveServerLock);
         XTRACE(_T("Async Task: %s Releasing lock\n"), GetTaskName());
         RELEASE_SERVER_LOCK( m_ServerKey);
         m_HaveServerLock=FALSE;
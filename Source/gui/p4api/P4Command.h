@@ -168,6 +168,7 @@
 #define	WM_ONDODELETEFIXES		WM_USER+324
 #define	WM_UPDATEHAVEREV		WM_USER+325
 #define	WM_P4CHANGESSHELVED		WM_USER+326
+#define WM_P4CHANGECHECK		WM_USER+327    // done CCmd_ChangeCheck
 #define WM_P4UPPERBOUND			WM_USER+398     // Used to test command values only, not a command
 #define WM_P4STATUS				WM_USER+399
 
@@ -186,7 +187,12 @@ class CGuiClientUser;
 class P4KeepAlive : public KeepAlive
 {
     public:
+		P4KeepAlive() { m_pCancel = NULL; }
 		int IsAlive();
+
+		// Independent commands are cancelled through their own flag,
+		// so they neither see nor consume the user's global_cancel
+		volatile LONG *m_pCancel;
 } ;
 
 class CP4Command : public CObject
@@ -226,6 +232,13 @@ protected:
     // Are we running (always synchronously) as a child task
 	BOOL m_IsChildTask;
 
+    // Are we running on our own connection, outside the server lock (see SetIndependent())
+	BOOL m_Independent;
+
+    // Independent commands share ConnectionLimit connections between them
+	static volatile LONG s_Connections;
+	BOOL m_HaveConnSlot;
+
 	BOOL m_UsedTagged;
 	BOOL m_RanInit;
 	BOOL m_ClosedConn;
@@ -254,6 +267,11 @@ protected:
 	POSITION m_posStrListIn;
 	CStringList *m_pStrListIn;
 	CStringList m_StrListOut;
+	int m_ListBatch;			// files per command from m_pStrListIn; 0 for all
+	int m_ListTotal;
+	int m_ListDone;
+	DWORD m_LastListProgress;
+	CMapStringToString m_ListResults;	// result line for each depot path
 
 	// Did the output exceed the number of file swe are
 	// willing to update in the tree views?
@@ -289,6 +307,9 @@ public:
 	void SetRedoOpenedFilter(int i) { m_RedoOpenedFilter = i; }
 
     virtual BOOL Init(HWND replyWnd, BOOL asynch, BOOL holdLock=FALSE, int key=0);
+	void SetIndependent(volatile LONG *cancel=NULL);
+	void InheritIndependence(const CP4Command *parent);
+	BOOL IsIndependent() const { return m_Independent; }
 	BOOL Run();
 protected:
 	virtual void OnOutputInfo(char level, LPCTSTR data, LPCTSTR msg);
@@ -333,14 +354,20 @@ protected:
     int AddArg(int arg);
 	void ClearArgs(int baseArgs=0);
 	virtual BOOL NextListArgs();	// return TRUE to indicate done; FALSE to keep running
+	void StreamList();
+	void AddListResult(LPCTSTR data);
 	
 	BOOL InitConnection();
+	BOOL AcquireConnectionSlot();
 public:
 	void CloseConn(Error *e);
+	static int GetFreeConnections();
 
 public:
     void AsyncExecCommand();
 	CString GetP4Command( );
+	BOOL GetListResult(LPCTSTR depotPath, CString &result);
+	const CMapStringToString *GetListResults() { return &m_ListResults; }
 	void ExecCommand();    
 protected:
 	// Inside ExecCommand(), after the connection to server is established:
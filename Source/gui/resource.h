@@ -1131,6 +1131,7 @@
 #define IDS_CHANGE_n                    1541
 #define IDC_SHOWHIDDEN                  1541
 #define IDS_CHANGE_n_UPDATED            1542
+#define IDC_USE_DESCRIPTION             1542
 #define IDS_UPDATING_JOB_FIXES          1543
 #define IDS_CHECKING_OPEN_FILES         1544
 #define IDS_PERFORCE_FIXED_JOB_DESCRIPTION 1545
@@ -1816,6 +1817,34 @@
 #define IDS_INSERTING_CLIENTS           2227
 #define IDS_INSERTING_LABELS            2228
 #define IDS_USERCLIENTROOTCWDADDRVERSERVERADDRDATEVERLICENSEROOTOS 2229
+#define IDS_MERGE_PREVIEW_CANCELED      2230
+#define IDS_STATUS_SHOWCOMPLETIONS      2231
+#define IDS_STATUS_SHOWWARNINGS         2232
+#define IDS_STATUS_SHOWERRORS           2233
+#define IDS_STATUS_SHOWTOOLOUTPUT       2234
+#define IDS_STATUS_SHOWLEVELS           2235
+#define IDS_n_OF_n_INDEXED_CHANGES_MATCH_s 2236
+#define IDS_UNABLE_TO_OPEN_s            2237
+#define IDS_s_TOO_LARGE_TO_COMPARE      2238
+#define IDS_UNABLE_TO_READ_s            2239
+#define IDS_NO_DIFFERENCES_s_s          2240
+#define IDS_CANT_MERGE_IN_MEMORY        2241
+#define IDS_MERGE_PREVIEW_FOR_s_n_n_n_n 2242
+#define IDS_PREVIEWING_n_MERGES_LOCALLY 2243
+#define IDS_UNABLE_TO_GET_s_n           2244
+#define IDS_s_MERGE_PREVIEW_n_n_n_n     2245
+#define IDS_s_NOT_PREVIEWED_s           2246
+#define IDS_MERGE_PREVIEW_n_FILES_n_CONFLICTED_n_CHUNKS 2247
+#define IDS_n_COULD_NOT_BE_PREVIEWED    2248
+#define IDS_UNABLE_TO_CREATE_s          2249
+#define IDS_UNABLE_TO_MAP_s             2250
+#define IDS_UNABLE_TO_MAP_DIFF_VIEW     2251
+#define IDS_UNABLE_TO_WRITE_s           2252
+#define IDS_n_DIFFERENCES_s_s_ARE_IN_s  2253
+#define IDS_DIFF_CANCELED               2254
+#define IDS_COMPARING_FILES_n           2255
+#define IDS_STATUS_LOG_NO_THREAD_s      2256
+#define IDS_UNABLE_TO_CREATE_STATUS_LOG_s 2257
 #define P4_INT_LBUILD                   6053
 #define ID_PERFORCE_INFO                32771
 #define ID_PERFORCE_OPTIONS             32772
@@ -2094,6 +2123,10 @@
 #define ID_Menu33154                    33154
 #define ID_SORTCHGFILESBYACTION         33158
 #define ID_SORTCHGFILESBYNAME           33159
+#define ID_STATUS_SHOWCOMPLETIONS       33160
+#define ID_STATUS_SHOWWARNINGS          33161
+#define ID_STATUS_SHOWERRORS            33162
+#define ID_STATUS_SHOWTOOLOUTPUT        33163
 #define ID_TOOL_1                       58001
 #define ID_TOOL_2                       58002
 #define ID_TOOL_3                       58003
@@ -2370,8 +2403,8 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_3D_CONTROLS                     1
 #define _APS_NEXT_RESOURCE_VALUE        467
-#define _APS_NEXT_COMMAND_VALUE         33160
-#define _APS_NEXT_CONTROL_VALUE         1542
+#define _APS_NEXT_COMMAND_VALUE         33164
+#define _APS_NEXT_CONTROL_VALUE         1543
 #define _APS_NEXT_SYMED_VALUE           368
 #endif
 #endif